@@ -306,7 +306,8 @@ static void MyAppTask(void *pvParam) {
 	#else
 	    KEY_Scan(); /* scan keys and set events */
 	#endif
-	    EVNT_HandleEvent(APP_EventHandler, TRUE);
+	    EVNT_HandleAllEvents(APP_EventHandler); /* a burst of events is handled within one period */
+	    EVNT_DispatchQueue(); /* posted events with payload to their subscribers */
 	    vTaskDelay(pdMS_TO_TICKS(100));
 	    }
 }
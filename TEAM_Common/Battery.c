@@ -12,35 +12,72 @@
 #include "ADC_Bat.h"
 #include "CLS1.h"
 #include "FRTOS1.h"
+#include "CS1.h"
 
-uint8_t BATT_MeasureBatteryVoltage(uint16_t *cvP) {
-  #define SAMPLE_GROUP_SIZE 1U
-  ADC_Bat_TResultData results[SAMPLE_GROUP_SIZE]={0};
-  LDD_ADC_TSample SampleGroup[SAMPLE_GROUP_SIZE];
-  uint32_t milliVolts;
+#define SAMPLE_GROUP_SIZE 1U
 #define BAT_V_DIVIDER_UP   62 /* voltage divider pull-up */
 #define BAT_V_DIVIDER_DOWN 30 /* voltage divider pull-down */
 
-  *cvP = 0; /* init */
+static bool BATT_isMeasuring = FALSE; /* if a measurement has been started and the result is not read yet */
+
+uint8_t BATT_StartMeasurement(void) {
+  LDD_ADC_TSample SampleGroup[SAMPLE_GROUP_SIZE];
+  CS1_CriticalVariable();
+
+  CS1_EnterCritical();
+  if (BATT_isMeasuring) {
+    CS1_ExitCritical();
+    return ERR_BUSY;
+  }
+  BATT_isMeasuring = TRUE; /* the ADC belongs to us now */
+  CS1_ExitCritical();
   SampleGroup[0].ChannelIdx = 0U;  /* Create one-sample group */
   if (ADC_Bat_CreateSampleGroup(ADC_Bat_DeviceData, (LDD_ADC_TSample *)SampleGroup, SAMPLE_GROUP_SIZE)!=ERR_OK) {  /* Set created sample group */
+    BATT_isMeasuring = FALSE;
     return ERR_FAILED;
   }
   if (ADC_Bat_StartSingleMeasurement(ADC_Bat_DeviceData)!=ERR_OK) {
+    BATT_isMeasuring = FALSE;
     return ERR_FAILED;
   }
-  while(!ADC_Bat_GetMeasurementCompleteStatus(ADC_Bat_DeviceData)) {
-    vTaskDelay(pdMS_TO_TICKS(1)); /* wait */
+  return ERR_OK;
+}
+
+uint8_t BATT_GetMeasurement(uint16_t *cvP) {
+  ADC_Bat_TResultData results[SAMPLE_GROUP_SIZE]={0};
+  uint32_t milliVolts;
+
+  *cvP = 0; /* init */
+  if (!ADC_Bat_GetMeasurementCompleteStatus(ADC_Bat_DeviceData)) {
+    return ERR_BUSY;
   }
   if (ADC_Bat_GetMeasuredValues(ADC_Bat_DeviceData, &results[0])!=ERR_OK) {
+    BATT_isMeasuring = FALSE;
     return ERR_FAILED;
   }
+  BATT_isMeasuring = FALSE;
   /* reference voltage is 3.3V. Battry Voltage is using a voltage divider (R29, 62KOhm pullup to VBat, R30 30kOhm pull down to GND) */
   milliVolts = results[0]*330*(BAT_V_DIVIDER_UP+BAT_V_DIVIDER_DOWN)/BAT_V_DIVIDER_DOWN/0xffff; /* scale it to centi-volt. Do multiplication first to avoid numerical issues */
   *cvP = milliVolts;
   return ERR_OK;
 }
 
+uint8_t BATT_MeasureBatteryVoltage(uint16_t *cvP) {
+  uint8_t res;
+
+  *cvP = 0; /* init */
+  while((res=BATT_StartMeasurement())==ERR_BUSY) {
+    vTaskDelay(pdMS_TO_TICKS(1)); /* somebody else is measuring, wait */
+  }
+  if (res!=ERR_OK) {
+    return res;
+  }
+  while((res=BATT_GetMeasurement(cvP))==ERR_BUSY) {
+    vTaskDelay(pdMS_TO_TICKS(1)); /* wait */
+  }
+  return res;
+}
+
 static uint8_t BATT_PrintStatus(const CLS1_StdIOType *io) {
   uint8_t buf[32];
   uint16_t cv;
@@ -30,6 +30,19 @@ uint8_t BATT_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_St
  */
 uint8_t BATT_MeasureBatteryVoltage(uint16_t *cvP);
 
+/*!
+ * \brief Starts a battery voltage measurement without waiting for the result. Use BATT_GetMeasurement() to get the result.
+ * \return Error code, ERR_OK if everything was fine, ERR_BUSY if a measurement is already running
+ */
+uint8_t BATT_StartMeasurement(void);
+
+/*!
+ * \brief Returns the result of a measurement started with BATT_StartMeasurement(), without blocking.
+ * \param cvP Pointer to variable where to store the voltage in centi-voltage units (330 is 3.3V)
+ * \return Error code, ERR_OK if the value is available, ERR_BUSY if the measurement is not completed yet
+ */
+uint8_t BATT_GetMeasurement(uint16_t *cvP);
+
 
 /*!
  * \brief Module Initialization.
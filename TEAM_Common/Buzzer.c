@@ -12,6 +12,9 @@
 #include "BUZ1.h"
 #include "Trigger.h"
 #include "UTIL1.h"
+#if PL_CONFIG_HAS_EVENTS
+  #include "Event.h"
+#endif
 #if PL_CONFIG_HAS_SHELL
   #include "CLS1.h"
 #endif
@@ -244,13 +247,25 @@ uint8_t BUZ_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_Std
 }
 #endif /* PL_CONFIG_HAS_SHELL */
 
+#if PL_CONFIG_HAS_EVENTS && PL_CONFIG_HAS_LINE_RECOVERY
+static void BUZ_OnLineLost(const EVNT_Msg *msg) {
+  (void)msg;
+  (void)BUZ_Beep(2000, 100);
+}
+#endif
+
 void BUZ_Deinit(void) {
-  /* nothing to do */
+#if PL_CONFIG_HAS_EVENTS && PL_CONFIG_HAS_LINE_RECOVERY
+  EVNT_Unsubscribe(EVNT_LINE_LOST, BUZ_OnLineLost);
+#endif
 }
 
 void BUZ_Init(void) {
   BUZ1_SetVal(); /* turn buzzer off */
   trgInfo.buzPeriodTicks = 0;
   trgInfo.buzIterationCntr = 0;
+#if PL_CONFIG_HAS_EVENTS && PL_CONFIG_HAS_LINE_RECOVERY
+  (void)EVNT_Subscribe(EVNT_LINE_LOST, BUZ_OnLineLost); /* beep while searching the line */
+#endif
 }
 #endif /* PL_CONFIG_HAS_BUZZER */
@@ -96,13 +96,6 @@ static VL6180X_Device DIST_ToF_Devices[] = {
   {.ptp_offset=0, .deviceAddr=VL6180X_DEFAULT_I2C_ADDRESS+4, .scale=VL6180X_SCALING_DEFAULT, .pinAction=DIST_TOF_CEPinAction_4},
 };
 
-typedef enum {
-  DIST_TOF_REAR = 0,
-  DIST_TOF_RIGHT = 1,
-  DIST_TOF_FRONT = 2,
-  DIST_TOF_LEFT = 3
-} DIST_SensorPosition;
-
 #endif
 
 #if PL_HAS_FRONT_DISTANCE
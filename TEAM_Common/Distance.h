@@ -43,8 +43,21 @@ uint8_t DIST_GetSensorBitsMiddle(void);
 uint8_t DIST_GetSensorBitsRight(void);
 #endif
 
+#if PL_HAS_TOF_SENSOR
+typedef enum {
+  DIST_TOF_REAR = 0,
+  DIST_TOF_RIGHT = 1,
+  DIST_TOF_FRONT = 2,
+  DIST_TOF_LEFT = 3
+} DIST_SensorPosition;
+#endif
+
 uint8_t DIST_SpeedIntoObstacle(int speedL, int speedR);
 uint8_t DIST_MotorDrivingIntoObstacle(void);
+/*!
+ * \brief Checks for walls close to the robot.
+ * \return Bit set (1<<DIST_TOF_FRONT, ...) for each side with an obstacle
+ */
 uint8_t DIST_CheckSurrounding(void);
 bool DIST_DriveToCenter(void);
 bool DIST_NearFrontObstacle(int16_t distance);
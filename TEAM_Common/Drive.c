@@ -20,6 +20,19 @@
 #include "Q4CRight.h"
 #include "Shell.h"
 #include "WAIT1.h"
+#if PL_CONFIG_HAS_ODOMETRY
+  #include "Odometry.h"
+#endif
+
+#define DRV_TASK_PERIOD_MS            5 /* period of the drive task */
+
+/*! \todo adopt the twist values for your robot */
+#define DRV_TWIST_MAX_WHEEL_SPEED     4000 /* maximum wheel speed in steps/sec used in twist mode */
+#define DRV_TWIST_DEFAULT_ACCEL_V     8000 /* default linear acceleration in steps/sec^2 */
+#define DRV_TWIST_DEFAULT_ACCEL_OMEGA 40000 /* default angular acceleration in milli-radians/sec^2 */
+#if !PL_CONFIG_HAS_ODOMETRY
+  #define DRV_TWIST_WHEEL_BASE_TICKS  890 /* distance between the wheels in encoder ticks */
+#endif
 
 struct {
   DRV_Mode mode;
@@ -29,12 +42,70 @@ struct {
   struct {
     int32_t left, right;
   } pos;
+  struct {
+    int32_t v, omega;
+  } twist;
 } DRV_Status;
 
+static struct {
+  int32_t v, omega; /* current (ramped) twist values */
+  int32_t accelV, accelOmega; /* acceleration limits */
+} DRV_Twist;
+
+/*! \todo adopt the slip detection values for your robot */
+#define DRV_SLIP_WINDOW           4     /* number of drive periods for one speed sample */
+#define DRV_SLIP_HISTORY          (2*DRV_SLIP_WINDOW+1) /* positions needed for two speed samples */
+#define DRV_SLIP_MAX_ACCEL        40000 /* physically possible wheel acceleration in steps/sec^2 */
+#define DRV_SLIP_MIN_SPEED_DIFF   400   /* minimum speed difference in steps/sec between wheels while driving straight */
+#define DRV_SLIP_PWM_SLEW         0x400 /* PWM slew limit while slipping, full power after 64 periods */
+#define DRV_SLIP_HOLD_MS          200   /* time to keep the slew limit after the last slip */
+
+typedef struct {
+  int32_t pos[DRV_SLIP_HISTORY]; /* position history, one entry per drive period */
+  int32_t speed; /* speed in steps/sec over the last window */
+  int32_t holdMs; /* remaining time for slew limit, 0 if not slipping */
+  uint32_t count; /* number of slip events */
+} DRV_SlipWheel;
+
+static struct {
+  DRV_SlipWheel left, right;
+  uint8_t idx; /* index of the newest entry in the position history */
+  uint8_t nofSamples; /* number of valid entries in the history */
+} DRV_Slip;
+
+#define DRV_MOTION_QUEUE_LENGTH   8   /* number of motion primitives which can be queued */
+#define DRV_MOTION_MIN_SPEED      100 /* minimum path speed in steps/sec, so a primitive always gets completed */
+
+typedef enum {
+  DRV_MOTION_STRAIGHT,
+  DRV_MOTION_ARC,
+  DRV_MOTION_SPIN,
+  DRV_MOTION_HOLD,
+} DRV_MotionKind;
+
+typedef struct {
+  DRV_MotionKind kind;
+  int32_t amount; /* STRAIGHT, ARC: center distance in ticks; SPIN: wheel ticks; HOLD: time in ms */
+  int32_t speed;  /* STRAIGHT, ARC, SPIN: maximum path speed in steps/sec; HOLD: linear velocity */
+  int32_t param;  /* ARC: radius in ticks; HOLD: angular velocity */
+  DRV_MotionDoneFct done; /* callback after completion, or NULL */
+  void *arg; /* argument for callback */
+} DRV_Motion;
+
+static xQueueHandle DRV_MotionQueue;
+static struct {
+  bool active; /* if curr is executed */
+  bool abort; /* request to abort the active primitive */
+  DRV_Motion curr; /* active primitive */
+  int32_t startL, startR; /* wheel positions at the start of the primitive */
+  TickType_t startTicks; /* time at the start of the primitive */
+} DRV_MotionState;
+
 typedef enum {
   DRV_SET_MODE,
   DRV_SET_SPEED,
   DRV_SET_POS,
+  DRV_SET_TWIST,
 } DRV_Commands;
 
 typedef struct {
@@ -47,6 +118,9 @@ typedef struct {
    struct {
       int32_t left, right;
     } pos; /* DRV_SET_POS */
+    struct {
+      int32_t v, omega;
+    } twist; /* DRV_SET_TWIST */
   } u;
 } DRV_Command;
 
@@ -54,6 +128,13 @@ typedef struct {
 #define QUEUE_ITEM_SIZE   sizeof(DRV_Command) /* each item is a single drive command */
 static xQueueHandle DRV_Queue;
 
+/* event group bits, set by the drive task as long as the condition is true */
+#define DRV_EVENT_POS_REACHED   (1<<0)  /* position target reached, see DRV_HasTurned() */
+#define DRV_EVENT_STOPPED       (1<<1)  /* robot stopped, see DRV_IsStopped() */
+#define DRV_EVENT_ALL           (DRV_EVENT_POS_REACHED|DRV_EVENT_STOPPED)
+#define DRV_WAIT_CHECK_STOP_MS  DRV_TASK_PERIOD_MS /* period to check the stop function while waiting */
+static EventGroupHandle_t DRV_EventGroup;
+
 bool DRV_IsStopped(void) {
   Q4CLeft_QuadCntrType leftPos;
   Q4CRight_QuadCntrType rightPos;
@@ -80,22 +161,49 @@ bool DRV_IsStopped(void) {
   }
 }
 
+static DRV_WaitResult DRV_WaitEvent(EventBits_t event, int32_t timeoutMs, DRV_StopFct stopIt) {
+  EventBits_t bits;
+  int32_t waitMs;
+
+  for(;;) {
+    if (stopIt!=NULL && stopIt()) {
+      return DRV_WAIT_ABORTED;
+    }
+    if (timeoutMs<=0) {
+      return DRV_WAIT_TIMEOUT;
+    }
+    waitMs = timeoutMs;
+    if (stopIt!=NULL && waitMs>DRV_WAIT_CHECK_STOP_MS) {
+      waitMs = DRV_WAIT_CHECK_STOP_MS; /* wake up to check the stop function */
+    }
+    bits = xEventGroupWaitBits(DRV_EventGroup, event, pdFALSE, pdTRUE, pdMS_TO_TICKS(waitMs));
+    if (bits&event) {
+      return DRV_WAIT_REACHED;
+    }
+    timeoutMs -= waitMs;
+  } /* for */
+}
+
+DRV_WaitResult DRV_WaitPosReached(int32_t timeoutMs, DRV_StopFct stopIt) {
+  return DRV_WaitEvent(DRV_EVENT_POS_REACHED, timeoutMs, stopIt);
+}
+
+DRV_WaitResult DRV_WaitStopped(int32_t timeoutMs, DRV_StopFct stopIt) {
+  return DRV_WaitEvent(DRV_EVENT_STOPPED, timeoutMs, stopIt);
+}
+
 uint8_t DRV_Stop(int32_t timeoutMs) {
   DRV_SetMode(DRV_MODE_STOP); /* stop it */
-  do {
-    if (DRV_IsStopped()) {
-      break;
-    }
-    WAIT1_WaitOSms(5);
-    timeoutMs -= 5;
-  } while (timeoutMs>0);
-  if (timeoutMs<0) {
+  if (DRV_WaitStopped(timeoutMs, NULL)!=DRV_WAIT_REACHED) {
     return ERR_BUSY; /* timeout */
   }
   return ERR_OK;
 }
 
 bool DRV_IsDrivingBackward(void) {
+  if (DRV_Status.mode==DRV_MODE_TWIST) {
+    return DRV_Status.twist.v<0;
+  }
   return DRV_Status.mode==DRV_MODE_SPEED
       && DRV_Status.speed.left<0
       && DRV_Status.speed.right<0;
@@ -144,6 +252,7 @@ uint8_t DRV_SetMode(DRV_Mode mode) {
   if (FRTOS1_xQueueSendToBack(DRV_Queue, &cmd, portMAX_DELAY)!=pdPASS) {
     return ERR_FAILED;
   }
+  (void)xEventGroupClearBits(DRV_EventGroup, DRV_EVENT_ALL); /* drive task sets them again for the new mode */
   FRTOS1_taskYIELD(); /* yield so drive task has a chance to read message */
   return ERR_OK;
 }
@@ -170,10 +279,405 @@ uint8_t DRV_SetPos(int32_t left, int32_t right) {
   if (FRTOS1_xQueueSendToBack(DRV_Queue, &cmd, portMAX_DELAY)!=pdPASS) {
     return ERR_FAILED;
   }
+  (void)xEventGroupClearBits(DRV_EventGroup, DRV_EVENT_ALL); /* drive task sets them again for the new target */
+  FRTOS1_taskYIELD(); /* yield so drive task has a chance to read message */
+  return ERR_OK;
+}
+
+uint8_t DRV_SetTwist(int32_t v, int32_t omega) {
+  DRV_Command cmd;
+
+  cmd.cmd = DRV_SET_TWIST;
+  cmd.u.twist.v = v;
+  cmd.u.twist.omega = omega;
+  if (FRTOS1_xQueueSendToBack(DRV_Queue, &cmd, portMAX_DELAY)!=pdPASS) {
+    return ERR_FAILED;
+  }
   FRTOS1_taskYIELD(); /* yield so drive task has a chance to read message */
   return ERR_OK;
 }
 
+static int32_t DRV_GetWheelBaseTicks(void) {
+#if PL_CONFIG_HAS_ODOMETRY
+  return ODO_UmToTicks(ODO_GetWheelBaseUm());
+#else
+  return DRV_TWIST_WHEEL_BASE_TICKS;
+#endif
+}
+
+/*!
+ * \brief Converts a twist into wheel speeds. If a wheel would exceed the maximum speed, the linear velocity gets reduced first.
+ * \param v Linear velocity in steps/sec
+ * \param omega Angular velocity in milli-radians/sec
+ * \param left Where to store the left wheel speed in steps/sec
+ * \param right Where to store the right wheel speed in steps/sec
+ */
+static void DRV_TwistToWheels(int32_t v, int32_t omega, int32_t *left, int32_t *right) {
+  int32_t diff, absV, absDiff;
+
+  diff = (int32_t)(((int64_t)omega*DRV_GetWheelBaseTicks())/2000); /* wheel speed difference to the center: omega*base/2 */
+  if (diff>DRV_TWIST_MAX_WHEEL_SPEED) {
+    diff = DRV_TWIST_MAX_WHEEL_SPEED;
+  } else if (diff<-DRV_TWIST_MAX_WHEEL_SPEED) {
+    diff = -DRV_TWIST_MAX_WHEEL_SPEED;
+  }
+  absV = v<0?-v:v;
+  absDiff = diff<0?-diff:diff;
+  if (absV+absDiff>DRV_TWIST_MAX_WHEEL_SPEED) { /* saturation: keep the rotation, reduce linear speed */
+    absV = DRV_TWIST_MAX_WHEEL_SPEED-absDiff;
+    v = v<0?-absV:absV;
+  }
+  *left = v-diff;
+  *right = v+diff;
+}
+
+static int32_t DRV_Ramp(int32_t curr, int32_t target, int32_t accel) {
+  int32_t step;
+
+  step = (accel*DRV_TASK_PERIOD_MS)/1000;
+  if (step<=0) {
+    step = 1;
+  }
+  if (target>curr+step) {
+    return curr+step;
+  } else if (target<curr-step) {
+    return curr-step;
+  }
+  return target;
+}
+
+static uint32_t DRV_Sqrt32(uint32_t val) {
+  uint32_t res = 0, bit = 1UL<<30;
+
+  while (bit>val) {
+    bit >>= 2;
+  }
+  while (bit!=0) {
+    if (val>=res+bit) {
+      val -= res+bit;
+      res = (res>>1)+bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return res;
+}
+
+static uint8_t DRV_MotionQueueItem(DRV_Motion *motion) {
+  if (FRTOS1_xQueueSendToBack(DRV_MotionQueue, motion, portMAX_DELAY)!=pdPASS) {
+    return ERR_FAILED;
+  }
+  return ERR_OK;
+}
+
+uint8_t DRV_MotionStraight(int32_t distTicks, int32_t speed, DRV_MotionDoneFct done, void *arg) {
+  DRV_Motion motion;
+
+  if (speed<=0) {
+    return ERR_FAILED;
+  }
+  motion.kind = DRV_MOTION_STRAIGHT;
+  motion.amount = distTicks;
+  motion.speed = speed;
+  motion.param = 0;
+  motion.done = done;
+  motion.arg = arg;
+  return DRV_MotionQueueItem(&motion);
+}
+
+uint8_t DRV_MotionArc(int32_t distTicks, int32_t radiusTicks, int32_t speed, DRV_MotionDoneFct done, void *arg) {
+  DRV_Motion motion;
+
+  if (speed<=0 || radiusTicks==0) {
+    return ERR_FAILED;
+  }
+  motion.kind = DRV_MOTION_ARC;
+  motion.amount = distTicks;
+  motion.speed = speed;
+  motion.param = radiusTicks;
+  motion.done = done;
+  motion.arg = arg;
+  return DRV_MotionQueueItem(&motion);
+}
+
+uint8_t DRV_MotionSpin(int32_t wheelTicks, int32_t speed, DRV_MotionDoneFct done, void *arg) {
+  DRV_Motion motion;
+
+  if (speed<=0) {
+    return ERR_FAILED;
+  }
+  motion.kind = DRV_MOTION_SPIN;
+  motion.amount = wheelTicks;
+  motion.speed = speed;
+  motion.param = 0;
+  motion.done = done;
+  motion.arg = arg;
+  return DRV_MotionQueueItem(&motion);
+}
+
+uint8_t DRV_MotionHold(int32_t v, int32_t omega, int32_t timeMs, DRV_MotionDoneFct done, void *arg) {
+  DRV_Motion motion;
+
+  if (timeMs<=0) {
+    return ERR_FAILED;
+  }
+  motion.kind = DRV_MOTION_HOLD;
+  motion.amount = timeMs;
+  motion.speed = v;
+  motion.param = omega;
+  motion.done = done;
+  motion.arg = arg;
+  return DRV_MotionQueueItem(&motion);
+}
+
+uint8_t DRV_MotionFlush(void) {
+  FRTOS1_taskENTER_CRITICAL();
+  (void)FRTOS1_xQueueReset(DRV_MotionQueue);
+  DRV_MotionState.abort = TRUE; /* drive task will drop the active primitive */
+  FRTOS1_taskEXIT_CRITICAL();
+  return ERR_OK;
+}
+
+bool DRV_MotionIsIdle(void) {
+  return !DRV_MotionState.active && FRTOS1_uxQueueMessagesWaiting(DRV_MotionQueue)==0;
+}
+
+static bool DRV_MotionIsTranslation(const DRV_Motion *motion) {
+  return motion->kind!=DRV_MOTION_SPIN;
+}
+
+static int32_t DRV_MotionSignedSpeed(const DRV_Motion *motion) {
+  if (motion->kind==DRV_MOTION_HOLD) {
+    return motion->speed;
+  }
+  return motion->amount<0?-motion->speed:motion->speed;
+}
+
+/*!
+ * \brief Calculates the speed at the end of a primitive, so the next primitive can continue without stopping.
+ * \param curr Current primitive
+ * \param next Next primitive, or NULL if there is none
+ * \return Path speed in steps/sec at the end of the current primitive
+ */
+static int32_t DRV_MotionExitSpeed(const DRV_Motion *curr, const DRV_Motion *next) {
+  int32_t vc, vn;
+
+  if (next==NULL) {
+    return 0; /* stop at the end */
+  }
+  if (DRV_MotionIsTranslation(curr)!=DRV_MotionIsTranslation(next)) {
+    return 0; /* between moving and turning on the spot we have to stop */
+  }
+  vc = DRV_MotionSignedSpeed(curr);
+  vn = DRV_MotionSignedSpeed(next);
+  if (vn==0 || (vc<0)!=(vn<0)) {
+    return 0; /* change of direction */
+  }
+  if (vc<0) {
+    vc = -vc;
+    vn = -vn;
+  }
+  return vc<vn?vc:vn;
+}
+
+static int32_t DRV_MotionAccel(const DRV_Motion *motion) {
+  int32_t accel;
+
+  if (motion->kind==DRV_MOTION_SPIN) { /* wheel acceleration from angular acceleration */
+    accel = (int32_t)(((int64_t)DRV_Twist.accelOmega*DRV_GetWheelBaseTicks())/2000);
+  } else {
+    accel = DRV_Twist.accelV;
+  }
+  return accel>0?accel:1;
+}
+
+/*!
+ * \brief Calculates the path speed, so the exit speed can be reached with the given deceleration at the end.
+ */
+static int32_t DRV_MotionPathSpeed(int32_t maxSpeed, int32_t exitSpeed, int32_t accel, int32_t remaining) {
+  int64_t v2;
+  int32_t speed;
+
+  v2 = (int64_t)exitSpeed*exitSpeed + 2*(int64_t)accel*remaining;
+  if (v2>=(int64_t)maxSpeed*maxSpeed) {
+    return maxSpeed;
+  }
+  speed = (int32_t)DRV_Sqrt32((uint32_t)v2);
+  if (speed<DRV_MOTION_MIN_SPEED) {
+    speed = maxSpeed<DRV_MOTION_MIN_SPEED?maxSpeed:DRV_MOTION_MIN_SPEED;
+  }
+  return speed;
+}
+
+static int32_t DRV_MotionRemaining(const DRV_Motion *motion, int32_t posL, int32_t posR) {
+  int32_t progress, dL, dR;
+
+  dL = posL-DRV_MotionState.startL;
+  dR = posR-DRV_MotionState.startR;
+  switch(motion->kind) {
+    case DRV_MOTION_STRAIGHT:
+    case DRV_MOTION_ARC:
+      progress = (dL+dR)/2;
+      break;
+    case DRV_MOTION_SPIN:
+      progress = (dR-dL)/2;
+      break;
+    case DRV_MOTION_HOLD:
+    default:
+      return motion->amount-(int32_t)((xTaskGetTickCount()-DRV_MotionState.startTicks)*portTICK_PERIOD_MS);
+  }
+  if (motion->amount<0) {
+    return -motion->amount+progress;
+  }
+  return motion->amount-progress;
+}
+
+/*!
+ * \brief Executes the queued motion primitives. Sets the twist values which are then used by the twist mode.
+ */
+static void DRV_MotionStep(void) {
+  DRV_Motion *curr = &DRV_MotionState.curr;
+  DRV_Motion next;
+  int32_t posL, posR, remaining, speed;
+  bool hasNext;
+
+  for(;;) { /* breaks */
+    posL = (int32_t)Q4CLeft_GetPos();
+    posR = (int32_t)Q4CRight_GetPos();
+    FRTOS1_taskENTER_CRITICAL();
+    if (DRV_MotionState.abort) {
+      DRV_MotionState.abort = FALSE;
+      DRV_MotionState.active = FALSE;
+    }
+    if (!DRV_MotionState.active && FRTOS1_xQueuePeek(DRV_MotionQueue, curr, 0)==pdPASS) {
+      DRV_MotionState.active = TRUE; /* mark active before removing it from the queue */
+      (void)FRTOS1_xQueueReceive(DRV_MotionQueue, curr, 0);
+      DRV_MotionState.startL = posL;
+      DRV_MotionState.startR = posR;
+      DRV_MotionState.startTicks = xTaskGetTickCount();
+    }
+    FRTOS1_taskEXIT_CRITICAL();
+    if (!DRV_MotionState.active) { /* nothing to do: come to a stop */
+      DRV_Status.twist.v = 0;
+      DRV_Status.twist.omega = 0;
+      return;
+    }
+    remaining = DRV_MotionRemaining(curr, posL, posR);
+    if (remaining>0) {
+      break; /* still in progress */
+    }
+    DRV_MotionState.active = FALSE; /* done, continue with next one */
+    if (curr->done!=NULL) {
+      curr->done(curr->arg);
+    }
+  } /* for */
+  if (curr->kind==DRV_MOTION_HOLD) {
+    DRV_Status.twist.v = curr->speed;
+    DRV_Status.twist.omega = curr->param;
+    return;
+  }
+  hasNext = FRTOS1_xQueuePeek(DRV_MotionQueue, &next, 0)==pdPASS;
+  speed = DRV_MotionPathSpeed(curr->speed, DRV_MotionExitSpeed(curr, hasNext?&next:NULL), DRV_MotionAccel(curr), remaining);
+  if (curr->amount<0) {
+    speed = -speed;
+  }
+  if (curr->kind==DRV_MOTION_SPIN) {
+    int32_t base = DRV_GetWheelBaseTicks();
+
+    DRV_Status.twist.v = 0;
+    DRV_Status.twist.omega = base>0?(int32_t)(((int64_t)speed*2000)/base):0;
+  } else if (curr->kind==DRV_MOTION_ARC) {
+    DRV_Status.twist.v = speed;
+    DRV_Status.twist.omega = (int32_t)(((int64_t)speed*1000)/curr->param);
+  } else {
+    DRV_Status.twist.v = speed;
+    DRV_Status.twist.omega = 0;
+  }
+}
+
+static void DRV_TwistStep(void) {
+  DRV_Twist.v = DRV_Ramp(DRV_Twist.v, DRV_Status.twist.v, DRV_Twist.accelV);
+  DRV_Twist.omega = DRV_Ramp(DRV_Twist.omega, DRV_Status.twist.omega, DRV_Twist.accelOmega);
+  DRV_TwistToWheels(DRV_Twist.v, DRV_Twist.omega, &DRV_Status.speed.left, &DRV_Status.speed.right);
+  PID_Speed(TACHO_GetSpeed(TRUE), DRV_Status.speed.left, TRUE);
+  PID_Speed(TACHO_GetSpeed(FALSE), DRV_Status.speed.right, FALSE);
+}
+
+#if PL_CONFIG_HAS_SHELL
+/*!
+ * \brief Estimates the time for a primitive with a trapezoid speed profile.
+ */
+static int32_t DRV_TrapezoidMs(int32_t dist, int32_t v0, int32_t v1, int32_t vMax, int32_t accel) {
+  int64_t dAcc, dDec, vPeak;
+
+  if (v0>vMax) {
+    v0 = vMax;
+  }
+  dAcc = ((int64_t)vMax*vMax-(int64_t)v0*v0)/(2*accel);
+  dDec = ((int64_t)vMax*vMax-(int64_t)v1*v1)/(2*accel);
+  if (dAcc+dDec<=dist) { /* reaching maximum speed */
+    return (int32_t)(((int64_t)(2*vMax-v0-v1)*1000)/accel + ((dist-dAcc-dDec)*1000)/vMax);
+  }
+  vPeak = DRV_Sqrt32((uint32_t)((2*(int64_t)accel*dist+(int64_t)v0*v0+(int64_t)v1*v1)/2));
+  return (int32_t)(((2*vPeak-v0-v1)*1000)/accel);
+}
+
+/*!
+ * \brief Estimates the time needed for a sequence of primitives, assuming the wheels follow the commanded speed.
+ * \param seq Sequence of primitives
+ * \param nof Number of primitives
+ * \param blended If TRUE, the primitives are blended as in the drive task, otherwise the robot stops after each primitive.
+ * \return Time in milliseconds
+ */
+static int32_t DRV_MotionEstimateMs(const DRV_Motion *seq, size_t nof, bool blended) {
+  int32_t ms = 0, entry, exit, dist;
+  size_t i;
+
+  for(i=0;i<nof;i++) {
+    if (seq[i].kind==DRV_MOTION_HOLD) {
+      ms += seq[i].amount;
+      continue;
+    }
+    entry = (blended && i>0)?DRV_MotionExitSpeed(&seq[i-1], &seq[i]):0;
+    exit = blended?DRV_MotionExitSpeed(&seq[i], i+1<nof?&seq[i+1]:NULL):0;
+    dist = seq[i].amount<0?-seq[i].amount:seq[i].amount;
+    ms += DRV_TrapezoidMs(dist, entry, exit, seq[i].speed, DRV_MotionAccel(&seq[i]));
+  }
+  return ms;
+}
+
+static void DRV_MotionBench(const CLS1_StdIOType *io) {
+  /* fixed sequence as used in a maze replay: straight, left turn, straight, arc, straight */
+  static const DRV_Motion seq[] = {
+    {DRV_MOTION_STRAIGHT, 1500, 2000, 0,   NULL, NULL},
+    {DRV_MOTION_STRAIGHT, 1000, 1500, 0,   NULL, NULL},
+    {DRV_MOTION_SPIN,     700,  1000, 0,   NULL, NULL},
+    {DRV_MOTION_STRAIGHT, 1500, 2000, 0,   NULL, NULL},
+    {DRV_MOTION_ARC,      1100, 1500, 700, NULL, NULL},
+    {DRV_MOTION_STRAIGHT, 1000, 2000, 0,   NULL, NULL},
+  };
+  uint8_t buf[32];
+
+  UTIL1_Num32sToStr(buf, sizeof(buf), DRV_MotionEstimateMs(seq, sizeof(seq)/sizeof(seq[0]), FALSE));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  stop and go", buf, io->stdOut);
+  UTIL1_Num32sToStr(buf, sizeof(buf), DRV_MotionEstimateMs(seq, sizeof(seq)/sizeof(seq[0]), TRUE));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  blended", buf, io->stdOut);
+}
+
+static uint8_t *DRV_GetMotionKindStr(DRV_MotionKind kind) {
+  switch(kind) {
+    case DRV_MOTION_STRAIGHT: return (uint8_t*)"STRAIGHT";
+    case DRV_MOTION_ARC:      return (uint8_t*)"ARC";
+    case DRV_MOTION_SPIN:     return (uint8_t*)"SPIN";
+    case DRV_MOTION_HOLD:     return (uint8_t*)"HOLD";
+    default: return (uint8_t*)"UNKNOWN";
+  }
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
 #if PL_CONFIG_HAS_SHELL
 static uint8_t *DRV_GetModeStr(DRV_Mode mode) {
   switch(mode) {
@@ -181,6 +685,8 @@ static uint8_t *DRV_GetModeStr(DRV_Mode mode) {
     case DRV_MODE_STOP:   return (uint8_t*)"STOP";
     case DRV_MODE_SPEED:  return (uint8_t*)"SPEED";
     case DRV_MODE_POS:    return (uint8_t*)"POS";
+    case DRV_MODE_TWIST:  return (uint8_t*)"TWIST";
+    case DRV_MODE_MOTION: return (uint8_t*)"MOTION";
     default: return (uint8_t*)"UNKNOWN";
   }
 }
@@ -188,10 +694,18 @@ static uint8_t *DRV_GetModeStr(DRV_Mode mode) {
 static void DRV_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"drive", (unsigned char*)"Group of drive commands\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows drive help or status\r\n", io->stdOut);
-  CLS1_SendHelpStr((unsigned char*)"  mode <mode>", (unsigned char*)"Set driving mode (none|stop|speed|pos)\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  mode <mode>", (unsigned char*)"Set driving mode (none|stop|speed|pos|twist|motion)\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  speed <left> <right>", (unsigned char*)"Move left and right motors with given speed\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  pos <left> <right>", (unsigned char*)"Move left and right wheels to given position\r\n", io->stdOut);
-  CLS1_SendHelpStr((unsigned char*)"  pos reset", (unsigned char*)"Reset drive and wheel position\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  pos reset", (unsigned char*)"Reset drive and wheel position, and the odometry pose\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  twist <v> <w>", (unsigned char*)"Drive with linear speed (steps/sec) and angular speed (mrad/sec)\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  accel <v> <w>", (unsigned char*)"Set twist acceleration limits (steps/sec^2, mrad/sec^2)\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  motion straight <d> <s>", (unsigned char*)"Queue straight move of d steps with speed s\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  motion arc <d> <r> <s>", (unsigned char*)"Queue arc of d steps with radius r and speed s\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  motion spin <d> <s>", (unsigned char*)"Queue turn on the spot with d wheel steps and speed s\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  motion hold <v> <w> <ms>", (unsigned char*)"Queue driving with twist for a given time\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  motion flush", (unsigned char*)"Remove all queued motion primitives\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  motion bench", (unsigned char*)"Estimate time of a fixed sequence, stop and go vs. blended\r\n", io->stdOut);
 }
 
 static void DRV_PrintStatus(const CLS1_StdIOType *io) {
@@ -225,12 +739,49 @@ static void DRV_PrintStatus(const CLS1_StdIOType *io) {
   UTIL1_strcatNum32s(buf, sizeof(buf), (int32_t)Q4CRight_GetPos());
   UTIL1_strcat(buf, sizeof(buf), (unsigned char*)")\r\n");
   CLS1_SendStatusStr((unsigned char*)"  pos right", buf, io->stdOut);
+
+  UTIL1_Num32sToStr(buf, sizeof(buf), DRV_Status.twist.v);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps/sec (curr: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), DRV_Twist.v);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)")\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  twist v", buf, io->stdOut);
+
+  UTIL1_Num32sToStr(buf, sizeof(buf), DRV_Status.twist.omega);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mrad/sec (curr: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), DRV_Twist.omega);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)")\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  twist w", buf, io->stdOut);
+
+  UTIL1_Num32sToStr(buf, sizeof(buf), DRV_Twist.accelV);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps/sec^2, ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), DRV_Twist.accelOmega);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mrad/sec^2\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  twist accel", buf, io->stdOut);
+
+  if (DRV_MotionState.active) {
+    UTIL1_strcpy(buf, sizeof(buf), DRV_GetMotionKindStr(DRV_MotionState.curr.kind));
+  } else {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"idle");
+  }
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", queued: ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), FRTOS1_uxQueueMessagesWaiting(DRV_MotionQueue));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  motion", buf, io->stdOut);
+
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"L: ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), DRV_Slip.left.count);
+  UTIL1_strcat(buf, sizeof(buf), DRV_Slip.left.holdMs>0?(unsigned char*)" (slipping)":(unsigned char*)"");
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", R: ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), DRV_Slip.right.count);
+  UTIL1_strcat(buf, sizeof(buf), DRV_Slip.right.holdMs>0?(unsigned char*)" (slipping)":(unsigned char*)"");
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  slip events", buf, io->stdOut);
 }
 
 uint8_t DRV_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
   uint8_t res = ERR_OK;
   const unsigned char *p;
-  int32_t val1, val2;
+  int32_t val1, val2, val3;
 
   if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"drive help")==0) {
     DRV_PrintHelp(io);
@@ -256,6 +807,9 @@ uint8_t DRV_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_Std
   } else if (UTIL1_strncmp((char*)cmd, (char*)"drive pos reset", sizeof("drive pos reset")-1)==0) {
     Q4CLeft_SetPos(0);
     Q4CRight_SetPos(0);
+#if PL_CONFIG_HAS_ODOMETRY
+    ODO_ResetPose(); /* the jump of the counters is not a movement: the next update starts again from zero */
+#endif
     if (DRV_SetPos(0, 0)!=ERR_OK) {
       CLS1_SendStr((unsigned char*)"failed\r\n", io->stdErr);
     }
@@ -275,6 +829,77 @@ uint8_t DRV_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_Std
       CLS1_SendStr((unsigned char*)"Wrong argument(s)\r\n", io->stdErr);
       res = ERR_FAILED;
     }
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"drive twist ", sizeof("drive twist ")-1)==0) {
+    p = cmd+sizeof("drive twist");
+    if (UTIL1_xatoi(&p, &val1)==ERR_OK && UTIL1_xatoi(&p, &val2)==ERR_OK) {
+      if (DRV_SetTwist(val1, val2)!=ERR_OK) {
+        CLS1_SendStr((unsigned char*)"failed\r\n", io->stdErr);
+      }
+      *handled = TRUE;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument(s)\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"drive accel ", sizeof("drive accel ")-1)==0) {
+    p = cmd+sizeof("drive accel");
+    if (UTIL1_xatoi(&p, &val1)==ERR_OK && UTIL1_xatoi(&p, &val2)==ERR_OK && val1>0 && val2>0) {
+      DRV_Twist.accelV = val1;
+      DRV_Twist.accelOmega = val2;
+      *handled = TRUE;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument(s)\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"drive motion straight ", sizeof("drive motion straight ")-1)==0) {
+    p = cmd+sizeof("drive motion straight");
+    if (UTIL1_xatoi(&p, &val1)==ERR_OK && UTIL1_xatoi(&p, &val2)==ERR_OK) {
+      if (DRV_MotionStraight(val1, val2, NULL, NULL)!=ERR_OK) {
+        CLS1_SendStr((unsigned char*)"failed\r\n", io->stdErr);
+      }
+      *handled = TRUE;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument(s)\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"drive motion arc ", sizeof("drive motion arc ")-1)==0) {
+    p = cmd+sizeof("drive motion arc");
+    if (UTIL1_xatoi(&p, &val1)==ERR_OK && UTIL1_xatoi(&p, &val2)==ERR_OK && UTIL1_xatoi(&p, &val3)==ERR_OK) {
+      if (DRV_MotionArc(val1, val2, val3, NULL, NULL)!=ERR_OK) {
+        CLS1_SendStr((unsigned char*)"failed\r\n", io->stdErr);
+      }
+      *handled = TRUE;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument(s)\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"drive motion spin ", sizeof("drive motion spin ")-1)==0) {
+    p = cmd+sizeof("drive motion spin");
+    if (UTIL1_xatoi(&p, &val1)==ERR_OK && UTIL1_xatoi(&p, &val2)==ERR_OK) {
+      if (DRV_MotionSpin(val1, val2, NULL, NULL)!=ERR_OK) {
+        CLS1_SendStr((unsigned char*)"failed\r\n", io->stdErr);
+      }
+      *handled = TRUE;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument(s)\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"drive motion hold ", sizeof("drive motion hold ")-1)==0) {
+    p = cmd+sizeof("drive motion hold");
+    if (UTIL1_xatoi(&p, &val1)==ERR_OK && UTIL1_xatoi(&p, &val2)==ERR_OK && UTIL1_xatoi(&p, &val3)==ERR_OK) {
+      if (DRV_MotionHold(val1, val2, val3, NULL, NULL)!=ERR_OK) {
+        CLS1_SendStr((unsigned char*)"failed\r\n", io->stdErr);
+      }
+      *handled = TRUE;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument(s)\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"drive motion flush")==0) {
+    (void)DRV_MotionFlush();
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"drive motion bench")==0) {
+    DRV_MotionBench(io);
+    *handled = TRUE;
   } else if (UTIL1_strncmp((char*)cmd, (char*)"drive mode ", sizeof("drive mode ")-1)==0) {
     p = cmd+sizeof("drive mode");
     if (UTIL1_strcmp((char*)p, (char*)"none")==0) {
@@ -293,6 +918,14 @@ uint8_t DRV_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_Std
       if (DRV_SetMode(DRV_MODE_POS)!=ERR_OK) {
         res = ERR_FAILED;
       }
+    } else if (UTIL1_strcmp((char*)p, (char*)"twist")==0) {
+      if (DRV_SetMode(DRV_MODE_TWIST)!=ERR_OK) {
+        res = ERR_FAILED;
+      }
+    } else if (UTIL1_strcmp((char*)p, (char*)"motion")==0) {
+      if (DRV_SetMode(DRV_MODE_MOTION)!=ERR_OK) {
+        res = ERR_FAILED;
+      }
     } else {
       res = ERR_FAILED;
     }
@@ -317,6 +950,18 @@ static uint8_t GetCmd(void) {
   FRTOS1_taskENTER_CRITICAL();
   if (cmd.cmd==DRV_SET_MODE) {
     PID_Start(); /* reset PID, especially integral counters */
+    if ((cmd.u.mode==DRV_MODE_TWIST || cmd.u.mode==DRV_MODE_MOTION)
+        && DRV_Status.mode!=DRV_MODE_TWIST && DRV_Status.mode!=DRV_MODE_MOTION)
+    {
+      /* start ramping from the current movement */
+      int32_t speedL, speedR, base;
+
+      speedL = TACHO_GetSpeed(TRUE);
+      speedR = TACHO_GetSpeed(FALSE);
+      base = DRV_GetWheelBaseTicks();
+      DRV_Twist.v = (speedL+speedR)/2;
+      DRV_Twist.omega = base>0?(int32_t)(((int64_t)(speedR-speedL)*1000)/base):0;
+    }
     DRV_Status.mode = cmd.u.mode;
   } else if (cmd.cmd==DRV_SET_SPEED) {
     DRV_Status.speed.left = cmd.u.speed.left;
@@ -324,11 +969,118 @@ static uint8_t GetCmd(void) {
   } else if (cmd.cmd==DRV_SET_POS) {
     DRV_Status.pos.left = cmd.u.pos.left;
     DRV_Status.pos.right = cmd.u.pos.right;
+  } else if (cmd.cmd==DRV_SET_TWIST) {
+    DRV_Status.twist.v = cmd.u.twist.v;
+    DRV_Status.twist.omega = cmd.u.twist.omega;
   }
   FRTOS1_taskEXIT_CRITICAL();
   return ERR_OK;
 }
 
+/*!
+ * \brief Updates the position history of a wheel and returns the acceleration.
+ * \return Acceleration in steps/sec^2
+ */
+static int32_t DRV_SlipSample(DRV_SlipWheel *wheel, int32_t pos) {
+  int32_t p0, p1, p2;
+
+  wheel->pos[DRV_Slip.idx] = pos;
+  p0 = pos; /* newest */
+  p1 = wheel->pos[(DRV_Slip.idx+DRV_SLIP_HISTORY-DRV_SLIP_WINDOW)%DRV_SLIP_HISTORY]; /* one window ago */
+  p2 = wheel->pos[(DRV_Slip.idx+1)%DRV_SLIP_HISTORY]; /* oldest, two windows ago */
+  wheel->speed = ((p0-p1)*1000)/(DRV_SLIP_WINDOW*DRV_TASK_PERIOD_MS);
+  /* second difference over the window time squared */
+  return (int32_t)(((int64_t)(p0-2*p1+p2)*1000000)/((DRV_SLIP_WINDOW*DRV_TASK_PERIOD_MS)*(DRV_SLIP_WINDOW*DRV_TASK_PERIOD_MS)));
+}
+
+static void DRV_SlipHandle(DRV_SlipWheel *wheel, MOT_MotorSide side, bool slip) {
+  if (slip) {
+    if (wheel->holdMs==0) { /* new slip event */
+      wheel->count++;
+      MOT_SetSlewLimit(MOT_GetMotorHandle(side), DRV_SLIP_PWM_SLEW);
+    }
+    wheel->holdMs = DRV_SLIP_HOLD_MS;
+  } else if (wheel->holdMs>0) {
+    wheel->holdMs -= DRV_TASK_PERIOD_MS;
+    if (wheel->holdMs<=0) {
+      wheel->holdMs = 0;
+      MOT_SetSlewLimit(MOT_GetMotorHandle(side), 0); /* traction is back */
+    }
+  }
+}
+
+static bool DRV_IsDrivingStraight(void) {
+  if (DRV_Status.mode==DRV_MODE_SPEED) {
+    return DRV_Status.speed.left==DRV_Status.speed.right && DRV_Status.speed.left!=0;
+  } else if (DRV_Status.mode==DRV_MODE_TWIST || DRV_Status.mode==DRV_MODE_MOTION) {
+    return DRV_Twist.omega==0 && DRV_Twist.v!=0;
+  }
+  return FALSE;
+}
+
+/*!
+ * \brief Detects wheel slip: the wheel acceleration is not physically possible, or the wheels run with different speed
+ * while they should drive straight. While slipping, the PWM slew rate of the motor is limited.
+ */
+static void DRV_CheckSlip(void) {
+  int32_t accelL, accelR, diff, limit;
+  bool slipL, slipR;
+
+  DRV_Slip.idx++;
+  if (DRV_Slip.idx>=DRV_SLIP_HISTORY) {
+    DRV_Slip.idx = 0;
+  }
+  accelL = DRV_SlipSample(&DRV_Slip.left, (int32_t)Q4CLeft_GetPos());
+  accelR = DRV_SlipSample(&DRV_Slip.right, (int32_t)Q4CRight_GetPos());
+  if (DRV_Slip.nofSamples<DRV_SLIP_HISTORY) {
+    DRV_Slip.nofSamples++;
+    return; /* not enough history yet */
+  }
+  slipL = accelL>DRV_SLIP_MAX_ACCEL || accelL<-DRV_SLIP_MAX_ACCEL;
+  slipR = accelR>DRV_SLIP_MAX_ACCEL || accelR<-DRV_SLIP_MAX_ACCEL;
+  if (DRV_IsDrivingStraight()) {
+    diff = DRV_Slip.left.speed-DRV_Slip.right.speed;
+    limit = (DRV_Slip.left.speed+DRV_Slip.right.speed)/8; /* allow about 25% difference */
+    if (limit<0) {
+      limit = -limit;
+    }
+    if (limit<DRV_SLIP_MIN_SPEED_DIFF) {
+      limit = DRV_SLIP_MIN_SPEED_DIFF;
+    }
+    if (diff>limit || diff<-limit) { /* the faster wheel is spinning */
+      if ((DRV_Slip.left.speed+DRV_Slip.right.speed>=0) == (diff>0)) { /* left wheel is faster in driving direction */
+        slipL = TRUE;
+      } else {
+        slipR = TRUE;
+      }
+    }
+  }
+  DRV_SlipHandle(&DRV_Slip.left, MOT_MOTOR_LEFT, slipL);
+  DRV_SlipHandle(&DRV_Slip.right, MOT_MOTOR_RIGHT, slipR);
+}
+
+/*!
+ * \brief Updates the event group bits, so waiting tasks do not need to poll.
+ */
+static void DRV_UpdateEvents(void) {
+  EventBits_t bits = 0;
+
+  if (DRV_HasTurned()) {
+    bits |= DRV_EVENT_POS_REACHED;
+  }
+  if (DRV_IsStopped()) {
+    bits |= DRV_EVENT_STOPPED;
+  }
+  if ((xEventGroupGetBits(DRV_EventGroup)&DRV_EVENT_ALL)!=bits) {
+    if (bits!=0) {
+      (void)xEventGroupSetBits(DRV_EventGroup, bits);
+    }
+    if ((~bits)&DRV_EVENT_ALL) {
+      (void)xEventGroupClearBits(DRV_EventGroup, (~bits)&DRV_EVENT_ALL);
+    }
+  }
+}
+
 static void DriveTask(void *pvParameters) {
   portTickType xLastWakeTime;
 
@@ -339,6 +1091,10 @@ static void DriveTask(void *pvParameters) {
       /* process incoming commands */
     }
     TACHO_CalcSpeed();
+#if PL_CONFIG_HAS_ODOMETRY
+    ODO_Update(); /* integrate pose with the drive loop rate */
+#endif
+    DRV_CheckSlip();
     if (DRV_Status.mode==DRV_MODE_SPEED) {
       PID_Speed(TACHO_GetSpeed(TRUE), DRV_Status.speed.left, TRUE);
       PID_Speed(TACHO_GetSpeed(FALSE), DRV_Status.speed.right, FALSE);
@@ -348,14 +1104,25 @@ static void DriveTask(void *pvParameters) {
     } else if (DRV_Status.mode==DRV_MODE_POS) {
       PID_Pos(Q4CLeft_GetPos(), DRV_Status.pos.left, TRUE);
       PID_Pos(Q4CRight_GetPos(), DRV_Status.pos.right, FALSE);
+    } else if (DRV_Status.mode==DRV_MODE_TWIST) {
+      DRV_TwistStep();
+    } else if (DRV_Status.mode==DRV_MODE_MOTION) {
+      DRV_MotionStep(); /* sets twist from the motion primitives */
+      DRV_TwistStep();
     } else if (DRV_Status.mode==DRV_MODE_NONE) {
       /* do nothing */
     }
-    FRTOS1_vTaskDelayUntil(&xLastWakeTime, 5/portTICK_PERIOD_MS);
+    if (DRV_Status.mode!=DRV_MODE_NONE) { /* in DRV_MODE_NONE the motors belong to somebody else, e.g. the line following which commits its own values */
+      MOT_CommitStaged(); /* apply the PID values of both motors in the same PWM period */
+    }
+    DRV_UpdateEvents();
+    FRTOS1_vTaskDelayUntil(&xLastWakeTime, DRV_TASK_PERIOD_MS/portTICK_PERIOD_MS);
   } /* for */
 }
 
 void DRV_Deinit(void) {
+  vEventGroupDelete(DRV_EventGroup);
+  FRTOS1_vQueueDelete(DRV_MotionQueue);
   FRTOS1_vQueueDelete(DRV_Queue);
 }
 
@@ -365,12 +1132,35 @@ void DRV_Init(void) {
   DRV_Status.speed.right = 0;
   DRV_Status.pos.left = 0;
   DRV_Status.pos.right = 0;
+  DRV_Status.twist.v = 0;
+  DRV_Status.twist.omega = 0;
+  DRV_Twist.v = 0;
+  DRV_Twist.omega = 0;
+  DRV_Twist.accelV = DRV_TWIST_DEFAULT_ACCEL_V;
+  DRV_Twist.accelOmega = DRV_TWIST_DEFAULT_ACCEL_OMEGA;
+  DRV_Slip.idx = 0;
+  DRV_Slip.nofSamples = 0;
+  DRV_Slip.left.holdMs = 0;
+  DRV_Slip.left.count = 0;
+  DRV_Slip.right.holdMs = 0;
+  DRV_Slip.right.count = 0;
   DRV_Queue = FRTOS1_xQueueCreate(QUEUE_LENGTH, QUEUE_ITEM_SIZE);
   if (DRV_Queue==NULL) {
     for(;;){} /* out of memory? */
   }
   FRTOS1_vQueueAddToRegistry(DRV_Queue, "Drive");
-  if (xTaskCreate(DriveTask, "Drive", 400/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+3, NULL) != pdPASS) {
+  DRV_MotionState.active = FALSE;
+  DRV_MotionState.abort = FALSE;
+  DRV_MotionQueue = FRTOS1_xQueueCreate(DRV_MOTION_QUEUE_LENGTH, sizeof(DRV_Motion));
+  if (DRV_MotionQueue==NULL) {
+    for(;;){} /* out of memory? */
+  }
+  FRTOS1_vQueueAddToRegistry(DRV_MotionQueue, "Motion");
+  DRV_EventGroup = xEventGroupCreate();
+  if (DRV_EventGroup==NULL) {
+    for(;;){} /* out of memory? */
+  }
+  if (xTaskCreate(DriveTask, "Drive", 500/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+3, NULL) != pdPASS) {
     for(;;){} /* error */
   }
 }
@@ -30,16 +30,115 @@ typedef enum {
   DRV_MODE_STOP,
   DRV_MODE_SPEED,
   DRV_MODE_POS,
+  DRV_MODE_TWIST,
+  DRV_MODE_MOTION,
 } DRV_Mode;
 
+/*!
+ * \brief Callback called from the drive task when a motion primitive has been completed.
+ * Keep it short and do not block in it.
+ * \param arg Argument passed when the primitive was queued
+ */
+typedef void (*DRV_MotionDoneFct)(void *arg);
+
 uint8_t DRV_SetSpeed(int32_t left, int32_t right);
 uint8_t DRV_SetPos(int32_t left, int32_t right);
+
+/*!
+ * \brief Sets the linear and angular velocity used in DRV_MODE_TWIST.
+ * The values are converted into wheel speeds using the acceleration limits. If a wheel would saturate, the angular velocity has priority over the linear one.
+ * \param v Linear velocity in steps/sec, positive is forward
+ * \param omega Angular velocity in milli-radians/sec, positive is counter-clockwise (left turn)
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t DRV_SetTwist(int32_t v, int32_t omega);
+
+/*!
+ * \brief Queues a straight move, executed in DRV_MODE_MOTION.
+ * Queued primitives are executed back-to-back: the speed at the end of a primitive is matched to the next one instead of stopping.
+ * \param distTicks Distance in encoder ticks, negative for backward
+ * \param speed Maximum speed in steps/sec
+ * \param done Callback called after completion, or NULL
+ * \param arg Argument passed to the callback
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t DRV_MotionStraight(int32_t distTicks, int32_t speed, DRV_MotionDoneFct done, void *arg);
+
+/*!
+ * \brief Queues an arc move, executed in DRV_MODE_MOTION.
+ * \param distTicks Distance of the robot center on the arc in encoder ticks, negative for backward
+ * \param radiusTicks Radius of the arc in encoder ticks, positive is a left (counter-clockwise) arc
+ * \param speed Maximum speed of the robot center in steps/sec
+ * \param done Callback called after completion, or NULL
+ * \param arg Argument passed to the callback
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t DRV_MotionArc(int32_t distTicks, int32_t radiusTicks, int32_t speed, DRV_MotionDoneFct done, void *arg);
+
+/*!
+ * \brief Queues a turn on the spot, executed in DRV_MODE_MOTION.
+ * \param wheelTicks Number of encoder ticks each wheel has to move, positive is counter-clockwise (left turn)
+ * \param speed Maximum wheel speed in steps/sec
+ * \param done Callback called after completion, or NULL
+ * \param arg Argument passed to the callback
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t DRV_MotionSpin(int32_t wheelTicks, int32_t speed, DRV_MotionDoneFct done, void *arg);
+
+/*!
+ * \brief Queues driving with a constant twist for a given time, executed in DRV_MODE_MOTION.
+ * \param v Linear velocity in steps/sec
+ * \param omega Angular velocity in milli-radians/sec
+ * \param timeMs Time in milliseconds
+ * \param done Callback called after completion, or NULL
+ * \param arg Argument passed to the callback
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t DRV_MotionHold(int32_t v, int32_t omega, int32_t timeMs, DRV_MotionDoneFct done, void *arg);
+
+/*!
+ * \brief Removes all queued motion primitives including the active one. No callbacks are called for them.
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t DRV_MotionFlush(void);
+
+/*!
+ * \brief Checks if all queued motion primitives have been completed.
+ * \return TRUE if there is no pending or active primitive
+ */
+bool DRV_MotionIsIdle(void);
 bool DRV_IsDrivingBackward(void);
 uint8_t DRV_SetMode(DRV_Mode mode);
 DRV_Mode DRV_GetMode(void);
 bool DRV_IsStopped(void);
 bool DRV_HasTurned(void);
 
+/*! \brief Result of waiting for a drive target */
+typedef enum {
+  DRV_WAIT_REACHED, /* target reached */
+  DRV_WAIT_TIMEOUT, /* timeout while waiting */
+  DRV_WAIT_ABORTED, /* aborted by the stop function */
+} DRV_WaitResult;
+
+/*! \brief Callback type function to abort waiting */
+typedef bool (*DRV_StopFct)(void);
+
+/*!
+ * \brief Blocks until the drive task has reached the target position set with DRV_SetPos().
+ * \param timeoutMs Timeout in milliseconds
+ * \param stopIt Callback to abort waiting, or NULL
+ * \return Result of waiting
+ */
+DRV_WaitResult DRV_WaitPosReached(int32_t timeoutMs, DRV_StopFct stopIt);
+
+/*!
+ * \brief Blocks until the drive task reports that the robot is stopped.
+ * \param timeoutMs Timeout in milliseconds
+ * \param stopIt Callback to abort waiting, or NULL
+ * \return Result of waiting
+ */
+DRV_WaitResult DRV_WaitStopped(int32_t timeoutMs, DRV_StopFct stopIt);
+
 /*!
  * \brief Stops the engines
  * \param timoutMs timout in milliseconds for operation
@@ -6,92 +6,515 @@
  * This module implements a generic event driver. We are using numbered events starting with zero.
  * EVNT_HandleEvent() can be used to process the pending events. Note that the event with the number zero
  * has the highest priority and will be handled first.
- * \todo Make this module reentrant and thread safe!
+ * The event flags are changed with atomic read-modify-write operations, so events can be set and cleared
+ * from tasks and interrupts without a critical section.
+ * Posted events are stored in a ring buffer, protected by a short critical section so it can be used from interrupts.
+ * EVNT_DispatchQueue() passes them to the subscriber table.
  */
 
 #include "Platform.h"
 #if PL_CONFIG_HAS_EVENTS
 #include "Event.h" /* our own interface */
 #include "CS1.h"
+#include "FRTOS1.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "UTIL1.h"
+  #include "KIN1.h" /* cycle counter for the benchmark */
+#endif
+
+/* Atomic update of the event flags:
+ * - ARMv7-M (Cortex-M3/M4): exclusive load/store (LDREX/STREX), retried if the access was interrupted.
+ * - other GCC targets (e.g. the host): GCC atomic builtins.
+ * - else (e.g. Cortex-M0+ without exclusive access): short critical section.
+ */
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+  #define EVNT_ATOMIC_LDREX    1
+#elif defined(__GNUC__) && !defined(__arm__)
+  #define EVNT_ATOMIC_BUILTIN  1
+#else
+  #define EVNT_ATOMIC_CRITICAL 1
+#endif
 
 typedef uint32_t EVNT_MemUnit; /*!< memory unit used to store events flags */
 #define EVNT_MEM_UNIT_NOF_BITS  (sizeof(EVNT_MemUnit)*8u)
   /*!< number of bits in memory unit */
+#define EVNT_NOF_MEM_UNITS      (((EVNT_NOF_EVENTS-1)/EVNT_MEM_UNIT_NOF_BITS)+1)
+  /*!< number of memory units for all events */
 
-static EVNT_MemUnit EVNT_Events[((EVNT_NOF_EVENTS-1)/EVNT_MEM_UNIT_NOF_BITS)+1]; /*!< Bit set of events */
+static volatile EVNT_MemUnit EVNT_Events[EVNT_NOF_MEM_UNITS]; /*!< Bit set of events, event zero is the most significant bit of the first unit */
 
-#define SET_EVENT(event) \
-  EVNT_Events[(event)/EVNT_MEM_UNIT_NOF_BITS] |= (1u<<(EVNT_MEM_UNIT_NOF_BITS-1))>>(((event)%EVNT_MEM_UNIT_NOF_BITS)) /*!< Set the event */
-#define CLR_EVENT(event) \
-  EVNT_Events[(event)/EVNT_MEM_UNIT_NOF_BITS] &= ~((1u<<(EVNT_MEM_UNIT_NOF_BITS-1))>>(((event)%EVNT_MEM_UNIT_NOF_BITS))) /*!< Clear the event */
-#define GET_EVENT(event) \
-  (EVNT_Events[(event)/EVNT_MEM_UNIT_NOF_BITS]&(((1u<<(EVNT_MEM_UNIT_NOF_BITS-1))>>(((event)%EVNT_MEM_UNIT_NOF_BITS))))) /*!< Return TRUE if event is set */
+#define EVENT_MASK(event) \
+  ((1u<<(EVNT_MEM_UNIT_NOF_BITS-1))>>(((event)%EVNT_MEM_UNIT_NOF_BITS))) /*!< Bit of the event in its memory unit */
 
-void EVNT_SetEvent(EVNT_Handle event) {
+#if defined(__GNUC__)
+  #define EVNT_CLZ(val)  ((unsigned)__builtin_clz(val)) /* CLZ instruction on ARMv7-M, val must not be zero */
+#else
+static unsigned EVNT_CLZ(EVNT_MemUnit val) {
+  unsigned n = 0;
+
+  while((val&(1u<<(EVNT_MEM_UNIT_NOF_BITS-1)))==0) {
+    val <<= 1;
+    n++;
+  }
+  return n;
+}
+#endif
+
+/*!
+ * \brief Atomically replaces a memory unit with (value&andMask)|orMask.
+ * \param unit Memory unit
+ * \param andMask Bits to keep
+ * \param orMask Bits to set
+ * \return Value before the update
+ */
+static EVNT_MemUnit EVNT_AtomicUpdate(volatile EVNT_MemUnit *unit, EVNT_MemUnit andMask, EVNT_MemUnit orMask) {
+  EVNT_MemUnit old;
+#if EVNT_ATOMIC_LDREX
+  uint32_t val, failed;
+
+  /* one asm block: the compiler must not put memory accesses between LDREX and STREX, they could clear the exclusive monitor */
+  __asm volatile(
+    "1: ldrex %0, [%3]    \n"
+    "   and   %1, %0, %4  \n"
+    "   orr   %1, %1, %5  \n"
+    "   strex %2, %1, [%3]\n"
+    "   cmp   %2, #0      \n"
+    "   bne   1b          \n" /* interrupted between LDREX and STREX: try again */
+    : "=&r" (old), "=&r" (val), "=&r" (failed)
+    : "r" (unit), "r" (andMask), "r" (orMask)
+    : "cc", "memory");
+#elif EVNT_ATOMIC_BUILTIN
+  old = __atomic_load_n(unit, __ATOMIC_RELAXED);
+  while(!__atomic_compare_exchange_n(unit, &old, (old&andMask)|orMask, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    /* old has been updated with the current value, try again */
+  }
+#else
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  old = *unit;
+  *unit = (old&andMask)|orMask;
+  CS1_ExitCritical();
+#endif
+  return old;
+}
+
+/*!
+ * \brief Finds the pending event with the highest priority in a bit set.
+ * \param set Bit set of events
+ * \param clearEvent If TRUE, the event gets cleared
+ * \param[out] event Event found
+ * \return TRUE if an event is pending
+ */
+static bool EVNT_TakeFrom(volatile EVNT_MemUnit *set, bool clearEvent, EVNT_Handle *event) {
+  EVNT_MemUnit bits, mask;
+  unsigned i, bit;
+
+  for(i=0;i<EVNT_NOF_MEM_UNITS;i++) {
+    while((bits=set[i])!=0) {
+      bit = EVNT_CLZ(bits);
+      mask = (1u<<(EVNT_MEM_UNIT_NOF_BITS-1))>>bit;
+      if (!clearEvent || (EVNT_AtomicUpdate(&set[i], ~mask, 0)&mask)) { /* else somebody else has taken the event: look again */
+        *event = (EVNT_Handle)(i*EVNT_MEM_UNIT_NOF_BITS+bit);
+        return TRUE;
+      }
+    }
+  }
+  return FALSE;
+}
 
-  CS1_CriticalVariable()					// lokale Variable um vorherige Interrupt-settings zu speichern!
+/*!
+ * \brief Clears all pending events of a bit set and calls the callback for each of them, in the order of the priority.
+ * \param set Bit set of events
+ * \param callback Callback for each event
+ * \return Number of handled events
+ */
+static unsigned EVNT_DrainFrom(volatile EVNT_MemUnit *set, void (*callback)(EVNT_Handle)) {
+  EVNT_MemUnit pending;
+  unsigned i, bit, nof = 0;
+
+  for(i=0;i<EVNT_NOF_MEM_UNITS;i++) {
+    if (set[i]==0) {
+      continue;
+    }
+    pending = EVNT_AtomicUpdate(&set[i], 0, 0); /* take all events of this unit at once */
+    while(pending!=0) {
+      bit = EVNT_CLZ(pending);
+      pending &= ~((1u<<(EVNT_MEM_UNIT_NOF_BITS-1))>>bit);
+      callback((EVNT_Handle)(i*EVNT_MEM_UNIT_NOF_BITS+bit));
+      nof++;
+    }
+  }
+  return nof;
+}
 
-  CS1_EnterCritical();						// schaltet Interrupts aus und speichert aktuelle Interrupt-settings ab
-  SET_EVENT(event);
-  CS1_ExitCritical();						// ldt vorherig gespeicherte Interrupt-settings
+void EVNT_SetEvent(EVNT_Handle event) {
+  (void)EVNT_AtomicUpdate(&EVNT_Events[event/EVNT_MEM_UNIT_NOF_BITS], ~0u, EVENT_MASK(event));
 }
 
 void EVNT_ClearEvent(EVNT_Handle event) {
+  (void)EVNT_AtomicUpdate(&EVNT_Events[event/EVNT_MEM_UNIT_NOF_BITS], ~EVENT_MASK(event), 0);
+}
+
+bool EVNT_EventIsSet(EVNT_Handle event) {
+  return (EVNT_Events[event/EVNT_MEM_UNIT_NOF_BITS]&EVENT_MASK(event))!=0; /* reading a single unit is atomic */
+}
 
+bool EVNT_EventIsSetAutoClear(EVNT_Handle event) {
+  if (!EVNT_EventIsSet(event)) {
+    return FALSE; /* no need for a write */
+  }
+  return (EVNT_AtomicUpdate(&EVNT_Events[event/EVNT_MEM_UNIT_NOF_BITS], ~EVENT_MASK(event), 0)&EVENT_MASK(event))!=0;
+}
+
+void EVNT_HandleEvent(void (*callback)(EVNT_Handle), bool clearEvent) {
+  /* Handle the one with the highest priority. Zero is the event with the highest priority. */
+  EVNT_Handle event;
+
+  if (EVNT_TakeFrom(EVNT_Events, clearEvent, &event)) {
+    callback(event);
+    /* Note: if the callback sets the event again, we will catch it by the next call. */
+  }
+}
+
+void EVNT_HandleAllEvents(void (*callback)(EVNT_Handle)) {
+  (void)EVNT_DrainFrom(EVNT_Events, callback);
+}
+
+#define EVNT_QUEUE_SIZE       16  /* number of posted events which can be pending */
+#define EVNT_NOF_SUBSCRIBERS  8   /* number of entries in the subscriber table */
+
+static struct {
+  EVNT_Msg msg[EVNT_QUEUE_SIZE]; /* ring buffer */
+  uint8_t head;                  /* index of the next free entry */
+  uint8_t tail;                  /* index of the oldest entry */
+  uint8_t nof;                   /* number of pending events */
+  uint8_t highWater;             /* largest number of pending events */
+  uint32_t nofPosted;            /* number of events posted */
+  uint32_t nofOverflows;         /* number of events lost because the queue was full */
+  uint32_t nofQueueFull;         /* number of events lost because a subscriber queue was full */
+} EVNT_Queue;
+
+typedef struct {
+  EVNT_Handle event;             /* event, or EVNT_ALL_EVENTS */
+  EVNT_MsgCallback callback;     /* callback, or NULL */
+  xQueueHandle queue;            /* task queue if there is no callback, entry is free if both are NULL */
+} EVNT_Subscriber;
+
+static EVNT_Subscriber EVNT_Subscribers[EVNT_NOF_SUBSCRIBERS];
+
+static uint8_t EVNT_PostMsg(EVNT_Handle event, const void *data, uint8_t size, uint32_t timeMs) {
+  EVNT_Msg *msg;
+  uint8_t i;
   CS1_CriticalVariable()
 
+  if (size>EVNT_PAYLOAD_SIZE) {
+    return ERR_FAILED;
+  }
   CS1_EnterCritical();
-  CLR_EVENT(event);
+  if (EVNT_Queue.nof==EVNT_QUEUE_SIZE) {
+    EVNT_Queue.nofOverflows++;
+    CS1_ExitCritical();
+    return ERR_OVERFLOW;
+  }
+  msg = &EVNT_Queue.msg[EVNT_Queue.head];
+  msg->timeMs = timeMs;
+  msg->event = event;
+  msg->size = size;
+  for(i=0;i<size;i++) { /* only a few bytes */
+    msg->data.u8[i] = ((const uint8_t*)data)[i];
+  }
+  EVNT_Queue.head = (uint8_t)((EVNT_Queue.head+1)%EVNT_QUEUE_SIZE);
+  EVNT_Queue.nof++;
+  if (EVNT_Queue.nof>EVNT_Queue.highWater) {
+    EVNT_Queue.highWater = EVNT_Queue.nof;
+  }
+  EVNT_Queue.nofPosted++;
   CS1_ExitCritical();
+  return ERR_OK;
 }
 
-bool EVNT_EventIsSet(EVNT_Handle event) {
-  bool isSet;
+uint8_t EVNT_Post(EVNT_Handle event, const void *data, uint8_t size) {
+  return EVNT_PostMsg(event, data, size, (uint32_t)FRTOS1_xTaskGetTickCount()*portTICK_PERIOD_MS);
+}
+
+uint8_t EVNT_PostFromISR(EVNT_Handle event, const void *data, uint8_t size) {
+  return EVNT_PostMsg(event, data, size, (uint32_t)xTaskGetTickCountFromISR()*portTICK_PERIOD_MS);
+}
 
+/*!
+ * \brief Removes the oldest event from the queue.
+ * \return TRUE if an event has been removed
+ */
+static bool EVNT_QueueGet(EVNT_Msg *msg) {
   CS1_CriticalVariable()
 
   CS1_EnterCritical();
-  isSet = GET_EVENT(event);
+  if (EVNT_Queue.nof==0) {
+    CS1_ExitCritical();
+    return FALSE;
+  }
+  *msg = EVNT_Queue.msg[EVNT_Queue.tail];
+  EVNT_Queue.tail = (uint8_t)((EVNT_Queue.tail+1)%EVNT_QUEUE_SIZE);
+  EVNT_Queue.nof--;
   CS1_ExitCritical();
-  return isSet;
+  return TRUE;
 }
 
-bool EVNT_EventIsSetAutoClear(EVNT_Handle event) {
-  bool res;
+static uint8_t EVNT_AddSubscriber(EVNT_Handle event, EVNT_MsgCallback callback, xQueueHandle queue) {
+  uint8_t i;
   CS1_CriticalVariable()
 
   CS1_EnterCritical();
-  res = GET_EVENT(event);
-  if (res) {
-    CLR_EVENT(event); /* automatically clear event */
+  for(i=0;i<EVNT_NOF_SUBSCRIBERS;i++) {
+    if (EVNT_Subscribers[i].callback==NULL && EVNT_Subscribers[i].queue==NULL) { /* free entry */
+      EVNT_Subscribers[i].event = event;
+      EVNT_Subscribers[i].callback = callback;
+      EVNT_Subscribers[i].queue = queue;
+      CS1_ExitCritical();
+      return ERR_OK;
+    }
   }
   CS1_ExitCritical();
-  return res;
+  return ERR_OVERFLOW;
 }
 
-void EVNT_HandleEvent(void (*callback)(EVNT_Handle), bool clearEvent) {
-   /* Handle the one with the highest priority. Zero is the event with the highest priority. */
-   EVNT_Handle event;
-   CS1_CriticalVariable()
-
-   CS1_EnterCritical();
-   for (event=(EVNT_Handle)0; event<EVNT_NOF_EVENTS; event++) { /* does a test on every event */
-     if (GET_EVENT(event)) { /* event present? */
-       if (clearEvent) {
-         CLR_EVENT(event); /* clear event */
-       }
-       break; /* get out of loop */
-     }
-   }
-   CS1_ExitCritical();
-   if (event != EVNT_NOF_EVENTS) {
-     callback(event);
-     /* Note: if the callback sets the event, we will get out of the loop.
-      * We will catch it by the next iteration.
-      */
-   }
+static void EVNT_RemoveSubscriber(EVNT_Handle event, EVNT_MsgCallback callback, xQueueHandle queue) {
+  uint8_t i;
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  for(i=0;i<EVNT_NOF_SUBSCRIBERS;i++) {
+    if (EVNT_Subscribers[i].event==event && EVNT_Subscribers[i].callback==callback && EVNT_Subscribers[i].queue==queue) {
+      EVNT_Subscribers[i].callback = NULL;
+      EVNT_Subscribers[i].queue = NULL;
+    }
+  }
+  CS1_ExitCritical();
+}
+
+uint8_t EVNT_Subscribe(EVNT_Handle event, EVNT_MsgCallback callback) {
+  if (callback==NULL) {
+    return ERR_FAILED;
+  }
+  return EVNT_AddSubscriber(event, callback, NULL);
+}
+
+uint8_t EVNT_SubscribeQueue(EVNT_Handle event, xQueueHandle queue) {
+  if (queue==NULL) {
+    return ERR_FAILED;
+  }
+  return EVNT_AddSubscriber(event, NULL, queue);
+}
+
+void EVNT_Unsubscribe(EVNT_Handle event, EVNT_MsgCallback callback) {
+  EVNT_RemoveSubscriber(event, callback, NULL);
+}
+
+void EVNT_UnsubscribeQueue(EVNT_Handle event, xQueueHandle queue) {
+  EVNT_RemoveSubscriber(event, NULL, queue);
+}
+
+void EVNT_DispatchQueue(void) {
+  EVNT_Msg msg;
+  EVNT_Subscriber sub;
+  uint8_t i;
+
+  while(EVNT_QueueGet(&msg)) {
+    for(i=0;i<EVNT_NOF_SUBSCRIBERS;i++) {
+      sub = EVNT_Subscribers[i]; /* copy, the entry might get changed by the callback */
+      if (sub.event!=msg.event && sub.event!=EVNT_ALL_EVENTS) {
+        continue;
+      }
+      if (sub.callback!=NULL) {
+        sub.callback(&msg);
+      } else if (sub.queue!=NULL) {
+        if (FRTOS1_xQueueSendToBack(sub.queue, &msg, 0)!=pdPASS) {
+          EVNT_Queue.nofQueueFull++;
+        }
+      }
+    }
+  }
+}
+
+#if PL_CONFIG_HAS_SHELL
+#define EVNT_BENCH_NOF_EVENTS  EVNT_NOF_EVENTS /* burst size of the benchmark */
+
+static volatile EVNT_MemUnit EVNT_BenchEvents[EVNT_NOF_MEM_UNITS]; /* the benchmark does not touch the application events */
+static unsigned EVNT_BenchCount;
+
+static void EVNT_BenchCallback(EVNT_Handle event) {
+  (void)event;
+  EVNT_BenchCount++;
+}
+
+static void EVNT_BenchSetAll(void) {
+  unsigned i;
+
+  for(i=0;i<EVNT_BENCH_NOF_EVENTS;i++) {
+    (void)EVNT_AtomicUpdate(&EVNT_BenchEvents[i/EVNT_MEM_UNIT_NOF_BITS], ~0u, EVENT_MASK(i));
+  }
+}
+
+static void EVNT_PrintBenchResult(const unsigned char *name, uint32_t cycles, const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+
+  UTIL1_Num32uToStr(buf, sizeof(buf), cycles);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" cycles (");
+  UTIL1_strcatNum32u(buf, sizeof(buf), cycles/EVNT_BENCH_NOF_EVENTS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" per event)\r\n");
+  CLS1_SendStatusStr(name, buf, io->stdOut);
+}
+
+/*!
+ * \brief Measures the cycles for a burst of all events: setting them, handling them with one call per event, and with a single call.
+ */
+static void EVNT_Bench(const CLS1_StdIOType *io) {
+  EVNT_Handle event;
+  uint32_t start, set, one, all;
+
+  KIN1_InitCycleCounter();
+  KIN1_EnableCycleCounter();
+  EVNT_BenchCount = 0;
+  start = KIN1_GetCycleCounter();
+  EVNT_BenchSetAll();
+  set = KIN1_GetCycleCounter()-start;
+
+  start = KIN1_GetCycleCounter();
+  while(EVNT_TakeFrom(EVNT_BenchEvents, TRUE, &event)) { /* same as calling EVNT_HandleEvent() until nothing is pending */
+    EVNT_BenchCallback(event);
+  }
+  one = KIN1_GetCycleCounter()-start;
+
+  EVNT_BenchSetAll();
+  start = KIN1_GetCycleCounter();
+  (void)EVNT_DrainFrom(EVNT_BenchEvents, EVNT_BenchCallback); /* same as EVNT_HandleAllEvents() */
+  all = KIN1_GetCycleCounter()-start;
+
+  CLS1_SendStatusStr((unsigned char*)"event bench", (unsigned char*)"\r\n", io->stdOut);
+  EVNT_PrintBenchResult((unsigned char*)"  set", set, io);
+  EVNT_PrintBenchResult((unsigned char*)"  handle one", one, io);
+  EVNT_PrintBenchResult((unsigned char*)"  handle all", all, io);
+  if (EVNT_BenchCount!=2*EVNT_BENCH_NOF_EVENTS) {
+    CLS1_SendStr((unsigned char*)"ERROR: events lost!\r\n", io->stdErr);
+  }
+}
+
+#define EVNT_LOG_QUEUE_LENGTH  8 /* logged events waiting for the shell task */
+static xQueueHandle EVNT_LogQueue; /* subscribed to all events with "event log on" */
+
+static void EVNT_LogMsg(const EVNT_Msg *msg, const CLS1_StdIOType *io) {
+  unsigned char buf[64];
+  uint8_t i;
+
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"event ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), (uint16_t)msg->event);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" at ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), msg->timeMs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms:");
+  for(i=0;i<msg->size;i++) {
+    UTIL1_chcat(buf, sizeof(buf), ' ');
+    UTIL1_strcatNum8Hex(buf, sizeof(buf), msg->data.u8[i]);
+  }
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStr(buf, io->stdOut);
+}
+
+void EVNT_PrintLog(const CLS1_StdIOType *io) {
+  EVNT_Msg msg;
+
+  while(FRTOS1_xQueueReceive(EVNT_LogQueue, &msg, 0)==pdPASS) {
+    EVNT_LogMsg(&msg, io);
+  }
 }
 
+static void EVNT_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"event", (unsigned char*)"Group of event commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  bench", (unsigned char*)"Measure the cycles to set and handle a burst of events\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  log on|off", (unsigned char*)"Print all posted events with time and payload\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  clear", (unsigned char*)"Reset the queue statistics\r\n", io->stdOut);
+}
+
+static void EVNT_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[64];
+  unsigned i;
+
+  CLS1_SendStatusStr((unsigned char*)"event", (unsigned char*)"\r\n", io->stdOut);
+  UTIL1_Num16uToStr(buf, sizeof(buf), EVNT_NOF_EVENTS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  events", buf, io->stdOut);
+  buf[0] = '\0';
+  for(i=0;i<EVNT_NOF_MEM_UNITS;i++) {
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"0x");
+    UTIL1_strcatNum32Hex(buf, sizeof(buf), EVNT_Events[i]);
+    UTIL1_chcat(buf, sizeof(buf), ' ');
+  }
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  pending", buf, io->stdOut);
+
+  UTIL1_Num8uToStr(buf, sizeof(buf), EVNT_Queue.nof);
+  UTIL1_chcat(buf, sizeof(buf), '/');
+  UTIL1_strcatNum8u(buf, sizeof(buf), EVNT_QUEUE_SIZE);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", high water ");
+  UTIL1_strcatNum8u(buf, sizeof(buf), EVNT_Queue.highWater);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  queue", buf, io->stdOut);
+  UTIL1_Num32uToStr(buf, sizeof(buf), EVNT_Queue.nofPosted);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" posted, ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), EVNT_Queue.nofOverflows);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" overflows, ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), EVNT_Queue.nofQueueFull);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" subscriber full\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  posted", buf, io->stdOut);
+  buf[0] = '\0';
+  for(i=0;i<EVNT_NOF_SUBSCRIBERS;i++) {
+    if (EVNT_Subscribers[i].callback!=NULL || EVNT_Subscribers[i].queue!=NULL) {
+      if (EVNT_Subscribers[i].event==EVNT_ALL_EVENTS) {
+        UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"all");
+      } else {
+        UTIL1_strcatNum16u(buf, sizeof(buf), (uint16_t)EVNT_Subscribers[i].event);
+      }
+      UTIL1_strcat(buf, sizeof(buf), EVNT_Subscribers[i].callback!=NULL?(unsigned char*)" ":(unsigned char*)"(q) ");
+    }
+  }
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  subscribers", buf, io->stdOut);
+}
+
+uint8_t EVNT_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"event help")==0) {
+    EVNT_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"event status")==0) {
+    EVNT_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"event bench")==0) {
+    EVNT_Bench(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"event log on")==0) {
+    EVNT_UnsubscribeQueue(EVNT_ALL_EVENTS, EVNT_LogQueue); /* only once */
+    res = EVNT_SubscribeQueue(EVNT_ALL_EVENTS, EVNT_LogQueue); /* printed by the shell task, not in the task dispatching the events */
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"No free subscriber entry\r\n", io->stdErr);
+    }
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"event log off")==0) {
+    EVNT_UnsubscribeQueue(EVNT_ALL_EVENTS, EVNT_LogQueue);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"event clear")==0) {
+    EVNT_Queue.highWater = EVNT_Queue.nof;
+    EVNT_Queue.nofPosted = 0;
+    EVNT_Queue.nofOverflows = 0;
+    EVNT_Queue.nofQueueFull = 0;
+    *handled = TRUE;
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
 void EVNT_Init(void) {
   uint8_t i;
 
@@ -100,10 +523,30 @@ void EVNT_Init(void) {
     EVNT_Events[i] = 0; /* initialize data structure */
     i++;
   } while(i<sizeof(EVNT_Events)/sizeof(EVNT_Events[0]));
+  EVNT_Queue.head = 0;
+  EVNT_Queue.tail = 0;
+  EVNT_Queue.nof = 0;
+  EVNT_Queue.highWater = 0;
+  EVNT_Queue.nofPosted = 0;
+  EVNT_Queue.nofOverflows = 0;
+  EVNT_Queue.nofQueueFull = 0;
+  for(i=0;i<EVNT_NOF_SUBSCRIBERS;i++) {
+    EVNT_Subscribers[i].callback = NULL;
+    EVNT_Subscribers[i].queue = NULL;
+  }
+#if PL_CONFIG_HAS_SHELL
+  EVNT_LogQueue = FRTOS1_xQueueCreate(EVNT_LOG_QUEUE_LENGTH, sizeof(EVNT_Msg));
+  if (EVNT_LogQueue==NULL) {
+    for(;;){} /* out of memory? */
+  }
+  FRTOS1_vQueueAddToRegistry(EVNT_LogQueue, "EventLog");
+#endif
 }
 
 void EVNT_Deinit(void) {
-  /* nothing needed */
+#if PL_CONFIG_HAS_SHELL
+  FRTOS1_vQueueDelete(EVNT_LogQueue);
+#endif
 }
 
 #endif /* PL_HAS_EVENTS */
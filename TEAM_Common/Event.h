@@ -6,6 +6,8 @@
  * This module implements a generic event driver. We are using numbered events starting with zero.
  * EVNT_HandleEvent() can be used to process the pending events. Note that the event with the number zero
  * has the highest priority and will be handled first
+ * In addition, events with a timestamp and a small payload can be posted to a queue (EVNT_Post()). They are dispatched by
+ * EVNT_DispatchQueue() to all modules which have subscribed to the event, with a callback or with a task queue.
  */
 
 #ifndef EVENT_H_
@@ -13,6 +15,7 @@
 
 #include "Platform.h"
 #if PL_CONFIG_HAS_EVENTS
+#include "FRTOS1.h"
 
 typedef enum EVNT_Handle {
   EVNT_STARTUP,            /*!< System startup Event */
@@ -54,11 +57,31 @@ typedef enum EVNT_Handle {
   EVNT_SW7_RELEASED,
   EVNT_SW7_LPRESSED,
   #endif
+#endif
+#if PL_CONFIG_HAS_LINE_RECOVERY
+  EVNT_LINE_LOST,         /*!< line lost, queue payload: i16[0..2] position x, y in mm and last line offset */
+  EVNT_LINE_FOUND,        /*!< line found again, queue payload: i32[0] search time in ms */
 #endif
   /*!< \todo Your extra events here */
   EVNT_NOF_EVENTS       /*!< Must be last one! */
 } EVNT_Handle;
 
+#define EVNT_ALL_EVENTS     EVNT_NOF_EVENTS /*!< subscribe to every posted event */
+#define EVNT_PAYLOAD_SIZE   8   /*!< maximum payload of a posted event, in bytes */
+
+typedef struct {
+  uint32_t timeMs;        /*!< time when the event was posted */
+  EVNT_Handle event;      /*!< event */
+  uint8_t size;           /*!< number of valid payload bytes */
+  union {
+    uint8_t u8[EVNT_PAYLOAD_SIZE];
+    int16_t i16[EVNT_PAYLOAD_SIZE/2];
+    int32_t i32[EVNT_PAYLOAD_SIZE/4];
+  } data;                 /*!< payload */
+} EVNT_Msg;
+
+typedef void (*EVNT_MsgCallback)(const EVNT_Msg *msg); /*!< subscriber callback, called from the task calling EVNT_DispatchQueue() */
+
 /*!
  * \brief Sets an event.
  * \param[in] event The handle of the event to set.
@@ -92,6 +115,76 @@ bool EVNT_EventIsSetAutoClear(EVNT_Handle event);
  */
 void EVNT_HandleEvent(void (*callback)(EVNT_Handle), bool clearEvent);
 
+/*!
+ * \brief Clears all pending events and calls the callback for each of them, highest priority first.
+ * Events set again by the callbacks are handled with the next call.
+ * \param[in] callback Callback routine to be called. The event handle is passed as argument to the callback.
+ */
+void EVNT_HandleAllEvents(void (*callback)(EVNT_Handle));
+
+/*!
+ * \brief Posts an event with a timestamp and a payload to the event queue. Repeated events are queued and not merged.
+ * \param[in] event Event
+ * \param[in] data Payload, can be NULL if size is zero
+ * \param[in] size Size of the payload, up to EVNT_PAYLOAD_SIZE
+ * \return Error code, ERR_OK if everything is fine, ERR_OVERFLOW if the queue is full
+ */
+uint8_t EVNT_Post(EVNT_Handle event, const void *data, uint8_t size);
+
+/*!
+ * \brief Same as EVNT_Post(), to be called from an interrupt.
+ */
+uint8_t EVNT_PostFromISR(EVNT_Handle event, const void *data, uint8_t size);
+
+/*!
+ * \brief Subscribes a callback to an event of the queue.
+ * \param[in] event Event, or EVNT_ALL_EVENTS
+ * \param[in] callback Callback to be called for each posted event
+ * \return Error code, ERR_OK if everything is fine, ERR_OVERFLOW if the subscriber table is full
+ */
+uint8_t EVNT_Subscribe(EVNT_Handle event, EVNT_MsgCallback callback);
+
+/*!
+ * \brief Subscribes a task queue to an event of the queue. A copy of each posted event is sent to the queue, without waiting.
+ * \param[in] event Event, or EVNT_ALL_EVENTS
+ * \param[in] queue Queue with items of sizeof(EVNT_Msg)
+ * \return Error code, ERR_OK if everything is fine, ERR_OVERFLOW if the subscriber table is full
+ */
+uint8_t EVNT_SubscribeQueue(EVNT_Handle event, xQueueHandle queue);
+
+/*!
+ * \brief Removes a subscription made with EVNT_Subscribe().
+ */
+void EVNT_Unsubscribe(EVNT_Handle event, EVNT_MsgCallback callback);
+
+/*!
+ * \brief Removes a subscription made with EVNT_SubscribeQueue().
+ */
+void EVNT_UnsubscribeQueue(EVNT_Handle event, xQueueHandle queue);
+
+/*!
+ * \brief Removes all posted events from the queue and passes them to the subscribers, in the order they have been posted.
+ */
+void EVNT_DispatchQueue(void);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Module command line parser
+ * \param cmd Pointer to command string to be parsed
+ * \param handled Set to TRUE if command has handled by parser
+ * \param io Shell standard I/O handler
+ * \return Error code, ERR_OK if everything was ok
+ */
+uint8_t EVNT_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+
+/*!
+ * \brief Prints the events logged with "event log on". Called by the shell task, so the logging does not run in the dispatching task.
+ * \param io Shell standard I/O handler
+ */
+void EVNT_PrintLog(const CLS1_StdIOType *io);
+#endif
+
 /*! \brief Event module initialization */
 void EVNT_Init(void);
 
@@ -0,0 +1,249 @@
+/**
+ * \file
+ * \brief Lap and segment timing implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Keeps a table with the events of the last runs in RAM. Times are in milliseconds since the start of the run.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LAP_TIMING
+#include "LapTime.h"
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_RADIO
+  #include "RNet_App.h"
+#endif
+
+#define LAPT_NOF_RUNS    4   /* number of runs kept in the table */
+#define LAPT_NOF_EVENTS  32  /* events per run, the last one is reserved for the end of the run */
+
+typedef struct {
+  uint16_t runNo;                 /* number of the run since power-up, 0 if the entry is not used */
+  bool running;                   /* TRUE until the finish or stop event */
+  uint8_t nofEvents;              /* number of stored events */
+  uint16_t nofDropped;            /* events not stored because the table was full */
+  uint32_t ms[LAPT_NOF_EVENTS];   /* time of each event since the start */
+  uint8_t event[LAPT_NOF_EVENTS]; /* LAPT_Event */
+} LAPT_Run;
+
+static LAPT_Run runs[LAPT_NOF_RUNS];
+static uint8_t currRun; /* index of the current or last run */
+static uint16_t nofRuns; /* number of runs since power-up */
+static TickType_t startTicks; /* time of the start event */
+static bool radioReport = TRUE; /* report the events to the timing node */
+static uint16_t nofRadioDropped; /* events not reported because the radio queue was full */
+
+void LAPT_AddEvent(LAPT_Event event) {
+  LAPT_Run *run = &runs[currRun];
+  uint32_t ms;
+  bool isEnd;
+
+  if (!run->running) {
+    return;
+  }
+  ms = (uint32_t)(FRTOS1_xTaskGetTickCount()-startTicks)*portTICK_PERIOD_MS;
+  isEnd = event==LAPT_EVENT_FINISH || event==LAPT_EVENT_STOP;
+  if (run->nofEvents<LAPT_NOF_EVENTS-1 || (isEnd && run->nofEvents<LAPT_NOF_EVENTS)) {
+    run->ms[run->nofEvents] = ms;
+    run->event[run->nofEvents] = (uint8_t)event;
+    run->nofEvents++;
+  } else {
+    run->nofDropped++;
+  }
+  if (isEnd) {
+    run->running = FALSE;
+  }
+#if PL_CONFIG_HAS_RADIO
+  if (radioReport && RNETA_QueueSignal((uint8_t)event, ms)!=ERR_OK) {
+    nofRadioDropped++;
+  }
+#endif
+}
+
+void LAPT_StartRun(void) {
+  if (runs[currRun].running) { /* previous run was not ended */
+    LAPT_AddEvent(LAPT_EVENT_STOP);
+  }
+  if (nofRuns!=0) {
+    currRun = (uint8_t)((currRun+1)%LAPT_NOF_RUNS);
+  }
+  nofRuns++;
+  runs[currRun].runNo = nofRuns;
+  runs[currRun].nofEvents = 0;
+  runs[currRun].nofDropped = 0;
+  runs[currRun].running = TRUE;
+  startTicks = FRTOS1_xTaskGetTickCount();
+  LAPT_AddEvent(LAPT_EVENT_START);
+}
+
+static void LAPT_Clear(void) {
+  int i;
+
+  for(i=0;i<LAPT_NOF_RUNS;i++) {
+    runs[i].runNo = 0;
+    runs[i].running = FALSE;
+    runs[i].nofEvents = 0;
+    runs[i].nofDropped = 0;
+  }
+  currRun = 0;
+  nofRuns = 0;
+  nofRadioDropped = 0;
+}
+
+#if PL_CONFIG_HAS_SHELL
+static const unsigned char *LAPT_EventName(uint8_t event) {
+  switch(event) {
+    case LAPT_EVENT_START:    return (const unsigned char*)"start";
+    case LAPT_EVENT_SEGMENT:  return (const unsigned char*)"segment";
+    case LAPT_EVENT_JUNCTION: return (const unsigned char*)"junction";
+    case LAPT_EVENT_LAP:      return (const unsigned char*)"lap";
+    case LAPT_EVENT_LOST:     return (const unsigned char*)"lost";
+    case LAPT_EVENT_FINISH:   return (const unsigned char*)"finish";
+    case LAPT_EVENT_STOP:     return (const unsigned char*)"stop";
+    default:                  return (const unsigned char*)"unknown";
+  }
+}
+
+/*!
+ * \brief Appends spaces up to a column of the table.
+ */
+static void LAPT_PadTo(unsigned char *buf, size_t bufSize, size_t column) {
+  while(UTIL1_strlen((char*)buf)<column) {
+    UTIL1_chcat(buf, bufSize, ' ');
+  }
+}
+
+static void LAPT_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"lap", (unsigned char*)"Group of lap timing commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information, with the table of the last runs\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  print [<run>]", (unsigned char*)"Print the events of a run, default is the last run\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  clear", (unsigned char*)"Clear the table\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  radio on|off", (unsigned char*)"Report the events and their times to the timing node\r\n", io->stdOut);
+}
+
+static void LAPT_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[64];
+  const LAPT_Run *run;
+  int i;
+
+  CLS1_SendStatusStr((unsigned char*)"lap", (unsigned char*)"\r\n", io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), radioReport?(unsigned char*)"on":(unsigned char*)"off");
+#if PL_CONFIG_HAS_RADIO
+  if (nofRadioDropped!=0) {
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", ");
+    UTIL1_strcatNum16u(buf, sizeof(buf), nofRadioDropped);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" events dropped");
+  }
+#endif
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  radio", buf, io->stdOut);
+  if (nofRuns==0) {
+    CLS1_SendStatusStr((unsigned char*)"  runs", (unsigned char*)"none\r\n", io->stdOut);
+    return;
+  }
+  CLS1_SendStatusStr((unsigned char*)"  runs", (unsigned char*)"run  time (ms)  result    events\r\n", io->stdOut);
+  for(i=LAPT_NOF_RUNS-1;i>=0;i--) { /* oldest first */
+    run = &runs[(currRun+LAPT_NOF_RUNS-i)%LAPT_NOF_RUNS];
+    if (run->runNo==0 || run->nofEvents==0) {
+      continue;
+    }
+    buf[0] = '\0';
+    UTIL1_strcatNum16u(buf, sizeof(buf), run->runNo);
+    LAPT_PadTo(buf, sizeof(buf), 5);
+    UTIL1_strcatNum32u(buf, sizeof(buf), run->ms[run->nofEvents-1]);
+    LAPT_PadTo(buf, sizeof(buf), 16);
+    if (run->running) {
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"running");
+    } else {
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)LAPT_EventName(run->event[run->nofEvents-1]));
+    }
+    LAPT_PadTo(buf, sizeof(buf), 26);
+    UTIL1_strcatNum8u(buf, sizeof(buf), run->nofEvents);
+    if (run->nofDropped!=0) {
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" (");
+      UTIL1_strcatNum16u(buf, sizeof(buf), run->nofDropped);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" dropped)");
+    }
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStatusStr((unsigned char*)"", buf, io->stdOut);
+  }
+}
+
+static uint8_t LAPT_PrintRun(uint16_t runNo, const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  const LAPT_Run *run = NULL;
+  int i;
+
+  for(i=0;i<LAPT_NOF_RUNS;i++) {
+    if (runs[i].runNo!=0 && (runs[i].runNo==runNo || (runNo==0 && i==currRun))) {
+      run = &runs[i];
+      break;
+    }
+  }
+  if (run==NULL) {
+    CLS1_SendStr((unsigned char*)"Run not in the table\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  CLS1_SendStr((unsigned char*)"#   event     time (ms)  delta (ms)\r\n", io->stdOut);
+  for(i=0;i<run->nofEvents;i++) {
+    buf[0] = '\0';
+    UTIL1_strcatNum16u(buf, sizeof(buf), (uint16_t)i);
+    LAPT_PadTo(buf, sizeof(buf), 4);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)LAPT_EventName(run->event[i]));
+    LAPT_PadTo(buf, sizeof(buf), 14);
+    UTIL1_strcatNum32u(buf, sizeof(buf), run->ms[i]);
+    LAPT_PadTo(buf, sizeof(buf), 25);
+    UTIL1_strcatNum32u(buf, sizeof(buf), i==0?0:run->ms[i]-run->ms[i-1]); /* after a junction event: time of the segment */
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+  }
+  return ERR_OK;
+}
+
+uint8_t LAPT_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+  const unsigned char *p;
+  int32_t val;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"lap help")==0) {
+    LAPT_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"lap status")==0) {
+    LAPT_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap print")==0) {
+    res = LAPT_PrintRun(0, io);
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"lap print ", sizeof("lap print ")-1)==0) {
+    p = cmd+sizeof("lap print");
+    if (UTIL1_xatoi(&p, &val)==ERR_OK && val>0 && val<=0xffff) {
+      res = LAPT_PrintRun((uint16_t)val, io);
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap clear")==0) {
+    LAPT_Clear();
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap radio on")==0) {
+    radioReport = TRUE;
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap radio off")==0) {
+    radioReport = FALSE;
+    *handled = TRUE;
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void LAPT_Deinit(void) {
+  /* nothing needed */
+}
+
+void LAPT_Init(void) {
+  LAPT_Clear();
+}
+
+#endif /* PL_CONFIG_HAS_LAP_TIMING */
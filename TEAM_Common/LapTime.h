@@ -0,0 +1,61 @@
+/**
+ * \file
+ * \brief Lap and segment timing interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Timestamps the start of a run and every segment, junction and lap event of the line following with millisecond resolution.
+ * The last runs are kept in RAM and can be printed as a table over the shell. Each event is queued for the radio task and reported to the timing node as lap point signal, followed by the measured time.
+ */
+
+#ifndef LAPTIME_H_
+#define LAPTIME_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LAP_TIMING
+
+typedef enum { /* the values are the signals sent to the timing node */
+  LAPT_EVENT_START = 'B',    /* run started */
+  LAPT_EVENT_SEGMENT = 'S',  /* started following a segment */
+  LAPT_EVENT_JUNCTION = 'J', /* reached the end of a segment (junction, corner or end of the line) */
+  LAPT_EVENT_LAP = 'L',      /* passed the lap marker */
+  LAPT_EVENT_LOST = 'R',     /* lost the line, searching it */
+  LAPT_EVENT_FINISH = 'C',   /* reached the finish */
+  LAPT_EVENT_STOP = 'X'      /* run stopped before the finish */
+} LAPT_Event;
+
+/*!
+ * \brief Starts a new run, replacing the oldest run in the table.
+ */
+void LAPT_StartRun(void);
+
+/*!
+ * \brief Adds an event with the current time to the current run. Events after the end of the run are ignored.
+ * \param event Event, LAPT_EVENT_FINISH and LAPT_EVENT_STOP end the run
+ */
+void LAPT_AddEvent(LAPT_Event event);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Module command line parser
+ * \param cmd Pointer to command string to be parsed
+ * \param handled Set to TRUE if command has handled by parser
+ * \param io Shell standard I/O handler
+ * \return Error code, ERR_OK if everything was ok
+ */
+uint8_t LAPT_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*!
+ * \brief Module de-initialization.
+ */
+void LAPT_Deinit(void);
+
+/*!
+ * \brief Module initialization.
+ */
+void LAPT_Init(void);
+
+#endif /* PL_CONFIG_HAS_LAP_TIMING */
+
+#endif /* LAPTIME_H_ */
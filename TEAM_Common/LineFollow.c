@@ -19,6 +19,21 @@
 #endif
 #include "WAIT1.h"
 #include "Pid.h"
+#if PL_CONFIG_HAS_LINE_MAZE
+  #include "Maze.h"
+#endif
+#if PL_CONFIG_HAS_LINE_SPEED
+  #include "LineSpeed.h"
+#endif
+#if PL_CONFIG_HAS_LINE_RECOVERY
+  #include "Odometry.h"
+#endif
+#if PL_CONFIG_HAS_LAP_TIMING
+  #include "LapTime.h"
+#endif
+#if PL_CONFIG_HAS_EVENTS
+  #include "Event.h"
+#endif
 #include "Drive.h"
 #include "Shell.h"
 #if PL_CONFIG_HAS_BUZZER
@@ -36,6 +51,7 @@ typedef enum {
   STATE_IDLE,              /* idle, not doing anything */
   STATE_FOLLOW_SEGMENT,    /* line following segment, going forward */
   STATE_TURN,              /* reached an intersection, turning around */
+  STATE_RECOVER,           /* lost the line, searching it again */
   STATE_FINISHED,          /* reached finish area */
   STATE_STOP               /* stop the engines */
 } StateType;
@@ -43,9 +59,96 @@ typedef enum {
 /* task notification bits */
 #define LF_START_FOLLOWING (1<<0)  /* start line following */
 #define LF_STOP_FOLLOWING  (1<<1)  /* stop line following */
+#define LF_NEW_FRAME       (1<<2)  /* new reflectance frame available */
 
 static volatile StateType LF_currState = STATE_IDLE;
 static xTaskHandle LFTaskHandle;
+#define LF_TASK_STACK_SIZE  (1000/sizeof(StackType_t)) /* the maze solver runs in this task: route search, FLASH and shell output */
+
+#if PL_CONFIG_HAS_LINE_RECOVERY
+/* line recovery search: arc towards the side where the line was seen last, then sweep left and right with a growing angle */
+#define LF_RECOVER_ARC_SPEED_MMS    100   /* forward speed while arcing towards the line */
+#define LF_RECOVER_ARC_OMEGA        1500  /* angular speed while arcing, mrad/s */
+#define LF_RECOVER_ARC_CDEG         3000  /* heading change of the arc, before sweeping */
+#define LF_RECOVER_SWEEP_SPEED_MMS  40    /* forward speed while sweeping */
+#define LF_RECOVER_SWEEP_OMEGA      3000  /* angular speed while sweeping, mrad/s */
+#define LF_RECOVER_SWEEP_STEP_CDEG  3000  /* sweep angle increase for each change of direction */
+#define LF_RECOVER_SWEEP_MAX_CDEG   15000 /* largest sweep angle to each side */
+#define LF_RECOVER_SIDE_OFFSET      100   /* line offset needed to know on which side the line is */
+#if PL_CONFIG_HAS_LINE_MAZE
+  #define LF_RECOVER_MIN_OFFSET     1000  /* in the maze, losing a centered line is a dead end and not a line loss */
+#endif
+
+static struct {
+  uint16_t maxMm;          /* give up after this distance, 0 to disable the recovery */
+  int8_t side;             /* side where we search first: 1 left, -1 right (as the angular speed) */
+  int16_t lastOffset;      /* line offset in the last frame with a line */
+  bool sweeping;           /* FALSE while arcing, TRUE while sweeping */
+  int32_t sweepCDeg;       /* current sweep angle */
+  int32_t startUm;         /* driven distance when the line was lost */
+  ODO_Angle startHeading;  /* heading when the line was lost */
+  TickType_t startTicks;   /* time when the line was lost */
+  uint32_t nofRecovered;   /* number of successful recoveries */
+  uint32_t nofFailed;      /* number of searches given up */
+  uint32_t sumMs;          /* time of all successful recoveries */
+  uint32_t maxMs;          /* longest successful recovery */
+} LF_Recover = {150};
+#endif
+
+/* latency from the capture of a frame to the new motor PWM values */
+#define LF_LATENCY_NOF_BINS  8
+static const uint16_t LF_LatencyBinUs[LF_LATENCY_NOF_BINS-1] = {250, 500, 1000, 2000, 5000, 10000, 20000}; /* upper limit of each bin, the last bin has no limit */
+
+static struct {
+  uint32_t nof;                        /* number of measurements */
+  uint32_t minUs, maxUs;               /* smallest and largest latency */
+  uint32_t sumUs;                      /* sum of all latencies, for the average */
+  uint32_t bin[LF_LATENCY_NOF_BINS];   /* histogram */
+} LF_Latency;
+
+static void LF_LatencyClear(void) {
+  int i;
+
+  LF_Latency.nof = 0;
+  LF_Latency.minUs = 0xffffffff;
+  LF_Latency.maxUs = 0;
+  LF_Latency.sumUs = 0;
+  for(i=0;i<LF_LATENCY_NOF_BINS;i++) {
+    LF_Latency.bin[i] = 0;
+  }
+}
+
+/*!
+ * \brief Adds the time since the capture of a frame to the latency statistics. Called after the motors have been updated.
+ * \param frameTimestamp Capture time of the frame used for the motor values
+ */
+static void LF_LatencyAdd(uint32_t frameTimestamp) {
+  uint32_t us;
+  int i;
+
+  us = REF_TimestampToUs(REF_GetTimestamp()-frameTimestamp);
+  LF_Latency.nof++;
+  LF_Latency.sumUs += us;
+  if (us<LF_Latency.minUs) {
+    LF_Latency.minUs = us;
+  }
+  if (us>LF_Latency.maxUs) {
+    LF_Latency.maxUs = us;
+  }
+  for(i=0;i<LF_LATENCY_NOF_BINS-1;i++) {
+    if (us<LF_LatencyBinUs[i]) {
+      break;
+    }
+  }
+  LF_Latency.bin[i]++;
+}
+
+/*!
+ * \brief Called by the reflectance task for every measured frame while we are following.
+ */
+static void LF_FrameCallback(void) {
+  (void)xTaskNotify(LFTaskHandle, LF_NEW_FRAME, eSetBits);
+}
 
 void LF_StartFollowing(void) {
   (void)xTaskNotify(LFTaskHandle, LF_START_FOLLOWING, eSetBits);
@@ -66,60 +169,257 @@ void LF_StartStopFollowing(void) {
 /* forward declaration */
 static void StateMachine(void);
 
+#if PL_CONFIG_HAS_LINE_RECOVERY
+static void LF_RecoverClear(void) {
+  LF_Recover.nofRecovered = 0;
+  LF_Recover.nofFailed = 0;
+  LF_Recover.sumMs = 0;
+  LF_Recover.maxMs = 0;
+}
+
+/*!
+ * \brief Remembers the line position of a frame with a line, so we know where to search if we lose it.
+ */
+static void LF_RecoverTrack(uint16_t line) {
+  LF_Recover.lastOffset = (int16_t)((int32_t)line-REF_MIDDLE_LINE_VALUE);
+  if (LF_Recover.lastOffset>LF_RECOVER_SIDE_OFFSET) { /* line on the right side (see PID_Line()) */
+    LF_Recover.side = -1;
+  } else if (LF_Recover.lastOffset<-LF_RECOVER_SIDE_OFFSET) {
+    LF_Recover.side = 1;
+  }
+}
+
+static void LF_RecoverSetTwist(int32_t speedMmS, int32_t omega) {
+  (void)DRV_SetTwist(ODO_UmToTicks(speedMmS*1000), omega);
+}
+
+/*!
+ * \brief Decides if we search the line after losing it, and starts the search.
+ * \return TRUE if the search is started
+ */
+static bool LF_RecoverStart(void) {
+  ODO_Pose pose;
+#if PL_CONFIG_HAS_EVENTS
+  int16_t payload[3];
+#endif
+
+  if (LF_Recover.maxMm==0 || REF_GetLineKind()!=REF_LINE_NONE) {
+    return FALSE;
+  }
+#if PL_CONFIG_HAS_LINE_MAZE
+  if (LF_Recover.lastOffset<LF_RECOVER_MIN_OFFSET && LF_Recover.lastOffset>-LF_RECOVER_MIN_OFFSET) {
+    return FALSE; /* dead end */
+  }
+#endif
+  ODO_GetPose(&pose);
+  LF_Recover.startUm = pose.distUm;
+  LF_Recover.startHeading = pose.heading;
+  LF_Recover.startTicks = FRTOS1_xTaskGetTickCount();
+  LF_Recover.sweeping = FALSE;
+  if (DRV_SetMode(DRV_MODE_TWIST)!=ERR_OK) {
+    return FALSE;
+  }
+  LF_RecoverSetTwist(LF_RECOVER_ARC_SPEED_MMS, LF_Recover.side*LF_RECOVER_ARC_OMEGA);
+#if PL_CONFIG_HAS_EVENTS
+  payload[0] = (int16_t)(pose.xUm/1000);
+  payload[1] = (int16_t)(pose.yUm/1000);
+  payload[2] = LF_Recover.lastOffset;
+  (void)EVNT_Post(EVNT_LINE_LOST, payload, sizeof(payload));
+#endif
+  return TRUE;
+}
+
+/*!
+ * \brief Performs one step of the line search, called for every frame.
+ * \return ERR_OK if the line is found, ERR_BUSY while searching, ERR_FAILED if we give up
+ */
+static uint8_t LF_RecoverStep(void) {
+  ODO_Pose pose;
+  int32_t angle;
+  uint32_t ms;
+
+  ODO_GetPose(&pose);
+  if (REF_GetLineKind()!=REF_LINE_NONE) { /* back on the line */
+    ms = (uint32_t)(FRTOS1_xTaskGetTickCount()-LF_Recover.startTicks)*portTICK_PERIOD_MS;
+    LF_Recover.nofRecovered++;
+    LF_Recover.sumMs += ms;
+    if (ms>LF_Recover.maxMs) {
+      LF_Recover.maxMs = ms;
+    }
+#if PL_CONFIG_HAS_EVENTS
+    (void)EVNT_Post(EVNT_LINE_FOUND, &ms, sizeof(ms));
+#endif
+    (void)DRV_SetMode(DRV_MODE_NONE); /* line following controls the motors again */
+    PID_Start();
+    return ERR_OK;
+  }
+  if (pose.distUm-LF_Recover.startUm>(int32_t)LF_Recover.maxMm*1000) {
+    LF_Recover.nofFailed++;
+    (void)DRV_SetMode(DRV_MODE_STOP);
+    return ERR_FAILED;
+  }
+  angle = ODO_AngleToCentiDeg(pose.heading-LF_Recover.startHeading)*LF_Recover.side; /* positive towards the search side */
+  if (!LF_Recover.sweeping) {
+    if (angle>=LF_RECOVER_ARC_CDEG) { /* not found with the arc: sweep back to the other side */
+      LF_Recover.sweeping = TRUE;
+      LF_Recover.sweepCDeg = LF_RECOVER_ARC_CDEG+LF_RECOVER_SWEEP_STEP_CDEG;
+      LF_Recover.side = (int8_t)-LF_Recover.side;
+      LF_RecoverSetTwist(LF_RECOVER_SWEEP_SPEED_MMS, LF_Recover.side*LF_RECOVER_SWEEP_OMEGA);
+    }
+  } else if (angle>=LF_Recover.sweepCDeg) { /* end of the sweep: change direction, and sweep wider */
+    if (LF_Recover.sweepCDeg<LF_RECOVER_SWEEP_MAX_CDEG) {
+      LF_Recover.sweepCDeg += LF_RECOVER_SWEEP_STEP_CDEG;
+    }
+    LF_Recover.side = (int8_t)-LF_Recover.side;
+    LF_RecoverSetTwist(LF_RECOVER_SWEEP_SPEED_MMS, LF_Recover.side*LF_RECOVER_SWEEP_OMEGA);
+  }
+  return ERR_BUSY;
+}
+#endif /* PL_CONFIG_HAS_LINE_RECOVERY */
+
 /*!
  * \brief follows a line segment.
  * \return Returns TRUE if still on line segment
  */
-static bool FollowSegment(void) {
+static bool FollowSegment(const REF_Frame *frame) {
   uint16_t currLine;
   REF_LineKind currLineKind;
+  uint8_t speedPercent = 0; /* zero: configured line following speed */
+#if PL_CONFIG_HAS_LINE_MAZE
+  uint8_t mazePercent;
+#endif
 
-  currLine = REF_GetLineValue();
-  currLineKind = REF_GetLineKind();
-  if (currLineKind==REF_LINE_STRAIGHT) {
-    PID_Line(currLine, REF_MIDDLE_LINE_VALUE); /* move along the line */
-    return TRUE;
-  } else {
+  currLine = frame->lineValue;
+  currLineKind = frame->kind;
+#if PL_CONFIG_HAS_LINE_SPEED
+  if (LSPD_PassLapMarker(currLineKind)) { /* start/finish of a closed track: count the lap and keep going */
+    currLine = REF_MIDDLE_LINE_VALUE;
+    currLineKind = REF_LINE_STRAIGHT;
+  }
+#endif
+#if PL_CONFIG_HAS_LINE_MAZE
+  if (MAZE_PassJunction(currLineKind)) { /* solution goes straight: keep the speed and cross the junction */
+    currLine = REF_MIDDLE_LINE_VALUE;
+    currLineKind = REF_LINE_STRAIGHT;
+  }
+#endif
+  if (currLineKind!=REF_LINE_STRAIGHT) {
     return FALSE; /* intersection/change of direction or not on line any more */
   }
+#if PL_CONFIG_HAS_LINE_RECOVERY
+  LF_RecoverTrack(currLine);
+#endif
+#if PL_CONFIG_HAS_LINE_SPEED
+  speedPercent = LSPD_GetSpeedPercent(currLine); /* slow down for curves */
+#endif
+#if PL_CONFIG_HAS_LINE_MAZE
+  mazePercent = MAZE_GetSpeedPercent(); /* speed profile of the solved maze */
+  if (mazePercent!=0 && (speedPercent==0 || mazePercent<speedPercent)) {
+    speedPercent = mazePercent;
+  }
+#endif
+  if (speedPercent!=0) {
+    PID_LineSpeed(currLine, REF_MIDDLE_LINE_VALUE, speedPercent); /* move along the line with the adapted speed */
+  } else {
+    PID_Line(currLine, REF_MIDDLE_LINE_VALUE); /* move along the line */
+  }
+  return TRUE;
 }
 
 static void StateMachine(void) {
+  REF_Frame frame;
+#if !PL_CONFIG_HAS_LINE_MAZE
   REF_LineKind lineKind;
+#endif
 
   switch (LF_currState) {
     case STATE_IDLE:
       break;
 
     case STATE_FOLLOW_SEGMENT:
-      if (!FollowSegment()) {
+      REF_GetFrame(&frame); /* line and capture time of the same frame */
+      if (FollowSegment(&frame)) {
+        LF_LatencyAdd(frame.timestamp); /* motor values for this frame are set */
+      } else {
         //SHELL_SendString((unsigned char*)"No line, stopped!\r\n");
         //LF_currState = STATE_STOP; /* stop if we do not have a line any more */
+#if PL_CONFIG_HAS_LINE_RECOVERY
+        if (LF_RecoverStart()) {
+#if PL_CONFIG_HAS_LAP_TIMING
+          LAPT_AddEvent(LAPT_EVENT_LOST);
+#endif
+          LF_currState = STATE_RECOVER; /* lost the line: search it before giving up */
+          break;
+        }
+#endif
+#if PL_CONFIG_HAS_LAP_TIMING
+        LAPT_AddEvent(LAPT_EVENT_JUNCTION); /* end of the segment */
+#endif
         LF_currState = STATE_TURN;
       }
       break;
 
+#if PL_CONFIG_HAS_LINE_RECOVERY
+    case STATE_RECOVER:
+      switch(LF_RecoverStep()) {
+        case ERR_OK:
+          LF_currState = STATE_FOLLOW_SEGMENT;
+          break;
+        case ERR_BUSY:
+          break;
+        default:
+          SHELL_SendString((unsigned char*)"Line lost!\r\n");
+          LF_currState = STATE_STOP;
+          break;
+      }
+      break;
+#endif
+
     case STATE_TURN:
+#if PL_CONFIG_HAS_LINE_MAZE
+    {
+      bool finished;
+
+      if (MAZE_EvaluteTurn(&finished)!=ERR_OK) {
+        LF_currState = STATE_STOP;
+      } else if (finished) {
+        LF_currState = STATE_FINISHED;
+      } else {
+        DRV_SetMode(DRV_MODE_NONE); /* disable position mode */
+#if PL_CONFIG_HAS_LAP_TIMING
+        LAPT_AddEvent(LAPT_EVENT_SEGMENT);
+#endif
+        LF_currState = STATE_FOLLOW_SEGMENT;
+      }
+    }
+#else
       lineKind = REF_GetLineKind();
       if (lineKind==REF_LINE_FULL) {
         LF_currState = STATE_FINISHED;
       } if (lineKind==REF_LINE_NONE) {
-        TURN_Turn(TURN_LEFT180, NULL);
+        (void)TURN_TurnToLine(TURN_LEFT180, NULL); /* turn until we are back on the line */
         DRV_SetMode(DRV_MODE_NONE); /* disable position mode */
+#if PL_CONFIG_HAS_LAP_TIMING
+        LAPT_AddEvent(LAPT_EVENT_SEGMENT);
+#endif
         LF_currState = STATE_FOLLOW_SEGMENT;
       } else {
         LF_currState = STATE_STOP;
       }
+#endif
       break;
 
     case STATE_FINISHED:
       SHELL_SendString("Finished!\r\n");
+#if PL_CONFIG_HAS_LAP_TIMING
+      LAPT_AddEvent(LAPT_EVENT_FINISH);
+#endif
       LF_currState = STATE_STOP;
       break;
 
     case STATE_STOP:
-#if 1
-      //RNETA_SendSignal('C'); /*! \todo */
+#if PL_CONFIG_HAS_LAP_TIMING
+      LAPT_AddEvent(LAPT_EVENT_STOP); /* ignored if the run has finished */
 #endif
       SHELL_SendString("Stopped!\r\n");
       TURN_Turn(TURN_STOP, NULL);
@@ -134,23 +434,54 @@ bool LF_IsFollowing(void) {
 
 static void LineTask (void *pvParameters) {
   uint32_t notifcationValue;
+  StateType prevState;
 
   (void)pvParameters; /* not used */
   for(;;) {
-    (void)xTaskNotifyWait(0UL, LF_START_FOLLOWING|LF_STOP_FOLLOWING, &notifcationValue, 0); /* check flags */
+    /* block until we get a command, or a new frame while following */
+    (void)xTaskNotifyWait(0UL, LF_START_FOLLOWING|LF_STOP_FOLLOWING|LF_NEW_FRAME, &notifcationValue, portMAX_DELAY);
     if (notifcationValue&LF_START_FOLLOWING) {
-#if 1
-      //RNETA_SendSignal('B'); /*! \todo */
+#if PL_CONFIG_HAS_LAP_TIMING
+      LAPT_StartRun(); /* reports the start to the timing node */
 #endif
       DRV_SetMode(DRV_MODE_NONE); /* disable any drive mode */
       PID_Start();
-      LF_currState = STATE_FOLLOW_SEGMENT;
+#if PL_CONFIG_HAS_LINE_MAZE
+      MAZE_StartRun();
+#endif
+#if PL_CONFIG_HAS_LINE_SPEED
+      LSPD_Start();
+#endif
+      LF_LatencyClear();
+#if PL_CONFIG_HAS_LINE_RECOVERY
+      LF_Recover.lastOffset = 0;
+      LF_Recover.side = 1;
+      LF_RecoverClear();
+#endif
+      REF_RemoveFrameCallback(LF_FrameCallback); /* in case we are already following */
+      if (REF_AddFrameCallback(LF_FrameCallback)==ERR_OK) {
+        LF_currState = STATE_FOLLOW_SEGMENT;
+      } else {
+        SHELL_SendString((unsigned char*)"LF: no frame callback available!\r\n");
+        LF_currState = STATE_STOP;
+      }
     }
-    if (notifcationValue&LF_STOP_FOLLOWING) {
+    if ((notifcationValue&LF_STOP_FOLLOWING) && LF_currState!=STATE_IDLE) { /* already stopped if idle, e.g. at the end of the maze */
+#if PL_CONFIG_HAS_LINE_RECOVERY
+      if (LF_currState==STATE_RECOVER) {
+        (void)DRV_SetMode(DRV_MODE_STOP); /* stop the search */
+      }
+#endif
       LF_currState = STATE_STOP;
     }
-    StateMachine();
-    FRTOS1_vTaskDelay(5/portTICK_PERIOD_MS);
+    /* run the state changes right away, following a segment needs the next frame */
+    do {
+      prevState = LF_currState;
+      StateMachine();
+    } while(LF_currState!=prevState && LF_currState!=STATE_FOLLOW_SEGMENT && LF_currState!=STATE_RECOVER);
+    if (LF_currState==STATE_IDLE) {
+      REF_RemoveFrameCallback(LF_FrameCallback); /* no wake-ups while idle */
+    }
   }
 }
 
@@ -158,9 +489,15 @@ static void LF_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"line", (unsigned char*)"Group of line following commands\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows line help or status\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  start|stop", (unsigned char*)"Starts or stops line following\r\n", io->stdOut);
+#if PL_CONFIG_HAS_LINE_RECOVERY
+  CLS1_SendHelpStr((unsigned char*)"  recover <mm>", (unsigned char*)"Distance to search a lost line before stopping, 0 to disable\r\n", io->stdOut);
+#endif
 }
 
 static void LF_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[64];
+  int i;
+
   CLS1_SendStatusStr((unsigned char*)"line follow", (unsigned char*)"\r\n", io->stdOut);
   switch (LF_currState) {
     case STATE_IDLE: 
@@ -175,6 +512,9 @@ static void LF_PrintStatus(const CLS1_StdIOType *io) {
     case STATE_TURN: 
       CLS1_SendStatusStr((unsigned char*)"  state", (unsigned char*)"TURN\r\n", io->stdOut);
       break;
+    case STATE_RECOVER: 
+      CLS1_SendStatusStr((unsigned char*)"  state", (unsigned char*)"RECOVER\r\n", io->stdOut);
+      break;
     case STATE_FINISHED: 
       CLS1_SendStatusStr((unsigned char*)"  state", (unsigned char*)"FINISHED\r\n", io->stdOut);
       break;
@@ -182,6 +522,65 @@ static void LF_PrintStatus(const CLS1_StdIOType *io) {
       CLS1_SendStatusStr((unsigned char*)"  state", (unsigned char*)"UNKNOWN\r\n", io->stdOut);
       break;
   } /* switch */
+#if PL_CONFIG_HAS_LINE_RECOVERY
+  if (LF_Recover.maxMm==0) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"off, ");
+  } else {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"");
+    UTIL1_strcatNum16u(buf, sizeof(buf), LF_Recover.maxMm);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, ");
+  }
+  UTIL1_strcatNum32u(buf, sizeof(buf), LF_Recover.nofRecovered);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ok, ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), LF_Recover.nofFailed);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" failed\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  recovery", buf, io->stdOut);
+  if (LF_Recover.nofRecovered!=0) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"avg ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), LF_Recover.sumMs/LF_Recover.nofRecovered);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", max ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), LF_Recover.maxMs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", total ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), LF_Recover.sumMs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+    CLS1_SendStatusStr((unsigned char*)"  recover time", buf, io->stdOut);
+  }
+#endif
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"");
+  UTIL1_strcatNum32u(buf, sizeof(buf), uxTaskGetStackHighWaterMark(LFTaskHandle)*sizeof(StackType_t));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" of ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), LF_TASK_STACK_SIZE*sizeof(StackType_t));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" bytes never used\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  stack", buf, io->stdOut);
+  if (LF_Latency.nof==0) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"no data\r\n");
+  } else {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"min ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), LF_Latency.minUs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", avg ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), LF_Latency.sumUs/LF_Latency.nof);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", max ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), LF_Latency.maxUs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us (");
+    UTIL1_strcatNum32u(buf, sizeof(buf), LF_Latency.nof);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" frames)\r\n");
+  }
+  CLS1_SendStatusStr((unsigned char*)"  latency", buf, io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  histogram", (unsigned char*)"", io->stdOut);
+  for(i=0;i<LF_LATENCY_NOF_BINS;i++) { /* number of frames below each limit in us */
+    if (i<LF_LATENCY_NOF_BINS-1) {
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"<");
+      UTIL1_strcatNum16u(buf, sizeof(buf), LF_LatencyBinUs[i]);
+    } else {
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)">=");
+      UTIL1_strcatNum16u(buf, sizeof(buf), LF_LatencyBinUs[i-1]);
+    }
+    UTIL1_chcat(buf, sizeof(buf), ':');
+    UTIL1_strcatNum32u(buf, sizeof(buf), LF_Latency.bin[i]);
+    UTIL1_chcat(buf, sizeof(buf), ' ');
+    CLS1_SendStr(buf, io->stdOut);
+  }
+  CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
 }
 
 uint8_t LF_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
@@ -199,6 +598,20 @@ uint8_t LF_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdI
   } else if (UTIL1_strcmp((char*)cmd, (char*)"line stop")==0) {
     LF_StopFollowing();
     *handled = TRUE;
+#if PL_CONFIG_HAS_LINE_RECOVERY
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"line recover ", sizeof("line recover ")-1)==0) {
+    const unsigned char *p;
+    int32_t val;
+
+    p = cmd+sizeof("line recover");
+    if (UTIL1_xatoi(&p, &val)==ERR_OK && val>=0 && val<=0xffff) {
+      LF_Recover.maxMm = (uint16_t)val;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+    *handled = TRUE;
+#endif
   }
   return res;
 }
@@ -209,7 +622,8 @@ void LF_Deinit(void) {
 
 void LF_Init(void) {
   LF_currState = STATE_IDLE;
-  if (xTaskCreate(LineTask, "Line", 400/sizeof(StackType_t), NULL, tskIDLE_PRIORITY, &LFTaskHandle) != pdPASS) {
+  LF_LatencyClear();
+  if (xTaskCreate(LineTask, "Line", LF_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY, &LFTaskHandle) != pdPASS) {
     for(;;){} /* error */
   }
 }
@@ -0,0 +1,366 @@
+/**
+ * \file
+ * \brief Line following speed control implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Feeds the odometry, the reflectance frames and the PID configuration into the speed model (LineSpeedModel.h), and runs the lap state machine.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LINE_SPEED
+#include "LineSpeed.h"
+#include "LineSpeedModel.h"
+#include "Reflectance.h"
+#include "Odometry.h"
+#include "Pid.h"
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_LAP_TIMING
+  #include "LapTime.h"
+#endif
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+
+#define LSPD_STRAIGHT_CURVATURE   1000  /* below this curvature (radius above 1 m) the track counts as straight */
+
+/* lap mode */
+#define LSPD_MIN_LAP_MM           500   /* full lines closer than this to the last lap marker are ignored */
+#define LSPD_FALLBACK_ENTER       1500  /* line offset (1000 per sensor) where we stop trusting the map */
+#define LSPD_FALLBACK_EXIT        500   /* line offset where we use the map again */
+#define LSPD_NOF_LAP_TIMES        8     /* number of lap times stored */
+
+typedef enum {
+  LSPD_LAP_OFF,      /* lap mode off */
+  LSPD_LAP_WAIT,     /* waiting for the lap marker, position on the track unknown */
+  LSPD_LAP_LEARN,    /* first lap: recording the curvature */
+  LSPD_LAP_RUN       /* driving with the speed map */
+} LSPD_LapState;
+
+static LSPM_Config config = {FALSE, 60, 15, 200, 2500, 80, 400, 1000}; /* off until tuned on the track: the straight speed is above the PID fw speed */
+
+static struct {
+  bool enabled;           /* if the lap mode is used */
+  LSPD_LapState state;    /* lap state machine */
+  bool onMarker;          /* TRUE while driving over the lap marker */
+  bool fallback;          /* TRUE if the line error is too large to trust the map */
+  uint8_t maxPercent;     /* speed on the known straights */
+  uint16_t nofBins;       /* length of the learned lap, in bins */
+  int32_t startUm;        /* driven distance at the lap marker */
+  TickType_t startTicks;  /* time at the lap marker */
+  uint16_t lapNo;         /* number of the current lap, 1 is the learning lap */
+  uint16_t nofFallbacks;  /* number of fallbacks to the reactive speed in the current lap */
+  uint32_t lapMs[LSPD_NOF_LAP_TIMES]; /* time of the last laps, lapMs[(n-1)%LSPD_NOF_LAP_TIMES] for lap n */
+  uint16_t lapFallbacks[LSPD_NOF_LAP_TIMES]; /* number of fallbacks in the last laps */
+  uint16_t mapMmS[LSPM_MAP_NOF_BINS]; /* while learning the largest curvature of each bin, afterwards the speed */
+} lap = {FALSE, LSPD_LAP_OFF, FALSE, FALSE, 100};
+
+static LSPM_History history; /* driven distance and heading of the previous frames */
+
+static uint16_t speedX100; /* current speed in 1/100 percent */
+static uint32_t curvature; /* last curvature estimation */
+static int32_t straightStartUm; /* driven distance where the current straight started */
+static uint32_t lastFrameTimestamp; /* timestamp of the previous frame */
+
+/*!
+ * \brief Called each time we pass the lap marker.
+ */
+static void LSPD_LapMarker(int32_t distUm) {
+  TickType_t now;
+  int32_t lapMm;
+  int i;
+
+  now = FRTOS1_xTaskGetTickCount();
+  lapMm = (distUm-lap.startUm)/1000;
+  if (lap.state!=LSPD_LAP_WAIT) { /* a lap is complete */
+    if (lapMm<LSPD_MIN_LAP_MM) {
+      return; /* another full line right after the marker */
+    }
+    lap.lapMs[(lap.lapNo-1)%LSPD_NOF_LAP_TIMES] = (uint32_t)(now-lap.startTicks)*portTICK_PERIOD_MS;
+    lap.lapFallbacks[(lap.lapNo-1)%LSPD_NOF_LAP_TIMES] = lap.nofFallbacks;
+  }
+  if (lap.state==LSPD_LAP_LEARN) {
+    if (lapMm/LSPM_MAP_BIN_MM<=LSPM_MAP_NOF_BINS) {
+      lap.nofBins = (uint16_t)(lapMm/LSPM_MAP_BIN_MM);
+      LSPM_MapBuild(&config, lap.mapMmS, lap.nofBins, lap.maxPercent);
+      lap.state = LSPD_LAP_RUN;
+    } else { /* track too long for the map */
+      lap.nofBins = 0;
+      lap.state = LSPD_LAP_WAIT;
+    }
+  } else if (lap.state==LSPD_LAP_WAIT) {
+    if (lap.nofBins!=0) {
+      lap.state = LSPD_LAP_RUN; /* map from a previous run */
+    } else {
+      for(i=0;i<LSPM_MAP_NOF_BINS;i++) {
+        lap.mapMmS[i] = 0;
+      }
+      lap.state = LSPD_LAP_LEARN;
+    }
+  }
+  lap.lapNo++;
+  lap.startUm = distUm;
+  lap.startTicks = now;
+  lap.nofFallbacks = 0;
+#if PL_CONFIG_HAS_LAP_TIMING
+  LAPT_AddEvent(LAPT_EVENT_LAP);
+#endif
+}
+
+bool LSPD_PassLapMarker(REF_LineKind kind) {
+  if (!lap.enabled) {
+    return FALSE;
+  }
+  if (kind!=REF_LINE_FULL) {
+    lap.onMarker = FALSE;
+    return FALSE;
+  }
+  if (!lap.onMarker) { /* first frame on the marker */
+    lap.onMarker = TRUE;
+    LSPD_LapMarker(ODO_GetDistanceUm());
+  }
+  return TRUE;
+}
+
+void LSPD_Start(void) {
+  PID_Config *pidConfig;
+
+  LSPM_HistoryReset(&history);
+  curvature = 0;
+  straightStartUm = ODO_GetDistanceUm();
+  lastFrameTimestamp = REF_GetFrameTimestamp();
+  lap.state = lap.enabled?LSPD_LAP_WAIT:LSPD_LAP_OFF; /* position on the track is unknown until the next marker */
+  lap.onMarker = FALSE;
+  lap.fallback = FALSE;
+  lap.lapNo = 0;
+  speedX100 = 0;
+  if (PID_GetPIDConfig(PID_CONFIG_LINE_FW, &pidConfig)==ERR_OK) {
+    speedX100 = (uint16_t)(pidConfig->maxSpeedPercent*100); /* start with the configured speed */
+  }
+}
+
+uint8_t LSPD_GetSpeedPercent(uint16_t lineValue) {
+  ODO_Pose pose;
+  PID_Config *pidConfig;
+  uint32_t headingCurvature, lineCurvature, target, frameUs;
+  int32_t offset;
+
+  ODO_GetPose(&pose);
+  offset = (int32_t)lineValue-REF_MIDDLE_LINE_VALUE;
+  headingCurvature = LSPM_HeadingCurvature(&history, pose.distUm, pose.heading);
+  lineCurvature = LSPM_LineCurvature(offset);
+  LSPM_HistoryAdd(&history, pose.distUm, pose.heading);
+  curvature = headingCurvature>lineCurvature?headingCurvature:lineCurvature;
+  frameUs = REF_TimestampToUs(REF_GetFrameTimestamp()-lastFrameTimestamp);
+  lastFrameTimestamp = REF_GetFrameTimestamp();
+  if (lap.state==LSPD_LAP_LEARN) { /* remember the largest curvature of each bin */
+    LSPM_MapLearn(lap.mapMmS, (pose.distUm-lap.startUm)/1000, curvature);
+  }
+  if (curvature>=LSPD_STRAIGHT_CURVATURE) {
+    straightStartUm = pose.distUm;
+  }
+  /* the learned map is used in lap mode even without the reactive speed control */
+  if ((!config.enabled && lap.state!=LSPD_LAP_RUN) || PID_GetPIDConfig(PID_CONFIG_LINE_FW, &pidConfig)!=ERR_OK) {
+    return 0; /* use the configured line following speed */
+  }
+  target = pidConfig->maxSpeedPercent*100;
+  if (config.enabled) {
+    target = LSPM_TargetX100(&config, target, curvature, pose.distUm-straightStartUm);
+  }
+  if (lap.state==LSPD_LAP_RUN) {
+    if (offset<0) {
+      offset = -offset;
+    }
+    if (!lap.fallback && offset>LSPD_FALLBACK_ENTER) { /* track differs from the map, or we are too fast: reactive speed */
+      lap.fallback = TRUE;
+      lap.nofFallbacks++;
+    } else if (lap.fallback && offset<LSPD_FALLBACK_EXIT) {
+      lap.fallback = FALSE;
+    }
+    if (!lap.fallback) {
+      target = LSPM_MapSpeedX100(&config, lap.mapMmS, lap.nofBins, (pose.distUm-lap.startUm)/1000);
+    }
+  }
+  speedX100 = LSPM_RampX100(&config, speedX100, target, frameUs); /* ramp towards the target */
+  if (speedX100<100) {
+    return 1;
+  }
+  return (uint8_t)(speedX100/100);
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void LSPD_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"lspeed", (unsigned char*)"Group of line following speed control commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows speed control help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  on|off", (unsigned char*)"Adapt the speed to the track, or use the PID fw speed (default)\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  straight|min <%>", (unsigned char*)"Speed on long straights, and lowest speed in curves\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  straightdist <mm>", (unsigned char*)"Distance on a straight before speeding up\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  lat <mm/s2>", (unsigned char*)"Lateral acceleration in curves\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  accel|decel <%/s>", (unsigned char*)"Maximum speed change per second\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  full <mm/s>", (unsigned char*)"Speed with 100%\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  lap on|off", (unsigned char*)"Learn a closed track in the first lap, full line is start/finish. The map is used also with the speed control off\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  lap max <%>", (unsigned char*)"Speed on known straights\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  lap clear", (unsigned char*)"Forget the learned track\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  laps", (unsigned char*)"Print the lap times\r\n", io->stdOut);
+}
+
+static void LSPD_PrintLaps(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  uint16_t n, first;
+
+  if (lap.lapNo<2) {
+    CLS1_SendStr((unsigned char*)"no lap completed\r\n", io->stdOut);
+    return;
+  }
+  first = 1;
+  if (lap.lapNo-1>LSPD_NOF_LAP_TIMES) {
+    first = (uint16_t)(lap.lapNo-LSPD_NOF_LAP_TIMES);
+  }
+  for(n=first;n<lap.lapNo;n++) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"lap ");
+    UTIL1_strcatNum16u(buf, sizeof(buf), n);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)": ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), lap.lapMs[(n-1)%LSPD_NOF_LAP_TIMES]);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms, ");
+    UTIL1_strcatNum16u(buf, sizeof(buf), lap.lapFallbacks[(n-1)%LSPD_NOF_LAP_TIMES]);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" fallbacks\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+  }
+}
+
+static void LSPD_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[64];
+
+  CLS1_SendStatusStr((unsigned char*)"lspeed", (unsigned char*)"\r\n", io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), config.enabled?(unsigned char*)"on, straight ":(unsigned char*)"off, straight ");
+  UTIL1_strcatNum8u(buf, sizeof(buf), config.straightPercent);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"% after ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), config.straightMm);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, min ");
+  UTIL1_strcatNum8u(buf, sizeof(buf), config.minPercent);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"%\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  config", buf, io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"lat ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), config.latAccelMmS2);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm/s2, accel ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), config.accelPercentS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", decel ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), config.decelPercentS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" %/s\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  limits", buf, io->stdOut);
+  UTIL1_Num16uToStr(buf, sizeof(buf), config.fullMmS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm/s\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  full", buf, io->stdOut);
+  UTIL1_Num32uToStr(buf, sizeof(buf), curvature);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" 1/km, speed ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), speedX100/100);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"%\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  curvature", buf, io->stdOut);
+  switch(lap.state) {
+    case LSPD_LAP_WAIT:  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"waiting for marker"); break;
+    case LSPD_LAP_LEARN: UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"learning"); break;
+    case LSPD_LAP_RUN:   UTIL1_strcpy(buf, sizeof(buf), lap.fallback?(unsigned char*)"map, fallback":(unsigned char*)"map"); break;
+    default:             UTIL1_strcpy(buf, sizeof(buf), lap.enabled?(unsigned char*)"on":(unsigned char*)"off"); break;
+  }
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", max ");
+  UTIL1_strcatNum8u(buf, sizeof(buf), lap.maxPercent);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"%, track ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), (uint32_t)lap.nofBins*LSPM_MAP_BIN_MM);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  lap", buf, io->stdOut);
+}
+
+static uint8_t LSPD_ParseValue(const unsigned char *p, int32_t max, uint16_t *valP, const CLS1_StdIOType *io) {
+  int32_t val;
+
+  if (UTIL1_xatoi(&p, &val)==ERR_OK && val>0 && val<=max) {
+    *valP = (uint16_t)val;
+    return ERR_OK;
+  }
+  CLS1_SendStr((unsigned char*)"Wrong argument, must be in the range 1..", io->stdErr);
+  CLS1_SendNum32s(max, io->stdErr);
+  CLS1_SendStr((unsigned char*)"\r\n", io->stdErr);
+  return ERR_FAILED;
+}
+
+uint8_t LSPD_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+  uint16_t val;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"lspeed help")==0) {
+    LSPD_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"lspeed status")==0) {
+    LSPD_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lspeed on")==0) {
+    config.enabled = TRUE;
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lspeed off")==0) {
+    config.enabled = FALSE;
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"lspeed straight ", sizeof("lspeed straight ")-1)==0) {
+    res = LSPD_ParseValue(cmd+sizeof("lspeed straight"), 100, &val, io);
+    if (res==ERR_OK) {
+      config.straightPercent = (uint8_t)val;
+    }
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"lspeed min ", sizeof("lspeed min ")-1)==0) {
+    res = LSPD_ParseValue(cmd+sizeof("lspeed min"), 100, &val, io);
+    if (res==ERR_OK) {
+      config.minPercent = (uint8_t)val;
+    }
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"lspeed straightdist ", sizeof("lspeed straightdist ")-1)==0) {
+    res = LSPD_ParseValue(cmd+sizeof("lspeed straightdist"), 0xFFFF, &config.straightMm, io);
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"lspeed lat ", sizeof("lspeed lat ")-1)==0) {
+    res = LSPD_ParseValue(cmd+sizeof("lspeed lat"), 0xFFFF, &config.latAccelMmS2, io);
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"lspeed accel ", sizeof("lspeed accel ")-1)==0) {
+    res = LSPD_ParseValue(cmd+sizeof("lspeed accel"), 10000, &config.accelPercentS, io);
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"lspeed decel ", sizeof("lspeed decel ")-1)==0) {
+    res = LSPD_ParseValue(cmd+sizeof("lspeed decel"), 10000, &config.decelPercentS, io);
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"lspeed full ", sizeof("lspeed full ")-1)==0) {
+    res = LSPD_ParseValue(cmd+sizeof("lspeed full"), 0xFFFF, &config.fullMmS, io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lspeed lap on")==0) {
+    lap.enabled = TRUE;
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lspeed lap off")==0) {
+    lap.enabled = FALSE;
+    lap.state = LSPD_LAP_OFF;
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lspeed lap clear")==0) {
+    lap.nofBins = 0;
+    if (lap.state!=LSPD_LAP_OFF) {
+      lap.state = LSPD_LAP_WAIT; /* learn again with the next marker */
+    }
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"lspeed lap max ", sizeof("lspeed lap max ")-1)==0) {
+    res = LSPD_ParseValue(cmd+sizeof("lspeed lap max"), 100, &val, io);
+    if (res==ERR_OK) {
+      lap.maxPercent = (uint8_t)val; /* used for the next map */
+    }
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lspeed laps")==0) {
+    LSPD_PrintLaps(io);
+    *handled = TRUE;
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void LSPD_Deinit(void) {
+  /* nothing needed */
+}
+
+void LSPD_Init(void) {
+  LSPM_HistoryReset(&history);
+  curvature = 0;
+  speedX100 = 0;
+}
+
+#endif /* PL_CONFIG_HAS_LINE_SPEED */
@@ -0,0 +1,63 @@
+/**
+ * \file
+ * \brief Line following speed control interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Adapts the line following speed to the track: the curvature is estimated from the line position (the sensors are ahead of the wheels)
+ * and from the heading change of the last few centimeters. The robot slows down before tight curves and speeds up on long straights,
+ * with limited acceleration and deceleration.
+ * On a closed track, the lap mode learns the curvature along the first lap (start/finish marked with a full line) and drives the following laps
+ * with a speed map: braking before the known curves and full speed on the known straights.
+ */
+
+#ifndef LINESPEED_H_
+#define LINESPEED_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LINE_SPEED
+#include "Reflectance.h"
+
+/*!
+ * \brief Called when line following starts, forgets the history of the previous run.
+ */
+void LSPD_Start(void);
+
+/*!
+ * \brief Decides if a full line is the lap marker, which is crossed without stopping. Needs to be called for every frame while following a segment.
+ * \param kind Current line kind
+ * \return TRUE if the line following shall go straight over the line, FALSE to handle the line kind as usual
+ */
+bool LSPD_PassLapMarker(REF_LineKind kind);
+
+/*!
+ * \brief Calculates the speed for the current reflectance frame. Needs to be called once for every frame while following the line.
+ * \param lineValue Line value of the frame
+ * \return Speed in percent, or zero if the configured line following speed shall be used
+ */
+uint8_t LSPD_GetSpeedPercent(uint16_t lineValue);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Module command line parser
+ * \param cmd Pointer to command string to be parsed
+ * \param handled Set to TRUE if command has handled by parser
+ * \param io Shell standard I/O handler
+ * \return Error code, ERR_OK if everything was ok
+ */
+uint8_t LSPD_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*!
+ * \brief Module de-initialization.
+ */
+void LSPD_Deinit(void);
+
+/*!
+ * \brief Module initialization.
+ */
+void LSPD_Init(void);
+
+#endif /* PL_CONFIG_HAS_LINE_SPEED */
+
+#endif /* LINESPEED_H_ */
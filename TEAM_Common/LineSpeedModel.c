@@ -0,0 +1,187 @@
+/**
+ * \file
+ * \brief Line following speed model implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Calculates the speed of the line following from the track, without hardware access, so it can be tested on the host.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LINE_SPEED
+#include "LineSpeedModel.h"
+
+#define LSPM_SENSOR_PITCH_UM      9500  /* distance between two reflectance sensors */
+#define LSPM_LOOKAHEAD_MM         40    /* distance of the reflectance sensors in front of the wheel axis */
+#define LSPM_WINDOW_MM            50    /* heading change is measured over this distance */
+#define LSPM_MIN_WINDOW_MM        10    /* below this distance the heading change is not used */
+#define LSPM_MAX_FRAME_US         100000 /* longer gaps between frames (e.g. after a turn) do not count for the ramp */
+#define LSPM_MAP_LOOKAHEAD_MM     50    /* use the map speed of this distance ahead */
+
+uint32_t LSPM_Sqrt32(uint32_t val) {
+  uint32_t res = 0, bit = 1UL<<30;
+
+  while(bit>val) {
+    bit >>= 2;
+  }
+  while(bit!=0) {
+    if (val>=res+bit) {
+      val -= res+bit;
+      res = (res>>1)+bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return res;
+}
+
+void LSPM_HistoryReset(LSPM_History *history) {
+  history->idx = 0;
+  history->nof = 0;
+}
+
+void LSPM_HistoryAdd(LSPM_History *history, int32_t distUm, ODO_Angle heading) {
+  history->distUm[history->idx] = distUm;
+  history->heading[history->idx] = heading;
+  history->idx = (uint8_t)((history->idx+1)%LSPM_NOF_HISTORY);
+  if (history->nof<LSPM_NOF_HISTORY) {
+    history->nof++;
+  }
+}
+
+uint32_t LSPM_HeadingCurvature(const LSPM_History *history, int32_t distUm, ODO_Angle heading) {
+  int i, idx;
+  int32_t ds, dh;
+
+  for(i=1;i<=history->nof;i++) { /* search back until we have enough distance */
+    idx = (history->idx+LSPM_NOF_HISTORY-i)%LSPM_NOF_HISTORY;
+    ds = distUm-history->distUm[idx];
+    if (ds>=LSPM_WINDOW_MM*1000 || i==history->nof) {
+      if (ds<LSPM_MIN_WINDOW_MM*1000) {
+        return 0; /* too slow, or driving backwards */
+      }
+      dh = (int32_t)(heading-history->heading[idx]);
+      if (dh<0) {
+        dh = -dh;
+      }
+      /* radian per meter times 1000: dh*2*pi/2^32/(ds/1e6)*1000, and 2*pi*1e9/2^32 is about 1.463 */
+      return (uint32_t)(((int64_t)dh*1463)/((int64_t)ds*1000));
+    }
+  }
+  return 0; /* no history yet */
+}
+
+uint32_t LSPM_LineCurvature(int32_t lineOffset) {
+  int32_t offsetUm;
+
+  offsetUm = (lineOffset*LSPM_SENSOR_PITCH_UM)/1000;
+  if (offsetUm<0) {
+    offsetUm = -offsetUm;
+  }
+  /* curvature = 2*offset/lookahead^2, in 1/km */
+  return (uint32_t)((2000*offsetUm)/(LSPM_LOOKAHEAD_MM*LSPM_LOOKAHEAD_MM));
+}
+
+uint32_t LSPM_TargetX100(const LSPM_Config *config, uint32_t speedX100, uint32_t curvature, int32_t straightUm) {
+  uint32_t target, limit;
+
+  target = speedX100;
+  if (straightUm>=(int32_t)config->straightMm*1000 && config->straightPercent*100U>target) {
+    target = config->straightPercent*100U;
+  }
+  /* curves: v^2 = a/curvature */
+  if (curvature!=0 && config->fullMmS!=0) {
+    limit = LSPM_Sqrt32((uint32_t)(((uint64_t)config->latAccelMmS2*1000000)/curvature))*10000/config->fullMmS;
+    if (limit<target) {
+      target = limit;
+    }
+  }
+  return target;
+}
+
+uint16_t LSPM_RampX100(const LSPM_Config *config, uint16_t speedX100, uint32_t targetX100, uint32_t frameUs) {
+  uint32_t step;
+
+  if (targetX100<config->minPercent*100U) {
+    targetX100 = config->minPercent*100U;
+  } else if (targetX100>10000) {
+    targetX100 = 10000;
+  }
+  if (frameUs>LSPM_MAX_FRAME_US) {
+    frameUs = LSPM_MAX_FRAME_US;
+  }
+  if (targetX100>speedX100) {
+    step = (config->accelPercentS*100U*frameUs)/1000000;
+    return (uint16_t)(targetX100-speedX100>step?speedX100+step:targetX100);
+  }
+  step = (config->decelPercentS*100U*frameUs)/1000000;
+  return (uint16_t)(speedX100-targetX100>step?speedX100-step:targetX100);
+}
+
+void LSPM_MapLearn(uint16_t *map, int32_t posMm, uint32_t curvature) {
+  uint32_t bin;
+
+  if (posMm<0) {
+    return;
+  }
+  bin = (uint32_t)posMm/LSPM_MAP_BIN_MM;
+  if (bin<LSPM_MAP_NOF_BINS && curvature>map[bin]) {
+    map[bin] = (uint16_t)(curvature>0xffff?0xffff:curvature);
+  }
+}
+
+/*!
+ * \brief Limits the speed of each bin so it can be reached with the acceleration from the previous bin, around the closed track.
+ * \param accelMmS2 Acceleration
+ * \param dir 1 to limit by the previous bin (accelerating), -1 to limit by the next bin (braking)
+ */
+static void LSPM_MapLimitAccel(uint16_t *map, uint16_t nofBins, uint32_t accelMmS2, int dir) {
+  int i, n, idx, prev;
+  uint32_t v;
+
+  n = nofBins;
+  idx = dir>0?0:n-1;
+  for(i=0;i<2*n;i++) { /* two rounds, so the limit wraps around the lap marker */
+    prev = (idx-dir+n)%n;
+    v = LSPM_Sqrt32((uint32_t)map[prev]*map[prev]+2*accelMmS2*LSPM_MAP_BIN_MM); /* v^2 = v0^2 + 2*a*s */
+    if (v<map[idx]) {
+      map[idx] = (uint16_t)v;
+    }
+    idx = (idx+dir+n)%n;
+  }
+}
+
+void LSPM_MapBuild(const LSPM_Config *config, uint16_t *map, uint16_t nofBins, uint8_t maxPercent) {
+  uint32_t maxMmS, v;
+  int i;
+
+  maxMmS = ((uint32_t)maxPercent*config->fullMmS)/100;
+  for(i=0;i<nofBins;i++) { /* curve speed v^2 = a/curvature */
+    v = maxMmS;
+    if (map[i]!=0) {
+      v = LSPM_Sqrt32((uint32_t)(((uint64_t)config->latAccelMmS2*1000000)/map[i]));
+      if (v>maxMmS) {
+        v = maxMmS;
+      }
+    }
+    map[i] = (uint16_t)v;
+  }
+  LSPM_MapLimitAccel(map, nofBins, ((uint32_t)config->decelPercentS*config->fullMmS)/100, -1); /* braking before curves */
+  LSPM_MapLimitAccel(map, nofBins, ((uint32_t)config->accelPercentS*config->fullMmS)/100, 1); /* accelerating after curves */
+}
+
+uint32_t LSPM_MapSpeedX100(const LSPM_Config *config, const uint16_t *map, uint16_t nofBins, int32_t posMm) {
+  uint32_t v, vAhead;
+
+  if (posMm<0) {
+    posMm = 0;
+  }
+  v = map[(posMm/LSPM_MAP_BIN_MM)%nofBins];
+  vAhead = map[((posMm+LSPM_MAP_LOOKAHEAD_MM)/LSPM_MAP_BIN_MM)%nofBins];
+  if (vAhead<v) {
+    v = vAhead;
+  }
+  return (v*10000)/config->fullMmS;
+}
+
+#endif /* PL_CONFIG_HAS_LINE_SPEED */
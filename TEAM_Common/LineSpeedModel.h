@@ -0,0 +1,126 @@
+/**
+ * \file
+ * \brief Line following speed model interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Curvature estimation, speed limits, speed ramp and lap speed map of the line following speed control.
+ * The functions only work on the provided data and have no hardware dependency.
+ * Curvature is used in 1/km (1000/radius in meters): 0 is a straight line, 10000 a curve with 100 mm radius.
+ */
+
+#ifndef LINESPEEDMODEL_H_
+#define LINESPEEDMODEL_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LINE_SPEED
+#include "Odometry.h"
+
+#define LSPM_NOF_HISTORY          16    /* number of frames in the history, needs to cover the curvature window at full speed */
+#define LSPM_MAP_BIN_MM           25    /* track length for each entry of the speed map */
+#define LSPM_MAP_NOF_BINS         400   /* maximum track length is LSPM_MAP_NOF_BINS*LSPM_MAP_BIN_MM */
+
+typedef struct {
+  bool enabled;            /*!< if the speed control is used */
+  uint8_t straightPercent; /*!< speed on long straights */
+  uint8_t minPercent;      /*!< speed in the tightest curves */
+  uint16_t straightMm;     /*!< distance with low curvature before speeding up to straightPercent */
+  uint16_t latAccelMmS2;   /*!< maximum lateral acceleration in curves */
+  uint16_t accelPercentS;  /*!< maximum speed increase in percent per second */
+  uint16_t decelPercentS;  /*!< maximum speed decrease in percent per second */
+  uint16_t fullMmS;        /*!< speed with 100% */
+} LSPM_Config;
+
+typedef struct {
+  int32_t distUm[LSPM_NOF_HISTORY];    /*!< driven distance of the frame */
+  ODO_Angle heading[LSPM_NOF_HISTORY]; /*!< heading of the frame */
+  uint8_t idx; /*!< next entry to be written */
+  uint8_t nof; /*!< number of valid entries */
+} LSPM_History;
+
+/*!
+ * \brief Integer square root.
+ * \param val Value
+ * \return Square root, rounded down
+ */
+uint32_t LSPM_Sqrt32(uint32_t val);
+
+/*!
+ * \brief Forgets all frames of the history.
+ * \param history History
+ */
+void LSPM_HistoryReset(LSPM_History *history);
+
+/*!
+ * \brief Adds a frame to the history, replacing the oldest frame if the history is full.
+ * \param history History
+ * \param distUm Driven distance
+ * \param heading Heading
+ */
+void LSPM_HistoryAdd(LSPM_History *history, int32_t distUm, ODO_Angle heading);
+
+/*!
+ * \brief Estimates the curvature from the heading change over the last 50 mm of the history.
+ * \param history History of the previous frames
+ * \param distUm Driven distance of the current frame
+ * \param heading Heading of the current frame
+ * \return Curvature, 0 if there is not enough distance in the history
+ */
+uint32_t LSPM_HeadingCurvature(const LSPM_History *history, int32_t distUm, ODO_Angle heading);
+
+/*!
+ * \brief Estimates the curvature ahead from the line offset: a circle tangent to the heading which passes the line in front of the wheels.
+ * \param lineOffset Line offset from the middle, 1000 per sensor
+ * \return Curvature
+ */
+uint32_t LSPM_LineCurvature(int32_t lineOffset);
+
+/*!
+ * \brief Calculates the target speed of the reactive speed control: the straight speed after a long enough straight, limited in curves.
+ * \param config Configuration
+ * \param speedX100 Speed without the speed control, in 1/100 percent
+ * \param curvature Current curvature
+ * \param straightUm Distance driven since the last curve
+ * \return Target speed in 1/100 percent
+ */
+uint32_t LSPM_TargetX100(const LSPM_Config *config, uint32_t speedX100, uint32_t curvature, int32_t straightUm);
+
+/*!
+ * \brief Limits the target speed to the configured range and moves the speed towards it with the configured acceleration and deceleration.
+ * \param config Configuration
+ * \param speedX100 Current speed in 1/100 percent
+ * \param targetX100 Target speed in 1/100 percent
+ * \param frameUs Time since the previous frame
+ * \return New speed in 1/100 percent
+ */
+uint16_t LSPM_RampX100(const LSPM_Config *config, uint16_t speedX100, uint32_t targetX100, uint32_t frameUs);
+
+/*!
+ * \brief Records the curvature for the learning lap: each bin of the map keeps the largest curvature.
+ * \param map Speed map, needs to be cleared before the learning lap
+ * \param posMm Position on the lap
+ * \param curvature Current curvature
+ */
+void LSPM_MapLearn(uint16_t *map, int32_t posMm, uint32_t curvature);
+
+/*!
+ * \brief Converts the curvature recorded in the learning lap into the speed map, with braking before the curves and accelerating after them.
+ * \param config Configuration
+ * \param map Speed map, curvature on entry and speed in mm/s on return
+ * \param nofBins Length of the lap in bins
+ * \param maxPercent Speed on the straights
+ */
+void LSPM_MapBuild(const LSPM_Config *config, uint16_t *map, uint16_t nofBins, uint8_t maxPercent);
+
+/*!
+ * \brief Returns the speed of the map at a position, looking ahead so we are slow enough when reaching a curve.
+ * \param config Configuration
+ * \param map Speed map
+ * \param nofBins Length of the lap in bins, not zero
+ * \param posMm Position on the lap
+ * \return Speed in 1/100 percent
+ */
+uint32_t LSPM_MapSpeedX100(const LSPM_Config *config, const uint16_t *map, uint16_t nofBins, int32_t posMm);
+
+#endif /* PL_CONFIG_HAS_LINE_SPEED */
+
+#endif /* LINESPEEDMODEL_H_ */
@@ -16,6 +16,16 @@
 #include "UTIL1.h"
 #include "Shell.h"
 #include "Reflectance.h"
+#include "MazePath.h"
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  #include "MazeGraph.h"
+#endif
+#if PL_CONFIG_HAS_ODOMETRY
+  #include "Odometry.h"
+#endif
+#if PL_CONFIG_HAS_CONFIG_NVM
+  #include "NVM_Config.h"
+#endif
 
 #define MAZE_MIN_LINE_VAL      0x40   /* minimum value indicating a line */ /* \todo adapt to your needs */
 static uint16_t SensorHistory[REF_NOF_SENSORS]; /* value of history while moving forward */
@@ -76,64 +86,507 @@ void MAZE_ClearSensorHistory(void) {
 }
 
 
-#define MAZE_MAX_PATH        8 /*! \todo maximum number of turns in path */
-
-static TURN_Kind path[MAZE_MAX_PATH]; /* recorded maze */
-static uint8_t pathLength; /* number of entries in path[] */
+static MAZEP_Path path; /* recorded maze */
+static uint16_t solvedIdx; /* index of the next decision while driving the solved path */
 static bool isSolved = FALSE; /* if we have solved the maze */
+static bool driveBack = FALSE; /* TRUE if the solved path gets driven from the finish to the start, path[] always is from the start to the finish */
+static MAZE_Rule mazeRule = MAZE_RULE_LEFT_HAND; /* rule used to explore the maze */
+static bool mazeRoll = TRUE; /* use rolling turns on the solved path */
+
+#if PL_CONFIG_HAS_ODOMETRY
+static uint16_t segLen[MAZEP_MAX_PATH+1]; /* length in mm of the segment ending at each decision, the last one ends in the finish */
+static int32_t segStartUm; /* driven distance at the start of the current segment */
+
+/* default speed profile for driving the solved path */
+#define MAZE_PROFILE_MAX_MMS        800   /* maximum speed */
+#define MAZE_PROFILE_JUNCTION_MMS   250   /* speed when reaching a junction where we turn */
+#define MAZE_PROFILE_ACCEL_MMS2     1500  /* acceleration */
+#define MAZE_PROFILE_DECEL_MMS2     1500  /* deceleration */
+#define MAZE_PROFILE_FULL_MMS       1000  /* speed with 100% line following speed */
+#define MAZE_PROFILE_MARGIN_MM      40    /* the junction gets detected this much before the segment end */
+#define MAZE_CROSS_MAX_MM           60    /* longest distance to cross a junction without turning */
+
+static MAZEP_Profile profile = {TRUE, MAZE_PROFILE_MAX_MMS, MAZE_PROFILE_JUNCTION_MMS, MAZE_PROFILE_ACCEL_MMS2, MAZE_PROFILE_DECEL_MMS2, MAZE_PROFILE_FULL_MMS};
+static uint16_t profSeg; /* segment where we started after the last stop */
+static bool profCrossing = FALSE; /* TRUE while crossing a junction without stopping */
+static int32_t profCrossStartUm; /* driven distance where the crossing started */
 
-static TURN_Kind RevertTurn(TURN_Kind turn) {
-  if (turn==TURN_LEFT90) {
-    turn = TURN_RIGHT90;
-  } else if (turn==TURN_RIGHT90) {
-    turn = TURN_LEFT90;
+/*!
+ * \brief Returns the length of the current segment.
+ * \return Length in mm
+ */
+static uint16_t MAZE_SegmentLengthMm(void) {
+  int32_t len;
+
+  len = (ODO_GetDistanceUm()-segStartUm)/1000;
+  if (len<0) {
+    len = -len;
+  }
+  if (len>0xffff) {
+    len = 0xffff;
   }
-  return turn;
+  return (uint16_t)len;
 }
+#endif /* PL_CONFIG_HAS_ODOMETRY */
 
-/**
- * \brief Reverts the path 
+static uint8_t MAZE_TurnToCode(TURN_Kind turn) {
+  switch(turn) {
+    case TURN_LEFT90:   return MAZEP_CODE_LEFT;
+    case TURN_RIGHT90:  return MAZEP_CODE_RIGHT;
+    case TURN_LEFT180:
+    case TURN_RIGHT180: return MAZEP_CODE_UTURN;
+    default:            return MAZEP_CODE_STRAIGHT;
+  }
+}
+
+static TURN_Kind MAZE_CodeToTurn(uint8_t code) {
+  switch(code) {
+    case MAZEP_CODE_LEFT:  return TURN_LEFT90;
+    case MAZEP_CODE_RIGHT: return TURN_RIGHT90;
+    case MAZEP_CODE_UTURN: return mazeRule==MAZE_RULE_RIGHT_HAND?TURN_RIGHT180:TURN_LEFT180;
+    default:              return TURN_STRAIGHT;
+  }
+}
+
+/*!
+ * \brief Returns a decision of the solved path in the direction we drive it.
+ * \param idx Index of the decision, 0 is the first one after the start of the run
  */
-static void MAZE_RevertPath(void) {
-  int i, j;
-  TURN_Kind tmp;
-  
-  if (pathLength==0) {
-    return;
+static uint8_t MAZE_SolvedCode(uint16_t idx) {
+  return driveBack ? MAZEP_GetBackCode(&path, idx) : MAZEP_GetCode(&path, idx);
+}
+
+/* exits of a junction, relative to the heading when arriving */
+#define MAZE_EXIT_AHEAD      (1<<0)
+#define MAZE_EXIT_RIGHT      (1<<1)
+#define MAZE_EXIT_BACK       (1<<2)
+#define MAZE_EXIT_LEFT       (1<<3)
+
+#if PL_CONFIG_HAS_MAZE_GRAPH
+/* default cost model for the route search */
+#define MAZE_COST_SPEED_MMS      300  /* average speed on segments */
+#define MAZE_COST_TURN90_MS      400  /* time for a 90 degree turn */
+#define MAZE_COST_TURN180_MS     800  /* time for a U-turn */
+#define MAZE_COST_JUNCTION_MS    150  /* time for stepping over a junction */
+
+static MAZEG_Graph graph; /* map built while exploring */
+static MAZEG_Cost graphCost = {MAZE_COST_SPEED_MMS, MAZE_COST_TURN90_MS, MAZE_COST_TURN180_MS, MAZE_COST_JUNCTION_MS};
+static bool graphValid = FALSE; /* FALSE if the map could not be built, e.g. because it was too large */
+static uint8_t graphNode; /* node where the current segment started */
+static uint8_t graphDir; /* absolute direction of the current segment */
+static uint8_t graphGoal = MAZEG_NO_NODE; /* node of the finish area */
+static uint32_t graphRouteMs; /* estimated time of the route */
+static ODO_Pose graphSegStart; /* pose at the start of the current segment */
+
+static MAZEG_Tremaux tremaux; /* marks of the branches used while exploring with the Tremaux rule */
+
+/*!
+ * \brief Returns a binary angle (counter-clockwise) in quarter turns clockwise, rounded to the closest one.
+ */
+static uint8_t MAZE_AngleToQuarterTurns(ODO_Angle angle) {
+  return (uint8_t)(((ODO_Angle)0-angle+ODO_ANGLE_90/2)>>30);
+}
+
+/*!
+ * \brief Starts a new map with the start node, the robot heading ahead.
+ */
+static void MAZE_GraphStart(void) {
+  MAZEG_Clear(&graph);
+  graphGoal = MAZEG_NO_NODE;
+  graphRouteMs = 0;
+  graphValid = MAZEG_AddNode(&graph, 0, 0, 1<<0, &graphNode)==ERR_OK;
+  graphDir = 0;
+  ODO_GetPose(&graphSegStart);
+  MAZEG_TremauxClear(&tremaux);
+  MAZEG_TremauxAddMark(&tremaux, graphNode, graphDir); /* we leave the start ahead */
+}
+
+/*!
+ * \brief Adds the junction at the current position to the map, connected to the node where the segment started.
+ * \param exits Exits of the junction, relative to the heading when arriving (MAZE_EXIT_AHEAD, ...)
+ * \param isGoal TRUE if the junction is the finish area
+ * \return Heading when arriving at the junction, as absolute direction
+ */
+static uint8_t MAZE_GraphAddJunction(uint8_t exits, bool isGoal) {
+  ODO_Pose pose;
+  int32_t dx, dy, len;
+  uint8_t rot, arrival, node, absExits;
+  int i;
+
+  ODO_GetPose(&pose);
+  /* the odometry frame is aligned to the map in quarter turns at the start of each segment, so heading drift does not add up */
+  rot = (uint8_t)((graphDir-MAZE_AngleToQuarterTurns(graphSegStart.heading))&3);
+  arrival = (uint8_t)((rot+MAZE_AngleToQuarterTurns(pose.heading))&3);
+  if (!graphValid) {
+    return arrival;
   }
-  j = pathLength-1;
-  i = 0;
-  while(i<=j) {
-    tmp = path[i];
-    path[i] = RevertTurn(path[j]);
-    path[j] = RevertTurn(tmp);
-    i++; j--;
+  dx = (pose.xUm-graphSegStart.xUm)/1000;
+  dy = -(pose.yUm-graphSegStart.yUm)/1000; /* odometry y is to the left */
+  MAZEG_Rotate(rot, &dx, &dy);
+  len = (pose.distUm-graphSegStart.distUm)/1000;
+  if (len<0) {
+    len = -len;
+  }
+  if (len>0xffff) {
+    len = 0xffff;
+  }
+  absExits = 0;
+  for(i=0;i<MAZEG_NOF_DIRS;i++) {
+    if (exits&(1<<i)) {
+      absExits |= 1<<((arrival+i)&3);
+    }
   }
+  if (MAZEG_AddNode(&graph, (int16_t)(graph.node[graphNode].xMm+dx), (int16_t)(graph.node[graphNode].yMm+dy), absExits, &node)!=ERR_OK) {
+    graphValid = FALSE; /* too many junctions, use the simplified path only */
+    return arrival;
+  }
+  MAZEG_Link(&graph, graphNode, graphDir, node, arrival, (uint16_t)len);
+  if (isGoal) {
+    graph.node[node].flags |= MAZEG_FLAG_GOAL;
+    graphGoal = node;
+  }
+  graphNode = node;
+  return arrival;
+}
+
+/*!
+ * \brief Replaces the path with the fastest route from the start to the finish through the map.
+ * \return Error code, ERR_OK if the path has been replaced
+ */
+static uint8_t MAZE_GraphRoute(void) {
+  uint8_t turns[MAZEG_MAX_NODES], res;
+  uint16_t i, nofTurns;
+
+  if (!graphValid || graphGoal==MAZEG_NO_NODE) {
+    return ERR_FAILED;
+  }
+#if PL_CONFIG_HAS_ODOMETRY
+  res = MAZEG_ShortestRoute(&graph, &graphCost, 0, 0, graphGoal, turns, segLen, sizeof(turns), &nofTurns, &graphRouteMs);
+#else
+  res = MAZEG_ShortestRoute(&graph, &graphCost, 0, 0, graphGoal, turns, NULL, sizeof(turns), &nofTurns, &graphRouteMs);
+#endif
+  if (res!=ERR_OK) {
+    return res;
+  }
+  for(i=0;i<nofTurns;i++) {
+    MAZEP_SetCode(&path, i, MAZEP_AngleToCode(turns[i]*90));
+  }
+  path.length = nofTurns;
+  return ERR_OK;
+}
+
+/*!
+ * \brief Called in the finish area while exploring with the Tremaux rule. If a faster route might still exist, we turn around and explore further.
+ * \param arrival Heading when arriving at the finish
+ * \return TRUE if exploring continues
+ */
+static bool MAZE_TremauxLeaveGoal(uint8_t arrival) {
+  uint8_t dir;
+
+  if (mazeRule!=MAZE_RULE_TREMAUX || !graphValid || tremaux.toGoal || MAZEG_TremauxIsExplored(&graph, &graphCost, graphGoal)) {
+    return FALSE;
+  }
+  dir = (uint8_t)((arrival+2)&3);
+  MAZEG_TremauxAddMark(&tremaux, graphNode, dir); /* in */
+  MAZEG_TremauxAddMark(&tremaux, graphNode, dir); /* and out again */
+  graphDir = dir;
+  MAZE_AddPath(TURN_LEFT180);
+  TURN_Turn(TURN_STEP_LINE_BW_POST_LINE, NULL); /* back to the border of the finish area */
+  (void)TURN_TurnToLine(TURN_LEFT180, NULL);
+  ODO_GetPose(&graphSegStart);
+  segStartUm = ODO_GetDistanceUm();
+  return TRUE;
+}
+#endif /* PL_CONFIG_HAS_MAZE_GRAPH */
+
+/*!
+ * \brief Returns the exits of a junction.
+ * \param prev Line kind seen while passing the junction
+ * \param curr Line kind after the junction
+ * \return Exits relative to the heading when arriving (MAZE_EXIT_AHEAD, ...)
+ */
+static uint8_t MAZE_JunctionExits(REF_LineKind prev, REF_LineKind curr) {
+  uint8_t exits = MAZE_EXIT_BACK; /* we can always go back */
+
+  if (prev==REF_LINE_LEFT || prev==REF_LINE_FULL) {
+    exits |= MAZE_EXIT_LEFT;
+  }
+  if (prev==REF_LINE_RIGHT || prev==REF_LINE_FULL) {
+    exits |= MAZE_EXIT_RIGHT;
+  }
+  if (curr!=REF_LINE_NONE) { /* line continues ahead */
+    exits |= MAZE_EXIT_AHEAD;
+  }
+  return exits;
+}
+
+#if PL_CONFIG_HAS_CONFIG_NVM
+#define MAZE_NVM_VERSION    2 /* increment if MAZE_NVMData_t changes */
+
+typedef struct {
+  uint16_t version;   /* MAZE_NVM_VERSION */
+  uint16_t crc;       /* CRC of the data after the header */
+  uint16_t pathLength; /* number of decisions in path[] */
+  uint8_t rule;       /* MAZE_Rule used for exploring */
+  uint8_t hasGraph;   /* if graph is valid */
+  uint8_t path[MAZEP_MAX_PATH/4]; /* solved path from the start to the finish */
+#if PL_CONFIG_HAS_ODOMETRY
+  uint16_t segLen[MAZEP_MAX_PATH+1]; /* length of the segments in mm */
+#endif
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  uint32_t routeMs;   /* estimated time of the route */
+  uint8_t goal;       /* node of the finish area */
+  MAZEG_Graph graph;  /* map */
+#endif
+} MAZE_NVMData_t;
+
+#define MAZE_NVM_HEADER_SIZE  (2*2) /* version and CRC, not covered by the CRC */
+
+static MAZE_NVMData_t nvmData; /* too large for the task stack */
+static bool nvmStored = FALSE; /* if the current solution is in FLASH */
+
+/*!
+ * \brief CRC-16-CCITT (polynomial 0x1021, start value 0xFFFF).
+ */
+static uint16_t MAZE_Crc16(const uint8_t *data, size_t size) {
+  uint16_t crc = 0xffff;
+  int i;
+
+  while(size>0) {
+    crc ^= (uint16_t)(*data<<8);
+    for(i=0;i<8;i++) {
+      if (crc&0x8000) {
+        crc = (uint16_t)((crc<<1)^0x1021);
+      } else {
+        crc <<= 1;
+      }
+    }
+    data++;
+    size--;
+  }
+  return crc;
+}
+
+/*!
+ * \brief Stores the solution with the path from the start to the finish.
+ * \return Error code, ERR_OK if everything is fine
+ */
+static uint8_t MAZE_StoreToFlash(void) {
+  size_t i;
+  uint8_t res;
+
+  for(i=0;i<sizeof(nvmData);i++) {
+    ((uint8_t*)&nvmData)[i] = 0; /* no random padding bytes in the CRC */
+  }
+  nvmData.version = MAZE_NVM_VERSION;
+  nvmData.pathLength = path.length;
+  nvmData.rule = (uint8_t)mazeRule;
+  for(i=0;i<sizeof(path.code);i++) {
+    nvmData.path[i] = path.code[i];
+  }
+#if PL_CONFIG_HAS_ODOMETRY
+  for(i=0;i<=path.length;i++) {
+    nvmData.segLen[i] = segLen[i];
+  }
+#endif
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  nvmData.hasGraph = graphValid;
+  nvmData.routeMs = graphRouteMs;
+  nvmData.goal = graphGoal;
+  nvmData.graph = graph; /* struct copy */
+#endif
+  nvmData.crc = MAZE_Crc16((uint8_t*)&nvmData+MAZE_NVM_HEADER_SIZE, sizeof(nvmData)-MAZE_NVM_HEADER_SIZE);
+  res = NVMC_SaveMazeData(&nvmData, sizeof(nvmData));
+  nvmStored = res==ERR_OK;
+  return res;
+}
+
+/*!
+ * \brief Loads the solution from FLASH, if there is a valid one.
+ * \return Error code, ERR_OK if a solution has been loaded
+ */
+static uint8_t MAZE_LoadFromFlash(void) {
+  const MAZE_NVMData_t *ptr;
+  size_t i;
+
+  ptr = (const MAZE_NVMData_t*)NVMC_GetMazeData();
+  if (ptr==NULL || ptr->version!=MAZE_NVM_VERSION || ptr->pathLength>MAZEP_MAX_PATH) {
+    return ERR_FAILED; /* nothing stored, or from an older firmware */
+  }
+  if (MAZE_Crc16((const uint8_t*)ptr+MAZE_NVM_HEADER_SIZE, sizeof(MAZE_NVMData_t)-MAZE_NVM_HEADER_SIZE)!=ptr->crc) {
+    return ERR_FAILED; /* corrupted, e.g. reset while writing */
+  }
+  for(i=0;i<sizeof(path.code);i++) {
+    path.code[i] = ptr->path[i];
+  }
+#if PL_CONFIG_HAS_ODOMETRY
+  for(i=0;i<=ptr->pathLength;i++) {
+    segLen[i] = ptr->segLen[i];
+  }
+#endif
+  path.length = ptr->pathLength;
+  mazeRule = (MAZE_Rule)ptr->rule;
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  graphValid = ptr->hasGraph && ptr->graph.nofNodes<=MAZEG_MAX_NODES;
+  if (graphValid) {
+    graph = ptr->graph; /* struct copy */
+    graphGoal = ptr->goal;
+    graphRouteMs = ptr->routeMs;
+  }
+#endif
+  isSolved = TRUE;
+  driveBack = FALSE; /* after a reset, we are at the start */
+  solvedIdx = 0;
+  nvmStored = TRUE;
+  return ERR_OK;
+}
+
+/*!
+ * \brief Invalidates the solution in FLASH.
+ * \return Error code, ERR_OK if everything is fine
+ */
+static uint8_t MAZE_EraseFlash(void) {
+  uint16_t header[MAZE_NVM_HEADER_SIZE/2];
+
+  if (NVMC_GetMazeData()==NULL) {
+    return ERR_OK; /* nothing stored */
+  }
+  header[0] = 0; /* no valid version */
+  header[1] = 0;
+  nvmStored = FALSE;
+  return NVMC_SaveMazeData(header, sizeof(header));
+}
+#endif /* PL_CONFIG_HAS_CONFIG_NVM */
+
+void MAZE_SetRule(MAZE_Rule rule) {
+  mazeRule = rule;
 }
 
 TURN_Kind MAZE_SelectTurn(REF_LineKind prev, REF_LineKind curr) {
-  if (prev==REF_LINE_NONE && curr==REF_LINE_NONE) { /* dead end */
-    return TURN_RIGHT180; /* make U turn */
+  uint8_t exits;
+  bool left, right, straight;
+
+  if (prev==REF_LINE_FULL && curr==REF_LINE_FULL) { /* still black after stepping over the line */
+    return TURN_FINISHED;
+  }
+  exits = MAZE_JunctionExits(prev, curr);
+  left = (exits&MAZE_EXIT_LEFT)!=0;
+  right = (exits&MAZE_EXIT_RIGHT)!=0;
+  straight = (exits&MAZE_EXIT_AHEAD)!=0;
+  if (mazeRule!=MAZE_RULE_RIGHT_HAND) { /* Tremaux falls back to the left hand rule */
+    if (left) {
+      return TURN_LEFT90;
+    } else if (straight) {
+      return TURN_STRAIGHT;
+    } else if (right) {
+      return TURN_RIGHT90;
+    }
+    return TURN_LEFT180; /* dead end */
+  } else {
+    if (right) {
+      return TURN_RIGHT90;
+    } else if (straight) {
+      return TURN_STRAIGHT;
+    } else if (left) {
+      return TURN_LEFT90;
+    }
+    return TURN_RIGHT180; /* dead end */
   }
-  /*! \todo Implement all cases for turning */
-  return TURN_STOP; /* error case */
 }
 
 void MAZE_SetSolved(void) {
   isSolved = TRUE;
-  /*! \todo here the path could be reverted */
-  MAZE_RevertPath();
-  MAZE_AddPath(TURN_STOP); /* add an action to stop */
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  (void)MAZE_GraphRoute(); /* if the map is usable, use the fastest route instead of the simplified path */
+#endif
+#if PL_CONFIG_HAS_CONFIG_NVM
+  if (MAZE_StoreToFlash()!=ERR_OK) { /* same path as in RAM, from the start to the finish */
+    SHELL_SendString((unsigned char*)"MAZE: storing to FLASH failed!\r\n");
+  }
+#endif
+  driveBack = TRUE; /* we are at the finish */
+  solvedIdx = 0;
+}
+
+void MAZE_StartRun(void) {
+#if PL_CONFIG_HAS_ODOMETRY
+  segStartUm = ODO_GetDistanceUm();
+  profSeg = 0;
+  profCrossing = FALSE;
+#endif
+  if (isSolved) {
+    solvedIdx = 0; /* drive the solution from the beginning */
+    return;
+  }
+  MAZE_ClearSolution(); /* explore again from the start */
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  MAZE_GraphStart();
+#endif
+}
+
+uint8_t MAZE_GetSpeedPercent(void) {
+#if PL_CONFIG_HAS_ODOMETRY
+  int32_t travelled, dist;
+
+  if (!profile.enabled || !isSolved || profSeg>path.length || profile.fullMmS==0) {
+    return 0; /* use the configured line following speed */
+  }
+  travelled = (ODO_GetDistanceUm()-segStartUm)/1000;
+  /* distance to the next junction where we have to turn (straight junctions are crossed without stopping), or the finish */
+  dist = (int32_t)MAZEP_TurnDistMm(&path, segLen, driveBack, profSeg);
+  return MAZEP_ProfileSpeedPercent(&profile, travelled, dist-travelled-MAZE_PROFILE_MARGIN_MM);
+#else
+  return 0; /* use the configured line following speed */
+#endif
+}
+
+bool MAZE_PassJunction(REF_LineKind kind) {
+#if PL_CONFIG_HAS_ODOMETRY
+  if (kind==REF_LINE_STRAIGHT) {
+    profCrossing = FALSE; /* on the line again */
+    return FALSE;
+  }
+  if (!profile.enabled || !isSolved) {
+    return FALSE;
+  }
+  if (profCrossing) {
+    if ((ODO_GetDistanceUm()-profCrossStartUm)/1000>MAZE_CROSS_MAX_MM) { /* line not found again */
+      profCrossing = FALSE;
+      if (kind==REF_LINE_NONE && solvedIdx>=path.length) {
+        /* crossed the last decision and the line ends: end of the solved path, MAZE_EvaluteTurn() finishes the run */
+      } else if (solvedIdx>0) {
+        solvedIdx--; /* let MAZE_EvaluteTurn() handle the junction */
+      }
+      return FALSE;
+    }
+    return TRUE;
+  }
+  if (kind!=REF_LINE_NONE && solvedIdx<path.length && MAZE_SolvedCode(solvedIdx)==MAZEP_CODE_STRAIGHT) {
+    profCrossing = TRUE;
+    profCrossStartUm = ODO_GetDistanceUm();
+    solvedIdx++; /* decision is done */
+    return TRUE;
+  }
+#else
+  (void)kind;
+#endif
+  return FALSE;
 }
 
 bool MAZE_IsSolved(void) {
   return isSolved;
 }
 
+uint16_t MAZE_GetPathLength(void) {
+  return path.length;
+}
+
 void MAZE_AddPath(TURN_Kind kind) {
-  if (pathLength<MAZE_MAX_PATH) {
-    path[pathLength] = kind;
-    pathLength++;
+  if (path.length<MAZEP_MAX_PATH) {
+#if PL_CONFIG_HAS_ODOMETRY
+    segLen[path.length] = MAZE_SegmentLengthMm(); /* the dead end segments get dropped with the simplification */
+#endif
+    (void)MAZEP_Add(&path, MAZE_TurnToCode(kind)); /* cuts dead ends right away, so the path only grows with the solution */
   } else {
     /* error! */
   }
@@ -143,9 +596,10 @@ void MAZE_AddPath(TURN_Kind kind) {
  * \brief Performs path simplification.
  * The idea is that whenever we encounter x-TURN_RIGHT180-x or x-TURN_LEFT180-x, we simplify it by cutting the dead end.
  * For example if we have TURN_LEFT90-TURN_RIGHT180-TURN_LEFT90, this can be simplified with TURN_STRAIGHT.
+ * The three decisions are replaced by the sum of their heading changes.
  */
 void MAZE_SimplifyPath(void) {
-  /*! \todo */
+  (void)MAZEP_Simplify(&path);
 }
 
 /*!
@@ -155,62 +609,254 @@ void MAZE_SimplifyPath(void) {
 uint8_t MAZE_EvaluteTurn(bool *finished) {
   REF_LineKind historyLineKind, currLineKind;
   TURN_Kind turn;
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  uint8_t arrival;
+#endif
 
   *finished = FALSE;
   currLineKind = REF_GetLineKind();
   if (currLineKind==REF_LINE_NONE) { /* nothing, must be dead end */
-    turn = TURN_LEFT180;
+    historyLineKind = REF_LINE_NONE;
+    if (isSolved && solvedIdx>=path.length) {
+      turn = TURN_STOP; /* end of the solved path: the start is a dead end */
+    } else {
+      turn = MAZE_SelectTurn(REF_LINE_NONE, REF_LINE_NONE);
+    }
   } else {
     MAZE_ClearSensorHistory(); /* clear history values */
     MAZE_SampleSensorHistory(); /* store current values */
-    TURN_Turn(TURN_STEP_LINE_FW_POST_LINE, MAZE_SampleTurnStopFunction); /* do the line and beyond in one step */
+    if (isSolved && mazeRoll) {
+      (void)TURN_RollTurn(TURN_STEP_LINE_FW_POST_LINE, MAZE_SampleTurnStopFunction); /* the turns are known: do not stop at the junction */
+    } else {
+      TURN_Turn(TURN_STEP_LINE_FW_POST_LINE, MAZE_SampleTurnStopFunction); /* do the line and beyond in one step */
+    }
     historyLineKind = MAZE_HistoryLineKind(); /* new read new values */
     currLineKind = REF_GetLineKind();
     turn = MAZE_SelectTurn(historyLineKind, currLineKind);
+    if (isSolved && turn!=TURN_FINISHED) {
+      turn = MAZE_GetSolvedTurn(&solvedIdx); /* use the solution instead of exploring */
+    }
   }
-  if (turn==TURN_FINISHED) {
+  if (turn==TURN_FINISHED || (isSolved && turn==TURN_STOP)) { /* finish area, or end of the solved path */
+    if (!isSolved) {
+#if PL_CONFIG_HAS_MAZE_GRAPH
+      arrival = MAZE_GraphAddJunction(MAZE_EXIT_BACK, TRUE);
+      if (MAZE_TremauxLeaveGoal(arrival)) {
+        return ERR_OK; /* there might be a faster route */
+      }
+#endif
+#if PL_CONFIG_HAS_ODOMETRY
+      segLen[path.length] = MAZE_SegmentLengthMm(); /* last segment, into the finish */
+#endif
+      MAZE_SetSolved(); /* we can drive the path back */
+    } else {
+      driveBack = !driveBack; /* next run is in the other direction */
+      solvedIdx = 0;
+    }
     *finished = TRUE;
     LF_StopFollowing();
     SHELL_SendString((unsigned char*)"MAZE: finished!\r\n");
     return ERR_OK;
-  } else if (turn==TURN_STRAIGHT) {
-    /*! \todo Extend if necessary */
-    SHELL_SendString((unsigned char*)"going straight\r\n");
-    return ERR_OK;
   } else if (turn==TURN_STOP) { /* should not happen here? */
     LF_StopFollowing();
     SHELL_SendString((unsigned char*)"Failure, stopped!!!\r\n");
     return ERR_FAILED; /* error case */
-  } else { /* turn or do something */
-    /*! \todo Extend if necessary */
-   return ERR_OK; /* turn finished */
   }
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  if (!isSolved) {
+    arrival = MAZE_GraphAddJunction(MAZE_JunctionExits(historyLineKind, currLineKind), FALSE);
+    if (mazeRule==MAZE_RULE_TREMAUX && graphValid) {
+      turn = MAZE_CodeToTurn(MAZEP_AngleToCode((uint16_t)(((MAZEG_TremauxSelectDir(&tremaux, &graph, &graphCost, graphGoal, graphNode, arrival)-arrival)&3)*90)));
+    }
+    /* leave the junction in the direction of the turn */
+    graphDir = (uint8_t)((arrival+MAZEP_CodeToAngle(MAZE_TurnToCode(turn))/90)&3);
+  }
+#endif
+  if (!isSolved) {
+    MAZE_AddPath(turn);
+  }
+  if (isSolved && mazeRoll) {
+    (void)TURN_RollTurn(turn, NULL); /* arc until we see the line again, U turns are on the spot */
+  } else if (turn!=TURN_STRAIGHT) {
+    (void)TURN_TurnToLine(turn, NULL); /* turn until we see the line again */
+  }
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  ODO_GetPose(&graphSegStart); /* next segment starts here */
+#endif
+#if PL_CONFIG_HAS_ODOMETRY
+  segStartUm = ODO_GetDistanceUm();
+  profSeg = solvedIdx; /* speed profile restarts from standstill */
+#endif
+  return ERR_OK;
 }
 
+#if PL_CONFIG_HAS_SHELL
 static void MAZE_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"maze", (unsigned char*)"Group of maze following commands\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows maze help or status\r\n", io->stdOut);
-  CLS1_SendHelpStr((unsigned char*)"  clear", (unsigned char*)"Clear the maze solution\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  clear", (unsigned char*)"Clear the maze solution, in RAM and FLASH\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  rule left|right", (unsigned char*)"Use left hand or right hand rule to explore the maze\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  roll on|off", (unsigned char*)"Rolling turns at the junctions of the solved path\r\n", io->stdOut);
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  CLS1_SendHelpStr((unsigned char*)"  rule tremaux", (unsigned char*)"Explore unused branches first, stop when no faster route is possible\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  graph", (unsigned char*)"Print the map of junctions built while exploring\r\n", io->stdOut);
+#endif
+#if PL_CONFIG_HAS_ODOMETRY
+  CLS1_SendHelpStr((unsigned char*)"  profile on|off", (unsigned char*)"Use the speed profile while driving the solved path\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  profile max|junction <mm/s>", (unsigned char*)"Maximum speed, and speed when reaching a junction where we turn\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  profile accel|decel <mm/s2>", (unsigned char*)"Acceleration, and deceleration for the braking distance\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  profile full <mm/s>", (unsigned char*)"Speed with 100% line following speed\r\n", io->stdOut);
+#endif
 }
 
-#if PL_CONFIG_HAS_SHELL
+#if PL_CONFIG_HAS_MAZE_GRAPH
+static void MAZE_PrintGraph(const CLS1_StdIOType *io) {
+  static const unsigned char dirChar[] = "ARBL"; /* ahead, right, back, left of the start heading */
+  unsigned char buf[48];
+  int i, d;
+  MAZEG_Node *node;
+
+  CLS1_SendStr((unsigned char*)"node   x mm   y mm  links (dir:node/mm)\r\n", io->stdOut);
+  for(i=0;i<graph.nofNodes;i++) {
+    node = &graph.node[i];
+    UTIL1_Num16uToStrFormatted(buf, sizeof(buf), (uint16_t)i, ' ', 4);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ");
+    UTIL1_strcatNum16sFormatted(buf, sizeof(buf), node->xMm, ' ', 6);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ");
+    UTIL1_strcatNum16sFormatted(buf, sizeof(buf), node->yMm, ' ', 6);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ");
+    CLS1_SendStr(buf, io->stdOut);
+    for(d=0;d<MAZEG_NOF_DIRS;d++) {
+      if (node->exits&(1<<d)) {
+        buf[0] = ' ';
+        buf[1] = dirChar[d];
+        buf[2] = ':';
+        buf[3] = '\0';
+        if (node->neighbor[d]==MAZEG_NO_NODE) {
+          UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"?"); /* not explored */
+        } else {
+          UTIL1_strcatNum8u(buf, sizeof(buf), node->neighbor[d]);
+          UTIL1_chcat(buf, sizeof(buf), '/');
+          UTIL1_strcatNum16u(buf, sizeof(buf), node->lenMm[d]);
+        }
+        CLS1_SendStr(buf, io->stdOut);
+      }
+    }
+    CLS1_SendStr((node->flags&MAZEG_FLAG_GOAL)?(unsigned char*)" goal\r\n":(unsigned char*)"\r\n", io->stdOut);
+  }
+}
+#endif
+
 static void MAZE_PrintStatus(const CLS1_StdIOType *io) {
-  int i;
-  
+  static const unsigned char codeChar[] = "LSRU"; /* indexed by path code */
+  unsigned char buf[64];
+  int i, j;
+
   CLS1_SendStatusStr((unsigned char*)"maze", (unsigned char*)"\r\n", io->stdOut);
   CLS1_SendStatusStr((unsigned char*)"  solved", MAZE_IsSolved()?(unsigned char*)"yes\r\n":(unsigned char*)"no\r\n", io->stdOut);
+#if PL_CONFIG_HAS_CONFIG_NVM
+  if (nvmStored) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"stored, version ");
+    UTIL1_strcatNum16u(buf, sizeof(buf), MAZE_NVM_VERSION);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", CRC 0x");
+    UTIL1_strcatNum16Hex(buf, sizeof(buf), ((const MAZE_NVMData_t*)NVMC_GetMazeData())->crc);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  } else {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"not stored\r\n");
+  }
+  CLS1_SendStatusStr((unsigned char*)"  FLASH", buf, io->stdOut);
+#endif
+  if (mazeRule==MAZE_RULE_LEFT_HAND) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"left hand\r\n");
+  } else if (mazeRule==MAZE_RULE_RIGHT_HAND) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"right hand\r\n");
+  } else {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"Tremaux");
+#if PL_CONFIG_HAS_MAZE_GRAPH
+    if (tremaux.toGoal) {
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", explored");
+    }
+#endif
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  }
+  CLS1_SendStatusStr((unsigned char*)"  rule", buf, io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  roll", mazeRoll?(unsigned char*)"on\r\n":(unsigned char*)"off\r\n", io->stdOut);
+#if PL_CONFIG_HAS_ODOMETRY
+  UTIL1_strcpy(buf, sizeof(buf), profile.enabled?(unsigned char*)"on, max ":(unsigned char*)"off, max ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), profile.maxMmS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", junction ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), profile.junctionMmS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm/s\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  profile", buf, io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"accel ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), profile.accelMmS2);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", decel ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), profile.decelMmS2);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm/s2, full ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), profile.fullMmS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm/s\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  ramp", buf, io->stdOut);
+#endif
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  UTIL1_Num8uToStr(buf, sizeof(buf), graph.nofNodes);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" nodes");
+  if (!graphValid) {
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", overflow");
+  } else if (graphGoal!=MAZEG_NO_NODE) {
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", goal ");
+    UTIL1_strcatNum8u(buf, sizeof(buf), graphGoal);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", route ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), graphRouteMs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms");
+  }
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  graph", buf, io->stdOut);
+#endif
   CLS1_SendStatusStr((unsigned char*)"  path", (unsigned char*)"(", io->stdOut);
-  CLS1_SendNum8u(pathLength, io->stdOut);
+  CLS1_SendNum16u(path.length, io->stdOut);
   CLS1_SendStr((unsigned char*)") ", io->stdOut);
-  for(i=0;i<pathLength;i++) {
-    CLS1_SendStr(TURN_TurnKindStr(path[i]), io->stdOut);
-    CLS1_SendStr((unsigned char*)" ", io->stdOut);
+  j = 0;
+  for(i=0;i<path.length;i++) { /* one letter for each decision: L, S, R or U */
+    buf[j++] = codeChar[MAZEP_GetCode(&path, i)];
+    if (j==sizeof(buf)-1 || i==path.length-1) {
+      buf[j] = '\0';
+      CLS1_SendStr(buf, io->stdOut);
+      j = 0;
+    }
+  }
+  if (isSolved && driveBack) {
+    CLS1_SendStr((unsigned char*)", next run backward from the finish", io->stdOut);
+  }
+  CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
+#if PL_CONFIG_HAS_ODOMETRY
+  CLS1_SendStatusStr((unsigned char*)"  segments", (unsigned char*)"", io->stdOut);
+  for(i=0;i<=path.length && path.length!=0;i++) { /* length in mm of each segment */
+    UTIL1_Num16uToStr(buf, sizeof(buf), segLen[i]);
+    UTIL1_chcat(buf, sizeof(buf), ' ');
+    CLS1_SendStr(buf, io->stdOut);
   }
   CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
+#endif
 }
 
+#if PL_CONFIG_HAS_ODOMETRY
+static uint8_t MAZE_ParseProfileValue(const unsigned char *p, uint16_t *valP, const CLS1_StdIOType *io) {
+  int32_t val;
+
+  if (UTIL1_xatoi(&p, &val)==ERR_OK && val>0 && val<=0xFFFF) {
+    *valP = (uint16_t)val;
+    return ERR_OK;
+  }
+  CLS1_SendStr((unsigned char*)"Wrong argument, must be in the range 1..65535\r\n", io->stdErr);
+  return ERR_FAILED;
+}
+#endif
+
 uint8_t MAZE_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
   uint8_t res = ERR_OK;
+#if PL_CONFIG_HAS_ODOMETRY
+  const unsigned char *p;
+#endif
 
   if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"maze help")==0) {
     MAZE_PrintHelp(io);
@@ -220,15 +866,69 @@ uint8_t MAZE_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_St
     *handled = TRUE;
   } else if (UTIL1_strcmp((char*)cmd, (char*)"maze clear")==0) {
     MAZE_ClearSolution();
+#if PL_CONFIG_HAS_CONFIG_NVM
+    res = MAZE_EraseFlash();
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"Clearing FLASH failed!\r\n", io->stdErr);
+    }
+#endif
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"maze rule left")==0) {
+    MAZE_SetRule(MAZE_RULE_LEFT_HAND);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"maze rule right")==0) {
+    MAZE_SetRule(MAZE_RULE_RIGHT_HAND);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"maze roll on")==0) {
+    mazeRoll = TRUE;
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"maze roll off")==0) {
+    mazeRoll = FALSE;
     *handled = TRUE;
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"maze rule tremaux")==0) {
+    MAZE_SetRule(MAZE_RULE_TREMAUX);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"maze graph")==0) {
+    MAZE_PrintGraph(io);
+    *handled = TRUE;
+#endif
+#if PL_CONFIG_HAS_ODOMETRY
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"maze profile on")==0) {
+    profile.enabled = TRUE;
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"maze profile off")==0) {
+    profile.enabled = FALSE;
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"maze profile max ", sizeof("maze profile max ")-1)==0) {
+    p = cmd+sizeof("maze profile max");
+    res = MAZE_ParseProfileValue(p, &profile.maxMmS, io);
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"maze profile junction ", sizeof("maze profile junction ")-1)==0) {
+    p = cmd+sizeof("maze profile junction");
+    res = MAZE_ParseProfileValue(p, &profile.junctionMmS, io);
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"maze profile accel ", sizeof("maze profile accel ")-1)==0) {
+    p = cmd+sizeof("maze profile accel");
+    res = MAZE_ParseProfileValue(p, &profile.accelMmS2, io);
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"maze profile decel ", sizeof("maze profile decel ")-1)==0) {
+    p = cmd+sizeof("maze profile decel");
+    res = MAZE_ParseProfileValue(p, &profile.decelMmS2, io);
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"maze profile full ", sizeof("maze profile full ")-1)==0) {
+    p = cmd+sizeof("maze profile full");
+    res = MAZE_ParseProfileValue(p, &profile.fullMmS, io);
+    *handled = TRUE;
+#endif
   }
   return res;
 }
 #endif
 
-TURN_Kind MAZE_GetSolvedTurn(uint8_t *solvedIdx) {
-  if (*solvedIdx < pathLength) {
-    return path[(*solvedIdx)++];
+TURN_Kind MAZE_GetSolvedTurn(uint16_t *solvedIdx) {
+  if (*solvedIdx < path.length) {
+    return MAZE_CodeToTurn(MAZE_SolvedCode((*solvedIdx)++));
   } else {
     return TURN_STOP; 
   }
@@ -236,7 +936,16 @@ TURN_Kind MAZE_GetSolvedTurn(uint8_t *solvedIdx) {
 
 void MAZE_ClearSolution(void) {
   isSolved = FALSE;
-  pathLength = 0;
+  driveBack = FALSE;
+  MAZEP_Clear(&path);
+  solvedIdx = 0;
+#if PL_CONFIG_HAS_MAZE_GRAPH
+  MAZEG_Clear(&graph);
+  graphValid = FALSE;
+  graphGoal = MAZEG_NO_NODE;
+  graphRouteMs = 0;
+  MAZEG_TremauxClear(&tremaux);
+#endif
 }
 
 void MAZE_Deinit(void) {
@@ -244,5 +953,8 @@ void MAZE_Deinit(void) {
 
 void MAZE_Init(void) {
   MAZE_ClearSolution();
+#if PL_CONFIG_HAS_CONFIG_NVM
+  (void)MAZE_LoadFromFlash(); /* solution from before the reset, so we can start with the speed run */
+#endif
 }
 #endif /* PL_HAS_LINE_SENSOR */
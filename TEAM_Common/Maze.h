@@ -13,8 +13,26 @@
 #include "Turn.h"
 #include "Reflectance.h"
 
+typedef enum {
+  MAZE_RULE_LEFT_HAND,  /*!< prefer left turns, then straight, then right turns */
+  MAZE_RULE_RIGHT_HAND, /*!< prefer right turns, then straight, then left turns */
+  MAZE_RULE_TREMAUX     /*!< prefer branches not used yet, and stop exploring as soon as no faster route is possible. Needs the maze graph, uses the left hand rule without it. */
+} MAZE_Rule;
+
+/*!
+ * \brief Sets the rule used to explore the maze.
+ * \param rule Rule to be used
+ */
+void MAZE_SetRule(MAZE_Rule rule);
+
 /*!
- * \brief Adds a new path while going forward through the maze
+ * \brief Returns the number of decisions in the path.
+ * \return Number of decisions
+ */
+uint16_t MAZE_GetPathLength(void);
+
+/*!
+ * \brief Adds a new path while going forward through the maze. Dead ends get removed right away with MAZE_SimplifyPath().
  * \param kind New path to be added
  */
 void MAZE_AddPath(TURN_Kind kind);
@@ -31,12 +49,32 @@ void MAZE_SimplifyPath(void);
 bool MAZE_IsSolved(void);
 
 /*!
- * \brief Marks the maze as solved.
+ * \brief Called when line following starts. Without a solution, a new exploration starts at this position.
+ */
+void MAZE_StartRun(void);
+
+/*!
+ * \brief Returns the line following speed while driving the solved path: accelerates on long segments and
+ * brakes in time for the next junction where we have to turn.
+ * \return Speed in percent, or zero if the configured line following speed shall be used
+ */
+uint8_t MAZE_GetSpeedPercent(void);
+
+/*!
+ * \brief Decides if a junction can be crossed without stopping, because the solution goes straight.
+ * Needs to be called for every line measurement while following a segment.
+ * \param kind Current line kind
+ * \return TRUE if the line following shall go straight over the junction, FALSE to handle the line kind as usual
+ */
+bool MAZE_PassJunction(REF_LineKind kind);
+
+/*!
+ * \brief Marks the maze as solved. The path stays from the start to the finish, as stored in FLASH, and the next run drives it backward from the finish.
  */
 void MAZE_SetSolved(void);
 
 /*!
- * This clears the solution, and MAZE_IsSolved() will return FALSE
+ * This clears the solution and the map, and MAZE_IsSolved() will return FALSE
  */
 void MAZE_ClearSolution(void);
 
@@ -45,12 +83,12 @@ void MAZE_ClearSolution(void);
  * \param solvedIdx Solution index, starting with zero. The callee will increment the index.
  * \return Solution turn
  */
-TURN_Kind MAZE_GetSolvedTurn(uint8_t *solvedIdx);
+TURN_Kind MAZE_GetSolvedTurn(uint16_t *solvedIdx);
 
 /*!
- * \brief Selects the new turn based.
- * \param prev Line previous the intersection
- * \param curr Line kind of the intersection.
+ * \brief Selects the new turn based on the line kinds and the left or right hand rule.
+ * \param prev Line kind seen while passing the intersection (branches to the left and/or right)
+ * \param curr Line kind after the intersection (line going straight ahead)
  * \return The new turn.
  */
 TURN_Kind MAZE_SelectTurn(REF_LineKind prev, REF_LineKind curr);
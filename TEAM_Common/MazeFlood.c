@@ -0,0 +1,221 @@
+/**
+ * \file
+ * \brief Flood fill wall maze implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Keeps the distance of each cell to the goal. New walls only make distances larger, so only the cells
+ * around a new wall need to be checked, and the change is propagated from there (modified flood fill).
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_WALL_MAZE
+#include "MazeFlood.h"
+
+#define MAZEF_NOF_CELLS   (MAZEF_SIZE*MAZEF_SIZE)
+#define MAZEF_CELL(x,y)   ((uint8_t)((y)*MAZEF_SIZE+(x)))
+
+static uint8_t MAZEF_queue[MAZEF_NOF_CELLS]; /* ring buffer of cells to be checked */
+static uint8_t MAZEF_inQueue[MAZEF_NOF_CELLS/8]; /* bit set if a cell is in the queue */
+static uint16_t MAZEF_qHead, MAZEF_qCount;
+
+static void MAZEF_QueueClear(void) {
+  int i;
+
+  MAZEF_qHead = 0;
+  MAZEF_qCount = 0;
+  for(i=0;i<(int)sizeof(MAZEF_inQueue);i++) {
+    MAZEF_inQueue[i] = 0;
+  }
+}
+
+static void MAZEF_QueuePut(uint8_t cell) {
+  if (MAZEF_inQueue[cell/8]&(1<<(cell%8))) {
+    return; /* already queued */
+  }
+  MAZEF_inQueue[cell/8] |= 1<<(cell%8);
+  MAZEF_queue[(MAZEF_qHead+MAZEF_qCount)%MAZEF_NOF_CELLS] = cell;
+  MAZEF_qCount++; /* can not overflow, as every cell is at most once in the queue */
+}
+
+static uint8_t MAZEF_QueueGet(void) {
+  uint8_t cell;
+
+  cell = MAZEF_queue[MAZEF_qHead];
+  MAZEF_qHead = (MAZEF_qHead+1)%MAZEF_NOF_CELLS;
+  MAZEF_qCount--;
+  MAZEF_inQueue[cell/8] &= ~(1<<(cell%8));
+  return cell;
+}
+
+static bool MAZEF_IsGoal(const MAZEF_Maze *maze, uint8_t x, uint8_t y) {
+  return x>=maze->goalX && x<maze->goalX+maze->goalSize && y>=maze->goalY && y<maze->goalY+maze->goalSize;
+}
+
+bool MAZEF_HasWall(const MAZEF_Maze *maze, uint8_t x, uint8_t y, uint8_t dir) {
+  switch(dir&3) {
+    case MAZEF_NORTH: return (maze->hWall[y+1]&(1<<x))!=0;
+    case MAZEF_EAST:  return (maze->vWall[x+1]&(1<<y))!=0;
+    case MAZEF_SOUTH: return (maze->hWall[y]&(1<<x))!=0;
+    default:          return (maze->vWall[x]&(1<<y))!=0;
+  }
+}
+
+static void MAZEF_SetWall(MAZEF_Maze *maze, uint8_t x, uint8_t y, uint8_t dir) {
+  switch(dir&3) {
+    case MAZEF_NORTH: maze->hWall[y+1] |= 1<<x; break;
+    case MAZEF_EAST:  maze->vWall[x+1] |= 1<<y; break;
+    case MAZEF_SOUTH: maze->hWall[y] |= 1<<x; break;
+    default:          maze->vWall[x] |= 1<<y; break;
+  }
+}
+
+void MAZEF_Move(uint8_t dir, uint8_t *x, uint8_t *y) {
+  switch(dir&3) {
+    case MAZEF_NORTH: (*y)++; break;
+    case MAZEF_EAST:  (*x)++; break;
+    case MAZEF_SOUTH: (*y)--; break;
+    default:          (*x)--; break;
+  }
+}
+
+bool MAZEF_IsVisited(const MAZEF_Maze *maze, uint8_t x, uint8_t y) {
+  return (maze->visited[y]&(1<<x))!=0;
+}
+
+/*!
+ * \brief Returns the smallest distance of the neighbors which can be reached without crossing a known wall.
+ */
+static uint8_t MAZEF_MinNeighborDist(const MAZEF_Maze *maze, uint8_t x, uint8_t y) {
+  uint8_t dir, nx, ny, min = MAZEF_DIST_UNREACHABLE;
+
+  for(dir=0;dir<MAZEF_NOF_DIRS;dir++) {
+    if (!MAZEF_HasWall(maze, x, y, dir)) {
+      nx = x; ny = y;
+      MAZEF_Move(dir, &nx, &ny);
+      if (maze->dist[ny][nx]<min) {
+        min = maze->dist[ny][nx];
+      }
+    }
+  }
+  return min;
+}
+
+/*!
+ * \brief Processes the queue: a cell which is not one more than its best neighbor gets corrected, and its neighbors get checked too.
+ */
+static void MAZEF_Propagate(MAZEF_Maze *maze) {
+  uint8_t cell, x, y, nx, ny, dir, min, d;
+
+  while(MAZEF_qCount>0) {
+    cell = MAZEF_QueueGet();
+    x = cell%MAZEF_SIZE;
+    y = cell/MAZEF_SIZE;
+    if (MAZEF_IsGoal(maze, x, y)) {
+      continue; /* goal cells stay at zero */
+    }
+    min = MAZEF_MinNeighborDist(maze, x, y);
+    d = min==MAZEF_DIST_UNREACHABLE?MAZEF_DIST_UNREACHABLE:(uint8_t)(min+1);
+    if (maze->dist[y][x]!=d) {
+      maze->dist[y][x] = d;
+      for(dir=0;dir<MAZEF_NOF_DIRS;dir++) { /* neighbors might depend on this cell */
+        if (!MAZEF_HasWall(maze, x, y, dir)) {
+          nx = x; ny = y;
+          MAZEF_Move(dir, &nx, &ny);
+          MAZEF_QueuePut(MAZEF_CELL(nx, ny));
+        }
+      }
+    }
+  }
+}
+
+void MAZEF_Flood(MAZEF_Maze *maze) {
+  uint8_t x, y, nx, ny, dir, cell;
+
+  /* breadth first from the goal */
+  MAZEF_QueueClear();
+  for(y=0;y<MAZEF_SIZE;y++) {
+    for(x=0;x<MAZEF_SIZE;x++) {
+      if (MAZEF_IsGoal(maze, x, y)) {
+        maze->dist[y][x] = 0;
+        MAZEF_QueuePut(MAZEF_CELL(x, y));
+      } else {
+        maze->dist[y][x] = MAZEF_DIST_UNREACHABLE;
+      }
+    }
+  }
+  while(MAZEF_qCount>0) {
+    cell = MAZEF_QueueGet();
+    x = cell%MAZEF_SIZE;
+    y = cell/MAZEF_SIZE;
+    for(dir=0;dir<MAZEF_NOF_DIRS;dir++) {
+      if (!MAZEF_HasWall(maze, x, y, dir)) {
+        nx = x; ny = y;
+        MAZEF_Move(dir, &nx, &ny);
+        if (maze->dist[ny][nx]==MAZEF_DIST_UNREACHABLE) {
+          maze->dist[ny][nx] = (uint8_t)(maze->dist[y][x]+1);
+          MAZEF_QueuePut(MAZEF_CELL(nx, ny));
+        }
+      }
+    }
+  }
+}
+
+void MAZEF_Init(MAZEF_Maze *maze, uint8_t goalX, uint8_t goalY, uint8_t goalSize) {
+  int i;
+
+  for(i=0;i<=MAZEF_SIZE;i++) {
+    maze->hWall[i] = 0;
+    maze->vWall[i] = 0;
+  }
+  maze->hWall[0] = maze->hWall[MAZEF_SIZE] = 0xffff; /* outer walls south and north */
+  maze->vWall[0] = maze->vWall[MAZEF_SIZE] = 0xffff; /* outer walls west and east */
+  for(i=0;i<MAZEF_SIZE;i++) {
+    maze->visited[i] = 0;
+  }
+  maze->goalX = goalX;
+  maze->goalY = goalY;
+  maze->goalSize = goalSize;
+  MAZEF_Flood(maze);
+}
+
+uint8_t MAZEF_AddWalls(MAZEF_Maze *maze, uint8_t x, uint8_t y, uint8_t walls) {
+  uint8_t dir, nx, ny, nofNew = 0;
+
+  maze->visited[y] |= 1<<x;
+  MAZEF_QueueClear();
+  for(dir=0;dir<MAZEF_NOF_DIRS;dir++) {
+    if ((walls&(1<<dir)) && !MAZEF_HasWall(maze, x, y, dir)) {
+      MAZEF_SetWall(maze, x, y, dir);
+      nofNew++;
+      /* both cells next to the new wall might be further away now */
+      MAZEF_QueuePut(MAZEF_CELL(x, y));
+      nx = x; ny = y;
+      MAZEF_Move(dir, &nx, &ny);
+      MAZEF_QueuePut(MAZEF_CELL(nx, ny));
+    }
+  }
+  MAZEF_Propagate(maze);
+  return nofNew;
+}
+
+uint8_t MAZEF_NextDir(const MAZEF_Maze *maze, uint8_t x, uint8_t y, uint8_t heading) {
+  uint8_t i, dir, nx, ny, best = MAZEF_NO_DIR, bestDist = MAZEF_DIST_UNREACHABLE;
+
+  /* check straight first, then right, left and back, so straight wins if distances are equal */
+  static const uint8_t order[MAZEF_NOF_DIRS] = {0, 1, 3, 2};
+
+  for(i=0;i<MAZEF_NOF_DIRS;i++) {
+    dir = (uint8_t)((heading+order[i])&3);
+    if (!MAZEF_HasWall(maze, x, y, dir)) {
+      nx = x; ny = y;
+      MAZEF_Move(dir, &nx, &ny);
+      if (maze->dist[ny][nx]<bestDist) {
+        bestDist = maze->dist[ny][nx];
+        best = dir;
+      }
+    }
+  }
+  return best;
+}
+
+#endif /* PL_CONFIG_HAS_WALL_MAZE */
@@ -0,0 +1,95 @@
+/**
+ * \file
+ * \brief Flood fill wall maze interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Map of a cell based wall maze with bit-packed walls and the distance of each cell to the goal.
+ * Directions: 0 north (+y), 1 east (+x), 2 south, 3 west. Cell (0,0) is the south west corner.
+ * The functions only work on the provided data and have no hardware dependency.
+ */
+
+#ifndef MAZEFLOOD_H_
+#define MAZEFLOOD_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_WALL_MAZE
+
+#define MAZEF_SIZE        16    /* number of cells in x and y direction, maximum 16 because of the 16bit wall rows */
+#define MAZEF_NOF_DIRS    4
+#define MAZEF_NORTH       0
+#define MAZEF_EAST        1
+#define MAZEF_SOUTH       2
+#define MAZEF_WEST        3
+#define MAZEF_NO_DIR      0xff  /* no way to the goal */
+#define MAZEF_DIST_UNREACHABLE  0xff
+
+typedef struct {
+  uint16_t hWall[MAZEF_SIZE+1];  /*!< horizontal walls: bit x of hWall[y] is the wall on the south side of cell (x,y) */
+  uint16_t vWall[MAZEF_SIZE+1];  /*!< vertical walls: bit y of vWall[x] is the wall on the west side of cell (x,y) */
+  uint16_t visited[MAZEF_SIZE];  /*!< bit x of visited[y] is set if the walls of cell (x,y) have been sensed */
+  uint8_t dist[MAZEF_SIZE][MAZEF_SIZE]; /*!< number of cells to the goal, indexed [y][x], unknown walls count as open */
+  uint8_t goalX, goalY;          /*!< south west cell of the goal area */
+  uint8_t goalSize;              /*!< goal area is goalSize x goalSize cells */
+} MAZEF_Maze;
+
+/*!
+ * \brief Initializes an empty maze with the outer walls, and floods the distances.
+ * \param maze Maze
+ * \param goalX South west cell of the goal area
+ * \param goalY South west cell of the goal area
+ * \param goalSize Size of the goal area in cells
+ */
+void MAZEF_Init(MAZEF_Maze *maze, uint8_t goalX, uint8_t goalY, uint8_t goalSize);
+
+/*!
+ * \brief Returns if there is a wall on a side of a cell.
+ * \param maze Maze
+ * \param x Cell
+ * \param y Cell
+ * \param dir Side of the cell
+ * \return TRUE if there is a (known) wall
+ */
+bool MAZEF_HasWall(const MAZEF_Maze *maze, uint8_t x, uint8_t y, uint8_t dir);
+
+/*!
+ * \brief Adds the sensed walls of a cell, and updates the distances of the cells affected by new walls.
+ * \param maze Maze
+ * \param x Cell
+ * \param y Cell
+ * \param walls Bit set for each direction (1<<MAZEF_NORTH, ...) with a wall
+ * \return Number of walls which have not been known before
+ */
+uint8_t MAZEF_AddWalls(MAZEF_Maze *maze, uint8_t x, uint8_t y, uint8_t walls);
+
+/*!
+ * \brief Floods all distances from the goal again.
+ * \param maze Maze
+ */
+void MAZEF_Flood(MAZEF_Maze *maze);
+
+/*!
+ * \brief Returns the direction to the neighbor closest to the goal. Going straight is preferred, as it is faster than turning.
+ * \param maze Maze
+ * \param x Cell
+ * \param y Cell
+ * \param heading Current heading
+ * \return Direction, or MAZEF_NO_DIR if the goal can not be reached
+ */
+uint8_t MAZEF_NextDir(const MAZEF_Maze *maze, uint8_t x, uint8_t y, uint8_t heading);
+
+/*!
+ * \brief Moves a cell position one cell in a direction.
+ * \param dir Direction
+ * \param[in,out] x Cell
+ * \param[in,out] y Cell
+ */
+void MAZEF_Move(uint8_t dir, uint8_t *x, uint8_t *y);
+
+/*!
+ * \brief Returns if a cell has been visited.
+ */
+bool MAZEF_IsVisited(const MAZEF_Maze *maze, uint8_t x, uint8_t y);
+
+#endif /* PL_CONFIG_HAS_WALL_MAZE */
+
+#endif /* MAZEFLOOD_H_ */
@@ -0,0 +1,326 @@
+/**
+ * \file
+ * \brief Maze graph implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Builds the map of a line maze, finds the fastest route with Dijkstra and selects the branches to explore with Tremaux' algorithm.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MAZE_GRAPH
+#include "MazeGraph.h"
+
+#define MAZEG_MATCH_MM      80  /* junctions closer than this are the same node */
+#define MAZEG_NOF_STATES    (MAZEG_MAX_NODES*MAZEG_NOF_DIRS) /* search state: node and heading when arriving */
+#define MAZEG_NO_STATE      0xffff
+#define MAZEG_INFINITE      MAZEG_NO_TIME
+#define MAZEG_TREMAUX_MAX_MARKS  2  /* a branch is used at most twice: once out and once back */
+
+static uint32_t MAZEG_time[MAZEG_NOF_STATES]; /* Dijkstra: best time to reach a state */
+static uint16_t MAZEG_prev[MAZEG_NOF_STATES]; /* Dijkstra: previous state on the best route */
+static uint8_t MAZEG_exit[MAZEG_NOF_STATES];  /* Dijkstra: direction used to leave the previous state */
+static uint8_t MAZEG_done[MAZEG_NOF_STATES/8]; /* Dijkstra: bit set if the best time of the state is final */
+
+void MAZEG_Clear(MAZEG_Graph *graph) {
+  graph->nofNodes = 0;
+}
+
+uint8_t MAZEG_AddNode(MAZEG_Graph *graph, int16_t xMm, int16_t yMm, uint8_t exits, uint8_t *idx) {
+  MAZEG_Node *node;
+  int i, dx, dy;
+
+  for(i=0;i<graph->nofNodes;i++) {
+    dx = graph->node[i].xMm-xMm;
+    dy = graph->node[i].yMm-yMm;
+    if (dx>-MAZEG_MATCH_MM && dx<MAZEG_MATCH_MM && dy>-MAZEG_MATCH_MM && dy<MAZEG_MATCH_MM) {
+      graph->node[i].exits |= exits;
+      *idx = (uint8_t)i;
+      return ERR_OK;
+    }
+  }
+  if (graph->nofNodes>=MAZEG_MAX_NODES) {
+    return ERR_OVERFLOW;
+  }
+  node = &graph->node[graph->nofNodes];
+  node->xMm = xMm;
+  node->yMm = yMm;
+  node->exits = exits;
+  node->flags = 0;
+  for(i=0;i<MAZEG_NOF_DIRS;i++) {
+    node->neighbor[i] = MAZEG_NO_NODE;
+    node->peerDir[i] = 0;
+    node->lenMm[i] = 0;
+  }
+  *idx = graph->nofNodes;
+  graph->nofNodes++;
+  return ERR_OK;
+}
+
+void MAZEG_Link(MAZEG_Graph *graph, uint8_t from, uint8_t dir, uint8_t to, uint8_t arrivalDir, uint16_t lenMm) {
+  uint8_t backDir;
+
+  dir &= 3;
+  backDir = (arrivalDir+2)&3; /* direction at to which leads back */
+  graph->node[from].neighbor[dir] = to;
+  graph->node[from].peerDir[dir] = backDir;
+  graph->node[from].lenMm[dir] = lenMm;
+  graph->node[from].exits |= 1<<dir;
+  graph->node[to].neighbor[backDir] = from;
+  graph->node[to].peerDir[backDir] = dir;
+  graph->node[to].lenMm[backDir] = lenMm;
+  graph->node[to].exits |= 1<<backDir;
+}
+
+void MAZEG_Rotate(uint8_t quarterTurns, int32_t *x, int32_t *y) {
+  int32_t tmp;
+
+  switch(quarterTurns&3) {
+    case 1: /* (x,y) -> (-y,x) */
+      tmp = *x; *x = -*y; *y = tmp;
+      break;
+    case 2:
+      *x = -*x; *y = -*y;
+      break;
+    case 3: /* (x,y) -> (y,-x) */
+      tmp = *x; *x = *y; *y = -tmp;
+      break;
+    default:
+      break;
+  }
+}
+
+static uint32_t MAZEG_TurnTime(const MAZEG_Cost *cost, uint8_t quarterTurns) {
+  switch(quarterTurns&3) {
+    case 0:  return cost->junctionMs;
+    case 2:  return cost->junctionMs+cost->turn180Ms;
+    default: return cost->junctionMs+cost->turn90Ms;
+  }
+}
+
+/*!
+ * \brief Dijkstra over the states (node, heading when arriving). The results are in MAZEG_time[], MAZEG_prev[] and MAZEG_exit[].
+ * \param startState State where the route starts
+ * \param atJunction TRUE if the route starts at a junction where we can turn, FALSE if we can only drive ahead (start of the maze)
+ * \param goal Node where the search stops, or MAZEG_NO_NODE to calculate the time for every state
+ * \return State at the goal with the best time, MAZEG_NO_STATE if the goal can not be reached
+ */
+static uint16_t MAZEG_Dijkstra(const MAZEG_Graph *graph, const MAZEG_Cost *cost, uint16_t startState, bool atJunction, uint8_t goal) {
+  uint16_t s, next, best, goalState, nofStates;
+  uint8_t dir, exit;
+  uint32_t t;
+  const MAZEG_Node *p;
+
+  nofStates = graph->nofNodes*MAZEG_NOF_DIRS;
+  for(s=0;s<nofStates;s++) {
+    MAZEG_time[s] = MAZEG_INFINITE;
+    MAZEG_prev[s] = MAZEG_NO_STATE;
+  }
+  for(s=0;s<sizeof(MAZEG_done);s++) {
+    MAZEG_done[s] = 0;
+  }
+  MAZEG_time[startState] = 0;
+  goalState = MAZEG_NO_STATE;
+  for(;;) {
+    /* take the closest state not done yet, the arrays are small enough for a linear search */
+    best = MAZEG_NO_STATE;
+    for(s=0;s<nofStates;s++) {
+      if (MAZEG_time[s]!=MAZEG_INFINITE && !(MAZEG_done[s/8]&(1<<(s%8)))
+          && (best==MAZEG_NO_STATE || MAZEG_time[s]<MAZEG_time[best]))
+      {
+        best = s;
+      }
+    }
+    if (best==MAZEG_NO_STATE) {
+      break; /* everything reachable is done */
+    }
+    MAZEG_done[best/8] |= 1<<(best%8);
+    if (best/MAZEG_NOF_DIRS==goal) {
+      goalState = best; /* the first goal state done has the best time */
+      break;
+    }
+    p = &graph->node[best/MAZEG_NOF_DIRS];
+    dir = (uint8_t)(best%MAZEG_NOF_DIRS); /* heading when arriving */
+    for(exit=0;exit<MAZEG_NOF_DIRS;exit++) {
+      if (p->neighbor[exit]==MAZEG_NO_NODE) {
+        continue; /* not explored */
+      }
+      if (best==startState && !atJunction) {
+        if (exit!=dir) {
+          continue; /* the start is no junction, we can only drive ahead */
+        }
+        t = 0;
+      } else {
+        t = MAZEG_TurnTime(cost, (uint8_t)(exit-dir));
+      }
+      t += MAZEG_time[best]+((uint32_t)p->lenMm[exit]*1000)/cost->speedMmS;
+      next = p->neighbor[exit]*MAZEG_NOF_DIRS+((p->peerDir[exit]+2)&3); /* heading when arriving at the neighbor */
+      if (t<MAZEG_time[next]) {
+        MAZEG_time[next] = t;
+        MAZEG_prev[next] = best;
+        MAZEG_exit[next] = exit;
+      }
+    }
+  }
+  return goalState;
+}
+
+uint8_t MAZEG_ShortestRoute(const MAZEG_Graph *graph, const MAZEG_Cost *cost, uint8_t start, uint8_t startDir, uint8_t goal,
+    uint8_t *turns, uint16_t *lenMm, uint16_t maxTurns, uint16_t *nofTurns, uint32_t *timeMs)
+{
+  uint16_t s, startState, goalState, n;
+
+  *nofTurns = 0;
+  if (start>=graph->nofNodes || goal>=graph->nofNodes || cost->speedMmS==0) {
+    return ERR_FAILED;
+  }
+  startState = start*MAZEG_NOF_DIRS+(startDir&3);
+  goalState = MAZEG_Dijkstra(graph, cost, startState, FALSE, goal);
+  if (goalState==MAZEG_NO_STATE) {
+    return ERR_FAILED;
+  }
+  if (timeMs!=NULL) {
+    *timeMs = MAZEG_time[goalState];
+  }
+  if (goalState==startState) {
+    if (lenMm!=NULL) {
+      lenMm[0] = 0;
+    }
+    return ERR_OK; /* already there */
+  }
+  /* one decision for each junction between start and goal */
+  n = 0;
+  for(s=goalState;MAZEG_prev[s]!=startState;s=MAZEG_prev[s]) {
+    n++;
+  }
+  if (n>maxTurns) {
+    return ERR_OVERFLOW;
+  }
+  *nofTurns = n;
+  /* walk back: the turn at a junction is the heading leaving it minus the heading arriving at it */
+  for(s=goalState;;s=MAZEG_prev[s]) {
+    if (lenMm!=NULL) {
+      lenMm[n] = graph->node[MAZEG_prev[s]/MAZEG_NOF_DIRS].lenMm[MAZEG_exit[s]]; /* segment ending in s */
+    }
+    if (MAZEG_prev[s]==startState) {
+      break;
+    }
+    n--;
+    turns[n] = (uint8_t)((MAZEG_exit[s]-MAZEG_prev[s]%MAZEG_NOF_DIRS)&3);
+  }
+  return ERR_OK;
+}
+
+uint8_t MAZEG_NodeTimes(const MAZEG_Graph *graph, const MAZEG_Cost *cost, uint8_t start, uint8_t startDir, uint32_t *timeMs) {
+  uint16_t s;
+
+  if (start>=graph->nofNodes || cost->speedMmS==0) {
+    return ERR_FAILED;
+  }
+  (void)MAZEG_Dijkstra(graph, cost, start*MAZEG_NOF_DIRS+(startDir&3), FALSE, MAZEG_NO_NODE);
+  for(s=0;s<graph->nofNodes;s++) {
+    timeMs[s] = MAZEG_INFINITE;
+  }
+  for(s=0;s<graph->nofNodes*MAZEG_NOF_DIRS;s++) { /* best of all headings when arriving */
+    if (MAZEG_time[s]<timeMs[s/MAZEG_NOF_DIRS]) {
+      timeMs[s/MAZEG_NOF_DIRS] = MAZEG_time[s];
+    }
+  }
+  return ERR_OK;
+}
+
+uint8_t MAZEG_NextExit(const MAZEG_Graph *graph, const MAZEG_Cost *cost, uint8_t node, uint8_t arrivalDir, uint8_t goal, uint8_t *exit) {
+  uint16_t s, startState;
+
+  if (node>=graph->nofNodes || goal>=graph->nofNodes || node==goal || cost->speedMmS==0) {
+    return ERR_FAILED;
+  }
+  startState = node*MAZEG_NOF_DIRS+(arrivalDir&3);
+  s = MAZEG_Dijkstra(graph, cost, startState, TRUE, goal);
+  if (s==MAZEG_NO_STATE) {
+    return ERR_FAILED;
+  }
+  while(MAZEG_prev[s]!=startState) { /* walk back to the first segment */
+    s = MAZEG_prev[s];
+  }
+  *exit = MAZEG_exit[s];
+  return ERR_OK;
+}
+
+void MAZEG_TremauxClear(MAZEG_Tremaux *tremaux) {
+  int i;
+
+  for(i=0;i<MAZEG_MAX_NODES;i++) {
+    tremaux->marks[i] = 0;
+  }
+  tremaux->toGoal = FALSE;
+}
+
+uint8_t MAZEG_TremauxGetMark(const MAZEG_Tremaux *tremaux, uint8_t node, uint8_t dir) {
+  return (tremaux->marks[node]>>(dir*2))&3;
+}
+
+void MAZEG_TremauxAddMark(MAZEG_Tremaux *tremaux, uint8_t node, uint8_t dir) {
+  if (MAZEG_TremauxGetMark(tremaux, node, dir)<MAZEG_TREMAUX_MAX_MARKS) {
+    tremaux->marks[node] += (uint8_t)(1<<(dir*2));
+  }
+}
+
+bool MAZEG_TremauxIsExplored(const MAZEG_Graph *graph, const MAZEG_Cost *cost, uint8_t goal) {
+  static uint32_t nodeMs[MAZEG_MAX_NODES]; /* too large for the task stack */
+  const MAZEG_Node *p, *g;
+  uint64_t budgetMm;
+  int64_t dx, dy;
+  int i, dir;
+
+  if (goal>=graph->nofNodes || MAZEG_NodeTimes(graph, cost, 0, 0, nodeMs)!=ERR_OK || nodeMs[goal]==MAZEG_NO_TIME) {
+    return FALSE;
+  }
+  g = &graph->node[goal];
+  for(i=0;i<graph->nofNodes;i++) {
+    if (nodeMs[i]>=nodeMs[goal]) {
+      continue; /* reaching the junction alone takes as long as the known route (or it can not be reached) */
+    }
+    p = &graph->node[i];
+    budgetMm = ((uint64_t)(nodeMs[goal]-nodeMs[i])*cost->speedMmS)/1000; /* distance left to beat the known route */
+    dx = p->xMm-g->xMm;
+    dy = p->yMm-g->yMm;
+    for(dir=0;dir<MAZEG_NOF_DIRS;dir++) {
+      if ((p->exits&(1<<dir)) && p->neighbor[dir]==MAZEG_NO_NODE && (uint64_t)(dx*dx+dy*dy)<budgetMm*budgetMm) {
+        return FALSE; /* this branch might be a shortcut */
+      }
+    }
+  }
+  return TRUE;
+}
+
+uint8_t MAZEG_TremauxSelectDir(MAZEG_Tremaux *tremaux, const MAZEG_Graph *graph, const MAZEG_Cost *cost, uint8_t goal, uint8_t node, uint8_t arrival) {
+  static const uint8_t order[MAZEG_NOF_DIRS] = {0, 3, 1, 2}; /* relative to the arrival: straight, left, right, back */
+  uint8_t entry, dir, best, bestMark, exits, i;
+  bool known;
+
+  entry = (uint8_t)((arrival+2)&3);
+  known = tremaux->marks[node]!=0;
+  MAZEG_TremauxAddMark(tremaux, node, entry);
+  if (!tremaux->toGoal && MAZEG_TremauxIsExplored(graph, cost, goal)) {
+    tremaux->toGoal = TRUE;
+  }
+  if (tremaux->toGoal && MAZEG_NextExit(graph, cost, node, arrival, goal, &dir)==ERR_OK) {
+    return dir;
+  }
+  best = entry;
+  if (!known || MAZEG_TremauxGetMark(tremaux, node, entry)!=1) {
+    exits = graph->node[node].exits;
+    bestMark = MAZEG_TREMAUX_MAX_MARKS+1;
+    for(i=0;i<MAZEG_NOF_DIRS;i++) { /* branch with the fewest marks */
+      dir = (uint8_t)((arrival+order[i])&3);
+      if ((exits&(1<<dir)) && MAZEG_TremauxGetMark(tremaux, node, dir)<bestMark) {
+        best = dir;
+        bestMark = MAZEG_TremauxGetMark(tremaux, node, dir);
+      }
+    }
+  } /* else: new branch into a known junction, go back */
+  MAZEG_TremauxAddMark(tremaux, node, best);
+  return best;
+}
+
+#endif /* PL_CONFIG_HAS_MAZE_GRAPH */
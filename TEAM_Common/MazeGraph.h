@@ -0,0 +1,176 @@
+/**
+ * \file
+ * \brief Maze graph interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Map of a line maze as a graph of junctions (nodes) connected by segments of known length.
+ * Directions are absolute, counted in quarter turns clockwise from the heading at the start (0: ahead, 1: right, 2: back, 3: left).
+ * The functions only work on the provided data and have no hardware dependency.
+ */
+
+#ifndef MAZEGRAPH_H_
+#define MAZEGRAPH_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MAZE_GRAPH
+
+#define MAZEG_MAX_NODES     64    /* maximum number of junctions, dead ends included */
+#define MAZEG_NO_NODE       0xff  /* no neighbor, or neighbor not explored yet */
+#define MAZEG_NOF_DIRS      4     /* ahead, right, back, left */
+#define MAZEG_NO_TIME       0xffffffffu /* node can not be reached */
+
+#define MAZEG_FLAG_GOAL     (1<<0) /* node is the finish area */
+
+typedef struct {
+  int16_t xMm, yMm;                /*!< position of the junction, x ahead and y to the right at the start */
+  uint8_t exits;                   /*!< bit set for each direction with a line */
+  uint8_t flags;                   /*!< MAZEG_FLAG_GOAL */
+  uint8_t neighbor[MAZEG_NOF_DIRS]; /*!< node reached in each direction, MAZEG_NO_NODE if unknown */
+  uint8_t peerDir[MAZEG_NOF_DIRS]; /*!< direction at the neighbor which leads back to this node */
+  uint16_t lenMm[MAZEG_NOF_DIRS];  /*!< segment length in each direction */
+} MAZEG_Node;
+
+typedef struct {
+  uint8_t nofNodes;                 /*!< number of used entries in node[] */
+  MAZEG_Node node[MAZEG_MAX_NODES]; /*!< junctions, node 0 is the start */
+} MAZEG_Graph;
+
+typedef struct {
+  uint16_t speedMmS;   /*!< average speed on a segment, in mm/s */
+  uint16_t turn90Ms;   /*!< time for a 90 degree turn at a junction */
+  uint16_t turn180Ms;  /*!< time for a U-turn at a junction */
+  uint16_t junctionMs; /*!< time for stepping over a junction */
+} MAZEG_Cost;
+
+typedef struct {
+  uint8_t marks[MAZEG_MAX_NODES]; /*!< number of times each branch of a junction has been used, two bits per direction */
+  bool toGoal;                    /*!< no unexplored branch can give a faster route, drive to the goal */
+} MAZEG_Tremaux;
+
+/*!
+ * \brief Empties the graph.
+ * \param graph Graph
+ */
+void MAZEG_Clear(MAZEG_Graph *graph);
+
+/*!
+ * \brief Returns the node at a position, or adds a new one if there is none close enough. The exits get merged into the node.
+ * \param graph Graph
+ * \param xMm Position of the junction
+ * \param yMm Position of the junction
+ * \param exits Bit set for each direction with a line
+ * \param[out] idx Index of the node
+ * \return Error code, ERR_OK if everything is fine, ERR_OVERFLOW if the graph is full
+ */
+uint8_t MAZEG_AddNode(MAZEG_Graph *graph, int16_t xMm, int16_t yMm, uint8_t exits, uint8_t *idx);
+
+/*!
+ * \brief Connects two nodes with a segment, in both directions.
+ * \param graph Graph
+ * \param from Node where the segment starts
+ * \param dir Direction of the segment when leaving from
+ * \param to Node where the segment ends
+ * \param arrivalDir Heading when arriving at to. Differs from dir if the segment has a curve.
+ * \param lenMm Length of the segment
+ */
+void MAZEG_Link(MAZEG_Graph *graph, uint8_t from, uint8_t dir, uint8_t to, uint8_t arrivalDir, uint16_t lenMm);
+
+/*!
+ * \brief Rotates a vector by quarter turns.
+ * \param quarterTurns Number of quarter turns clockwise
+ * \param[in,out] x Vector component ahead
+ * \param[in,out] y Vector component to the right
+ */
+void MAZEG_Rotate(uint8_t quarterTurns, int32_t *x, int32_t *y);
+
+/*!
+ * \brief Finds the fastest route over the explored segments with Dijkstra, using the estimated time for segments and turns.
+ * \param graph Graph
+ * \param cost Cost model
+ * \param start Start node
+ * \param startDir Heading at the start node
+ * \param goal Goal node
+ * \param[out] turns Turn at each junction between start and goal, in quarter turns clockwise (0: straight, 1: right, 2: U-turn, 3: left)
+ * \param[out] lenMm Length of each segment of the route (nofTurns+1 entries), can be NULL
+ * \param maxTurns Number of entries in turns, lenMm needs one entry more
+ * \param[out] nofTurns Number of turns stored
+ * \param[out] timeMs Estimated time for the route, can be NULL
+ * \return Error code, ERR_OK if everything is fine, ERR_FAILED if the goal can not be reached, ERR_OVERFLOW if turns is too small
+ */
+uint8_t MAZEG_ShortestRoute(const MAZEG_Graph *graph, const MAZEG_Cost *cost, uint8_t start, uint8_t startDir, uint8_t goal,
+    uint8_t *turns, uint16_t *lenMm, uint16_t maxTurns, uint16_t *nofTurns, uint32_t *timeMs);
+
+/*!
+ * \brief Calculates the time of the fastest route from the start to every node, over the explored segments.
+ * \param graph Graph
+ * \param cost Cost model
+ * \param start Start node
+ * \param startDir Heading at the start node
+ * \param[out] timeMs Time for each node (graph->nofNodes entries), MAZEG_NO_TIME if the node can not be reached
+ * \return Error code, ERR_OK if everything is fine
+ */
+uint8_t MAZEG_NodeTimes(const MAZEG_Graph *graph, const MAZEG_Cost *cost, uint8_t start, uint8_t startDir, uint32_t *timeMs);
+
+/*!
+ * \brief Returns the direction to take at a junction to follow the fastest route to the goal.
+ * \param graph Graph
+ * \param cost Cost model
+ * \param node Junction where we are
+ * \param arrivalDir Heading when arriving at the junction
+ * \param goal Goal node
+ * \param[out] exit Absolute direction to leave the junction
+ * \return Error code, ERR_OK if everything is fine, ERR_FAILED if the goal can not be reached or we are already there
+ */
+uint8_t MAZEG_NextExit(const MAZEG_Graph *graph, const MAZEG_Cost *cost, uint8_t node, uint8_t arrivalDir, uint8_t goal, uint8_t *exit);
+
+/*!
+ * \brief Removes all Tremaux marks.
+ * \param tremaux Marks of the branches
+ */
+void MAZEG_TremauxClear(MAZEG_Tremaux *tremaux);
+
+/*!
+ * \brief Marks a branch as used once more. A branch gets at most two marks: once out and once back.
+ * \param tremaux Marks of the branches
+ * \param node Junction
+ * \param dir Absolute direction of the branch
+ */
+void MAZEG_TremauxAddMark(MAZEG_Tremaux *tremaux, uint8_t node, uint8_t dir);
+
+/*!
+ * \brief Returns the number of marks of a branch.
+ * \param tremaux Marks of the branches
+ * \param node Junction
+ * \param dir Absolute direction of the branch
+ * \return Number of times the branch has been used, 0 to 2
+ */
+uint8_t MAZEG_TremauxGetMark(const MAZEG_Tremaux *tremaux, uint8_t node, uint8_t dir);
+
+/*!
+ * \brief Checks if exploring can stop: the goal has been found, and no unexplored branch can lead to a faster route.
+ * A route over an unexplored branch needs at least the time to reach the branch from the start (node 0, heading ahead),
+ * plus the time for the straight line distance from the branch to the goal.
+ * \param graph Graph
+ * \param cost Cost model
+ * \param goal Goal node, MAZEG_NO_NODE if not found yet
+ * \return TRUE if the known route to the goal is the fastest one
+ */
+bool MAZEG_TremauxIsExplored(const MAZEG_Graph *graph, const MAZEG_Cost *cost, uint8_t goal);
+
+/*!
+ * \brief Selects the direction at a junction with Tremaux' algorithm and marks the branches used.
+ * Branches without marks are preferred. Arriving over a new branch at a known junction means we have closed a loop, so we go back.
+ * Once the maze is explored enough, the fastest known route to the goal is used.
+ * \param tremaux Marks of the branches
+ * \param graph Graph
+ * \param cost Cost model
+ * \param goal Goal node, MAZEG_NO_NODE if not found yet
+ * \param node Junction where we are
+ * \param arrival Heading when arriving at the junction
+ * \return Absolute direction to leave the junction
+ */
+uint8_t MAZEG_TremauxSelectDir(MAZEG_Tremaux *tremaux, const MAZEG_Graph *graph, const MAZEG_Cost *cost, uint8_t goal, uint8_t node, uint8_t arrival);
+
+#endif /* PL_CONFIG_HAS_MAZE_GRAPH */
+
+#endif /* MAZEGRAPH_H_ */
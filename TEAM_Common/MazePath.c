@@ -0,0 +1,140 @@
+/**
+ * \file
+ * \brief Maze path implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Records and simplifies the decisions taken in a line maze.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LINE_MAZE
+#include "MazePath.h"
+
+#define MAZEP_PROFILE_MAX_DIST_MM    20000 /* limit for the profile calculation, avoids overflows */
+
+void MAZEP_Clear(MAZEP_Path *path) {
+  path->length = 0;
+}
+
+uint8_t MAZEP_GetCode(const MAZEP_Path *path, uint16_t idx) {
+  return (path->code[idx/4]>>((idx%4)*2))&3;
+}
+
+void MAZEP_SetCode(MAZEP_Path *path, uint16_t idx, uint8_t code) {
+  path->code[idx/4] = (uint8_t)((path->code[idx/4]&~(3<<((idx%4)*2)))|((code&3)<<((idx%4)*2)));
+}
+
+uint16_t MAZEP_CodeToAngle(uint8_t code) {
+  switch(code) {
+    case MAZEP_CODE_LEFT:  return 270;
+    case MAZEP_CODE_RIGHT: return 90;
+    case MAZEP_CODE_UTURN: return 180;
+    default:               return 0;
+  }
+}
+
+uint8_t MAZEP_AngleToCode(uint16_t angle) {
+  switch(angle%360) {
+    case 270: return MAZEP_CODE_LEFT;
+    case 90:  return MAZEP_CODE_RIGHT;
+    case 180: return MAZEP_CODE_UTURN;
+    default:  return MAZEP_CODE_STRAIGHT;
+  }
+}
+
+bool MAZEP_Simplify(MAZEP_Path *path) {
+  uint16_t angle;
+
+  if (path->length<3 || MAZEP_GetCode(path, path->length-2)!=MAZEP_CODE_UTURN) {
+    return FALSE;
+  }
+  angle = MAZEP_CodeToAngle(MAZEP_GetCode(path, path->length-3))
+         +MAZEP_CodeToAngle(MAZEP_CODE_UTURN)
+         +MAZEP_CodeToAngle(MAZEP_GetCode(path, path->length-1));
+  path->length -= 2;
+  MAZEP_SetCode(path, path->length-1, MAZEP_AngleToCode(angle));
+  return TRUE;
+}
+
+uint8_t MAZEP_Add(MAZEP_Path *path, uint8_t code) {
+  if (path->length>=MAZEP_MAX_PATH) {
+    return ERR_OVERFLOW;
+  }
+  MAZEP_SetCode(path, path->length, code);
+  path->length++;
+  (void)MAZEP_Simplify(path);
+  return ERR_OK;
+}
+
+uint8_t MAZEP_GetBackCode(const MAZEP_Path *path, uint16_t idx) {
+  /* left and right get swapped on the way back, straight stays straight */
+  return MAZEP_AngleToCode((uint16_t)(360-MAZEP_CodeToAngle(MAZEP_GetCode(path, (uint16_t)(path->length-1-idx)))));
+}
+
+uint32_t MAZEP_TurnDistMm(const MAZEP_Path *path, const uint16_t *segLen, bool back, uint16_t seg) {
+  uint32_t dist = 0;
+  uint16_t i;
+
+  for(i=seg;i<=path->length;i++) {
+    dist += back ? segLen[path->length-i] : segLen[i];
+    if (i==path->length || (back ? MAZEP_GetBackCode(path, i) : MAZEP_GetCode(path, i))!=MAZEP_CODE_STRAIGHT) {
+      break;
+    }
+  }
+  return dist;
+}
+
+/*!
+ * \brief Integer square root.
+ */
+static uint32_t MAZEP_Sqrt32(uint32_t val) {
+  uint32_t res = 0, bit = 1UL<<30;
+
+  while(bit>val) {
+    bit >>= 2;
+  }
+  while(bit!=0) {
+    if (val>=res+bit) {
+      val -= res+bit;
+      res = (res>>1)+bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return res;
+}
+
+uint8_t MAZEP_ProfileSpeedPercent(const MAZEP_Profile *profile, int32_t travelledMm, int32_t remainingMm) {
+  uint32_t vJunction2, v, vLimit;
+
+  if (travelledMm<0) {
+    travelledMm = 0;
+  } else if (travelledMm>MAZEP_PROFILE_MAX_DIST_MM) {
+    travelledMm = MAZEP_PROFILE_MAX_DIST_MM;
+  }
+  if (remainingMm<0) {
+    remainingMm = 0;
+  } else if (remainingMm>MAZEP_PROFILE_MAX_DIST_MM) {
+    remainingMm = MAZEP_PROFILE_MAX_DIST_MM;
+  }
+  vJunction2 = (uint32_t)profile->junctionMmS*profile->junctionMmS;
+  v = profile->maxMmS;
+  vLimit = MAZEP_Sqrt32(vJunction2+2*(uint32_t)profile->accelMmS2*(uint32_t)travelledMm); /* v^2 = v0^2 + 2*a*s */
+  if (vLimit<v) {
+    v = vLimit;
+  }
+  vLimit = MAZEP_Sqrt32(vJunction2+2*(uint32_t)profile->decelMmS2*(uint32_t)remainingMm); /* braking distance: s = (v^2-vJ^2)/(2*a) */
+  if (vLimit<v) {
+    v = vLimit;
+  }
+  v = (v*100)/profile->fullMmS;
+  if (v<1) {
+    v = 1;
+  } else if (v>100) {
+    v = 100;
+  }
+  return (uint8_t)v;
+}
+
+#endif /* PL_CONFIG_HAS_LINE_MAZE */
@@ -0,0 +1,123 @@
+/**
+ * \file
+ * \brief Maze path interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Path through a line maze as the list of decisions taken at the junctions, two bits per decision.
+ * Dead ends are cut while the path is recorded, so the path only grows with the solution.
+ * The speed profile calculates the speed for driving the solved path from the segment lengths.
+ * The functions only work on the provided data and have no hardware dependency.
+ */
+
+#ifndef MAZEPATH_H_
+#define MAZEPATH_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LINE_MAZE
+
+#define MAZEP_MAX_PATH        512 /* maximum number of decisions in a path, 2 bits each */
+
+/* path codes, 2 bits each */
+#define MAZEP_CODE_LEFT       0
+#define MAZEP_CODE_STRAIGHT   1
+#define MAZEP_CODE_RIGHT      2
+#define MAZEP_CODE_UTURN      3
+
+typedef struct {
+  uint16_t length;                   /*!< number of decisions in code[] */
+  uint8_t code[MAZEP_MAX_PATH/4];    /*!< decisions, four per byte */
+} MAZEP_Path;
+
+typedef struct {
+  bool enabled;         /*!< if the speed profile is used while driving the solved path */
+  uint16_t maxMmS;      /*!< maximum speed */
+  uint16_t junctionMmS; /*!< speed when reaching a junction where we turn, and when starting */
+  uint16_t accelMmS2;   /*!< acceleration */
+  uint16_t decelMmS2;   /*!< deceleration for the braking distance */
+  uint16_t fullMmS;     /*!< speed with 100% line following speed, to convert the speed into percent */
+} MAZEP_Profile;
+
+/*!
+ * \brief Empties the path.
+ * \param path Path
+ */
+void MAZEP_Clear(MAZEP_Path *path);
+
+/*!
+ * \brief Returns a decision of the path.
+ * \param path Path
+ * \param idx Index of the decision, from 0 to length-1
+ * \return Path code
+ */
+uint8_t MAZEP_GetCode(const MAZEP_Path *path, uint16_t idx);
+
+/*!
+ * \brief Replaces a decision of the path.
+ * \param path Path
+ * \param idx Index of the decision, from 0 to MAZEP_MAX_PATH-1
+ * \param code Path code
+ */
+void MAZEP_SetCode(MAZEP_Path *path, uint16_t idx, uint8_t code);
+
+/*!
+ * \brief Returns the heading change of a path code.
+ * \param code Path code
+ * \return Heading change in degree, clockwise
+ */
+uint16_t MAZEP_CodeToAngle(uint8_t code);
+
+/*!
+ * \brief Returns the path code for a heading change.
+ * \param angle Heading change in degree, clockwise, any multiple of 90
+ * \return Path code
+ */
+uint8_t MAZEP_AngleToCode(uint16_t angle);
+
+/*!
+ * \brief Cuts a dead end at the end of the path: x-UTURN-y gets replaced by the sum of the three heading changes.
+ * For example LEFT-UTURN-LEFT is the same as STRAIGHT.
+ * \param path Path
+ * \return TRUE if the path has been simplified
+ */
+bool MAZEP_Simplify(MAZEP_Path *path);
+
+/*!
+ * \brief Adds a decision at the end of the path and cuts the dead end with MAZEP_Simplify().
+ * \param path Path
+ * \param code Path code
+ * \return Error code, ERR_OK if everything is fine, ERR_OVERFLOW if the path is full
+ */
+uint8_t MAZEP_Add(MAZEP_Path *path, uint8_t code);
+
+/*!
+ * \brief Returns a decision of the way back, from the end to the start of the path: the decisions in reverse order, with left and right swapped.
+ * The path itself always stays in the direction it has been recorded.
+ * \param path Path
+ * \param idx Index of the decision on the way back, from 0 to length-1
+ * \return Path code
+ */
+uint8_t MAZEP_GetBackCode(const MAZEP_Path *path, uint16_t idx);
+
+/*!
+ * \brief Returns the distance from the start of a segment to the next junction where we have to turn, or to the end of the path.
+ * Junctions where the path goes straight are crossed without stopping.
+ * \param path Path
+ * \param segLen Length in mm of the segment ending at each decision, path->length+1 entries, the last one ends at the end of the path
+ * \param back TRUE if the path is driven from the end to the start
+ * \param seg Index of the segment in the direction we drive, it ends at the decision with the same index
+ * \return Distance in mm
+ */
+uint32_t MAZEP_TurnDistMm(const MAZEP_Path *path, const uint16_t *segLen, bool back, uint16_t seg);
+
+/*!
+ * \brief Calculates the speed of the profile: accelerates from the last stop and brakes in time to reach the next turn with the junction speed.
+ * \param profile Speed profile, fullMmS must not be zero
+ * \param travelledMm Distance since the last stop
+ * \param remainingMm Distance left until we need to be at the junction speed
+ * \return Speed in percent of fullMmS, 1..100
+ */
+uint8_t MAZEP_ProfileSpeedPercent(const MAZEP_Profile *profile, int32_t travelledMm, int32_t remainingMm);
+
+#endif /* PL_CONFIG_HAS_LINE_MAZE */
+
+#endif /* MAZEPATH_H_ */
@@ -14,8 +14,70 @@
 #include "PWMR.h"
 #include "PWML.h"
 #include "UTIL1.h"
+#include "CS1.h"
+#include "WAIT1.h"
+#include "FRTOS1.h"
+#if PL_CONFIG_HAS_QUADRATURE
+  #include "Q4CLeft.h"
+  #include "Q4CRight.h"
+#endif
+#if PL_CONFIG_HAS_MOTOR_TACHO
+  #include "Tacho.h"
+#endif
+#if PL_CONFIG_HAS_BATTERY_ADC
+  #include "Battery.h"
+#endif
+#if PL_CONFIG_BOARD_IS_ROBO_V2
+  #include "FTM_PDD.h"
+#endif
+#if PL_CONFIG_HAS_CONFIG_NVM
+  #include "NVM_Config.h"
+#endif
+
+#define MOT_PWM_OFF   0xFFFF /* PWM value for zero duty, H-Bridge is low active */
+
+/*! \todo adopt the limits for your robot */
+#define MOT_DEFAULT_SLEW_RATE   2000 /* %/s: full duty change in 50 ms */
+#define MOT_DEFAULT_JERK_RATE   0    /* %/s^2, 0: no jerk limit */
+#define MOT_COMMIT_MAX_GAP_MS   (4*MOT_COMMIT_PERIOD_MS) /* longer time between commits is limited to this, so a ramp does not jump after a pause */
+
+#define MOT_DEADBAND_MAX        0x8000 /* maximum deadband duty (50%), anything above is not a valid calibration */
+#define MOT_DEADBAND_MIN_DUTY   0x0100 /* requested duty below this is treated as zero, so the motor does not chatter around zero */
+#define MOT_DEADBAND_MOVING_SPEED  50  /* tacho speed (steps/s) above which the motor is considered as turning */
+
+/*! \todo adopt the nominal voltage to your battery */
+#define MOT_DEFAULT_SUPPLY_NOMINAL_CV  500  /* nominal battery voltage in centi-volt the controllers are tuned for */
+#define MOT_DEFAULT_SUPPLY_CLAMP       150  /* maximum scale factor in %, used for a low battery */
+#define MOT_SUPPLY_MIN_SCALE_PERCENT   50   /* minimum scale factor in % */
+#define MOT_SUPPLY_PERIOD_MS           100  /* time between battery measurements */
+#define MOT_SUPPLY_FILTER_SHIFT        3    /* low pass filter: each measurement contributes with 1/8 */
+
+typedef struct {
+  uint32_t slewRate, jerkRate; /* per motor limits, as in MOT_MotorDevice */
+  uint16_t deadbandBreakaway[2], deadbandKinetic[2]; /* per motor and direction, as in MOT_MotorDevice */
+} MOT_Config_t;
+
+typedef struct {
+  MOT_Config_t motor[2]; /* left and right motor */
+  uint16_t supplyNominalCV, supplyClampPercent; /* as in MOT_Supply */
+} MOT_NVMData_t;
+
+static struct {
+  bool enabled; /* if the supply compensation is enabled */
+  uint16_t nominalCV; /* nominal voltage in centi-volt */
+  uint16_t clampPercent; /* maximum scale factor in % */
+#if PL_CONFIG_HAS_BATTERY_ADC
+  bool isMeasuring; /* if we have started a measurement */
+  TickType_t lastTicks; /* time of the last measurement start */
+  uint32_t filteredCV; /* filtered voltage in centi-volt, shifted by MOT_SUPPLY_FILTER_SHIFT, 0 if no measurement yet */
+#endif
+  volatile uint32_t scale; /* current scale factor, MOT_SUPPLY_SCALE_ONE is 1.0 */
+} MOT_Supply;
 
 static MOT_MotorDevice motorL, motorR;
+static TickType_t MOT_lastCommitTicks; /* time of the last MOT_CommitStaged() */
+static MOTM_Model MOT_Model[2]; /* measured model of the left and right motor */
+static bool MOT_ModelValid = FALSE; /* if MOT_Model is valid */
 
 MOT_MotorDevice *MOT_GetMotorHandle(MOT_MotorSide side) {
   if (side==MOT_MOTOR_LEFT) {
@@ -43,9 +105,415 @@ static void DirRPutVal(bool val) {
   DIRR_PutVal(val);
 }
 
+static uint16_t MOT_LimitSlew(MOT_MotorDevice *motor, uint16_t val) {
+  if (motor->slewLimit!=0 && val<motor->currPWMvalue && motor->currPWMvalue-val>motor->slewLimit) {
+    val = motor->currPWMvalue-motor->slewLimit; /* PWM is low active: lower value means more power */
+  }
+  return val;
+}
+
+uint32_t MOT_GetSupplyScale(void) {
+  return MOT_Supply.scale;
+}
+
+/*!
+ * \brief Scales the duty with the current supply scale factor.
+ * \param val PWM value (low active)
+ * \return Scaled PWM value
+ */
+static uint16_t MOT_ScaleSupply(uint16_t val) {
+  uint32_t duty;
+
+  if (!MOT_Supply.enabled) {
+    return val;
+  }
+  duty = ((uint32_t)(MOT_PWM_OFF-val)*MOT_Supply.scale)/MOT_SUPPLY_SCALE_ONE;
+  if (duty>MOT_PWM_OFF) {
+    duty = MOT_PWM_OFF; /* full duty */
+  }
+  return (uint16_t)(MOT_PWM_OFF-duty);
+}
+
+#if PL_CONFIG_HAS_BATTERY_ADC
+static void MOT_SupplyCalcScale(void) {
+  uint32_t cv, scale;
+
+  cv = MOT_Supply.filteredCV>>MOT_SUPPLY_FILTER_SHIFT;
+  if (cv==0) {
+    scale = MOT_SUPPLY_SCALE_ONE; /* no valid measurement yet */
+  } else {
+    scale = ((uint32_t)MOT_Supply.nominalCV*MOT_SUPPLY_SCALE_ONE)/cv;
+  }
+  if (scale>(uint32_t)MOT_Supply.clampPercent*MOT_SUPPLY_SCALE_ONE/100) {
+    scale = (uint32_t)MOT_Supply.clampPercent*MOT_SUPPLY_SCALE_ONE/100;
+  } else if (scale<MOT_SUPPLY_MIN_SCALE_PERCENT*MOT_SUPPLY_SCALE_ONE/100) {
+    scale = MOT_SUPPLY_MIN_SCALE_PERCENT*MOT_SUPPLY_SCALE_ONE/100;
+  }
+  MOT_Supply.scale = scale;
+}
+
+/*!
+ * \brief Measures the battery voltage periodically, without waiting for the ADC.
+ * Called for every MOT_CommitStaged(), so from the control loop.
+ */
+static void MOT_SupplyPoll(void) {
+  uint16_t cv;
+  uint8_t res;
+  CS1_CriticalVariable();
+
+  CS1_EnterCritical(); /* MOT_CommitStaged() can be called from different tasks */
+  if (!MOT_Supply.isMeasuring) {
+    if ((FRTOS1_xTaskGetTickCount()-MOT_Supply.lastTicks)*portTICK_PERIOD_MS>=MOT_SUPPLY_PERIOD_MS && BATT_StartMeasurement()==ERR_OK) {
+      MOT_Supply.lastTicks = FRTOS1_xTaskGetTickCount();
+      MOT_Supply.isMeasuring = TRUE;
+    }
+    CS1_ExitCritical();
+    return;
+  }
+  res = BATT_GetMeasurement(&cv);
+  if (res==ERR_BUSY) {
+    CS1_ExitCritical();
+    return; /* check again next time */
+  }
+  MOT_Supply.isMeasuring = FALSE;
+  if (res==ERR_OK && cv!=0) {
+    if (MOT_Supply.filteredCV==0) { /* first measurement */
+      MOT_Supply.filteredCV = (uint32_t)cv<<MOT_SUPPLY_FILTER_SHIFT;
+    } else {
+      MOT_Supply.filteredCV += cv-(MOT_Supply.filteredCV>>MOT_SUPPLY_FILTER_SHIFT);
+    }
+    MOT_SupplyCalcScale();
+  }
+  CS1_ExitCritical();
+}
+#endif /* PL_CONFIG_HAS_BATTERY_ADC */
+
 void MOT_SetVal(MOT_MotorDevice *motor, uint16_t val) {
+  CS1_CriticalVariable();
+
+  CS1_EnterCritical();
+  motor->isStaged = FALSE; /* a direct value replaces a staged ramp, so a later commit does not continue it */
+  motor->dutyStep = 0;
+  val = MOT_LimitSlew(motor, val);
   motor->currPWMvalue = val;
   motor->SetRatio16(val);
+  CS1_ExitCritical();
+}
+
+/*!
+ * \brief Determines if the motor is already turning in the given direction.
+ */
+static bool MOT_IsTurning(MOT_MotorDevice *motor, MOT_Direction dir) {
+#if PL_CONFIG_HAS_MOTOR_TACHO
+  int32_t speed;
+
+  speed = TACHO_GetSpeed(motor==&motorL);
+  if (dir==MOT_DIR_BACKWARD) {
+    speed = -speed;
+  }
+  return speed>MOT_DEADBAND_MOVING_SPEED;
+#else
+  /* no speed information: assume the motor turns if it is already powered in this direction */
+  return motor->currDirection==dir && motor->currPWMvalue!=MOT_PWM_OFF;
+#endif
+}
+
+/*!
+ * \brief Maps the duty range above the deadband: a small duty starts with the breakaway or kinetic duty of the motor.
+ * \param motor Motor handle
+ * \param val PWM value (low active)
+ * \param dir Direction
+ * \return Compensated PWM value
+ */
+static uint16_t MOT_CompensateDeadband(MOT_MotorDevice *motor, uint16_t val, MOT_Direction dir) {
+  uint32_t duty, offset;
+
+  duty = MOT_PWM_OFF-val;
+  if (duty<MOT_DEADBAND_MIN_DUTY) {
+    return MOT_PWM_OFF; /* treat as zero */
+  }
+  if (MOT_IsTurning(motor, dir)) {
+    offset = motor->deadbandKinetic[dir];
+  } else {
+    offset = motor->deadbandBreakaway[dir];
+  }
+  if (offset==0) {
+    return val; /* not calibrated */
+  }
+  duty = offset+(duty*(MOT_PWM_OFF-offset))/MOT_PWM_OFF;
+  return (uint16_t)(MOT_PWM_OFF-duty);
+}
+
+void MOT_StageVal(MOT_MotorDevice *motor, uint16_t val, MOT_Direction dir) {
+  CS1_CriticalVariable();
+
+  val = MOT_ScaleSupply(MOT_CompensateDeadband(motor, val, dir));
+  CS1_EnterCritical();
+  motor->stagedPWMvalue = val;
+  motor->stagedDirection = dir;
+  motor->isStaged = TRUE;
+  CS1_ExitCritical();
+}
+
+static uint32_t MOT_Sqrt32(uint32_t val) {
+  uint32_t res = 0, bit = 1UL<<30;
+
+  while (bit>val) {
+    bit >>= 2;
+  }
+  while (bit!=0) {
+    if (val>=res+bit) {
+      val -= res+bit;
+      res = (res>>1)+bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return res;
+}
+
+/*!
+ * \brief Returns the largest slope from which the duty can still stop within a distance, if the slope can be reduced by jerkStep per period.
+ * Slopes s, s-j, s-2j, ... add up to s*(m+1)-j*m*(m+1)/2, with m=(s-1)/j the number of further periods.
+ * \param jerkStep Maximum change of the slope per period, not zero
+ * \param dist Distance to the target
+ * \return Maximum slope per period
+ */
+static uint32_t MOT_BrakeSlope(uint32_t jerkStep, uint32_t dist) {
+  uint64_t root;
+  uint32_t m, slope;
+
+  root = (uint64_t)jerkStep*jerkStep+(uint64_t)8*jerkStep*dist;
+  if (root>0xFFFFFFFFu) {
+    return 0xFFFFFFFFu; /* larger than any duty change */
+  }
+  slope = (MOT_Sqrt32((uint32_t)root)-jerkStep)/2; /* continuous solution, used to find m */
+  m = slope/jerkStep;
+  for(;;) { /* m is correct or one off */
+    slope = (uint32_t)(((uint64_t)dist+(uint64_t)jerkStep*m*(m+1)/2)/(m+1));
+    if (slope>(m+1)*jerkStep) {
+      m++;
+    } else if (m>0 && slope<=m*jerkStep) {
+      m--;
+    } else {
+      return slope;
+    }
+  }
+}
+
+/*!
+ * \brief Limits the duty change since the last commit with the slew and jerk rate.
+ * The limits are calculated for the nominal period MOT_COMMIT_PERIOD_MS and scaled with the elapsed time.
+ * \param motor Motor handle
+ * \param duty Current duty, -0xFFFF (full backward) to 0xFFFF (full forward)
+ * \param target Target duty
+ * \param dtMs Time since the last commit, 1..MOT_COMMIT_MAX_GAP_MS
+ * \return New duty
+ */
+static int32_t MOT_LimitRate(MOT_MotorDevice *motor, int32_t duty, int32_t target, uint32_t dtMs) {
+  int32_t delta, step, reachStep, maxStep;
+  uint32_t maxSlope;
+
+  delta = target-duty;
+  if (motor->slewRate==0 && motor->jerkRate==0) {
+    motor->dutyStep = 0;
+    return target; /* no limit */
+  }
+  step = (int32_t)(((int64_t)delta*MOT_COMMIT_PERIOD_MS)/(int32_t)dtMs); /* slope per nominal period to reach the target now */
+  reachStep = step;
+  if (motor->slewRate!=0) {
+    maxStep = (int32_t)(((uint64_t)motor->slewRate*0xFFFF*MOT_COMMIT_PERIOD_MS)/(100*1000));
+    if (maxStep<1) {
+      maxStep = 1;
+    }
+    if (step>maxStep) {
+      step = maxStep;
+    } else if (step<-maxStep) {
+      step = -maxStep;
+    }
+  }
+  if (motor->jerkRate!=0) {
+    maxStep = (int32_t)(((uint64_t)motor->jerkRate*0xFFFF*MOT_COMMIT_PERIOD_MS*MOT_COMMIT_PERIOD_MS)/(100*1000*1000));
+    if (maxStep<1) {
+      maxStep = 1;
+    }
+    /* reduce the slope in time, so the target is reached without overshoot */
+    maxSlope = MOT_BrakeSlope((uint32_t)maxStep, (uint32_t)(delta<0?-delta:delta));
+    if (step>0 && (uint32_t)step>maxSlope) {
+      step = (int32_t)maxSlope;
+    } else if (step<0 && (uint32_t)-step>maxSlope) {
+      step = -(int32_t)maxSlope;
+    }
+    /* limit the change of the slope, for the elapsed time */
+    maxStep = (int32_t)(((int64_t)maxStep*(int32_t)dtMs)/MOT_COMMIT_PERIOD_MS);
+    if (maxStep<1) {
+      maxStep = 1;
+    }
+    if (step>motor->dutyStep+maxStep) {
+      step = motor->dutyStep+maxStep;
+    } else if (step<motor->dutyStep-maxStep) {
+      step = motor->dutyStep-maxStep;
+    }
+  }
+  if (step==reachStep) {
+    step = delta; /* no limit active, avoid the rounding */
+  } else {
+    step = (int32_t)(((int64_t)step*(int32_t)dtMs)/MOT_COMMIT_PERIOD_MS); /* change for the elapsed time */
+  }
+  if (step==0 && delta!=0) {
+    step = delta>0?1:-1; /* make progress even with rounding */
+  }
+  if ((delta>=0 && step>delta) || (delta<0 && step<delta)) {
+    step = delta; /* do not overshoot */
+  }
+  motor->dutyStep = (int32_t)(((int64_t)step*MOT_COMMIT_PERIOD_MS)/(int32_t)dtMs); /* slope per nominal period */
+  return duty+step;
+}
+
+/*!
+ * \brief Determines the value to be written for a motor with the next commit.
+ * \param[in] motor Motor handle
+ * \param[in] dtMs Time since the last commit, for the rate limits
+ * \param[out] changeDir Set to TRUE if the direction has to be changed
+ * \return PWM value to be used
+ */
+static uint16_t MOT_PrepareCommit(MOT_MotorDevice *motor, uint32_t dtMs, bool *changeDir, MOT_Direction *dir) {
+  int32_t duty, target;
+  uint16_t val;
+
+  *changeDir = FALSE;
+  *dir = motor->currDirection;
+  if (!motor->isStaged) {
+    motor->dutyStep = 0; /* duty stays constant */
+    return motor->currPWMvalue; /* keep current value */
+  }
+  /* use signed duty for the rate limits, so a reversal passes through zero */
+  duty = MOT_PWM_OFF-motor->currPWMvalue;
+  if (motor->currDirection==MOT_DIR_BACKWARD) {
+    duty = -duty;
+  }
+  target = MOT_PWM_OFF-motor->stagedPWMvalue;
+  if (motor->stagedDirection==MOT_DIR_BACKWARD) {
+    target = -target;
+  }
+  duty = MOT_LimitRate(motor, duty, target, dtMs);
+  if (duty==target) {
+    motor->isStaged = FALSE; /* target reached */
+  }
+  if (duty<0) {
+    *dir = MOT_DIR_BACKWARD;
+    duty = -duty;
+  } else if (duty>0) {
+    *dir = MOT_DIR_FORWARD;
+  }
+  if (*dir!=motor->currDirection) {
+    if (motor->currPWMvalue!=MOT_PWM_OFF) {
+      motor->isStaged = TRUE; /* continue with next commit */
+      *dir = motor->currDirection;
+      return MOT_PWM_OFF; /* first step of reversal: zero duty, direction changes with the next commit */
+    }
+    *changeDir = TRUE;
+  }
+  val = MOT_LimitSlew(motor, (uint16_t)(MOT_PWM_OFF-duty));
+  if (val!=MOT_PWM_OFF-duty) {
+    motor->isStaged = TRUE; /* slip limit active: continue ramp with next commit */
+  }
+  return val;
+}
+
+#if PL_CONFIG_BOARD_IS_ROBO_V2 /* PWML and PWMR are on FTM0 (MOTTU) */
+static uint32_t MOT_FTM0ReadCounter(void) {
+  return FTM_PDD_ReadCounterReg(FTM0_BASE_PTR);
+}
+
+static uint32_t MOT_FTM0ReadModulo(void) {
+  return FTM_PDD_ReadModuloReg(FTM0_BASE_PTR);
+}
+
+static const MOT_PwmTimer MOT_FTM0Timer = {
+  MOT_FTM0ReadCounter,
+  MOT_FTM0ReadModulo
+};
+#endif
+
+static const MOT_PwmTimer *MOT_pwmTimer = NULL; /* timer of both PWM channels, NULL if they do not share one */
+
+void MOT_SetPwmTimer(const MOT_PwmTimer *timer) {
+  MOT_pwmTimer = timer;
+}
+
+/*!
+ * \brief Makes sure that we are not at the end of the PWM period, so that both channels get reloaded in the same period.
+ */
+static void MOT_WaitForReloadWindow(void) {
+  uint32_t mod;
+
+  if (MOT_pwmTimer==NULL) {
+    return; /* channels are not synchronized */
+  }
+  mod = MOT_pwmTimer->ReadModulo();
+  while (MOT_pwmTimer->ReadCounter()>mod-mod/4) {
+    /* wait for the counter reload, this is less than a quarter of the 20 kHz PWM period */
+  }
+}
+
+void MOT_CommitStaged(void) {
+  uint16_t valL, valR;
+  bool changeDirL, changeDirR;
+  MOT_Direction dirL, dirR;
+  TickType_t now;
+  uint32_t dtMs;
+  CS1_CriticalVariable();
+
+#if PL_CONFIG_HAS_BATTERY_ADC
+  MOT_SupplyPoll();
+#endif
+  now = FRTOS1_xTaskGetTickCount();
+  CS1_EnterCritical();
+  dtMs = (uint32_t)(now-MOT_lastCommitTicks)*portTICK_PERIOD_MS;
+  if (dtMs==0) {
+    CS1_ExitCritical();
+    return; /* already committed in this tick, the rate limits do not allow a change yet */
+  }
+  MOT_lastCommitTicks = now;
+  if (dtMs>MOT_COMMIT_MAX_GAP_MS) {
+    dtMs = MOT_COMMIT_MAX_GAP_MS;
+  }
+  if (!motorL.isStaged && !motorR.isStaged) {
+    motorL.dutyStep = 0; /* duty stays constant */
+    motorR.dutyStep = 0;
+    CS1_ExitCritical();
+    return; /* nothing to do */
+  }
+  valL = MOT_PrepareCommit(&motorL, dtMs, &changeDirL, &dirL);
+  valR = MOT_PrepareCommit(&motorR, dtMs, &changeDirR, &dirR);
+  /* duty of a motor with direction change is already zero, so the direction signal can change now */
+  if (changeDirL) {
+    MOT_SetDirection(&motorL, dirL);
+  }
+  if (changeDirR) {
+    MOT_SetDirection(&motorR, dirR);
+  }
+  MOT_WaitForReloadWindow();
+  motorL.currPWMvalue = valL;
+  motorR.currPWMvalue = valR;
+  (void)motorL.SetRatio16(valL);
+  (void)motorR.SetRatio16(valR);
+  CS1_ExitCritical();
+  MOT_UpdatePercent(&motorL, motorL.currDirection);
+  MOT_UpdatePercent(&motorR, motorR.currDirection);
+}
+
+void MOT_SetSlewLimit(MOT_MotorDevice *motor, uint16_t maxIncrease) {
+  motor->slewLimit = maxIncrease;
+}
+
+const MOTM_Model *MOT_GetModel(MOT_MotorSide side) {
+  if (!MOT_ModelValid) {
+    return NULL;
+  }
+  return &MOT_Model[side==MOT_MOTOR_LEFT?0:1];
 }
 
 uint16_t MOT_GetVal(MOT_MotorDevice *motor) {
@@ -76,7 +544,7 @@ void MOT_SetSpeedPercent(MOT_MotorDevice *motor, MOT_SpeedPercent percent) {
     MOT_SetDirection(motor, MOT_DIR_FORWARD);
   }
   val = ((100-percent)*0xffff)/100; /* H-Bridge is low active! */
-  MOT_SetVal(motor, (uint16_t)val);
+  MOT_SetVal(motor, MOT_ScaleSupply((uint16_t)val));
 }
 
 void MOT_UpdatePercent(MOT_MotorDevice *motor, MOT_Direction dir) {
@@ -97,6 +565,7 @@ void MOT_ChangeSpeedPercent(MOT_MotorDevice *motor, MOT_SpeedPercent relPercent)
 }
 
 void MOT_SetDirection(MOT_MotorDevice *motor, MOT_Direction dir) {
+  motor->currDirection = dir;
   if (dir==MOT_DIR_FORWARD ) {
 #if MOTOR_HAS_INVERT
     motor->DirPutVal(motor->inverted?0:1);
@@ -126,12 +595,399 @@ MOT_Direction MOT_GetDirection(MOT_MotorDevice *motor) {
   }
 }
 
+static void MOT_ClearDeadband(MOT_MotorDevice *motor) {
+  motor->deadbandBreakaway[MOT_DIR_FORWARD] = 0;
+  motor->deadbandBreakaway[MOT_DIR_BACKWARD] = 0;
+  motor->deadbandKinetic[MOT_DIR_FORWARD] = 0;
+  motor->deadbandKinetic[MOT_DIR_BACKWARD] = 0;
+}
+
+#if PL_CONFIG_HAS_CONFIG_NVM
+static uint16_t MOT_CheckDeadband(uint16_t val) {
+  if (val>MOT_DEADBAND_MAX) { /* erased or invalid FLASH */
+    return 0;
+  }
+  return val;
+}
+
+static void MOT_LoadConfig(MOT_MotorDevice *motor, const MOT_Config_t *config) {
+  motor->slewRate = config->slewRate;
+  motor->jerkRate = config->jerkRate;
+  motor->deadbandBreakaway[MOT_DIR_FORWARD] = MOT_CheckDeadband(config->deadbandBreakaway[MOT_DIR_FORWARD]);
+  motor->deadbandBreakaway[MOT_DIR_BACKWARD] = MOT_CheckDeadband(config->deadbandBreakaway[MOT_DIR_BACKWARD]);
+  motor->deadbandKinetic[MOT_DIR_FORWARD] = MOT_CheckDeadband(config->deadbandKinetic[MOT_DIR_FORWARD]);
+  motor->deadbandKinetic[MOT_DIR_BACKWARD] = MOT_CheckDeadband(config->deadbandKinetic[MOT_DIR_BACKWARD]);
+}
+
+static void MOT_StoreConfig(const MOT_MotorDevice *motor, MOT_Config_t *config) {
+  config->slewRate = motor->slewRate;
+  config->jerkRate = motor->jerkRate;
+  config->deadbandBreakaway[MOT_DIR_FORWARD] = motor->deadbandBreakaway[MOT_DIR_FORWARD];
+  config->deadbandBreakaway[MOT_DIR_BACKWARD] = motor->deadbandBreakaway[MOT_DIR_BACKWARD];
+  config->deadbandKinetic[MOT_DIR_FORWARD] = motor->deadbandKinetic[MOT_DIR_FORWARD];
+  config->deadbandKinetic[MOT_DIR_BACKWARD] = motor->deadbandKinetic[MOT_DIR_BACKWARD];
+}
+
+static uint8_t MOT_LoadSettingsFromFlash(void) {
+  MOT_NVMData_t *ptr;
+
+  ptr = (MOT_NVMData_t*)NVMC_GetMotorData();
+  if (ptr==NULL) {
+    return ERR_FAILED;
+  }
+  MOT_LoadConfig(&motorL, &ptr->motor[0]);
+  MOT_LoadConfig(&motorR, &ptr->motor[1]);
+  if (ptr->supplyNominalCV!=0xFFFF && ptr->supplyNominalCV!=0) { /* not erased */
+    MOT_Supply.nominalCV = ptr->supplyNominalCV;
+  }
+  if (ptr->supplyClampPercent>=100 && ptr->supplyClampPercent<=200) {
+    MOT_Supply.clampPercent = ptr->supplyClampPercent;
+  }
+  return ERR_OK;
+}
+
+static uint8_t MOT_StoreSettingsToFlash(void) {
+  MOT_NVMData_t data;
+
+  MOT_StoreConfig(&motorL, &data.motor[0]);
+  MOT_StoreConfig(&motorR, &data.motor[1]);
+  data.supplyNominalCV = MOT_Supply.nominalCV;
+  data.supplyClampPercent = MOT_Supply.clampPercent;
+  return NVMC_SaveMotorData(&data, sizeof(data));
+}
+
+static uint8_t MOT_LoadModelFromFlash(void) {
+  MOTM_Model *ptr;
+
+  ptr = (MOTM_Model*)NVMC_GetMotorModelData();
+  if (ptr==NULL) {
+    return ERR_FAILED;
+  }
+  MOT_Model[0] = ptr[0];
+  MOT_Model[1] = ptr[1];
+  MOT_ModelValid = TRUE;
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_CONFIG_NVM */
+
+#if PL_CONFIG_HAS_SHELL
+static void MOT_PrintModel(const MOTM_Model *model, const unsigned char *kindStr, const CLS1_StdIOType *io) {
+  unsigned char buf[96];
+
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"K ");
+  UTIL1_strcatNum32sDotValue100(buf, sizeof(buf), model->gainX100);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps/s/%, offset ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), model->offset);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", tau ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), model->tauMs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms, dead ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), model->deadTimeMs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms, max ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), model->maxSpeed);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps/s\r\n");
+  CLS1_SendStatusStr(kindStr, buf, io->stdOut);
+}
+#endif
+
+#if PL_CONFIG_HAS_QUADRATURE && PL_CONFIG_HAS_SHELL
+#define MOT_CALIB_STEP          0x80  /* duty increment for each calibration step (0.2%) */
+#define MOT_CALIB_STEP_MS       10    /* time for each calibration step */
+#define MOT_CALIB_MOVE_TICKS    4     /* number of encoder ticks to detect a turning motor */
+#define MOT_CALIB_STILL_MS      50    /* time without encoder tick to detect a stopped motor */
+
+static int32_t MOT_CalibGetPos(MOT_MotorDevice *motor) {
+  if (motor==&motorL) {
+    return (int32_t)Q4CLeft_GetPos();
+  }
+  return (int32_t)Q4CRight_GetPos();
+}
+
+static bool MOT_CalibHasMoved(MOT_MotorDevice *motor, int32_t startPos, int32_t nofTicks) {
+  int32_t diff;
+
+  diff = MOT_CalibGetPos(motor)-startPos;
+  return diff>=nofTicks || diff<=-nofTicks;
+}
+
+/*!
+ * \brief Measures the deadband of a motor in one direction. The motor gets ramped up until the wheel turns (breakaway),
+ * and then ramped down until the wheel stops (kinetic).
+ * \param motor Motor handle
+ * \param dir Direction to measure
+ * \return Error code, ERR_OK if everything is fine
+ */
+static uint8_t MOT_CalibDeadband(MOT_MotorDevice *motor, MOT_Direction dir) {
+  uint32_t duty, breakaway, kinetic;
+  int32_t pos;
+  uint8_t res = ERR_OK;
+  CS1_CriticalVariable();
+
+  CS1_EnterCritical();
+  motor->isStaged = FALSE; /* we drive the motor directly */
+  CS1_ExitCritical();
+  MOT_SetDirection(motor, dir);
+  /* ramp up until the wheel turns */
+  pos = MOT_CalibGetPos(motor);
+  for(duty=MOT_CALIB_STEP;;duty+=MOT_CALIB_STEP) {
+    if (duty>MOT_DEADBAND_MAX) {
+      res = ERR_FAILED; /* wheel blocked or encoder not working */
+      break;
+    }
+    MOT_SetVal(motor, (uint16_t)(MOT_PWM_OFF-duty));
+    WAIT1_WaitOSms(MOT_CALIB_STEP_MS);
+    if (MOT_CalibHasMoved(motor, pos, MOT_CALIB_MOVE_TICKS)) {
+      break;
+    }
+  }
+  breakaway = duty;
+  /* ramp down until the wheel stops */
+  kinetic = breakaway;
+  if (res==ERR_OK) {
+    for(;;) {
+      pos = MOT_CalibGetPos(motor);
+      WAIT1_WaitOSms(MOT_CALIB_STILL_MS);
+      if (!MOT_CalibHasMoved(motor, pos, 1)) {
+        break; /* stopped: last duty was the lowest one keeping the wheel turning */
+      }
+      kinetic = duty;
+      if (duty<=MOT_CALIB_STEP) {
+        break;
+      }
+      duty -= MOT_CALIB_STEP;
+      MOT_SetVal(motor, (uint16_t)(MOT_PWM_OFF-duty));
+    }
+  }
+  MOT_SetVal(motor, MOT_PWM_OFF);
+  MOT_UpdatePercent(motor, dir);
+  if (res==ERR_OK) {
+    motor->deadbandBreakaway[dir] = (uint16_t)breakaway;
+    motor->deadbandKinetic[dir] = (uint16_t)kinetic;
+  }
+  WAIT1_WaitOSms(200); /* let the wheel stop */
+  return res;
+}
+
+static uint8_t MOT_CalibDeadbandAll(const CLS1_StdIOType *io) {
+  static const struct {
+    MOT_MotorDevice *motor;
+    MOT_Direction dir;
+    const unsigned char *name;
+  } calib[] = {
+      {&motorL, MOT_DIR_FORWARD, (const unsigned char*)"L forward"},
+      {&motorL, MOT_DIR_BACKWARD, (const unsigned char*)"L backward"},
+      {&motorR, MOT_DIR_FORWARD, (const unsigned char*)"R forward"},
+      {&motorR, MOT_DIR_BACKWARD, (const unsigned char*)"R backward"},
+  };
+  unsigned char buf[48];
+  uint8_t res = ERR_OK;
+  int i;
+
+  CLS1_SendStr((unsigned char*)"Calibrating deadband, lift the robot and make sure the drive mode is 'none'...\r\n", io->stdOut);
+  for(i=0;i<(int)(sizeof(calib)/sizeof(calib[0]));i++) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"motor ");
+    UTIL1_strcat(buf, sizeof(buf), calib[i].name);
+    if (MOT_CalibDeadband(calib[i].motor, calib[i].dir)!=ERR_OK) {
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)": FAILED, wheel did not turn\r\n");
+      CLS1_SendStr(buf, io->stdErr);
+      res = ERR_FAILED;
+    } else {
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)": breakaway 0x");
+      UTIL1_strcatNum16Hex(buf, sizeof(buf), calib[i].motor->deadbandBreakaway[calib[i].dir]);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", kinetic 0x");
+      UTIL1_strcatNum16Hex(buf, sizeof(buf), calib[i].motor->deadbandKinetic[calib[i].dir]);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+      CLS1_SendStr(buf, io->stdOut);
+    }
+  }
+#if PL_CONFIG_HAS_CONFIG_NVM
+  if (res==ERR_OK) {
+    res = MOT_StoreSettingsToFlash();
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"Storing to FLASH failed!\r\n", io->stdErr);
+    }
+  }
+#endif
+  return res;
+}
+
+#define MOT_CHAR_PERIOD_MS     5     /* sample period for the characterization */
+#define MOT_CHAR_NOF_SAMPLES   200   /* number of samples for the step response */
+#define MOT_CHAR_STEP_DUTY     0x8000 /* duty for the step response (50%) */
+#define MOT_CHAR_RAMP_MS       2000  /* duration of the ramp from 0 to 100% */
+#define MOT_CHAR_HOLD_MS       300   /* time at 100% to measure the maximum speed */
+#define MOT_CHAR_PAUSE_MS      500   /* time to let the wheel stop */
+
+static int16_t MOT_CharPos[MOT_CHAR_NOF_SAMPLES], MOT_CharSpeed[MOT_CHAR_NOF_SAMPLES]; /* log for the step response */
+
+/*!
+ * \brief Measures the dynamic model of a motor with a duty step and a duty ramp. The motor is driven directly,
+ * without deadband or supply compensation, so the model describes the raw motor.
+ * \param motor Motor handle
+ * \param model Where to store the model
+ * \return Error code, ERR_OK if everything is fine
+ */
+static uint8_t MOT_Characterize(MOT_MotorDevice *motor, MOTM_Model *model) {
+  TickType_t lastWakeTime;
+  MOTM_LineFit fit;
+  int32_t startPos, pos, prevPos, speed, sign;
+  uint32_t duty;
+  int i;
+  uint8_t res;
+  CS1_CriticalVariable();
+
+  CS1_EnterCritical();
+  motor->isStaged = FALSE; /* we drive the motor directly */
+  CS1_ExitCritical();
+  MOT_SetDirection(motor, MOT_DIR_FORWARD);
+  /* step response */
+  startPos = MOT_CalibGetPos(motor);
+  lastWakeTime = FRTOS1_xTaskGetTickCount();
+  MOT_SetVal(motor, (uint16_t)(MOT_PWM_OFF-MOT_CHAR_STEP_DUTY));
+  for(i=0;i<MOT_CHAR_NOF_SAMPLES;i++) {
+    MOT_CharPos[i] = (int16_t)(MOT_CalibGetPos(motor)-startPos);
+    FRTOS1_vTaskDelayUntil(&lastWakeTime, MOT_CHAR_PERIOD_MS/portTICK_PERIOD_MS);
+  }
+  MOT_SetVal(motor, MOT_PWM_OFF);
+  MOTM_PosToSpeed(MOT_CharPos, MOT_CharSpeed, MOT_CHAR_NOF_SAMPLES, MOT_CHAR_PERIOD_MS);
+  res = MOTM_FitStep(MOT_CharSpeed, MOT_CHAR_NOF_SAMPLES, MOT_CHAR_PERIOD_MS, model);
+  sign = MOT_CharPos[MOT_CHAR_NOF_SAMPLES-1]<0?-1:1; /* encoder direction */
+  WAIT1_WaitOSms(MOT_CHAR_PAUSE_MS);
+  if (res!=ERR_OK) {
+    return res;
+  }
+  /* ramp for the static curve: only use samples where the wheel turns */
+  MOTM_LineFitInit(&fit);
+  prevPos = MOT_CalibGetPos(motor);
+  lastWakeTime = FRTOS1_xTaskGetTickCount();
+  for(i=1;i<=MOT_CHAR_RAMP_MS/MOT_CHAR_PERIOD_MS;i++) {
+    duty = ((uint32_t)i*MOT_PWM_OFF)/(MOT_CHAR_RAMP_MS/MOT_CHAR_PERIOD_MS);
+    MOT_SetVal(motor, (uint16_t)(MOT_PWM_OFF-duty));
+    FRTOS1_vTaskDelayUntil(&lastWakeTime, MOT_CHAR_PERIOD_MS/portTICK_PERIOD_MS);
+    pos = MOT_CalibGetPos(motor);
+    speed = (sign*(pos-prevPos)*1000)/MOT_CHAR_PERIOD_MS;
+    prevPos = pos;
+    if (speed>0) {
+      MOTM_LineFitAdd(&fit, (int32_t)((duty*10000)/MOT_PWM_OFF), speed);
+    }
+  }
+  /* hold full duty for the maximum speed */
+  WAIT1_WaitOSms(MOT_CHAR_HOLD_MS/2); /* settle */
+  startPos = MOT_CalibGetPos(motor);
+  WAIT1_WaitOSms(MOT_CHAR_HOLD_MS);
+  model->maxSpeed = (sign*(MOT_CalibGetPos(motor)-startPos)*1000)/MOT_CHAR_HOLD_MS;
+  MOT_SetVal(motor, MOT_PWM_OFF);
+  MOT_UpdatePercent(motor, MOT_DIR_FORWARD);
+  WAIT1_WaitOSms(MOT_CHAR_PAUSE_MS);
+  return MOTM_LineFitGet(&fit, model);
+}
+
+static uint8_t MOT_CharacterizeAll(const CLS1_StdIOType *io) {
+  unsigned char buf[64];
+  MOTM_Model model[2];
+  uint8_t res;
+  int i;
+
+  CLS1_SendStr((unsigned char*)"Characterizing motors, lift the robot and make sure the drive mode is 'none'...\r\n", io->stdOut);
+  for(i=0;i<2;i++) {
+    res = MOT_Characterize(i==0?&motorL:&motorR, &model[i]);
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)(i==0?"motor L: FAILED, no usable response\r\n":"motor R: FAILED, no usable response\r\n"), io->stdErr);
+      return res;
+    }
+  }
+  MOT_Model[0] = model[0];
+  MOT_Model[1] = model[1];
+  MOT_ModelValid = TRUE;
+  /* summary for the controller design: first order model plus dead time and the feed forward for a speed */
+  CLS1_SendStatusStr((unsigned char*)"Motor model", (unsigned char*)"speed = K*duty+offset, first order with dead time\r\n", io->stdOut);
+  MOT_PrintModel(&MOT_Model[0], (unsigned char*)"  model L", io);
+  MOT_PrintModel(&MOT_Model[1], (unsigned char*)"  model R", io);
+  for(i=0;i<2;i++) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"1000 steps/s: ");
+    UTIL1_strcatNum32sDotValue100(buf, sizeof(buf), MOTM_SpeedToDutyX100(&MOT_Model[i], 1000));
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"% duty\r\n");
+    CLS1_SendStatusStr((unsigned char*)(i==0?"  feedfwd L":"  feedfwd R"), buf, io->stdOut);
+  }
+#if PL_CONFIG_HAS_CONFIG_NVM
+  res = NVMC_SaveMotorModelData(MOT_Model, sizeof(MOT_Model));
+  if (res!=ERR_OK) {
+    CLS1_SendStr((unsigned char*)"Storing to FLASH failed!\r\n", io->stdErr);
+  }
+#endif
+  return res;
+}
+#endif /* PL_CONFIG_HAS_QUADRATURE && PL_CONFIG_HAS_SHELL */
+
 #if PL_CONFIG_HAS_SHELL
 static void MOT_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"motor", (unsigned char*)"Group of motor commands\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows motor help or status\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  (L|R) forward|backward", (unsigned char*)"Change motor direction\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  (L|R) duty <number>", (unsigned char*)"Change motor PWM (-100..+100)%\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  (L|R) slew <number>", (unsigned char*)"Set slew rate limit in %/s for controller values, 0 to disable\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  (L|R) jerk <number>", (unsigned char*)"Set jerk limit in %/s^2 for controller values, 0 to disable\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  (L|R) deadband clear", (unsigned char*)"Disable the deadband compensation\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  supply on|off", (unsigned char*)"Enable or disable the battery voltage compensation\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  supply nominal <cV>", (unsigned char*)"Set nominal battery voltage in centi-volt (500 is 5.0V)\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  supply clamp <percent>", (unsigned char*)"Set maximum supply scale factor (100..200)%\r\n", io->stdOut);
+#if PL_CONFIG_HAS_QUADRATURE
+  CLS1_SendHelpStr((unsigned char*)"  calib deadband", (unsigned char*)"Measure breakaway and kinetic duty of both motors (robot lifted)\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  characterize", (unsigned char*)"Measure gain, time constant, dead time and max speed of both motors (robot lifted)\r\n", io->stdOut);
+#endif
+#if PL_CONFIG_HAS_CONFIG_NVM
+  CLS1_SendHelpStr((unsigned char*)"  store", (unsigned char*)"Store slew, jerk, deadband and supply settings in FLASH\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  load", (unsigned char*)"Load slew, jerk, deadband and supply settings from FLASH\r\n", io->stdOut);
+#endif
+}
+
+static void MOT_PrintLimits(MOT_MotorDevice *motor, const unsigned char *kindStr, const CLS1_StdIOType *io) {
+  unsigned char buf[40];
+
+  buf[0] = '\0';
+  UTIL1_strcatNum32u(buf, sizeof(buf), motor->slewRate);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" %/s, jerk ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), motor->jerkRate);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" %/s^2\r\n");
+  CLS1_SendStatusStr(kindStr, buf, io->stdOut);
+}
+
+static void MOT_PrintDeadband(MOT_MotorDevice *motor, const unsigned char *kindStr, const CLS1_StdIOType *io) {
+  unsigned char buf[64];
+
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"fw 0x");
+  UTIL1_strcatNum16Hex(buf, sizeof(buf), motor->deadbandBreakaway[MOT_DIR_FORWARD]);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"/0x");
+  UTIL1_strcatNum16Hex(buf, sizeof(buf), motor->deadbandKinetic[MOT_DIR_FORWARD]);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", bw 0x");
+  UTIL1_strcatNum16Hex(buf, sizeof(buf), motor->deadbandBreakaway[MOT_DIR_BACKWARD]);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"/0x");
+  UTIL1_strcatNum16Hex(buf, sizeof(buf), motor->deadbandKinetic[MOT_DIR_BACKWARD]);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" (breakaway/kinetic)\r\n");
+  CLS1_SendStatusStr(kindStr, buf, io->stdOut);
+}
+
+static void MOT_PrintSupply(const CLS1_StdIOType *io) {
+  unsigned char buf[64];
+
+  buf[0] = '\0';
+#if PL_CONFIG_HAS_BATTERY_ADC
+  if (MOT_Supply.filteredCV!=0) {
+    UTIL1_strcatNum32sDotValue100(buf, sizeof(buf), MOT_Supply.filteredCV>>MOT_SUPPLY_FILTER_SHIFT);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" V");
+  } else {
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"no measurement");
+  }
+#else
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"no ADC");
+#endif
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" (nominal ");
+  UTIL1_strcatNum32sDotValue100(buf, sizeof(buf), MOT_Supply.nominalCV);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" V), scale ");
+  UTIL1_strcatNum32sDotValue100(buf, sizeof(buf), (int32_t)((MOT_Supply.scale*100)/MOT_SUPPLY_SCALE_ONE));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" (max ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), MOT_Supply.clampPercent);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)(MOT_Supply.enabled?"%), on\r\n":"%), off\r\n"));
+  CLS1_SendStatusStr((unsigned char*)"  supply", buf, io->stdOut);
 }
 
 static void MOT_PrintStatus(const CLS1_StdIOType *io) {
@@ -156,6 +1012,30 @@ static void MOT_PrintStatus(const CLS1_StdIOType *io) {
   UTIL1_strcat(buf, sizeof(buf),(unsigned char*)(MOT_GetDirection(&motorR)==MOT_DIR_FORWARD?", fw":", bw"));
   CLS1_SendStr(buf, io->stdOut);
   CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
+
+  MOT_PrintLimits(&motorL, (unsigned char*)"  slew L", io);
+  MOT_PrintLimits(&motorR, (unsigned char*)"  slew R", io);
+  MOT_PrintDeadband(&motorL, (unsigned char*)"  deadband L", io);
+  MOT_PrintDeadband(&motorR, (unsigned char*)"  deadband R", io);
+  MOT_PrintSupply(io);
+  if (MOT_ModelValid) {
+    MOT_PrintModel(&MOT_Model[0], (unsigned char*)"  model L", io);
+    MOT_PrintModel(&MOT_Model[1], (unsigned char*)"  model R", io);
+  } else {
+    CLS1_SendStatusStr((unsigned char*)"  model", (unsigned char*)"not characterized\r\n", io->stdOut);
+  }
+}
+
+static uint8_t MOT_ParseLimit(const unsigned char *p, uint32_t *limit, bool *handled, const CLS1_StdIOType *io) {
+  int32_t val;
+
+  if (UTIL1_xatoi(&p, &val)==ERR_OK && val>=0) {
+    *limit = (uint32_t)val;
+    *handled = TRUE;
+    return ERR_OK;
+  }
+  CLS1_SendStr((unsigned char*)"Wrong argument, must be zero or positive\r\n", io->stdErr);
+  return ERR_FAILED;
 }
 
 uint8_t MOT_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
@@ -199,6 +1079,77 @@ uint8_t MOT_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_Std
       CLS1_SendStr((unsigned char*)"Wrong argument, must be in the range -100..100\r\n", io->stdErr);
       res = ERR_FAILED;
     }
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"motor L slew ", sizeof("motor L slew ")-1)==0) {
+    res = MOT_ParseLimit(cmd+sizeof("motor L slew"), &motorL.slewRate, handled, io);
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"motor R slew ", sizeof("motor R slew ")-1)==0) {
+    res = MOT_ParseLimit(cmd+sizeof("motor R slew"), &motorR.slewRate, handled, io);
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"motor L jerk ", sizeof("motor L jerk ")-1)==0) {
+    res = MOT_ParseLimit(cmd+sizeof("motor L jerk"), &motorL.jerkRate, handled, io);
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"motor R jerk ", sizeof("motor R jerk ")-1)==0) {
+    res = MOT_ParseLimit(cmd+sizeof("motor R jerk"), &motorR.jerkRate, handled, io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motor L deadband clear")==0) {
+    MOT_ClearDeadband(&motorL);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motor R deadband clear")==0) {
+    MOT_ClearDeadband(&motorR);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motor supply on")==0) {
+#if PL_CONFIG_HAS_BATTERY_ADC
+    MOT_Supply.enabled = TRUE;
+#else
+    CLS1_SendStr((unsigned char*)"No battery ADC, enable PL_CONFIG_HAS_BATTERY_ADC\r\n", io->stdErr);
+    res = ERR_FAILED;
+#endif
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motor supply off")==0) {
+    MOT_Supply.enabled = FALSE;
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"motor supply nominal ", sizeof("motor supply nominal ")-1)==0) {
+    p = cmd+sizeof("motor supply nominal");
+    if (UTIL1_xatoi(&p, &val)==ERR_OK && val>0 && val<=0xFFFE) {
+      MOT_Supply.nominalCV = (uint16_t)val;
+#if PL_CONFIG_HAS_BATTERY_ADC
+      MOT_SupplyCalcScale();
+#endif
+      *handled = TRUE;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument, must be positive centi-volt value\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"motor supply clamp ", sizeof("motor supply clamp ")-1)==0) {
+    p = cmd+sizeof("motor supply clamp");
+    if (UTIL1_xatoi(&p, &val)==ERR_OK && val>=100 && val<=200) {
+      MOT_Supply.clampPercent = (uint16_t)val;
+#if PL_CONFIG_HAS_BATTERY_ADC
+      MOT_SupplyCalcScale();
+#endif
+      *handled = TRUE;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument, must be in the range 100..200\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+#if PL_CONFIG_HAS_QUADRATURE
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motor calib deadband")==0) {
+    *handled = TRUE;
+    res = MOT_CalibDeadbandAll(io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motor characterize")==0) {
+    *handled = TRUE;
+    res = MOT_CharacterizeAll(io);
+#endif
+#if PL_CONFIG_HAS_CONFIG_NVM
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motor store")==0) {
+    *handled = TRUE;
+    res = MOT_StoreSettingsToFlash();
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"Storing to FLASH failed!\r\n", io->stdErr);
+    }
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motor load")==0) {
+    *handled = TRUE;
+    res = MOT_LoadSettingsFromFlash();
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"Loading from FLASH failed!\r\n", io->stdErr);
+    }
+#endif
   }
   return res;
 }
@@ -217,6 +1168,41 @@ void MOT_Init(void) {
   motorR.DirPutVal = DirRPutVal;
   motorL.SetRatio16 = PWMLSetRatio16;
   motorR.SetRatio16 = PWMRSetRatio16;
+  motorL.slewLimit = 0;
+  motorR.slewLimit = 0;
+  motorL.isStaged = FALSE;
+  motorR.isStaged = FALSE;
+#if PL_CONFIG_BOARD_IS_ROBO_V2
+  MOT_SetPwmTimer(&MOT_FTM0Timer);
+#else
+  MOT_SetPwmTimer(NULL);
+#endif
+  motorL.dutyStep = 0;
+  motorR.dutyStep = 0;
+  MOT_lastCommitTicks = FRTOS1_xTaskGetTickCount();
+  motorL.slewRate = MOT_DEFAULT_SLEW_RATE;
+  motorR.slewRate = MOT_DEFAULT_SLEW_RATE;
+  motorL.jerkRate = MOT_DEFAULT_JERK_RATE;
+  motorR.jerkRate = MOT_DEFAULT_JERK_RATE;
+  MOT_ClearDeadband(&motorL);
+  MOT_ClearDeadband(&motorR);
+#if PL_CONFIG_HAS_BATTERY_ADC
+  MOT_Supply.enabled = TRUE;
+#else
+  MOT_Supply.enabled = FALSE; /* only makes sense if we can measure the voltage */
+#endif
+  MOT_Supply.nominalCV = MOT_DEFAULT_SUPPLY_NOMINAL_CV;
+  MOT_Supply.clampPercent = MOT_DEFAULT_SUPPLY_CLAMP;
+  MOT_Supply.scale = MOT_SUPPLY_SCALE_ONE;
+#if PL_CONFIG_HAS_BATTERY_ADC
+  MOT_Supply.isMeasuring = FALSE;
+  MOT_Supply.lastTicks = FRTOS1_xTaskGetTickCount()-MOT_SUPPLY_PERIOD_MS/portTICK_PERIOD_MS; /* measure with the first commit */
+  MOT_Supply.filteredCV = 0;
+#endif
+#if PL_CONFIG_HAS_CONFIG_NVM
+  (void)MOT_LoadSettingsFromFlash(); /* use stored limits if available */
+  (void)MOT_LoadModelFromFlash();
+#endif
   MOT_SetSpeedPercent(&motorL, 0);
   MOT_SetSpeedPercent(&motorR, 0);
   (void)PWML_Enable();
@@ -11,6 +11,7 @@
 
 #include "Platform.h"
 #if PL_CONFIG_HAS_MOTOR
+#include "MotorModel.h"
 
 #define MOTOR_HAS_INVERT 1  /* if we support motor revert at runtime */
 
@@ -27,6 +28,16 @@ typedef struct MOT_MotorDevice_ {
 #endif
   MOT_SpeedPercent currSpeedPercent; /*!< our current speed in %, negative percent means backward */
   uint16_t currPWMvalue; /*!< current PWM value used */
+  uint16_t slewLimit; /*!< maximum PWM duty increase for each MOT_SetVal() call, 0 for no limit */
+  MOT_Direction currDirection; /*!< current state of the direction signal */
+  bool isStaged; /*!< if a value is staged and waiting for MOT_CommitStaged() */
+  uint16_t stagedPWMvalue; /*!< staged PWM value */
+  MOT_Direction stagedDirection; /*!< staged direction */
+  uint32_t slewRate; /*!< maximum duty change in %/s applied by MOT_CommitStaged(), 0 for no limit */
+  uint32_t jerkRate; /*!< maximum change of the duty slope in %/s^2 applied by MOT_CommitStaged(), 0 for no limit */
+  int32_t dutyStep; /*!< duty change of the last commit per MOT_COMMIT_PERIOD_MS, used for the jerk limit */
+  uint16_t deadbandBreakaway[2]; /*!< duty needed to start the motor from standstill, indexed by MOT_Direction, 0 for no compensation */
+  uint16_t deadbandKinetic[2]; /*!< duty needed to keep the motor turning, indexed by MOT_Direction, 0 for no compensation */
   uint8_t (*SetRatio16)(uint16_t); /*!< function to set the ratio */
   void (*DirPutVal)(bool); /*!< function to set direction bit */
 } MOT_MotorDevice;
@@ -75,12 +86,69 @@ void MOT_SetSpeedPercent(MOT_MotorDevice *motor, MOT_SpeedPercent percent);
 void MOT_UpdatePercent(MOT_MotorDevice *motor, MOT_Direction dir);
 
 /*!
- * \brief Sets the PWM value for the motor.
+ * \brief Sets the PWM value for the motor. A value staged for the motor gets discarded.
  * \param[in] motor Motor handle
  * \param[in] val New PWM value.
  */
 void MOT_SetVal(MOT_MotorDevice *motor, uint16_t val);
 
+/*!
+ * \brief Stages a new PWM value and direction for a motor. The values get applied with MOT_CommitStaged().
+ * The value gets compensated for the deadband of the motor: a small duty is lifted above the static or kinetic friction.
+ * Additionally the duty gets scaled with the battery voltage, see MOT_GetSupplyScale().
+ * \param[in] motor Motor handle
+ * \param[in] val New PWM value (low active)
+ * \param[in] dir New direction
+ */
+void MOT_StageVal(MOT_MotorDevice *motor, uint16_t val, MOT_Direction dir);
+
+#define MOT_COMMIT_PERIOD_MS  5 /*!< nominal period in ms MOT_CommitStaged() is called. The slew and jerk limits get scaled with the actual time between the commits */
+
+#define MOT_SUPPLY_SCALE_ONE  0x1000 /*!< supply scale factor of 1.0 */
+
+/*!
+ * \brief Returns the factor the duty gets scaled with to compensate the battery voltage (nominal/actual voltage).
+ * The battery voltage is measured periodically with MOT_CommitStaged().
+ * Without PL_CONFIG_HAS_BATTERY_ADC (disabled in the robot configuration) the compensation is off and the factor stays 1.0.
+ * \return Scale factor, MOT_SUPPLY_SCALE_ONE is 1.0
+ */
+uint32_t MOT_GetSupplyScale(void);
+
+/*!
+ * \brief Applies the staged values of both motors, so they get active in the same PWM period.
+ * The change of the duty is limited by the slew and jerk rate of the motor for the time since the last commit, so it can take several commits to reach the staged value.
+ * Only the controller which stages the values should commit them: a second commit in the same tick does not change anything.
+ * If the direction of a motor changes, the motor gets first a zero duty step and the direction change
+ * with the new value is applied with the next commit.
+ */
+void MOT_CommitStaged(void);
+
+typedef struct {
+  uint32_t (*ReadCounter)(void); /*!< returns the counter of the PWM timer */
+  uint32_t (*ReadModulo)(void);  /*!< returns the modulo (last counter value of the period) of the PWM timer */
+} MOT_PwmTimer;
+
+/*!
+ * \brief Sets the timer both PWM channels run on. MOT_CommitStaged() uses it to write both channels early in the same PWM period.
+ * MOT_Init() sets the FTM0 timer of the V2 robot. Tests can use it to inject a fake timer.
+ * \param timer Timer access functions, NULL if the channels do not share a timer (no waiting)
+ */
+void MOT_SetPwmTimer(const MOT_PwmTimer *timer);
+
+/*!
+ * \brief Limits how fast the motor power can be increased with MOT_SetVal(). Decreasing the power is not limited.
+ * \param[in] motor Motor handle
+ * \param[in] maxIncrease Maximum duty increase (in PWM units) for each call of MOT_SetVal(), 0 to disable the limit
+ */
+void MOT_SetSlewLimit(MOT_MotorDevice *motor, uint16_t maxIncrease);
+
+/*!
+ * \brief Returns the measured dynamic model of a motor, see 'motor characterize'.
+ * \param side Which motor
+ * \return Pointer to the model, or NULL if the motor has not been characterized
+ */
+const MOTM_Model *MOT_GetModel(MOT_MotorSide side);
+
 /*!
  * \brief Return the current PWM value of the motor.
  * \param[in] motor Motor handle
@@ -0,0 +1,144 @@
+/**
+ * \file
+ * \brief Motor model implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Fits a first order motor model to measured step responses and duty ramps.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MOTOR
+#include "MotorModel.h"
+
+#define MOTM_SPEED_HALF_WINDOW  2 /* central difference over 2*MOTM_SPEED_HALF_WINDOW samples */
+
+void MOTM_PosToSpeed(const int16_t *pos, int16_t *speed, uint16_t nofSamples, uint16_t periodMs) {
+  int i, lo, hi;
+
+  for(i=0;i<nofSamples;i++) {
+    lo = i-MOTM_SPEED_HALF_WINDOW;
+    if (lo<0) {
+      lo = 0;
+    }
+    hi = i+MOTM_SPEED_HALF_WINDOW;
+    if (hi>=nofSamples) {
+      hi = nofSamples-1;
+    }
+    if (hi==lo) {
+      speed[i] = 0;
+    } else {
+      speed[i] = (int16_t)(((int32_t)(pos[hi]-pos[lo])*1000)/((hi-lo)*(int32_t)periodMs));
+    }
+  }
+}
+
+/*!
+ * \brief Returns the time in ms when the response crosses the threshold the first time, with linear interpolation.
+ * \return Time in ms, or -1 if the threshold is not reached
+ */
+static int32_t MOTM_CrossingTimeMs(const int16_t *speed, uint16_t nofSamples, uint16_t periodMs, int32_t sign, int32_t threshold) {
+  int i;
+  int32_t y0, y1;
+
+  y0 = 0;
+  for(i=0;i<nofSamples;i++) {
+    y1 = sign*speed[i];
+    if (y1>=threshold) {
+      if (i==0 || y1==y0) {
+        return (int32_t)i*periodMs;
+      }
+      return (int32_t)(i-1)*periodMs + ((threshold-y0)*(int32_t)periodMs)/(y1-y0);
+    }
+    y0 = y1;
+  }
+  return -1;
+}
+
+uint8_t MOTM_FitStep(const int16_t *speed, uint16_t nofSamples, uint16_t periodMs, MOTM_Model *model) {
+  int32_t final, sign, t28, t63, tau, deadTime;
+  int i, nofFinal;
+
+  if (nofSamples<8) {
+    return ERR_FAILED;
+  }
+  /* final value: average of the last quarter */
+  nofFinal = nofSamples/4;
+  final = 0;
+  for(i=nofSamples-nofFinal;i<nofSamples;i++) {
+    final += speed[i];
+  }
+  final /= nofFinal;
+  if (final==0) {
+    return ERR_FAILED; /* no movement */
+  }
+  sign = 1;
+  if (final<0) { /* encoder counting backwards */
+    sign = -1;
+    final = -final;
+  }
+  t28 = MOTM_CrossingTimeMs(speed, nofSamples, periodMs, sign, (final*283)/1000);
+  t63 = MOTM_CrossingTimeMs(speed, nofSamples, periodMs, sign, (final*632)/1000);
+  if (t28<0 || t63<0 || t63<=t28) {
+    return ERR_FAILED;
+  }
+  /* first order with dead time: t28 = deadTime+tau/3, t63 = deadTime+tau */
+  tau = ((t63-t28)*3)/2;
+  deadTime = t63-tau;
+  if (deadTime<0) {
+    deadTime = 0;
+  }
+  model->tauMs = (uint16_t)tau;
+  model->deadTimeMs = (uint16_t)deadTime;
+  return ERR_OK;
+}
+
+void MOTM_LineFitInit(MOTM_LineFit *fit) {
+  fit->n = 0;
+  fit->sx = 0;
+  fit->sy = 0;
+  fit->sxx = 0;
+  fit->sxy = 0;
+}
+
+void MOTM_LineFitAdd(MOTM_LineFit *fit, int32_t dutyX100, int32_t speed) {
+  fit->n++;
+  fit->sx += dutyX100;
+  fit->sy += speed;
+  fit->sxx += (int64_t)dutyX100*dutyX100;
+  fit->sxy += (int64_t)dutyX100*speed;
+}
+
+uint8_t MOTM_LineFitGet(const MOTM_LineFit *fit, MOTM_Model *model) {
+  int64_t num, den;
+
+  if (fit->n<2) {
+    return ERR_FAILED;
+  }
+  num = fit->n*fit->sxy - fit->sx*fit->sy;
+  den = fit->n*fit->sxx - fit->sx*fit->sx;
+  if (den==0) {
+    return ERR_FAILED; /* all samples with the same duty */
+  }
+  /* x is in 1/100 %, so the slope times 10000 is the gain in (steps/s)/% times 100 */
+  model->gainX100 = (int32_t)((num*10000)/den);
+  model->offset = (int32_t)(fit->sy/fit->n - ((int64_t)model->gainX100*(fit->sx/fit->n))/10000);
+  return ERR_OK;
+}
+
+int32_t MOTM_SpeedToDutyX100(const MOTM_Model *model, int32_t speed) {
+  int32_t duty;
+
+  if (model->gainX100==0) {
+    return 0;
+  }
+  /* speed = gainX100/100*duty + offset */
+  duty = (int32_t)(((int64_t)(speed-model->offset)*10000)/model->gainX100);
+  if (duty<0) {
+    duty = 0;
+  } else if (duty>10000) {
+    duty = 10000;
+  }
+  return duty;
+}
+
+#endif /* PL_CONFIG_HAS_MOTOR */
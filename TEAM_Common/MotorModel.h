@@ -0,0 +1,81 @@
+/**
+ * \file
+ * \brief Motor model interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * First order motor model (gain, time constant, dead time) and the functions to fit it to measured data.
+ * The functions only work on the provided data and have no hardware dependency.
+ */
+
+#ifndef MOTORMODEL_H_
+#define MOTORMODEL_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MOTOR
+
+typedef struct {
+  int32_t gainX100;   /*!< steady state speed increase per duty percent, in (steps/s)/% times 100 */
+  int32_t offset;     /*!< speed axis intercept of the static curve in steps/s, negative because of the deadband */
+  uint16_t tauMs;     /*!< time constant in ms */
+  uint16_t deadTimeMs; /*!< dead time in ms */
+  int32_t maxSpeed;   /*!< speed at 100% duty in steps/s */
+} MOTM_Model;
+
+typedef struct {
+  int32_t n;            /*!< number of samples */
+  int64_t sx, sy;       /*!< sum of x and y */
+  int64_t sxx, sxy;     /*!< sum of x*x and x*y */
+} MOTM_LineFit;
+
+/*!
+ * \brief Calculates the speed from a position log, with a central difference over 4 samples.
+ * \param pos Array of positions in steps
+ * \param speed Array where to store the speed in steps/s, can not be the same as pos
+ * \param nofSamples Number of entries in the arrays
+ * \param periodMs Time between the samples
+ */
+void MOTM_PosToSpeed(const int16_t *pos, int16_t *speed, uint16_t nofSamples, uint16_t periodMs);
+
+/*!
+ * \brief Determines time constant and dead time from a step response with the two point method (28.3% and 63.2% of the final value).
+ * \param speed Step response (speed in steps/s), starting at the time of the step
+ * \param nofSamples Number of samples. The last quarter of the samples is used as final value.
+ * \param periodMs Time between the samples
+ * \param[out] model Where tauMs and deadTimeMs get stored
+ * \return Error code, ERR_OK if everything is fine, ERR_FAILED if there is no usable response
+ */
+uint8_t MOTM_FitStep(const int16_t *speed, uint16_t nofSamples, uint16_t periodMs, MOTM_Model *model);
+
+/*!
+ * \brief Resets a least square line fit.
+ * \param fit Line fit data
+ */
+void MOTM_LineFitInit(MOTM_LineFit *fit);
+
+/*!
+ * \brief Adds a sample of the static curve to the line fit.
+ * \param fit Line fit data
+ * \param dutyX100 Duty in percent times 100 (0..10000)
+ * \param speed Speed in steps/s
+ */
+void MOTM_LineFitAdd(MOTM_LineFit *fit, int32_t dutyX100, int32_t speed);
+
+/*!
+ * \brief Calculates gain and offset of the static curve from the line fit.
+ * \param fit Line fit data
+ * \param[out] model Where gainX100 and offset get stored
+ * \return Error code, ERR_OK if everything is fine, ERR_FAILED if there are not enough samples
+ */
+uint8_t MOTM_LineFitGet(const MOTM_LineFit *fit, MOTM_Model *model);
+
+/*!
+ * \brief Calculates the feed forward duty needed for a speed, based on the static curve.
+ * \param model Motor model
+ * \param speed Desired speed in steps/s
+ * \return Duty in percent times 100, limited to 0..10000
+ */
+int32_t MOTM_SpeedToDutyX100(const MOTM_Model *model, int32_t speed);
+
+#endif /* PL_CONFIG_HAS_MOTOR */
+
+#endif /* MOTORMODEL_H_ */
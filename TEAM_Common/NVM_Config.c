@@ -51,6 +51,62 @@ void *NVMC_GetPIDData(void) {
   return (void*)NVMC_PID_SETTINGS_DATA_START_ADDR;
 }
 
+uint8_t NVMC_SaveOdoData(void *data, uint16_t dataSize) {
+  if (dataSize>NVMC_ODO_DATA_SIZE) {
+    return ERR_OVERFLOW;
+  }
+  return IFsh1_SetBlockFlash(data, (IFsh1_TAddress)(NVMC_ODO_DATA_START_ADDR), dataSize);
+}
+
+void *NVMC_GetOdoData(void) {
+  if (isErased((uint8_t*)NVMC_ODO_DATA_START_ADDR, NVMC_ODO_DATA_SIZE)) {
+    return NULL;
+  }
+  return (void*)NVMC_ODO_DATA_START_ADDR;
+}
+
+uint8_t NVMC_SaveMotorData(void *data, uint16_t dataSize) {
+  if (dataSize>NVMC_MOTOR_DATA_SIZE) {
+    return ERR_OVERFLOW;
+  }
+  return IFsh1_SetBlockFlash(data, (IFsh1_TAddress)(NVMC_MOTOR_DATA_START_ADDR), dataSize);
+}
+
+void *NVMC_GetMotorData(void) {
+  if (isErased((uint8_t*)NVMC_MOTOR_DATA_START_ADDR, NVMC_MOTOR_DATA_SIZE)) {
+    return NULL;
+  }
+  return (void*)NVMC_MOTOR_DATA_START_ADDR;
+}
+
+uint8_t NVMC_SaveMotorModelData(void *data, uint16_t dataSize) {
+  if (dataSize>NVMC_MOTOR_MODEL_DATA_SIZE) {
+    return ERR_OVERFLOW;
+  }
+  return IFsh1_SetBlockFlash(data, (IFsh1_TAddress)(NVMC_MOTOR_MODEL_DATA_START_ADDR), dataSize);
+}
+
+void *NVMC_GetMotorModelData(void) {
+  if (isErased((uint8_t*)NVMC_MOTOR_MODEL_DATA_START_ADDR, NVMC_MOTOR_MODEL_DATA_SIZE)) {
+    return NULL;
+  }
+  return (void*)NVMC_MOTOR_MODEL_DATA_START_ADDR;
+}
+
+uint8_t NVMC_SaveMazeData(void *data, uint16_t dataSize) {
+  if (dataSize>NVMC_MAZE_DATA_SIZE) {
+    return ERR_OVERFLOW;
+  }
+  return IFsh1_SetBlockFlash(data, (IFsh1_TAddress)(NVMC_MAZE_DATA_START_ADDR), dataSize);
+}
+
+void *NVMC_GetMazeData(void) {
+  if (isErased((uint8_t*)NVMC_MAZE_DATA_START_ADDR, NVMC_MAZE_DATA_SIZE)) {
+    return NULL;
+  }
+  return (void*)NVMC_MAZE_DATA_START_ADDR;
+}
+
 
 void NVMC_Init(void) {
   /* nothing needed */
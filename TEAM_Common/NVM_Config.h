@@ -42,6 +42,22 @@
 #define NVMC_PID_SETTINGS_DATA_SIZE        (5*7*4) /* 5 PID configs with 7 32bit values each */
 #define NVMC_PID_SETTINGS_END_ADDR         (NVMC_REFLECTANCE_END_ADDR+NVMC_PID_SETTINGS_DATA_SIZE)
 
+#define NVMC_ODO_DATA_START_ADDR           (NVMC_PID_SETTINGS_END_ADDR)
+#define NVMC_ODO_DATA_SIZE                 (2*4) /* odometry calibration: ticks per meter and wheel base, 32bit each */
+#define NVMC_ODO_END_ADDR                  (NVMC_ODO_DATA_START_ADDR+NVMC_ODO_DATA_SIZE)
+
+#define NVMC_MOTOR_DATA_START_ADDR         (NVMC_ODO_END_ADDR)
+#define NVMC_MOTOR_DATA_SIZE               (2*(2*4+4*2)+2*2) /* for two motors: slew and jerk limit (32bit), deadband for both directions (2x16bit), plus supply nominal voltage and clamp (16bit) */
+#define NVMC_MOTOR_END_ADDR                (NVMC_MOTOR_DATA_START_ADDR+NVMC_MOTOR_DATA_SIZE)
+
+#define NVMC_MOTOR_MODEL_DATA_START_ADDR   (NVMC_MOTOR_END_ADDR)
+#define NVMC_MOTOR_MODEL_DATA_SIZE         (2*16) /* MOTM_Model for two motors */
+#define NVMC_MOTOR_MODEL_END_ADDR          (NVMC_MOTOR_MODEL_DATA_START_ADDR+NVMC_MOTOR_MODEL_DATA_SIZE)
+
+#define NVMC_MAZE_DATA_START_ADDR          (NVMC_MOTOR_MODEL_END_ADDR)
+#define NVMC_MAZE_DATA_SIZE                (0xA80) /* solved maze: header, packed path, segment lengths and map of 64 junctions */
+#define NVMC_MAZE_END_ADDR                 (NVMC_MAZE_DATA_START_ADDR+NVMC_MAZE_DATA_SIZE)
+
 /*!
  * \brief Saves the reflectance calibration data
  * \param data Pointer to the data
@@ -70,6 +86,62 @@ uint8_t NVMC_SavePIDData(void *data, uint16_t dataSize);
  */
 void *NVMC_GetPIDData(void);
 
+/*!
+ * \brief Saves the odometry calibration
+ * \param data Pointer to the data
+ * \param dataSize Size of data in bytes
+ * \return Error code, ERR_OK if everything is fine
+ */
+uint8_t NVMC_SaveOdoData(void *data, uint16_t dataSize);
+
+/*!
+ * \brief Returns the odometry calibration data
+ * \return Pointer to data, or NULL for failure
+ */
+void *NVMC_GetOdoData(void);
+
+/*!
+ * \brief Saves the motor limit, deadband and supply compensation settings
+ * \param data Pointer to the data
+ * \param dataSize Size of data in bytes
+ * \return Error code, ERR_OK if everything is fine
+ */
+uint8_t NVMC_SaveMotorData(void *data, uint16_t dataSize);
+
+/*!
+ * \brief Returns the motor limit, deadband and supply compensation settings
+ * \return Pointer to data, or NULL for failure
+ */
+void *NVMC_GetMotorData(void);
+
+/*!
+ * \brief Saves the measured motor models
+ * \param data Pointer to the data
+ * \param dataSize Size of data in bytes
+ * \return Error code, ERR_OK if everything is fine
+ */
+uint8_t NVMC_SaveMotorModelData(void *data, uint16_t dataSize);
+
+/*!
+ * \brief Returns the measured motor models
+ * \return Pointer to data, or NULL for failure
+ */
+void *NVMC_GetMotorModelData(void);
+
+/*!
+ * \brief Saves the solved maze
+ * \param data Pointer to the data
+ * \param dataSize Size of data in bytes
+ * \return Error code, ERR_OK if everything is fine
+ */
+uint8_t NVMC_SaveMazeData(void *data, uint16_t dataSize);
+
+/*!
+ * \brief Returns the solved maze
+ * \return Pointer to data, or NULL for failure
+ */
+void *NVMC_GetMazeData(void);
+
 /*! \brief Driver initialization  */
 void NVMC_Init(void);
 
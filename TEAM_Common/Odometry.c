@@ -0,0 +1,351 @@
+/**
+ * \file
+ * \brief Odometry implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module estimates the robot pose (x, y, heading) from the wheel encoders.
+ * The pose is integrated in fixed-point arithmetic using a sine lookup table:
+ * the position is accumulated in encoder half-ticks (sum of both wheels) scaled by the
+ * Q15 sine/cosine values, so no rounding error accumulates. Conversion into
+ * micrometers is done on publishing, using the calibration values.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_ODOMETRY
+#include "Odometry.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+#if PL_CONFIG_HAS_CONFIG_NVM
+  #include "NVM_Config.h"
+#endif
+
+/*! \todo adopt the values for your robot */
+#define ODO_DEFAULT_TICKS_PER_M       10370 /* encoder ticks per meter of wheel travel */
+#define ODO_DEFAULT_WHEEL_BASE_UM     86000 /* distance between the wheel contact points in micrometers */
+
+#define ODO_TRIG_ONE          32767 /* 1.0 in Q15 of the sine table */
+#define ODO_BAM_PER_RAD       683565276LL /* 2^32/(2*pi) */
+
+typedef struct {
+  int32_t ticksPerM;   /* encoder ticks per meter */
+  int32_t wheelBaseUm; /* wheel base in micrometers */
+} ODO_Calib_t;
+
+static ODO_Calib_t ODO_calib; /* calibration values */
+
+static struct {
+  int64_t x, y;        /* position in half-ticks, scaled by ODO_TRIG_ONE */
+  ODO_Angle heading;   /* current heading */
+  int32_t dist;        /* distance in half-ticks */
+  int32_t lastL, lastR;/* encoder positions of last update */
+  int32_t angleFactor; /* binary angle per tick of wheel difference */
+} ODO_state;
+
+static ODO_Pose ODO_pose; /* published pose, protected by ODO_poseSeq */
+static volatile uint32_t ODO_poseSeq = 0; /* sequence counter: odd while writing */
+static volatile bool ODO_resetRequest = FALSE;
+static volatile bool ODO_calibChanged = FALSE;
+
+#define ODO_MEMORY_BARRIER()  __asm volatile("" ::: "memory")
+
+/* sin(i*pi/128) for the first quadrant, Q15 */
+static const int16_t ODO_SinTable[65] = {
+      0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+   6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+  12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+  18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+  23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+  27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+  30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+  32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+  32767,
+};
+
+/*!
+ * \brief Returns the sine value of a table index, with 256 entries for a full turn.
+ */
+static int32_t SinIdx(uint32_t idx) {
+  idx &= 0xff;
+  if (idx<64) {
+    return ODO_SinTable[idx];
+  } else if (idx<128) {
+    return ODO_SinTable[128-idx];
+  } else if (idx<192) {
+    return -ODO_SinTable[idx-128];
+  } else {
+    return -ODO_SinTable[256-idx];
+  }
+}
+
+/*!
+ * \brief Sine of a binary angle, linear interpolated from the table.
+ * \return Sine in Q15
+ */
+static int32_t ODO_Sin(ODO_Angle angle) {
+  uint32_t idx;
+  int32_t a, b, frac;
+
+  idx = angle>>24; /* upper 8 bits: table index */
+  frac = (int32_t)((angle>>8)&0xffff); /* next 16 bits: interpolation */
+  a = SinIdx(idx);
+  b = SinIdx(idx+1);
+  return a+(((b-a)*frac)>>16);
+}
+
+static int32_t ODO_Cos(ODO_Angle angle) {
+  return ODO_Sin(angle+ODO_ANGLE_90);
+}
+
+static void ODO_CalcFactors(void) {
+  int64_t denom;
+
+  denom = (int64_t)ODO_calib.ticksPerM*ODO_calib.wheelBaseUm;
+  if (denom<=0) {
+    ODO_state.angleFactor = 0; /* invalid calibration */
+  } else {
+    /* angle = (dR-dL)/(ticksPerM*wheelBase), scaled to binary angle */
+    ODO_state.angleFactor = (int32_t)((ODO_BAM_PER_RAD*1000000LL)/denom);
+  }
+}
+
+/*!
+ * \brief Integrates a wheel movement into the state.
+ * \param deltaL Left wheel movement in ticks
+ * \param deltaR Right wheel movement in ticks
+ */
+static void ODO_Integrate(int32_t deltaL, int32_t deltaR) {
+  int32_t sum;
+  ODO_Angle dAngle, midAngle;
+
+  sum = deltaL+deltaR; /* twice the center movement */
+  dAngle = (ODO_Angle)((deltaR-deltaL)*ODO_state.angleFactor); /* wraps around as intended */
+  midAngle = ODO_state.heading+(ODO_Angle)((int32_t)dAngle/2); /* use the heading in the middle of the arc */
+  ODO_state.x += (int64_t)sum*ODO_Cos(midAngle);
+  ODO_state.y += (int64_t)sum*ODO_Sin(midAngle);
+  ODO_state.heading += dAngle;
+  ODO_state.dist += sum;
+}
+
+static int32_t HalfTicksToUm(int64_t halfTicks) {
+  if (ODO_calib.ticksPerM<=0) {
+    return 0;
+  }
+  return (int32_t)((halfTicks*1000000LL)/(2*(int64_t)ODO_calib.ticksPerM));
+}
+
+static void ODO_Publish(void) {
+  ODO_poseSeq++; /* odd: writing */
+  ODO_MEMORY_BARRIER();
+  ODO_pose.xUm = HalfTicksToUm(ODO_state.x/ODO_TRIG_ONE);
+  ODO_pose.yUm = HalfTicksToUm(ODO_state.y/ODO_TRIG_ONE);
+  ODO_pose.heading = ODO_state.heading;
+  ODO_pose.distUm = HalfTicksToUm(ODO_state.dist);
+  ODO_MEMORY_BARRIER();
+  ODO_poseSeq++; /* even: done */
+}
+
+void ODO_GetPose(ODO_Pose *pose) {
+  uint32_t seq;
+
+  do {
+    seq = ODO_poseSeq;
+    ODO_MEMORY_BARRIER();
+    *pose = ODO_pose; /* struct copy */
+    ODO_MEMORY_BARRIER();
+  } while ((seq&1)!=0 || seq!=ODO_poseSeq); /* retry if the writer was active */
+}
+
+int32_t ODO_GetDistanceUm(void) {
+  return ODO_pose.distUm; /* single 32bit value, atomic read */
+}
+
+int32_t ODO_AngleToCentiDeg(ODO_Angle angle) {
+  return (int32_t)(((int64_t)(int32_t)angle*36000)>>32);
+}
+
+int32_t ODO_TicksToUm(int32_t ticks) {
+  return HalfTicksToUm(2*(int64_t)ticks);
+}
+
+int32_t ODO_UmToTicks(int32_t um) {
+  return (int32_t)(((int64_t)um*ODO_calib.ticksPerM)/1000000LL);
+}
+
+int32_t ODO_GetWheelBaseUm(void) {
+  return ODO_calib.wheelBaseUm;
+}
+
+void ODO_ResetPose(void) {
+  ODO_resetRequest = TRUE;
+}
+
+void ODO_Update(void) {
+  int32_t posL, posR;
+
+  posL = (int32_t)Q4CLeft_GetPos();
+  posR = (int32_t)Q4CRight_GetPos();
+  if (ODO_calibChanged) {
+    ODO_calibChanged = FALSE;
+    ODO_CalcFactors();
+  }
+  if (ODO_resetRequest) {
+    ODO_resetRequest = FALSE;
+    ODO_state.x = 0;
+    ODO_state.y = 0;
+    ODO_state.heading = 0;
+    ODO_state.dist = 0;
+  } else {
+    ODO_Integrate(posL-ODO_state.lastL, posR-ODO_state.lastR);
+  }
+  ODO_state.lastL = posL;
+  ODO_state.lastR = posR;
+  ODO_Publish();
+}
+
+#if PL_CONFIG_HAS_CONFIG_NVM
+static uint8_t ODO_LoadSettingsFromFlash(void) {
+  ODO_Calib_t *ptr;
+
+  ptr = (ODO_Calib_t*)NVMC_GetOdoData();
+  if (ptr==NULL || ptr->ticksPerM<=0 || ptr->wheelBaseUm<=0) {
+    return ERR_FAILED;
+  }
+  ODO_calib = *ptr; /* copy data from FLASH to RAM */
+  ODO_calibChanged = TRUE;
+  return ERR_OK;
+}
+
+static uint8_t ODO_StoreSettingsToFlash(void) {
+  return NVMC_SaveOdoData(&ODO_calib, sizeof(ODO_calib));
+}
+#endif
+
+#if PL_CONFIG_HAS_SHELL
+static void ODO_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"odo", (unsigned char*)"Group of odometry commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows odometry help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Reset pose to zero\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  ticks <ticks>", (unsigned char*)"Set number of encoder ticks per meter\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  wheelbase <um>", (unsigned char*)"Set wheel base in micrometers\r\n", io->stdOut);
+#if PL_CONFIG_HAS_CONFIG_NVM
+  CLS1_SendHelpStr((unsigned char*)"  store", (unsigned char*)"Store odometry calibration in FLASH\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  load", (unsigned char*)"Load odometry calibration from FLASH\r\n", io->stdOut);
+#endif
+}
+
+static void ODO_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[32];
+  ODO_Pose pose;
+
+  ODO_GetPose(&pose);
+  CLS1_SendStatusStr((unsigned char*)"odo", (unsigned char*)"\r\n", io->stdOut);
+
+  buf[0] = '\0';
+  UTIL1_strcatNum32sDotValue(buf, sizeof(buf), pose.xUm/100, 10); /* 0.1 mm resolution */
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  x", buf, io->stdOut);
+
+  buf[0] = '\0';
+  UTIL1_strcatNum32sDotValue(buf, sizeof(buf), pose.yUm/100, 10);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  y", buf, io->stdOut);
+
+  buf[0] = '\0';
+  UTIL1_strcatNum32sDotValue100(buf, sizeof(buf), ODO_AngleToCentiDeg(pose.heading));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" deg\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  heading", buf, io->stdOut);
+
+  buf[0] = '\0';
+  UTIL1_strcatNum32sDotValue(buf, sizeof(buf), pose.distUm/100, 10);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  distance", buf, io->stdOut);
+
+  UTIL1_Num32sToStr(buf, sizeof(buf), ODO_calib.ticksPerM);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ticks/m\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  ticks", buf, io->stdOut);
+
+  UTIL1_Num32sToStr(buf, sizeof(buf), ODO_calib.wheelBaseUm);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" um\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  wheelbase", buf, io->stdOut);
+}
+
+uint8_t ODO_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+  const unsigned char *p;
+  int32_t val;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"odo help")==0) {
+    ODO_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"odo status")==0) {
+    ODO_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"odo reset")==0) {
+    ODO_ResetPose();
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"odo ticks ", sizeof("odo ticks ")-1)==0) {
+    p = cmd+sizeof("odo ticks");
+    if (UTIL1_xatoi(&p, &val)==ERR_OK && val>0) {
+      ODO_calib.ticksPerM = val;
+      ODO_calibChanged = TRUE;
+      *handled = TRUE;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"odo wheelbase ", sizeof("odo wheelbase ")-1)==0) {
+    p = cmd+sizeof("odo wheelbase");
+    if (UTIL1_xatoi(&p, &val)==ERR_OK && val>0) {
+      ODO_calib.wheelBaseUm = val;
+      ODO_calibChanged = TRUE;
+      *handled = TRUE;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+#if PL_CONFIG_HAS_CONFIG_NVM
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"odo store")==0) {
+    *handled = TRUE;
+    res = ODO_StoreSettingsToFlash();
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"Storing to FLASH failed!\r\n", io->stdErr);
+    }
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"odo load")==0) {
+    *handled = TRUE;
+    res = ODO_LoadSettingsFromFlash();
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"Loading from FLASH failed!\r\n", io->stdErr);
+    }
+#endif
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void ODO_Deinit(void) {
+  /* nothing needed */
+}
+
+void ODO_Init(void) {
+  ODO_calib.ticksPerM = ODO_DEFAULT_TICKS_PER_M;
+  ODO_calib.wheelBaseUm = ODO_DEFAULT_WHEEL_BASE_UM;
+#if PL_CONFIG_HAS_CONFIG_NVM
+  (void)ODO_LoadSettingsFromFlash(); /* use stored calibration if available */
+#endif
+  ODO_CalcFactors();
+  ODO_calibChanged = FALSE;
+  ODO_state.x = 0;
+  ODO_state.y = 0;
+  ODO_state.heading = 0;
+  ODO_state.dist = 0;
+  ODO_state.lastL = (int32_t)Q4CLeft_GetPos();
+  ODO_state.lastR = (int32_t)Q4CRight_GetPos();
+  ODO_resetRequest = FALSE;
+  ODO_Publish();
+}
+
+#endif /* PL_CONFIG_HAS_ODOMETRY */
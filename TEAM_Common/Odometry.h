@@ -0,0 +1,95 @@
+/**
+ * \file
+ * \brief Odometry interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module estimates the robot pose (x, y, heading) from the wheel encoders.
+ */
+
+#ifndef ODOMETRY_H_
+#define ODOMETRY_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_ODOMETRY
+
+typedef uint32_t ODO_Angle; /*!< binary angle: 2^32 is a full turn, positive is counter-clockwise */
+
+#define ODO_ANGLE_90   ((ODO_Angle)0x40000000u) /*!< 90 degree as binary angle */
+#define ODO_ANGLE_180  ((ODO_Angle)0x80000000u) /*!< 180 degree as binary angle */
+
+typedef struct {
+  int32_t xUm;       /*!< x position in micrometers, x axis is the robot heading at reset */
+  int32_t yUm;       /*!< y position in micrometers, positive is to the left */
+  ODO_Angle heading; /*!< heading as binary angle, counter-clockwise */
+  int32_t distUm;    /*!< driven distance of the robot center in micrometers, negative if driving backward */
+} ODO_Pose;
+
+/*!
+ * \brief Returns the current pose. This is lock-free and can be called from any task.
+ * \param pose Where to store the pose
+ */
+void ODO_GetPose(ODO_Pose *pose);
+
+/*!
+ * \brief Returns the driven distance of the robot center. This is lock-free and can be called from any task.
+ * \return Distance in micrometers, negative if driving backward
+ */
+int32_t ODO_GetDistanceUm(void);
+
+/*!
+ * \brief Converts a binary angle into centi-degree.
+ * \param angle Binary angle
+ * \return Angle in centi-degree, in the range -18000..+17999
+ */
+int32_t ODO_AngleToCentiDeg(ODO_Angle angle);
+
+/*!
+ * \brief Converts encoder ticks into micrometers, using the current calibration.
+ * \param ticks Number of encoder ticks
+ * \return Distance in micrometers
+ */
+int32_t ODO_TicksToUm(int32_t ticks);
+
+/*!
+ * \brief Converts micrometers into encoder ticks, using the current calibration.
+ * \param um Distance in micrometers
+ * \return Number of encoder ticks
+ */
+int32_t ODO_UmToTicks(int32_t um);
+
+/*!
+ * \brief Returns the wheel base (distance between the wheels) used by the odometry.
+ * \return Wheel base in micrometers
+ */
+int32_t ODO_GetWheelBaseUm(void);
+
+/*!
+ * \brief Requests a reset of the pose to zero. The reset is performed with the next update.
+ */
+void ODO_ResetPose(void);
+
+/*!
+ * \brief Integrates the wheel movement since the last call into the pose. Needs to be called periodically from a single task.
+ */
+void ODO_Update(void);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Shell command line parser.
+ * \param[in] cmd Pointer to command string
+ * \param[out] handled If command is handled by the parser
+ * \param[in] io Std I/O handler of shell
+ */
+uint8_t ODO_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief Module de-initialization */
+void ODO_Deinit(void);
+
+/*! \brief Module initialization */
+void ODO_Init(void);
+
+#endif /* PL_CONFIG_HAS_ODOMETRY */
+
+#endif /* ODOMETRY_H_ */
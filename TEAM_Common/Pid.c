@@ -90,9 +90,7 @@ static void PID_SpeedCfg(int32_t currSpeed, int32_t setSpeed, bool isLeft, PID_C
   } else {
     motHandle = MOT_GetMotorHandle(MOT_MOTOR_RIGHT);
   }
-  MOT_SetVal(motHandle, 0xFFFF-speed); /* PWM is low active */
-  MOT_SetDirection(motHandle, direction);
-  MOT_UpdatePercent(motHandle, direction);
+  MOT_StageVal(motHandle, 0xFFFF-speed, direction); /* PWM is low active, applied with MOT_CommitStaged() */
 }
 
 static int32_t Limit(int32_t val, int32_t minVal, int32_t maxVal) {
@@ -120,7 +118,7 @@ static uint8_t errorWithinPercent(int32_t error) {
   return error/(REF_MAX_LINE_VALUE/2/100);
 }
 
-static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config) {
+static void PID_LineCfg(uint16_t currLine, uint16_t setLine, uint8_t speedPercent, PID_Config *config) {
   int32_t pid, speed, speedL, speedR;
   uint8_t errorPercent;
   MOT_Direction directionL=MOT_DIR_FORWARD, directionR=MOT_DIR_FORWARD;
@@ -130,7 +128,7 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
 
   /* transform into different speed for motors. The PID is used as difference value to the motor PWM */
   if (errorPercent <= 20) { /* pretty on center: move forward both motors with base speed */
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100); /* 100% */
+    speed = ((int32_t)speedPercent)*(0xffff/100); /* 100% */
     pid = Limit(pid, -speed, speed);
     if (pid<0) { /* turn right */
       speedR = speed;
@@ -141,7 +139,7 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
     }
   } else if (errorPercent <= 40) {
     /* outside left/right halve position from center, slow down one motor and speed up the other */
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100)*8/10; /* 80% */
+    speed = ((int32_t)speedPercent)*(0xffff/100)*8/10; /* 80% */
     pid = Limit(pid, -speed, speed);
     if (pid<0) { /* turn right */
       speedR = speed+pid; /* decrease speed */
@@ -151,7 +149,7 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
       speedL = speed-pid; /* decrease speed */
     }
   } else if (errorPercent <= 70) {
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100)*6/10; /* %60 */
+    speed = ((int32_t)speedPercent)*(0xffff/100)*6/10; /* %60 */
     pid = Limit(pid, -speed, speed);
     if (pid<0) { /* turn right */
       speedR = 0 /*maxSpeed+pid*/; /* decrease speed */
@@ -162,7 +160,7 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
     }
   } else  {
     /* line is far to the left or right: use backward motor motion */
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100)*10/10; /* %80 */
+    speed = ((int32_t)speedPercent)*(0xffff/100)*10/10; /* %80 */
     if (pid<0) { /* turn right */
       speedR = -speed+pid; /* decrease speed */
       speedL = speed-pid; /* increase speed */
@@ -187,14 +185,17 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
     speedR = 0;
   }
   /* send new speed values to motor */
-  MOT_SetVal(MOT_GetMotorHandle(MOT_MOTOR_LEFT), 0xFFFF-speedL); /* PWM is low active */
-  MOT_SetDirection(MOT_GetMotorHandle(MOT_MOTOR_LEFT), directionL);
-  MOT_SetVal(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), 0xFFFF-speedR); /* PWM is low active */
-  MOT_SetDirection(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), directionR);
+  MOT_StageVal(MOT_GetMotorHandle(MOT_MOTOR_LEFT), 0xFFFF-speedL, directionL); /* PWM is low active */
+  MOT_StageVal(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), 0xFFFF-speedR, directionR); /* PWM is low active */
+  MOT_CommitStaged(); /* apply both motors in the same PWM period */
 }
 
 void PID_Line(uint16_t currLine, uint16_t setLine) {
-  PID_LineCfg(currLine, setLine, &config.lineFwConfig);
+  PID_LineCfg(currLine, setLine, config.lineFwConfig.maxSpeedPercent, &config.lineFwConfig);
+}
+
+void PID_LineSpeed(uint16_t currLine, uint16_t setLine, uint8_t speedPercent) {
+  PID_LineCfg(currLine, setLine, speedPercent, &config.lineFwConfig);
 }
 
 void PID_Speed(int32_t currSpeed, int32_t setSpeed, bool isLeft) {
@@ -243,9 +244,7 @@ static void PID_PosCfg(int32_t currPos, int32_t setPos, bool isLeft, PID_Config
   } else {
     motHandle = MOT_GetMotorHandle(MOT_MOTOR_RIGHT);
   }
-  MOT_SetVal(motHandle, 0xFFFF-speed); /* PWM is low active */
-  MOT_SetDirection(motHandle, direction);
-  MOT_UpdatePercent(motHandle, direction);
+  MOT_StageVal(motHandle, 0xFFFF-speed, direction); /* PWM is low active, applied with MOT_CommitStaged() */
 }
 
 void PID_Pos(int32_t currPos, int32_t setPos, bool isLeft) {
@@ -65,6 +65,14 @@ void PID_Pos(int32_t currPos, int32_t setPos, bool isLeft);
  */
 void PID_Line(uint16_t currLine, uint16_t setLine);
 
+/*!
+ * \brief Same as PID_Line(), but with a speed which overrides the configured maximum speed.
+ * \param currLine Current line position
+ * \param setLine Desired line position
+ * \param speedPercent Speed in percent
+ */
+void PID_LineSpeed(uint16_t currLine, uint16_t setLine, uint8_t speedPercent);
+
 /*! \brief Driver re-init and reset */
 void PID_Start(void);
 
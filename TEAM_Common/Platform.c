@@ -54,9 +54,18 @@
 #if PL_CONFIG_HAS_DRIVE
   #include "Drive.h"
 #endif
+#if PL_CONFIG_HAS_ODOMETRY
+  #include "Odometry.h"
+#endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   #include "LineFollow.h"
 #endif
+#if PL_CONFIG_HAS_LINE_SPEED
+  #include "LineSpeed.h"
+#endif
+#if PL_CONFIG_HAS_LAP_TIMING
+  #include "LapTime.h"
+#endif
 #if PL_CONFIG_HAS_RADIO
   #include "RNet_App.h"
 #endif
@@ -72,6 +81,9 @@
 #if PL_CONFIG_HAS_LINE_MAZE
   #include "Maze.h"
 #endif
+#if PL_CONFIG_HAS_WALL_MAZE
+  #include "WallMaze.h"
+#endif
 #if PL_CONFIG_HAS_LCD
   #include "LCD.h"
 #endif
@@ -137,9 +149,18 @@ void PL_Init(void) {
 #if PL_CONFIG_HAS_DRIVE
   DRV_Init();
 #endif
+#if PL_CONFIG_HAS_ODOMETRY
+  ODO_Init();
+#endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   LF_Init();
 #endif
+#if PL_CONFIG_HAS_LINE_SPEED
+  LSPD_Init();
+#endif
+#if PL_CONFIG_HAS_LAP_TIMING
+  LAPT_Init();
+#endif
 #if PL_CONFIG_HAS_RADIO
   RNETA_Init();
 #endif
@@ -167,6 +188,9 @@ void PL_Init(void) {
 #if PL_HAS_DISTANCE_SENSOR
   DIST_Init();
 #endif
+#if PL_CONFIG_HAS_WALL_MAZE
+  WMAZE_Init();
+#endif
 #if PL_CONFIG_HAS_SUMO
   SUMO_Init();
 #endif
@@ -176,6 +200,9 @@ void PL_Deinit(void) {
 #if PL_CONFIG_HAS_SUMO
   SUMO_Deinit();
 #endif
+#if PL_CONFIG_HAS_WALL_MAZE
+  WMAZE_Deinit();
+#endif
 #if PL_HAS_DISTANCE_SENSOR
   DIST_Deinit();
 #endif
@@ -203,9 +230,18 @@ void PL_Deinit(void) {
 #if PL_CONFIG_HAS_RADIO
   RNETA_Deinit();
 #endif
+#if PL_CONFIG_HAS_LAP_TIMING
+  LAPT_Deinit();
+#endif
+#if PL_CONFIG_HAS_LINE_SPEED
+  LSPD_Deinit();
+#endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   LF_Deinit();
 #endif
+#if PL_CONFIG_HAS_ODOMETRY
+  ODO_Deinit();
+#endif
 #if PL_CONFIG_HAS_DRIVE
   DRV_Deinit();
 #endif
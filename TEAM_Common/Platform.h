@@ -90,14 +90,20 @@
 #define PL_CONFIG_HAS_QUAD_CALIBRATION  (1 && !defined(PL_LOCAL_CONFIG_HAS_QUAD_CALIBRATION_DISABLED) && PL_CONFIG_HAS_MCP4728)
 #define PL_CONFIG_HAS_PID               (1 && !defined(PL_LOCAL_CONFIG_HAS_PID_DISABLED) && PL_CONFIG_HAS_QUADRATURE)
 #define PL_CONFIG_HAS_DRIVE             (1 && !defined(PL_LOCAL_CONFIG_HAS_DRIVE_DISABLED) && PL_CONFIG_HAS_PID)
+#define PL_CONFIG_HAS_ODOMETRY          (1 && !defined(PL_LOCAL_CONFIG_HAS_ODOMETRY_DISABLED) && PL_CONFIG_HAS_DRIVE)
 #define PL_CONFIG_HAS_REFLECTANCE       (1 && !defined(PL_LOCAL_CONFIG_HAS_REFLECTANCE_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
 #define PL_CONFIG_HAS_LINE_FOLLOW       (1 && !defined(PL_LOCAL_CONFIG_HAS_LINE_FOLLOW_DISABLED)/* && PL_CONFIG_HAS_DRIVE*/)
 #define PL_CONFIG_HAS_TURN              (1 && !defined(PL_LOCAL_CONFIG_HAS_TURN_DISABLED) && PL_CONFIG_HAS_QUADRATURE)
+#define PL_CONFIG_HAS_LINE_SPEED        (1 && !defined(PL_LOCAL_CONFIG_HAS_LINE_SPEED_DISABLED) && PL_CONFIG_HAS_LINE_FOLLOW && PL_CONFIG_HAS_ODOMETRY && PL_CONFIG_HAS_PID) /* adapt line following speed to the curvature */
+#define PL_CONFIG_HAS_LINE_RECOVERY     (1 && !defined(PL_LOCAL_CONFIG_HAS_LINE_RECOVERY_DISABLED) && PL_CONFIG_HAS_LINE_FOLLOW && PL_CONFIG_HAS_ODOMETRY) /* search the line after a short line loss */
+#define PL_CONFIG_HAS_LAP_TIMING        (1 && !defined(PL_LOCAL_CONFIG_HAS_LAP_TIMING_DISABLED) && PL_CONFIG_HAS_LINE_FOLLOW) /* timestamps of the line following events */
 #define PL_CONFIG_HAS_LINE_MAZE         (1 && !defined(PL_LOCAL_CONFIG_HAS_LINE_MAZE_DISABLED) && PL_CONFIG_HAS_LINE_FOLLOW)
+#define PL_CONFIG_HAS_MAZE_GRAPH        (1 && !defined(PL_LOCAL_CONFIG_HAS_MAZE_GRAPH_DISABLED) && PL_CONFIG_HAS_LINE_MAZE && PL_CONFIG_HAS_ODOMETRY) /* map of junctions and segments for the fastest route */
 #define PL_HAS_DISTANCE_SENSOR          (1 && !defined(PL_LOCAL_CONFIG_HAS_DISTANCE_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
 #define PL_HAS_TOF_SENSOR               (1 && !defined(PL_LOCAL_CONFIG_HAS_TOF_SENSOR_DISABLED) && PL_HAS_DISTANCE_SENSOR)
 #define PL_HAS_SIDE_DISTANCE            (0)
 #define PL_HAS_FRONT_DISTANCE           (0)
+#define PL_CONFIG_HAS_WALL_MAZE         (1 && !defined(PL_LOCAL_CONFIG_HAS_WALL_MAZE_DISABLED) && PL_HAS_TOF_SENSOR && PL_CONFIG_HAS_TURN && PL_CONFIG_HAS_ODOMETRY) /* flood fill wall maze with the ToF sensors */
 
 #define PL_CONFIG_HAS_BATTERY_ADC       (1 && !defined(PL_LOCAL_CONFIG_HAS_BATTERY_ADC_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
 
@@ -40,6 +40,14 @@ typedef enum {
 
 static RNETA_State appState = RNETA_NONE;
 
+#define RNETA_SIGNAL_QUEUE_LENGTH  8 /* signals waiting to be sent by the radio task */
+static xQueueHandle RNETA_SignalQueue;
+
+typedef struct {
+  uint8_t signal; /* RAPP_MSG_TYPE_LAP_POINT signal */
+  uint32_t ms;    /* time of the signal in ms, sent after the signal */
+} RNETA_QueuedSignal;
+
 RNWK_ShortAddrType RNETA_GetDestAddr(void) {
   return APP_dstAddr;
 }
@@ -52,6 +60,17 @@ void RNETA_SendSignal(uint8_t signal) {
   (void)RAPP_SendPayloadDataBlock(data, sizeof(data), RAPP_MSG_TYPE_LAP_POINT, APP_RNET_ADDR_TIME_SYSTEM, RPHY_PACKET_FLAGS_NONE);
 }
 
+uint8_t RNETA_QueueSignal(uint8_t signal, uint32_t ms) {
+  RNETA_QueuedSignal item;
+
+  item.signal = signal;
+  item.ms = ms;
+  if (FRTOS1_xQueueSendToBack(RNETA_SignalQueue, &item, 0)!=pdPASS) {
+    return ERR_BUSY; /* queue full */
+  }
+  return ERR_OK;
+}
+
 uint8_t RNETA_SendIdValuePairMessage(uint8_t msgType, uint16_t id, uint32_t value, RAPP_ShortAddrType addr, RAPP_FlagsType flags) {
   uint8_t dataBuf[6]; /* 2 byte ID followed by 4 byte data */
 
@@ -203,6 +222,8 @@ static void RadioPowerUp(void) {
 }
 
 static void Process(void) {
+  RNETA_QueuedSignal item;
+
   for(;;) {
     switch(appState) {
     case RNETA_NONE:
@@ -215,6 +236,10 @@ static void Process(void) {
       break;
       
     case RNETA_TX_RX:
+      while(FRTOS1_xQueueReceive(RNETA_SignalQueue, &item, 0)==pdPASS) { /* signals from other tasks */
+        RNETA_SendSignal(item.signal); /* the timing node measures its own time with the signal */
+        (void)RNETA_SendIdValuePairMessage(RAPP_MSG_TYPE_NOTIFY_VALUE, RAPP_MSG_TYPE_DATA_ID_LAP_TIME|item.signal, item.ms, APP_RNET_ADDR_TIME_SYSTEM, RPHY_PACKET_FLAGS_NONE);
+      }
       (void)RNET1_Process();
       break;
   
@@ -252,6 +277,7 @@ static void RadioTask(void *pvParameters) {
 
 void RNETA_Deinit(void) {
   RNET1_Deinit();
+  FRTOS1_vQueueDelete(RNETA_SignalQueue);
 }
 
 void RNETA_Init(void) {
@@ -260,6 +286,11 @@ void RNETA_Init(void) {
     //APP_DebugPrint((unsigned char*)"ERR: failed setting message handler!\r\n");
     for(;;) {} /* error */
   }
+  RNETA_SignalQueue = FRTOS1_xQueueCreate(RNETA_SIGNAL_QUEUE_LENGTH, sizeof(RNETA_QueuedSignal));
+  if (RNETA_SignalQueue==NULL) {
+    for(;;){} /* out of memory? */
+  }
+  FRTOS1_vQueueAddToRegistry(RNETA_SignalQueue, "RadioSignal");
   if (xTaskCreate(
         RadioTask,  /* pointer to the task */
         "Radio", /* task name for kernel awareness debugging */
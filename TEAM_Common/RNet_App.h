@@ -43,6 +43,15 @@ RNWK_ShortAddrType RNETA_GetDestAddr(void);
 /*! \breif send a special signal to the other system */
 void RNETA_SendSignal(uint8_t signal);
 
+/*!
+ * \brief Queues a signal for the timing system. It is sent by the radio task, so it can be used from time critical tasks.
+ * The radio task sends the signal with RNETA_SendSignal(), followed by a RAPP_MSG_TYPE_NOTIFY_VALUE message with the ID RAPP_MSG_TYPE_DATA_ID_LAP_TIME|signal and the time.
+ * \param signal Signal, same as for RNETA_SendSignal()
+ * \param ms Time of the signal in milliseconds
+ * \return Error code, ERR_OK if everything is fine, ERR_BUSY if the queue is full
+ */
+uint8_t RNETA_QueueSignal(uint8_t signal, uint32_t ms);
+
 /*! \brief Driver de-initialization */
 void RNETA_Deinit(void);
 
@@ -36,6 +36,7 @@ typedef enum {
   RAPP_MSG_TYPE_DATA_ID_BATTERY_V = 7,      /* Battery voltage */
   RAPP_MSG_TYPE_DATA_ID_PID_FW_SPEED = 8,   /* PID forward speed */
   RAPP_MSG_TYPE_DATA_ID_START_STOP = 9,     /* start/stop robot */
+  RAPP_MSG_TYPE_DATA_ID_LAP_TIME = 0x100,   /* lap timing: the low byte is the RAPP_MSG_TYPE_LAP_POINT signal, the value the time since the start in ms */
   /*! \todo extend as needed */
 } RAPP_MSG_DateIDType;
 
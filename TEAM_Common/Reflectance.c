@@ -20,6 +20,7 @@
 #include "IR6.h"
 #include "UTIL1.h"
 #include "FRTOS1.h"
+#include "KIN1.h" /* cycle counter for the frame timestamps */
 #include "Application.h"
 #include "Event.h"
 #include "Shell.h"
@@ -72,6 +73,11 @@ static int16_t refCenterLineVal=0; /* 0 means no line, >0 means line is below se
 static SensorCalibT SensorCalibMinMax; /* min/max calibration data in SRAM */
 static SensorTimeType SensorRaw[REF_NOF_SENSORS]; /* raw sensor values */
 static SensorTimeType SensorCalibrated[REF_NOF_SENSORS]; /* 0 means white/min value, 1000 means black/max value */
+static uint32_t refCaptureTimestamp; /* cycle counter at the start of the discharge of the frame being measured */
+static REF_Frame refFrame; /* last measured frame, published together with its timestamp */
+
+#define REF_NOF_FRAME_CALLBACKS  2 /* maximum number of frame callbacks */
+static volatile REF_FrameCallback REF_FrameCallbacks[REF_NOF_FRAME_CALLBACKS]; /* called after each measured frame, NULL if not used */
 
 /* Functions as wrapper around macro. */
 static void S1_SetOutput(void) { IR1_SetOutput(); }
@@ -155,6 +161,7 @@ static void REF_MeasureRaw(SensorTimeType raw[REF_NOF_SENSORS]) {
     SensorFctArray[i].SetInput(); /* turn I/O line as input */
   }
   (void)RefCnt_ResetCounter(timerHandle); /* reset timer counter */
+  refCaptureTimestamp = KIN1_GetCycleCounter(); /* the frame is captured now */
   do {
     timerVal = RefCnt_GetCounterValue(timerHandle);
     cnt = 0;
@@ -342,6 +349,17 @@ static void REF_Measure(void) {
 #if 1 || PL_CONFIG_HAS_LINE_FOLLOW
   refLineKind = ReadLineKind(SensorCalibrated);
 #endif
+  taskENTER_CRITICAL(); /* the readers get the line and the timestamp of the same frame */
+  refFrame.lineValue = (uint16_t)refCenterLineVal;
+  refFrame.kind = refLineKind;
+  refFrame.timestamp = refCaptureTimestamp;
+  taskEXIT_CRITICAL();
+}
+
+void REF_GetFrame(REF_Frame *frame) {
+  taskENTER_CRITICAL();
+  *frame = refFrame;
+  taskEXIT_CRITICAL();
 }
 
 static uint8_t PrintHelp(const CLS1_StdIOType *io) {
@@ -490,6 +508,46 @@ byte REF_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOT
   return ERR_OK;
 }
 
+uint8_t REF_AddFrameCallback(REF_FrameCallback cb) {
+  int i;
+  uint8_t res = ERR_OVERFLOW;
+
+  taskENTER_CRITICAL();
+  for(i=0;i<REF_NOF_FRAME_CALLBACKS;i++) {
+    if (REF_FrameCallbacks[i]==NULL) {
+      REF_FrameCallbacks[i] = cb;
+      res = ERR_OK;
+      break;
+    }
+  }
+  taskEXIT_CRITICAL();
+  return res;
+}
+
+void REF_RemoveFrameCallback(REF_FrameCallback cb) {
+  int i;
+
+  taskENTER_CRITICAL();
+  for(i=0;i<REF_NOF_FRAME_CALLBACKS;i++) {
+    if (REF_FrameCallbacks[i]==cb) {
+      REF_FrameCallbacks[i] = NULL;
+    }
+  }
+  taskEXIT_CRITICAL();
+}
+
+static void REF_CallFrameCallbacks(void) {
+  int i;
+  REF_FrameCallback cb;
+
+  for(i=0;i<REF_NOF_FRAME_CALLBACKS;i++) {
+    cb = REF_FrameCallbacks[i];
+    if (cb!=NULL) {
+      cb();
+    }
+  }
+}
+
 static void REF_StateMachine(void) {
   int i;
 
@@ -559,6 +617,7 @@ static void REF_StateMachine(void) {
         
     case REF_STATE_READY:
       REF_Measure();
+      REF_CallFrameCallbacks();
 #if REF_START_STOP_CALIB
       if (FRTOS1_xSemaphoreTake(REF_StartStopSem, 0)==pdTRUE) {
         refState = REF_STATE_START_CALIBRATION;
@@ -572,6 +631,18 @@ bool REF_IsReady(void) {
   return refState==REF_STATE_READY;
 }
 
+uint32_t REF_GetFrameTimestamp(void) {
+  return refFrame.timestamp; /* not the frame being measured: it belongs to REF_GetLineValue() and REF_GetLineKind() */
+}
+
+uint32_t REF_GetTimestamp(void) {
+  return KIN1_GetCycleCounter();
+}
+
+uint32_t REF_TimestampToUs(uint32_t ticks) {
+  return ticks/(configCPU_CLOCK_HZ/1000000);
+}
+
 static void ReflTask (void *pvParameters) {
   (void)pvParameters; /* not used */
   for(;;) {
@@ -584,6 +655,8 @@ void REF_Deinit(void) {
 }
 
 void REF_Init(void) {
+  int i;
+
 #if REF_START_STOP_CALIB
   vSemaphoreCreateBinary(REF_StartStopSem);
   if (REF_StartStopSem==NULL) { /* semaphore creation failed */
@@ -593,8 +666,14 @@ void REF_Init(void) {
   vQueueAddToRegistry(REF_StartStopSem, "RefStartStopSem");
 #endif
 
+  for(i=0;i<REF_NOF_FRAME_CALLBACKS;i++) {
+    REF_FrameCallbacks[i] = NULL;
+  }
   refState = REF_STATE_INIT;
   timerHandle = RefCnt_Init(NULL);
+  KIN1_InitCycleCounter(); /* time base for the frame timestamps */
+  KIN1_ResetCycleCounter();
+  KIN1_EnableCycleCounter();
   /*! \todo You might need to adjust priority or other task settings */
   if (xTaskCreate(ReflTask, "Refl", 600/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+1, NULL) != pdPASS) {
     for(;;){} /* error */
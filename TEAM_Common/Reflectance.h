@@ -25,8 +25,20 @@ typedef enum {
   REF_NOF_LINES        /* Sentinel */
 } REF_LineKind;
 
+typedef struct {
+  uint16_t lineValue;  /*!< line value, same as REF_GetLineValue() */
+  REF_LineKind kind;   /*!< line kind, same as REF_GetLineKind() */
+  uint32_t timestamp;  /*!< capture time, same as REF_GetFrameTimestamp() */
+} REF_Frame;
+
 REF_LineKind REF_GetLineKind(void);
 
+/*!
+ * \brief Returns the line value, the line kind and the capture time of the last measured frame. All three belong to the same frame.
+ * \param[out] frame Frame data
+ */
+void REF_GetFrame(REF_Frame *frame);
+
 void REF_GetSensorValues(uint16_t *values, int nofValues);
 
 #if PL_CONFIG_HAS_SHELL
@@ -62,6 +74,42 @@ uint16_t REF_GetLineValue(void);
  */
 bool REF_IsReady(void);
 
+/*! \brief Callback type, called from the reflectance task after each measured frame */
+typedef void (*REF_FrameCallback)(void);
+
+/*!
+ * \brief Adds a callback which is called after every measured sensor frame, with REF_GetLineKind() and REF_GetLineValue() already updated.
+ * The callback runs in the context of the reflectance task and shall not block.
+ * \param cb Callback to add
+ * \return Error code, ERR_OK if everything was ok, ERR_OVERFLOW if there are too many callbacks
+ */
+uint8_t REF_AddFrameCallback(REF_FrameCallback cb);
+
+/*!
+ * \brief Removes a callback added with REF_AddFrameCallback().
+ * \param cb Callback to remove
+ */
+void REF_RemoveFrameCallback(REF_FrameCallback cb);
+
+/*!
+ * \brief Returns when the last frame has been captured, which is the start of the sensor discharge.
+ * \return Timestamp in CPU cycles, same time base as REF_GetTimestamp()
+ */
+uint32_t REF_GetFrameTimestamp(void);
+
+/*!
+ * \brief Returns the current time for comparison with frame timestamps. The difference of two timestamps is valid across the wrap around.
+ * \return Timestamp in CPU cycles
+ */
+uint32_t REF_GetTimestamp(void);
+
+/*!
+ * \brief Converts the difference of two timestamps into microseconds.
+ * \param ticks Difference of two timestamps
+ * \return Time in microseconds
+ */
+uint32_t REF_TimestampToUs(uint32_t ticks);
+
 /*!
  * \brief Driver Deinitialization.
  */
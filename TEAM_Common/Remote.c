@@ -163,18 +163,36 @@ static void RemoteTask (void *pvParameters) {
 static void REMOTE_HandleMotorMsg(int16_t speedVal, int16_t directionVal, int16_t z) {
   #define SCALE_DOWN 30
   #define MIN_VALUE  250 /* values below this value are ignored */
-  #define DRIVE_DOWN 1
+#if PL_CONFIG_HAS_DRIVE
+  #define REMOTE_TWIST_MAX_OMEGA  3000 /* angular speed in milli-radians/sec for full direction value */
+  int32_t v, omega;
+#endif
 
   if (!REMOTE_isOn) {
     return;
   }
-  if (z<-900) { /* have a way to stop motor: turn FRDM USB port side up or down */
 #if PL_CONFIG_HAS_DRIVE
-    DRV_SetSpeed(0, 0);
+  if (z<-900) { /* have a way to stop motor: turn FRDM USB port side up or down */
+    v = 0;
+    omega = 0;
+  } else {
+    v = 0;
+    omega = 0;
+    if (speedVal>100 || speedVal<-100) { /* speed */
+      v = speedVal;
+    }
+    if (directionVal>100 || directionVal<-100) { /* direction: positive is turning right, which is clockwise */
+      omega = -((int32_t)directionVal*REMOTE_TWIST_MAX_OMEGA)/1000;
+    }
+  }
+  (void)DRV_SetTwist(v, omega); /* kinematics and acceleration limits are handled by the drive */
+  if (DRV_GetMode()!=DRV_MODE_TWIST) {
+    (void)DRV_SetMode(DRV_MODE_TWIST);
+  }
 #else
+  if (z<-900) { /* have a way to stop motor: turn FRDM USB port side up or down */
     MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_LEFT), 0);
     MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), 0);
-#endif
   } else if ((directionVal>MIN_VALUE || directionVal<-MIN_VALUE) && (speedVal>MIN_VALUE || speedVal<-MIN_VALUE)) {
     int16_t speed, speedL, speedR;
     
@@ -194,34 +212,19 @@ static void REMOTE_HandleMotorMsg(int16_t speedVal, int16_t directionVal, int16_
         speedL = speed+(directionVal/SCALE_DOWN);
       }
     }
-#if PL_CONFIG_HAS_DRIVE
-    DRV_SetSpeed(speedL*SCALE_DOWN/DRIVE_DOWN, speedR*SCALE_DOWN/DRIVE_DOWN);
-#else
     MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_LEFT), speedL);
     MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), speedR);
-#endif
   } else if (speedVal>100 || speedVal<-100) { /* speed */
-#if PL_CONFIG_HAS_DRIVE
-    DRV_SetSpeed(speedVal, speedVal);
-#else
     MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_LEFT), -speedVal/SCALE_DOWN);
     MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), -speedVal/SCALE_DOWN);
-#endif
   } else if (directionVal>100 || directionVal<-100) { /* direction */
-#if PL_CONFIG_HAS_DRIVE
-    DRV_SetSpeed(directionVal/DRIVE_DOWN, -directionVal/DRIVE_DOWN);
-#else
     MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_LEFT), -directionVal/SCALE_DOWN);
-    MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), (directionVAl/SCALE_DOWN));
-#endif
+    MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), (directionVal/SCALE_DOWN));
   } else { /* device flat on the table? */
-#if PL_CONFIG_HAS_DRIVE
-    DRV_SetSpeed(0, 0);
-#else
     MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_LEFT), 0);
     MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), 0);
-#endif
   }
+#endif
 }
 #endif
 
@@ -11,6 +11,9 @@
 #include "Shell.h"
 #include "CLS1.h"
 #include "Application.h"
+#if PL_CONFIG_HAS_EVENTS
+  #include "Event.h"
+#endif
 #if PL_CONFIG_HAS_RTOS
   #include "FRTOS1.h"
 #endif
@@ -54,12 +57,21 @@
 #if PL_CONFIG_HAS_DRIVE
   #include "Drive.h"
 #endif
+#if PL_CONFIG_HAS_ODOMETRY
+  #include "Odometry.h"
+#endif
 #if PL_CONFIG_HAS_TURN
   #include "Turn.h"
 #endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   #include "LineFollow.h"
 #endif
+#if PL_CONFIG_HAS_LINE_SPEED
+  #include "LineSpeed.h"
+#endif
+#if PL_CONFIG_HAS_LAP_TIMING
+  #include "LapTime.h"
+#endif
 #if PL_CONFIG_HAS_RADIO
   #include "RApp.h"
   #include "RNet_App.h"
@@ -74,6 +86,9 @@
 #if PL_CONFIG_HAS_LINE_MAZE
   #include "Maze.h"
 #endif
+#if PL_CONFIG_HAS_WALL_MAZE
+  #include "WallMaze.h"
+#endif
 #if PL_CONFIG_HAS_USB_CDC
   #include "CDC1.h"
 #endif
@@ -224,6 +239,9 @@ static const CLS1_ParseCommandCallback CmdParserTable[] =
 #if FRTOS1_PARSE_COMMAND_ENABLED
   FRTOS1_ParseCommand, /* FreeRTOS shell parser */
 #endif
+#if PL_CONFIG_HAS_EVENTS
+  EVNT_ParseCommand,
+#endif
 #if defined(BT1_PARSE_COMMAND_ENABLED) && BT1_PARSE_COMMAND_ENABLED
   BT1_ParseCommand,
 #endif
@@ -266,12 +284,21 @@ static const CLS1_ParseCommandCallback CmdParserTable[] =
 #if PL_CONFIG_HAS_DRIVE
   DRV_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_ODOMETRY
+  ODO_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_TURN
   TURN_ParseCommand,
 #endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   LF_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_LINE_SPEED
+  LSPD_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_LAP_TIMING
+  LAPT_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_RADIO
 #if RNET1_PARSE_COMMAND_ENABLED
   RNET1_ParseCommand,
@@ -290,6 +317,9 @@ static const CLS1_ParseCommandCallback CmdParserTable[] =
 #if PL_HAS_DISTANCE_SENSOR
   DIST_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_WALL_MAZE
+  WMAZE_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_SUMO
   SUMO_ParseCommand,
 #endif
@@ -379,6 +409,9 @@ static void ShellTask(void *pvParameters) {
 #if PL_CONFIG_HAS_RADIO && RNET_CONFIG_REMOTE_STDIO
     RSTDIO_Print(SHELL_GetStdio()); /* dispatch incoming messages */
 #endif
+#if PL_CONFIG_HAS_EVENTS
+    EVNT_PrintLog(ios[0].stdio); /* events logged with 'event log on' */
+#endif
 #if PL_CONFIG_HAS_SHELL_QUEUE && PL_CONFIG_SQUEUE_SINGLE_CHAR
     {
         /*! \todo Handle shell queue */
@@ -64,8 +64,8 @@ static void SumoRun(void) {
         return;
 
       case SUMO_STATE_START_DRIVING:
-        DRV_SetSpeed(1000, 1000);
-        DRV_SetMode(DRV_MODE_SPEED);
+        DRV_SetTwist(1000, 0); /* straight forward, ramped with the drive acceleration limits */
+        DRV_SetMode(DRV_MODE_TWIST);
         sumoState = SUMO_STATE_DRIVING;
         break; /* handle next state */
 
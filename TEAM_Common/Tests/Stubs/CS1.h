@@ -0,0 +1,16 @@
+/**
+ * \file
+ * \brief Host replacement of the critical section component. The tests are single threaded.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef CS1_H_
+#define CS1_H_
+
+#include "PE_Types.h"
+
+#define CS1_CriticalVariable()  uint8_t cpuSR = 0;
+#define CS1_EnterCritical()     do { (void)cpuSR; } while(0)
+#define CS1_ExitCritical()      do { } while(0)
+
+#endif /* CS1_H_ */
@@ -0,0 +1,14 @@
+/**
+ * \file
+ * \brief Host replacement of the CPU component header.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef CPU_H_
+#define CPU_H_
+
+#include "PE_Types.h"
+
+#define PEcfg_RoboV2  1 /* same configuration as the robot */
+
+#endif /* CPU_H_ */
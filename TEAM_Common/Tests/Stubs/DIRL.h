@@ -0,0 +1,14 @@
+/**
+ * \file
+ * \brief Host replacement of the direction pin component, implemented by the test.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef DIRL_H_
+#define DIRL_H_
+
+#include "PE_Types.h"
+
+void DIRL_PutVal(bool val);
+
+#endif /* DIRL_H_ */
@@ -0,0 +1,14 @@
+/**
+ * \file
+ * \brief Host replacement of the direction pin component, implemented by the test.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef DIRR_H_
+#define DIRR_H_
+
+#include "PE_Types.h"
+
+void DIRR_PutVal(bool val);
+
+#endif /* DIRR_H_ */
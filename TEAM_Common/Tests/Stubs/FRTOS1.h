@@ -0,0 +1,24 @@
+/**
+ * \file
+ * \brief Host replacement of the FreeRTOS component. The tick count and the queue are implemented by the test.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef FRTOS1_H_
+#define FRTOS1_H_
+
+#include "PE_Types.h"
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef void *xQueueHandle;
+
+#define portTICK_PERIOD_MS  1
+#define pdPASS              1
+#define pdFAIL              0
+
+TickType_t FRTOS1_xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+BaseType_t FRTOS1_xQueueSendToBack(xQueueHandle queue, const void *item, TickType_t ticksToWait);
+
+#endif /* FRTOS1_H_ */
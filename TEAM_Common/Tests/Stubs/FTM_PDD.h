@@ -0,0 +1,16 @@
+/**
+ * \file
+ * \brief Host replacement of the FTM register access. The tests inject their own timer with MOT_SetPwmTimer().
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef FTM_PDD_H_
+#define FTM_PDD_H_
+
+#include "PE_Types.h"
+
+#define FTM0_BASE_PTR                   NULL
+#define FTM_PDD_ReadCounterReg(base)    0U
+#define FTM_PDD_ReadModuloReg(base)     0U
+
+#endif /* FTM_PDD_H_ */
@@ -0,0 +1,35 @@
+/**
+ * \file
+ * \brief Host replacement of the Processor Expert types.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef PE_TYPES_H_
+#define PE_TYPES_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef unsigned char bool;
+typedef unsigned char byte;
+typedef unsigned short word;
+typedef unsigned long dword;
+
+#ifndef TRUE
+  #define TRUE  1U
+#endif
+#ifndef FALSE
+  #define FALSE 0U
+#endif
+
+/* error codes, same values as in PE_Error.h */
+#define ERR_OK           0x00U
+#define ERR_SPEED        0x01U
+#define ERR_RANGE        0x02U
+#define ERR_VALUE        0x03U
+#define ERR_OVERFLOW     0x04U
+#define ERR_DISABLED     0x07U
+#define ERR_BUSY         0x08U
+#define ERR_FAILED       0x1BU
+
+#endif /* PE_TYPES_H_ */
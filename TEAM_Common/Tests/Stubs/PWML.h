@@ -0,0 +1,15 @@
+/**
+ * \file
+ * \brief Host replacement of the PWM component, implemented by the test.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef PWML_H_
+#define PWML_H_
+
+#include "PE_Types.h"
+
+uint8_t PWML_SetRatio16(uint16_t ratio);
+uint8_t PWML_Enable(void);
+
+#endif /* PWML_H_ */
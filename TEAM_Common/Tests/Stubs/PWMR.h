@@ -0,0 +1,15 @@
+/**
+ * \file
+ * \brief Host replacement of the PWM component, implemented by the test.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef PWMR_H_
+#define PWMR_H_
+
+#include "PE_Types.h"
+
+uint8_t PWMR_SetRatio16(uint16_t ratio);
+uint8_t PWMR_Enable(void);
+
+#endif /* PWMR_H_ */
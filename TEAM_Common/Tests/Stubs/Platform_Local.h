@@ -0,0 +1,40 @@
+/**
+ * \file
+ * \brief Local configuration of the host test build.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Configures the common platform as a robot, without the modules which need the target (shell, NVM, radio, ...).
+ * Only the hardware independent modules get compiled for the host.
+ */
+
+#ifndef SOURCES_PLATFORM_LOCAL_H_
+#define SOURCES_PLATFORM_LOCAL_H_
+
+/* board identification: */
+#define PL_LOCAL_CONFIG_BOARD_IS_ROBO     (1) /* test the robot configuration */
+
+/* platform hardware configuration */
+#define PL_LOCAL_CONFIG_NOF_LEDS          (0)
+#define PL_LOCAL_CONFIG_NOF_KEYS          (0)
+#define PL_LOCAL_CONFIG_KEY_1_ISR         (0)
+#define PL_LOCAL_CONFIG_KEY_2_ISR         (0)
+#define PL_LOCAL_CONFIG_KEY_3_ISR         (0)
+#define PL_LOCAL_CONFIG_KEY_4_ISR         (0)
+#define PL_LOCAL_CONFIG_KEY_5_ISR         (0)
+#define PL_LOCAL_CONFIG_KEY_6_ISR         (0)
+#define PL_LOCAL_CONFIG_KEY_7_ISR         (0)
+
+/* no target I/O on the host */
+#define PL_LOCAL_CONFIG_HAS_SHELL_DISABLED
+#define PL_LOCAL_CONFIG_HAS_SEGGER_RTT_DISABLED
+#define PL_LOCAL_CONFIG_HAS_USB_CDC_DISABLED
+#define PL_LOCAL_CONFIG_HAS_CONFIG_NVM_DISABLED
+#define PL_LOCAL_CONFIG_HAS_RADIO_DISABLED
+#define PL_LOCAL_CONFIG_HAS_REMOTE_DISABLED
+#define PL_LOCAL_CONFIG_HAS_LCD_DISABLED
+#define PL_LOCAL_CONFIG_HAS_BLUETOOTH_DISABLED
+#define PL_LOCAL_CONFIG_HAS_MPC4728_DISABLED
+#define PL_LOCAL_CONFIG_HAS_QUAD_CALIBRATION_DISABLED
+#define PL_LOCAL_CONFIG_HAS_BATTERY_ADC_DISABLED
+
+#endif /* SOURCES_PLATFORM_LOCAL_H_ */
@@ -0,0 +1,18 @@
+/**
+ * \file
+ * \brief Host replacement of the left quadrature counter. The test sets the position.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef Q4CLEFT_H_
+#define Q4CLEFT_H_
+
+#include "PE_Types.h"
+
+typedef uint32_t Q4CLeft_QuadCntrType;
+
+extern Q4CLeft_QuadCntrType Q4CLeft_Pos; /* defined by the test */
+
+#define Q4CLeft_GetPos()  (Q4CLeft_Pos)
+
+#endif /* Q4CLEFT_H_ */
@@ -0,0 +1,18 @@
+/**
+ * \file
+ * \brief Host replacement of the right quadrature counter. The test sets the position.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef Q4CRIGHT_H_
+#define Q4CRIGHT_H_
+
+#include "PE_Types.h"
+
+typedef uint32_t Q4CRight_QuadCntrType;
+
+extern Q4CRight_QuadCntrType Q4CRight_Pos; /* defined by the test */
+
+#define Q4CRight_GetPos()  (Q4CRight_Pos)
+
+#endif /* Q4CRIGHT_H_ */
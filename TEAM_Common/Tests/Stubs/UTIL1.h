@@ -0,0 +1,12 @@
+/**
+ * \file
+ * \brief Host replacement of the utility component header. Only needed by includes, the shell is not part of the host build.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef UTIL1_H_
+#define UTIL1_H_
+
+#include "PE_Types.h"
+
+#endif /* UTIL1_H_ */
@@ -0,0 +1,15 @@
+/**
+ * \file
+ * \brief Host replacement of the wait component.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef WAIT1_H_
+#define WAIT1_H_
+
+#include "PE_Types.h"
+
+#define WAIT1_Waitms(ms)  do { } while(0)
+#define WAIT1_Waitus(us)  do { } while(0)
+
+#endif /* WAIT1_H_ */
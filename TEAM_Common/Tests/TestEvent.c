@@ -0,0 +1,206 @@
+/**
+ * \file
+ * \brief Host test of the event flags and the event queue.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The host build uses the GCC atomic builtins for the event flags (EVNT_ATOMIC_BUILTIN). Threads setting and clearing
+ * their own events in the same memory unit check that no update gets lost. The LDREX/STREX variant and the
+ * "event bench" command only run on the target.
+ * The task queue of the subscribers is a fake which logs the sent events.
+ */
+
+#include "Event.h"
+#include "FRTOS1.h"
+#include "TestUtil.h"
+#include <pthread.h>
+
+#define NOF_THREADS   4
+#define NOF_LOOPS     1000000
+#define QUEUE_LENGTH  4
+
+static TickType_t tickCount;
+static EVNT_Handle handled[2*EVNT_NOF_EVENTS];
+static unsigned nofHandled;
+static EVNT_Msg received[2*QUEUE_LENGTH];
+static unsigned nofReceived;
+static unsigned fakeQueueLength; /* number of items the fake queue accepts */
+static int fakeQueue; /* only the address is used */
+
+TickType_t FRTOS1_xTaskGetTickCount(void) { return tickCount; }
+TickType_t xTaskGetTickCountFromISR(void) { return tickCount; }
+
+BaseType_t FRTOS1_xQueueSendToBack(xQueueHandle queue, const void *item, TickType_t ticksToWait) {
+  if (queue!=&fakeQueue || nofReceived>=fakeQueueLength) {
+    return pdFAIL;
+  }
+  received[nofReceived++] = *(const EVNT_Msg*)item;
+  return pdPASS;
+}
+
+static void Handler(EVNT_Handle event) {
+  handled[nofHandled++] = event;
+}
+
+static void SetAgainHandler(EVNT_Handle event) {
+  Handler(event);
+  EVNT_SetEvent(event); /* handled with the next call */
+}
+
+static void TestFlags(void) {
+  int i;
+
+  EVNT_Init();
+  TEST_CHECK(EVNT_NOF_EVENTS>=4);
+  for(i=0;i<EVNT_NOF_EVENTS;i++) {
+    TEST_CHECK(!EVNT_EventIsSet((EVNT_Handle)i));
+  }
+  EVNT_SetEvent((EVNT_Handle)1);
+  TEST_CHECK(EVNT_EventIsSet((EVNT_Handle)1) && !EVNT_EventIsSet((EVNT_Handle)0) && !EVNT_EventIsSet((EVNT_Handle)2));
+  EVNT_ClearEvent((EVNT_Handle)1);
+  TEST_CHECK(!EVNT_EventIsSet((EVNT_Handle)1));
+  EVNT_SetEvent((EVNT_Handle)2);
+  TEST_CHECK(EVNT_EventIsSetAutoClear((EVNT_Handle)2));
+  TEST_CHECK(!EVNT_EventIsSetAutoClear((EVNT_Handle)2));
+  /* one event per call, the lowest number first */
+  for(i=EVNT_NOF_EVENTS-1;i>=0;i--) {
+    EVNT_SetEvent((EVNT_Handle)i);
+  }
+  nofHandled = 0;
+  EVNT_HandleEvent(Handler, FALSE); /* not cleared: same event again */
+  EVNT_HandleEvent(Handler, FALSE);
+  TEST_CHECK(nofHandled==2 && handled[0]==0 && handled[1]==0);
+  nofHandled = 0;
+  for(i=0;i<EVNT_NOF_EVENTS+1;i++) {
+    EVNT_HandleEvent(Handler, TRUE);
+  }
+  TEST_CHECK(nofHandled==EVNT_NOF_EVENTS);
+  for(i=0;i<(int)nofHandled;i++) {
+    TEST_CHECK(handled[i]==(EVNT_Handle)i);
+  }
+  /* all events in one call, also across memory units */
+  for(i=0;i<EVNT_NOF_EVENTS;i+=2) {
+    EVNT_SetEvent((EVNT_Handle)i);
+  }
+  nofHandled = 0;
+  EVNT_HandleAllEvents(SetAgainHandler);
+  TEST_CHECK(nofHandled==(EVNT_NOF_EVENTS+1)/2);
+  for(i=0;i<(int)nofHandled;i++) {
+    TEST_CHECK(handled[i]==(EVNT_Handle)(2*i));
+    TEST_CHECK(EVNT_EventIsSet((EVNT_Handle)(2*i))); /* set again by the callback */
+  }
+  nofHandled = 0;
+  EVNT_HandleAllEvents(Handler);
+  TEST_CHECK(nofHandled==(EVNT_NOF_EVENTS+1)/2);
+  nofHandled = 0;
+  EVNT_HandleAllEvents(Handler);
+  TEST_CHECK(nofHandled==0);
+}
+
+static EVNT_Msg lastMsg;
+static unsigned nofCallbacks;
+
+static void MsgCallback(const EVNT_Msg *msg) {
+  lastMsg = *msg;
+  nofCallbacks++;
+}
+
+static void TestQueue(void) {
+  static const uint8_t payload[EVNT_PAYLOAD_SIZE+1] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  int i, nofOk;
+
+  EVNT_Init();
+  nofCallbacks = 0;
+  nofReceived = 0;
+  fakeQueueLength = QUEUE_LENGTH;
+  TEST_CHECK(EVNT_Subscribe((EVNT_Handle)1, MsgCallback)==ERR_OK);
+  TEST_CHECK(EVNT_Subscribe((EVNT_Handle)1, NULL)==ERR_FAILED);
+  TEST_CHECK(EVNT_SubscribeQueue(EVNT_ALL_EVENTS, &fakeQueue)==ERR_OK);
+  TEST_CHECK(EVNT_Post((EVNT_Handle)1, payload, EVNT_PAYLOAD_SIZE+1)==ERR_FAILED);
+  tickCount = 1234;
+  TEST_CHECK(EVNT_Post((EVNT_Handle)1, payload, 3)==ERR_OK);
+  tickCount = 1300;
+  TEST_CHECK(EVNT_PostFromISR((EVNT_Handle)2, NULL, 0)==ERR_OK);
+  TEST_CHECK(nofCallbacks==0); /* only dispatched by the task */
+  EVNT_DispatchQueue();
+  TEST_CHECK(nofCallbacks==1);
+  TEST_CHECK(lastMsg.event==1 && lastMsg.timeMs==1234 && lastMsg.size==3 && lastMsg.data.u8[2]==3);
+  TEST_CHECK(nofReceived==2); /* the queue gets all events, in the order they were posted */
+  TEST_CHECK(received[0].event==1 && received[1].event==2 && received[1].timeMs==1300);
+  /* a full subscriber queue does not block the others */
+  nofReceived = 0;
+  fakeQueueLength = 0;
+  TEST_CHECK(EVNT_Post((EVNT_Handle)1, payload, 1)==ERR_OK);
+  EVNT_DispatchQueue();
+  TEST_CHECK(nofCallbacks==2 && nofReceived==0);
+  /* queue overflow */
+  nofOk = 0;
+  for(i=0;i<100;i++) {
+    nofOk += EVNT_Post((EVNT_Handle)3, NULL, 0)==ERR_OK;
+  }
+  TEST_CHECK(nofOk>0 && nofOk<100);
+  TEST_CHECK(EVNT_Post((EVNT_Handle)3, NULL, 0)==ERR_OVERFLOW);
+  EVNT_DispatchQueue();
+  TEST_CHECK(EVNT_Post((EVNT_Handle)3, NULL, 0)==ERR_OK);
+  /* unsubscribe */
+  EVNT_Unsubscribe((EVNT_Handle)1, MsgCallback);
+  EVNT_UnsubscribeQueue(EVNT_ALL_EVENTS, &fakeQueue);
+  fakeQueueLength = QUEUE_LENGTH;
+  nofReceived = 0;
+  TEST_CHECK(EVNT_Post((EVNT_Handle)1, NULL, 0)==ERR_OK);
+  EVNT_DispatchQueue();
+  TEST_CHECK(nofCallbacks==2 && nofReceived==0);
+}
+
+static int lostUpdates[NOF_THREADS];
+static pthread_barrier_t startBarrier; /* all threads start together */
+
+/*!
+ * \brief Sets and clears its own event. The other threads change the other bits of the same memory unit at the same time.
+ */
+static void *FlagThread(void *arg) {
+  EVNT_Handle event = (EVNT_Handle)(intptr_t)arg;
+  int i;
+
+  (void)pthread_barrier_wait(&startBarrier);
+  for(i=0;i<NOF_LOOPS;i++) {
+    EVNT_SetEvent(event);
+    if (!EVNT_EventIsSet(event)) {
+      lostUpdates[event]++; /* cleared by somebody else */
+    }
+    if (!EVNT_EventIsSetAutoClear(event)) {
+      lostUpdates[event]++;
+    }
+    if (EVNT_EventIsSet(event)) {
+      lostUpdates[event]++; /* set by somebody else */
+    }
+  }
+  return NULL;
+}
+
+static void TestAtomic(void) {
+  pthread_t threads[NOF_THREADS];
+  int i, nofEvents;
+
+  EVNT_Init();
+  nofEvents = EVNT_NOF_EVENTS<NOF_THREADS ? EVNT_NOF_EVENTS : NOF_THREADS; /* events 0..3 share the first memory unit */
+  TEST_CHECK(pthread_barrier_init(&startBarrier, NULL, (unsigned)nofEvents)==0);
+  for(i=0;i<nofEvents;i++) {
+    lostUpdates[i] = 0;
+    TEST_CHECK(pthread_create(&threads[i], NULL, FlagThread, (void*)(intptr_t)i)==0);
+  }
+  for(i=0;i<nofEvents;i++) {
+    TEST_CHECK(pthread_join(threads[i], NULL)==0);
+    TEST_CHECK(lostUpdates[i]==0);
+  }
+  (void)pthread_barrier_destroy(&startBarrier);
+  for(i=0;i<EVNT_NOF_EVENTS;i++) {
+    TEST_CHECK(!EVNT_EventIsSet((EVNT_Handle)i));
+  }
+}
+
+int main(void) {
+  TestFlags();
+  TestQueue();
+  TestAtomic();
+  return TEST_Result("TestEvent");
+}
@@ -0,0 +1,308 @@
+/**
+ * \file
+ * \brief Host test of the line following speed model.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Drives a simulated robot along a straight, an oval and an S-curve track: the sensors are 40 mm in front of the wheels,
+ * the steering aims at the line under the sensors, the motors follow the speed with a lag, and the tires only take a limited
+ * lateral acceleration. Each track is driven at the PID fw speed, with the reactive speed control and, on the oval, with the lap map.
+ * Checks that the line is never lost and that the speed control gives faster lap times.
+ */
+
+#include <math.h>
+#include "LineSpeedModel.h"
+#include "TestUtil.h"
+
+#define FRAME_US      2000  /* time between two reflectance frames */
+#define LOOKAHEAD_MM  40.0  /* sensors in front of the wheel axis */
+#define PITCH_MM      9.5   /* distance between two sensors */
+#define LOST_MM       28.0  /* line is lost beyond the outer sensors */
+#define GRIP_MMS2     3000.0 /* lateral acceleration the tires can take */
+#define MOTOR_TAU_MS  50.0  /* time constant of the motor speed */
+#define MAX_POINTS    8000  /* track points, one per mm */
+#define MAX_FRAMES    20000 /* 40 s */
+#define NOF_LAPS      4
+
+typedef enum {
+  MODE_PID,      /* without the speed control */
+  MODE_REACTIVE, /* reactive speed control */
+  MODE_LAP       /* lap map, learned in the first lap */
+} Mode;
+
+typedef struct {
+  double x[MAX_POINTS], y[MAX_POINTS]; /* line, one point per mm */
+  int nof;
+  bool closed;
+} Track;
+
+typedef struct {
+  double lapMs; /* time of the last lap, or to the end of an open track */
+  double maxOffsetMm; /* largest distance of the line from the middle sensor */
+  int lost; /* number of frames without the line */
+} Result;
+
+static const LSPM_Config config = {TRUE, 60, 15, 200, 2500, 80, 400, 1000}; /* default configuration, switched on */
+static Track track;
+static int pidPercent = 40; /* PID fw speed */
+static uint16_t map[LSPM_MAP_NOF_BINS];
+
+static void TrackStraight(double *h, double len) {
+  int i, last;
+
+  last = track.nof-1;
+  for(i=1;i<=(int)len && track.nof<MAX_POINTS;i++) {
+    track.x[track.nof] = track.x[last]+i*cos(*h);
+    track.y[track.nof] = track.y[last]+i*sin(*h);
+    track.nof++;
+  }
+}
+
+/*!
+ * \brief Adds an arc to the track.
+ * \param radius Radius in mm
+ * \param deg Angle, positive is counter-clockwise
+ */
+static void TrackArc(double *h, double radius, double deg) {
+  int i, n, last;
+  double cx, cy, a0, sign;
+
+  last = track.nof-1;
+  sign = deg>0?1:-1;
+  cx = track.x[last]-sign*radius*sin(*h);
+  cy = track.y[last]+sign*radius*cos(*h);
+  a0 = *h-sign*M_PI/2;
+  n = (int)(fabs(deg)*M_PI/180*radius);
+  for(i=1;i<=n && track.nof<MAX_POINTS;i++) {
+    track.x[track.nof] = cx+radius*cos(a0+sign*i/radius);
+    track.y[track.nof] = cy+radius*sin(a0+sign*i/radius);
+    track.nof++;
+  }
+  *h += deg*M_PI/180;
+}
+
+static void TrackStart(void) {
+  track.nof = 1;
+  track.x[0] = 0;
+  track.y[0] = 0;
+  track.closed = FALSE;
+}
+
+/*!
+ * \brief Signed distance of a point from the line, positive if the line is to the right. Updates the index of the nearest line point.
+ */
+static double LineOffset(double px, double py, int *idx) {
+  int i, k, best;
+  double d, bestD, tx, ty;
+
+  best = *idx;
+  bestD = 1e12;
+  for(i=-10;i<=80;i++) { /* the sensors only move forward */
+    k = *idx+i;
+    if (track.closed) {
+      k = (k+track.nof)%track.nof;
+    } else if (k<0 || k>=track.nof) {
+      continue;
+    }
+    d = (px-track.x[k])*(px-track.x[k])+(py-track.y[k])*(py-track.y[k]);
+    if (d<bestD) {
+      bestD = d;
+      best = k;
+    }
+  }
+  *idx = best;
+  k = best+1<track.nof?best+1:(track.closed?0:best);
+  i = k==best?best-1:best;
+  tx = track.x[k]-track.x[i];
+  ty = track.y[k]-track.y[i];
+  d = sqrt(tx*tx+ty*ty);
+  return (tx*(py-track.y[best])-ty*(px-track.x[best]))/d; /* cross product: positive if the point is left of the line */
+}
+
+/*!
+ * \brief Drives the track. Open tracks are driven once, closed tracks NOF_LAPS times.
+ */
+static void Drive(Mode mode, Result *res) {
+  LSPM_History history;
+  double x, y, h, v, dist, offset, curv, vCmd, lapStartMs, ms;
+  int idx, prevIdx, frame, laps, percent;
+  uint32_t curvature, target;
+  int32_t distUm, straightStartUm, lapStartUm, lineOffset;
+  uint16_t speedX100, nofBins;
+  ODO_Angle heading;
+  bool learn, fallback;
+
+  h = atan2(track.y[1]-track.y[0], track.x[1]-track.x[0]);
+  x = track.x[0]-LOOKAHEAD_MM*cos(h); /* sensors on the start of the line */
+  y = track.y[0]-LOOKAHEAD_MM*sin(h);
+  v = 0;
+  dist = 0;
+  idx = 0;
+  laps = 0;
+  lapStartMs = 0;
+  lapStartUm = 0;
+  straightStartUm = 0;
+  learn = TRUE;
+  fallback = FALSE;
+  nofBins = 0;
+  speedX100 = (uint16_t)(pidPercent*100);
+  LSPM_HistoryReset(&history);
+  for(idx=0;idx<LSPM_MAP_NOF_BINS;idx++) {
+    map[idx] = 0;
+  }
+  idx = 0;
+  res->lapMs = 0;
+  res->maxOffsetMm = 0;
+  res->lost = 0;
+  for(frame=1;frame<=MAX_FRAMES;frame++) {
+    ms = frame*FRAME_US/1000.0;
+    prevIdx = idx;
+    offset = LineOffset(x+LOOKAHEAD_MM*cos(h), y+LOOKAHEAD_MM*sin(h), &idx);
+    if (fabs(offset)>res->maxOffsetMm) {
+      res->maxOffsetMm = fabs(offset);
+    }
+    if (fabs(offset)>LOST_MM) {
+      res->lost++;
+      offset = offset>0?LOST_MM:-LOST_MM; /* the robot keeps turning to the side where it has seen the line */
+    }
+    if (track.closed && idx<prevIdx-track.nof/2) { /* passed the lap marker */
+      laps++;
+      res->lapMs = ms-lapStartMs;
+      lapStartMs = ms;
+      if (mode==MODE_LAP && learn) {
+        nofBins = (uint16_t)(((int32_t)(dist*1000)-lapStartUm)/1000/LSPM_MAP_BIN_MM);
+        LSPM_MapBuild(&config, map, nofBins, 100);
+        learn = FALSE;
+      }
+      lapStartUm = (int32_t)(dist*1000);
+      if (laps==NOF_LAPS) {
+        return;
+      }
+    } else if (!track.closed && idx==track.nof-1) { /* end of the line */
+      res->lapMs = ms;
+      return;
+    }
+    /* speed control, like LSPD_GetSpeedPercent() */
+    percent = pidPercent;
+    if (mode!=MODE_PID) {
+      distUm = (int32_t)(dist*1000);
+      heading = (ODO_Angle)(int64_t)(h/(2*M_PI)*4294967296.0);
+      lineOffset = (int32_t)(-offset*1000/PITCH_MM);
+      curvature = LSPM_HeadingCurvature(&history, distUm, heading);
+      if (LSPM_LineCurvature(lineOffset)>curvature) {
+        curvature = LSPM_LineCurvature(lineOffset);
+      }
+      LSPM_HistoryAdd(&history, distUm, heading);
+      if (curvature>=1000) {
+        straightStartUm = distUm;
+      }
+      target = (uint32_t)pidPercent*100;
+      if (mode==MODE_REACTIVE) {
+        target = LSPM_TargetX100(&config, target, curvature, distUm-straightStartUm);
+      } else if (learn) {
+        LSPM_MapLearn(map, (distUm-lapStartUm)/1000, curvature);
+      } else {
+        if (!fallback && abs(lineOffset)>1500) {
+          fallback = TRUE;
+        } else if (fallback && abs(lineOffset)<500) {
+          fallback = FALSE;
+        }
+        if (!fallback) {
+          target = LSPM_MapSpeedX100(&config, map, nofBins, (distUm-lapStartUm)/1000);
+        }
+      }
+      speedX100 = LSPM_RampX100(&config, speedX100, target, FRAME_US);
+      percent = speedX100<100?1:speedX100/100;
+    }
+    /* robot: motors with a lag, steering towards the line under the sensors, limited by the grip */
+    vCmd = percent*config.fullMmS/100.0;
+    v += (vCmd-v)*(FRAME_US/1000.0)/MOTOR_TAU_MS;
+    curv = -2*offset/(LOOKAHEAD_MM*LOOKAHEAD_MM);
+    if (v>0 && fabs(curv)*v*v>GRIP_MMS2) {
+      curv = (curv>0?1:-1)*GRIP_MMS2/(v*v); /* sliding */
+    }
+    x += v*FRAME_US/1e6*cos(h);
+    y += v*FRAME_US/1e6*sin(h);
+    h += curv*v*FRAME_US/1e6;
+    dist += v*FRAME_US/1e6;
+  }
+  res->lapMs = 0; /* did not finish */
+}
+
+static void TestTrack(const char *name, bool hasLap, double *pidMs, double *reactiveMs) {
+  Result pid, reactive, lap;
+
+  Drive(MODE_PID, &pid);
+  Drive(MODE_REACTIVE, &reactive);
+  printf("%s: %.0f ms at %d%%, %.0f ms with the speed control", name, pid.lapMs, pidPercent, reactive.lapMs);
+  TEST_CHECK(pid.lapMs>0);
+  TEST_CHECK(pid.lost==0);
+  TEST_CHECK(reactive.lapMs>0);
+  TEST_CHECK(reactive.lost==0);
+  TEST_CHECK(reactive.lapMs<pid.lapMs);
+  if (hasLap) {
+    Drive(MODE_LAP, &lap);
+    printf(", %.0f ms with the lap map", lap.lapMs);
+    TEST_CHECK(lap.lapMs>0);
+    TEST_CHECK(lap.lost==0);
+    TEST_CHECK(lap.lapMs<reactive.lapMs);
+  }
+  printf(" (max line offset %.1f/%.1f mm)\n", pid.maxOffsetMm, reactive.maxOffsetMm);
+  *pidMs = pid.lapMs;
+  *reactiveMs = reactive.lapMs;
+}
+
+static void TestStraight(void) {
+  double h = 0, pidMs, reactiveMs;
+
+  TrackStart();
+  TrackStraight(&h, 2000);
+  TestTrack("straight", FALSE, &pidMs, &reactiveMs);
+  /* 2 m: 5 s at 40%, the speed control drives the most of it with 60% */
+  TEST_CHECK_NEAR(pidMs, 2000/0.4+MOTOR_TAU_MS, 20);
+  TEST_CHECK(reactiveMs<4000);
+}
+
+static void TestOval(void) {
+  double h = 0, pidMs, reactiveMs;
+
+  TrackStart();
+  TrackStraight(&h, 400);
+  TrackArc(&h, 200, 180);
+  TrackStraight(&h, 800);
+  TrackArc(&h, 200, 180);
+  TrackStraight(&h, 399);
+  track.closed = TRUE;
+  TestTrack("oval", TRUE, &pidMs, &reactiveMs);
+  TEST_CHECK_NEAR(pidMs, track.nof/0.4, 20); /* constant speed on the lap */
+}
+
+static void TestSCurve(void) {
+  double h = 0, pidMs, reactiveMs;
+  Result fast;
+
+  TrackStart();
+  TrackStraight(&h, 600);
+  TrackArc(&h, 100, 180);
+  TrackArc(&h, 100, -180);
+  TrackStraight(&h, 600);
+  TestTrack("S-curve", FALSE, &pidMs, &reactiveMs);
+  /* a fixed speed like the straight speed of the speed control is too fast for the curves */
+  pidPercent = config.straightPercent;
+  Drive(MODE_PID, &fast);
+  pidPercent = 40;
+  printf("S-curve: line lost at %d%% without the speed control (max line offset %.1f mm)\n", config.straightPercent, fast.maxOffsetMm);
+  TEST_CHECK(fast.lost>0);
+}
+
+int main(void) {
+  TEST_CHECK(LSPM_Sqrt32(0)==0);
+  TEST_CHECK(LSPM_Sqrt32(99)==9);
+  TEST_CHECK(LSPM_Sqrt32(100)==10);
+  TEST_CHECK(LSPM_Sqrt32(0xffffffff)==0xffff);
+  TEST_CHECK(LSPM_LineCurvature(0)==0);
+  TEST_CHECK_NEAR(LSPM_LineCurvature(1000), 2*9.5/(40*40)*1e6, 20); /* one sensor off: radius 84 mm */
+  TestStraight();
+  TestOval();
+  TestSCurve();
+  return TEST_Result("TestLineSpeed");
+}
@@ -0,0 +1,151 @@
+/**
+ * \file
+ * \brief Generated grid mazes for the host tests of the maze modules.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * A maze is a grid of cells with the open sides of each cell. Directions are N (0), E (1), S (2) and W (3), y grows to the north.
+ * Mazes are generated with a random depth first search, which gives exactly one route between two cells,
+ * and optionally get loops by opening more walls. The generation only depends on the seed of rand().
+ */
+
+#ifndef TESTMAZE_H_
+#define TESTMAZE_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TMAZE_MAX_SIZE  16
+#define TMAZE_NOF_DIRS  4
+#define TMAZE_NO_DIST   -1
+
+typedef struct {
+  int w, h;                                          /* size in cells */
+  unsigned char open[TMAZE_MAX_SIZE][TMAZE_MAX_SIZE]; /* [x][y]: bit set for each open side */
+} TMAZE_Maze;
+
+static const int TMAZE_dx[TMAZE_NOF_DIRS] = {0, 1, 0, -1};
+static const int TMAZE_dy[TMAZE_NOF_DIRS] = {1, 0, -1, 0};
+
+static int TMAZE_IsOpen(const TMAZE_Maze *m, int x, int y, int dir) {
+  return (m->open[x][y]&(1<<(dir&3)))!=0;
+}
+
+static int TMAZE_IsInside(const TMAZE_Maze *m, int x, int y) {
+  return x>=0 && y>=0 && x<m->w && y<m->h;
+}
+
+static void TMAZE_Open(TMAZE_Maze *m, int x, int y, int dir) {
+  m->open[x][y] |= (unsigned char)(1<<dir);
+  m->open[x+TMAZE_dx[dir]][y+TMAZE_dy[dir]] |= (unsigned char)(1<<((dir+2)&3));
+}
+
+/*!
+ * \brief Generates a maze.
+ * \param nofLoops Number of walls opened after the depth first search, each one adds a loop. Limited to the number of inner walls left.
+ */
+static void TMAZE_Generate(TMAZE_Maze *m, int w, int h, int nofLoops) {
+  int stackX[TMAZE_MAX_SIZE*TMAZE_MAX_SIZE], stackY[TMAZE_MAX_SIZE*TMAZE_MAX_SIZE];
+  int visited[TMAZE_MAX_SIZE][TMAZE_MAX_SIZE];
+  int sp, x, y, nx, ny, dir, cand[TMAZE_NOF_DIRS], nofCand;
+
+  memset(m, 0, sizeof(*m));
+  memset(visited, 0, sizeof(visited));
+  m->w = w;
+  m->h = h;
+  sp = 0;
+  stackX[sp] = 0; stackY[sp] = 0; sp++;
+  visited[0][0] = 1;
+  while(sp>0) {
+    x = stackX[sp-1];
+    y = stackY[sp-1];
+    nofCand = 0;
+    for(dir=0;dir<TMAZE_NOF_DIRS;dir++) {
+      nx = x+TMAZE_dx[dir];
+      ny = y+TMAZE_dy[dir];
+      if (TMAZE_IsInside(m, nx, ny) && !visited[nx][ny]) {
+        cand[nofCand++] = dir;
+      }
+    }
+    if (nofCand==0) {
+      sp--;
+      continue;
+    }
+    dir = cand[rand()%nofCand];
+    TMAZE_Open(m, x, y, dir);
+    nx = x+TMAZE_dx[dir];
+    ny = y+TMAZE_dy[dir];
+    visited[nx][ny] = 1;
+    stackX[sp] = nx; stackY[sp] = ny; sp++;
+  }
+  if (nofLoops>(w-1)*h+w*(h-1)-(w*h-1)) {
+    nofLoops = (w-1)*h+w*(h-1)-(w*h-1); /* all inner walls open */
+  }
+  while(nofLoops>0) {
+    x = rand()%w;
+    y = rand()%h;
+    dir = rand()%TMAZE_NOF_DIRS;
+    if (TMAZE_IsInside(m, x+TMAZE_dx[dir], y+TMAZE_dy[dir]) && !TMAZE_IsOpen(m, x, y, dir)) {
+      TMAZE_Open(m, x, y, dir);
+      nofLoops--;
+    }
+  }
+}
+
+/* line maze: the start is a line into the south side of cell (0,0), with a dead end at (0,-1) */
+#define TMAZE_START_X   0
+#define TMAZE_START_Y   -1
+
+/*!
+ * \brief Returns the open sides of a cell of the line maze, with the start line.
+ */
+static int TMAZE_LineExits(const TMAZE_Maze *m, int x, int y) {
+  if (x==TMAZE_START_X && y==TMAZE_START_Y) {
+    return 1<<0; /* only north */
+  }
+  if (x==0 && y==0) {
+    return m->open[x][y]|(1<<2);
+  }
+  return m->open[x][y];
+}
+
+/*!
+ * \brief Returns TRUE if the robot sees a junction at a cell of the line maze: everything but a straight line through the cell.
+ * Corners and dead ends are junctions too.
+ */
+static int TMAZE_IsJunction(const TMAZE_Maze *m, int x, int y) {
+  int exits = TMAZE_LineExits(m, x, y);
+
+  return exits!=((1<<0)|(1<<2)) && exits!=((1<<1)|(1<<3));
+}
+
+/*!
+ * \brief Number of cells to the goal for each cell, with a breadth first search.
+ */
+static void TMAZE_Distances(const TMAZE_Maze *m, int gx, int gy, int dist[TMAZE_MAX_SIZE][TMAZE_MAX_SIZE]) {
+  int queueX[TMAZE_MAX_SIZE*TMAZE_MAX_SIZE], queueY[TMAZE_MAX_SIZE*TMAZE_MAX_SIZE];
+  int head, tail, x, y, dir, nx, ny;
+
+  for(x=0;x<TMAZE_MAX_SIZE;x++) {
+    for(y=0;y<TMAZE_MAX_SIZE;y++) {
+      dist[x][y] = TMAZE_NO_DIST;
+    }
+  }
+  head = tail = 0;
+  dist[gx][gy] = 0;
+  queueX[tail] = gx; queueY[tail] = gy; tail++;
+  while(head<tail) {
+    x = queueX[head];
+    y = queueY[head];
+    head++;
+    for(dir=0;dir<TMAZE_NOF_DIRS;dir++) {
+      nx = x+TMAZE_dx[dir];
+      ny = y+TMAZE_dy[dir];
+      if (TMAZE_IsOpen(m, x, y, dir) && dist[nx][ny]==TMAZE_NO_DIST) {
+        dist[nx][ny] = dist[x][y]+1;
+        queueX[tail] = nx; queueY[tail] = ny; tail++;
+      }
+    }
+  }
+}
+
+#endif /* TESTMAZE_H_ */
@@ -0,0 +1,156 @@
+/**
+ * \file
+ * \brief Host test of the flood fill wall maze.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Simulates the exploration of the wall maze module in generated 16x16 mazes with loops: the robot senses the walls of its cell,
+ * misses some walls in front, and gets blocked by them when driving. The robot is carried back to the start after each run,
+ * until a run finds no new walls: then it has to take the shortest route.
+ */
+
+#include "MazeFlood.h"
+#include "TestUtil.h"
+#include "TestMaze.h"
+
+#define GOAL_X       7
+#define GOAL_Y       7
+#define GOAL_SIZE    2
+#define MAX_RUNS     40
+#define MAX_MOVES    2000
+#define MISS_PERCENT 20   /* walls in front not seen by the sensor */
+
+static TMAZE_Maze maze;
+static MAZEF_Maze map;
+static int trueDist[TMAZE_MAX_SIZE][TMAZE_MAX_SIZE]; /* [x][y] distance to the goal area in the generated maze */
+
+static void TrueDistances(void) {
+  int dist[TMAZE_MAX_SIZE][TMAZE_MAX_SIZE];
+  int x, y, gx, gy;
+
+  for(x=0;x<TMAZE_MAX_SIZE;x++) {
+    for(y=0;y<TMAZE_MAX_SIZE;y++) {
+      trueDist[x][y] = 0x7fff;
+    }
+  }
+  for(gx=GOAL_X;gx<GOAL_X+GOAL_SIZE;gx++) {
+    for(gy=GOAL_Y;gy<GOAL_Y+GOAL_SIZE;gy++) {
+      TMAZE_Distances(&maze, gx, gy, dist);
+      for(x=0;x<TMAZE_MAX_SIZE;x++) {
+        for(y=0;y<TMAZE_MAX_SIZE;y++) {
+          if (dist[x][y]!=TMAZE_NO_DIST && dist[x][y]<trueDist[x][y]) {
+            trueDist[x][y] = dist[x][y];
+          }
+        }
+      }
+    }
+  }
+}
+
+/*!
+ * \brief Sensor model: all walls of the cell, the wall in front is missed sometimes.
+ */
+static uint8_t SenseWalls(int x, int y, int heading) {
+  uint8_t walls = (uint8_t)(~maze.open[x][y]&0xf);
+
+  if ((walls&(1<<heading)) && rand()%100<MISS_PERCENT) {
+    walls &= (uint8_t)~(1<<heading);
+  }
+  return walls;
+}
+
+/*!
+ * \brief Checks the distances kept up to date with each new wall against a full flood, and that they never overestimate.
+ */
+static void CheckDistances(void) {
+  static MAZEF_Maze flooded;
+  int x, y, same = 1, optimistic = 1;
+
+  flooded = map;
+  MAZEF_Flood(&flooded);
+  for(y=0;y<MAZEF_SIZE;y++) {
+    for(x=0;x<MAZEF_SIZE;x++) {
+      same &= flooded.dist[y][x]==map.dist[y][x];
+      optimistic &= map.dist[y][x]<=trueDist[x][y];
+    }
+  }
+  TEST_CHECK(same);
+  TEST_CHECK(optimistic);
+}
+
+/*!
+ * \brief One run from the start to the goal, like WMAZE_Explore().
+ * \param[out] nofNewWalls Number of walls found in the run
+ * \return Number of cells driven, -1 if the goal has not been reached
+ */
+static int Run(int *nofNewWalls) {
+  uint8_t x = 0, y = 0, heading = MAZEF_NORTH, dir;
+  int moves = 0;
+
+  *nofNewWalls = 0;
+  while(moves<MAX_MOVES) {
+    *nofNewWalls += MAZEF_AddWalls(&map, x, y, SenseWalls(x, y, heading));
+    CheckDistances();
+    if (map.dist[y][x]==0) {
+      return moves;
+    }
+    dir = MAZEF_NextDir(&map, x, y, heading);
+    if (dir==MAZEF_NO_DIR) {
+      return -1;
+    }
+    TEST_CHECK(!MAZEF_HasWall(&map, x, y, dir)); /* never into a known wall */
+    heading = dir;
+    if (!TMAZE_IsOpen(&maze, x, y, dir)) { /* blocked by a wall we did not see */
+      *nofNewWalls += MAZEF_AddWalls(&map, x, y, (uint8_t)(1<<dir));
+      continue;
+    }
+    MAZEF_Move(dir, &x, &y);
+    moves++;
+  }
+  return -1;
+}
+
+static void TestExplore(int nofLoops) {
+  int runs, moves, nofNewWalls;
+
+  TMAZE_Generate(&maze, MAZEF_SIZE, MAZEF_SIZE, nofLoops);
+  TrueDistances();
+  MAZEF_Init(&map, GOAL_X, GOAL_Y, GOAL_SIZE);
+  TEST_CHECK(map.dist[0][0]==GOAL_X+GOAL_Y); /* no walls known: straight to the goal */
+  for(runs=0;runs<MAX_RUNS;runs++) {
+    moves = Run(&nofNewWalls);
+    TEST_CHECK(moves>=trueDist[0][0]);
+    if (nofNewWalls==0) {
+      break;
+    }
+  }
+  TEST_CHECK(runs<MAX_RUNS);
+  TEST_CHECK(moves==trueDist[0][0]); /* no new walls: the route only used known walls and is the shortest */
+  TEST_CHECK(MAZEF_IsVisited(&map, 0, 0));
+}
+
+static void TestWalls(void) {
+  MAZEF_Init(&map, GOAL_X, GOAL_Y, GOAL_SIZE);
+  TEST_CHECK(MAZEF_HasWall(&map, 0, 0, MAZEF_SOUTH) && MAZEF_HasWall(&map, 0, 0, MAZEF_WEST));
+  TEST_CHECK(!MAZEF_HasWall(&map, 0, 0, MAZEF_NORTH) && !MAZEF_HasWall(&map, 0, 0, MAZEF_EAST));
+  TEST_CHECK(MAZEF_HasWall(&map, MAZEF_SIZE-1, MAZEF_SIZE-1, MAZEF_NORTH) && MAZEF_HasWall(&map, MAZEF_SIZE-1, MAZEF_SIZE-1, MAZEF_EAST));
+  TEST_CHECK(MAZEF_AddWalls(&map, 3, 3, (1<<MAZEF_NORTH)|(1<<MAZEF_WEST))==2);
+  TEST_CHECK(MAZEF_HasWall(&map, 3, 4, MAZEF_SOUTH) && MAZEF_HasWall(&map, 2, 3, MAZEF_EAST)); /* seen from the neighbors */
+  TEST_CHECK(MAZEF_AddWalls(&map, 3, 4, 1<<MAZEF_SOUTH)==0); /* already known */
+  TEST_CHECK(map.dist[GOAL_Y][GOAL_X]==0 && map.dist[GOAL_Y+1][GOAL_X+1]==0);
+  /* wall the goal in: no way */
+  MAZEF_Init(&map, 0, 0, 1);
+  (void)MAZEF_AddWalls(&map, 0, 0, (1<<MAZEF_NORTH)|(1<<MAZEF_EAST));
+  TEST_CHECK(map.dist[1][1]==MAZEF_DIST_UNREACHABLE);
+  TEST_CHECK(MAZEF_NextDir(&map, 1, 1, MAZEF_NORTH)==MAZEF_NO_DIR);
+}
+
+int main(void) {
+  int i;
+
+  srand(3);
+  TestWalls();
+  for(i=0;i<20;i++) {
+    TestExplore(i*4);
+  }
+  return TEST_Result("TestMazeFlood");
+}
@@ -0,0 +1,424 @@
+/**
+ * \file
+ * \brief Host test of the maze graph route search.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Builds the graph of generated line mazes with loops, like after a full exploration, and checks the route found with Dijkstra:
+ * it has to lead to the finish, its time has to match a search over all cells, and it has to be faster than the simplified left hand path.
+ * Then explores the mazes with Tremaux' algorithm like the robot, building the graph on the way, and checks that the route over
+ * the partly explored graph is still the fastest one. The distance driven for the exploration is compared with the left hand rule
+ * and with a full Tremaux exploration, which drives every line twice.
+ */
+
+#include "MazeGraph.h"
+#include "MazePath.h"
+#include "TestUtil.h"
+#include "TestMaze.h"
+
+#define CELL_MM     300 /* one cell takes 1000 ms with the cost model */
+#define CELL_MS     1000
+#define MAX_MOVES   4000
+#define NO_TIME     0x7fffffff
+
+static const MAZEG_Cost cost = {300, 400, 700, 150}; /* speed, 90 degree turn, U-turn, junction */
+
+static TMAZE_Maze maze;
+static MAZEG_Graph graph;
+static uint8_t node[TMAZE_MAX_SIZE][TMAZE_MAX_SIZE+1]; /* node of each cell, [x][y+1] for the start line */
+
+static uint32_t TurnMs(int quarterTurns) {
+  switch(quarterTurns&3) {
+    case 0:  return cost.junctionMs;
+    case 2:  return cost.junctionMs+cost.turn180Ms;
+    default: return cost.junctionMs+cost.turn90Ms;
+  }
+}
+
+static int IsNode(int x, int y, int gx, int gy) {
+  return (x==gx && y==gy) || TMAZE_IsJunction(&maze, x, y);
+}
+
+/*!
+ * \brief Builds the graph the robot has after exploring everything: a node for every junction, the start and the finish.
+ * \return Node of the finish
+ */
+static uint8_t BuildGraph(int gx, int gy) {
+  int x, y, dir, cx, cy, cells;
+  uint8_t idx;
+
+  MAZEG_Clear(&graph);
+  for(y=TMAZE_START_Y;y<maze.h;y++) {
+    for(x=0;x<maze.w;x++) {
+      node[x][y+1] = MAZEG_NO_NODE;
+      if ((y>=0 || x==TMAZE_START_X) && IsNode(x, y, gx, gy)) { /* start first, it has to be node 0 */
+        TEST_CHECK(MAZEG_AddNode(&graph, (int16_t)((y+1)*CELL_MM), (int16_t)(x*CELL_MM), (uint8_t)TMAZE_LineExits(&maze, x, y), &idx)==ERR_OK);
+        node[x][y+1] = idx;
+      }
+    }
+  }
+  TEST_CHECK(node[TMAZE_START_X][TMAZE_START_Y+1]==0);
+  for(y=TMAZE_START_Y;y<maze.h;y++) {
+    for(x=0;x<maze.w;x++) {
+      if (node[x][y+1]==MAZEG_NO_NODE) {
+        continue;
+      }
+      for(dir=0;dir<TMAZE_NOF_DIRS;dir++) {
+        if (!(TMAZE_LineExits(&maze, x, y)&(1<<dir))) {
+          continue;
+        }
+        cx = x; cy = y; cells = 0;
+        do { /* follow the line to the next node, there are no curves between nodes */
+          cx += TMAZE_dx[dir];
+          cy += TMAZE_dy[dir];
+          cells++;
+        } while(node[cx][cy+1]==MAZEG_NO_NODE && !IsNode(cx, cy, gx, gy));
+        MAZEG_Link(&graph, node[x][y+1], (uint8_t)dir, node[cx][cy+1], (uint8_t)dir, (uint16_t)(cells*CELL_MM));
+      }
+    }
+  }
+  return node[gx][gy+1];
+}
+
+/*!
+ * \brief Reference: best time from the start to the goal, relaxing the states (cell, heading) until nothing changes.
+ */
+static uint32_t ReferenceTime(int gx, int gy) {
+  static uint32_t t[TMAZE_MAX_SIZE][TMAZE_MAX_SIZE+1][TMAZE_NOF_DIRS];
+  int x, y, h, e, nx, ny, changed;
+  uint32_t nt, best;
+
+  for(x=0;x<TMAZE_MAX_SIZE;x++) {
+    for(y=0;y<=TMAZE_MAX_SIZE;y++) {
+      for(h=0;h<TMAZE_NOF_DIRS;h++) {
+        t[x][y][h] = NO_TIME;
+      }
+    }
+  }
+  t[TMAZE_START_X][TMAZE_START_Y+1][0] = 0;
+  do {
+    changed = 0;
+    for(y=TMAZE_START_Y;y<maze.h;y++) {
+      for(x=0;x<maze.w;x++) {
+        if (y<0 && x!=TMAZE_START_X) {
+          continue;
+        }
+        for(h=0;h<TMAZE_NOF_DIRS;h++) {
+          if (t[x][y+1][h]==NO_TIME || (x==gx && y==gy)) {
+            continue;
+          }
+          for(e=0;e<TMAZE_NOF_DIRS;e++) {
+            if (!(TMAZE_LineExits(&maze, x, y)&(1<<e))) {
+              continue;
+            }
+            if (y<0 || !IsNode(x, y, gx, gy)) { /* start or line: only ahead */
+              if (e!=h) {
+                continue;
+              }
+              nt = t[x][y+1][h];
+            } else {
+              nt = t[x][y+1][h]+TurnMs(e-h);
+            }
+            nt += CELL_MS;
+            nx = x+TMAZE_dx[e];
+            ny = y+TMAZE_dy[e];
+            if (nt<t[nx][ny+1][e]) {
+              t[nx][ny+1][e] = nt;
+              changed = 1;
+            }
+          }
+        }
+      }
+    }
+  } while(changed);
+  best = NO_TIME;
+  for(h=0;h<TMAZE_NOF_DIRS;h++) {
+    if (t[gx][gy+1][h]<best) {
+      best = t[gx][gy+1][h];
+    }
+  }
+  return best;
+}
+
+/*!
+ * \brief Drives the turns of a route from the start and adds up the time.
+ * \param turns Quarter turns clockwise at each junction
+ * \param lenMm Segment lengths of the route, checked against the maze if not NULL
+ * \return Time to the goal, NO_TIME if the route does not lead there
+ */
+static uint32_t DriveTime(const uint8_t *turns, uint16_t nofTurns, const uint16_t *lenMm, int gx, int gy) {
+  int x = TMAZE_START_X, y = TMAZE_START_Y, heading = 0, cells = 0;
+  uint16_t idx = 0;
+  uint32_t t = 0;
+
+  while(t<MAX_MOVES*CELL_MS) {
+    if (!(TMAZE_LineExits(&maze, x, y)&(1<<heading))) {
+      return NO_TIME;
+    }
+    x += TMAZE_dx[heading];
+    y += TMAZE_dy[heading];
+    t += CELL_MS;
+    cells++;
+    if (x==gx && y==gy) {
+      if (lenMm!=NULL) {
+        TEST_CHECK(lenMm[idx]==cells*CELL_MM);
+      }
+      return idx==nofTurns ? t : NO_TIME;
+    }
+    if (!IsNode(x, y, gx, gy)) {
+      continue;
+    }
+    if (idx>=nofTurns) {
+      return NO_TIME;
+    }
+    if (lenMm!=NULL) {
+      TEST_CHECK(lenMm[idx]==cells*CELL_MM); /* segment ending at this junction */
+    }
+    cells = 0;
+    t += TurnMs(turns[idx]);
+    heading = (heading+turns[idx])&3;
+    idx++;
+  }
+  return NO_TIME;
+}
+
+/*!
+ * \brief Time of the simplified path found with the left hand rule.
+ * \param[out] drivenMm Distance driven while exploring with the left hand rule, or NULL
+ */
+static uint32_t LeftHandTime(int gx, int gy, uint32_t *drivenMm) {
+  MAZEP_Path path;
+  uint8_t turns[MAZEP_MAX_PATH];
+  int x = TMAZE_START_X, y = TMAZE_START_Y, heading = 0, moves, exits, code;
+  uint16_t i;
+
+  MAZEP_Clear(&path);
+  for(moves=0;moves<MAX_MOVES;moves++) {
+    x += TMAZE_dx[heading];
+    y += TMAZE_dy[heading];
+    if (x==gx && y==gy) {
+      break;
+    }
+    if (!IsNode(x, y, gx, gy)) {
+      continue;
+    }
+    exits = TMAZE_LineExits(&maze, x, y);
+    if (exits&(1<<((heading+3)&3))) {
+      code = MAZEP_CODE_LEFT;
+    } else if (exits&(1<<heading)) {
+      code = MAZEP_CODE_STRAIGHT;
+    } else if (exits&(1<<((heading+1)&3))) {
+      code = MAZEP_CODE_RIGHT;
+    } else {
+      code = MAZEP_CODE_UTURN;
+    }
+    (void)MAZEP_Add(&path, (uint8_t)code);
+    heading = (heading+MAZEP_CodeToAngle((uint8_t)code)/90)&3;
+  }
+  if (drivenMm!=NULL) {
+    *drivenMm = (uint32_t)(moves+1)*CELL_MM; /* including the dead ends */
+  }
+  for(i=0;i<path.length;i++) {
+    turns[i] = (uint8_t)(MAZEP_CodeToAngle(MAZEP_GetCode(&path, i))/90);
+  }
+  return DriveTime(turns, path.length, NULL, gx, gy);
+}
+
+static int TestRoute(int w, int h, int nofLoops) {
+  uint8_t turns[MAZEG_MAX_NODES], goal;
+  uint16_t lenMm[MAZEG_MAX_NODES+1], nofTurns;
+  uint32_t timeMs, refMs, leftMs;
+  int gx = w-1, gy = h-1;
+
+  TMAZE_Generate(&maze, w, h, nofLoops);
+  goal = BuildGraph(gx, gy);
+  TEST_CHECK(MAZEG_ShortestRoute(&graph, &cost, 0, 0, goal, turns, lenMm, sizeof(turns), &nofTurns, &timeMs)==ERR_OK);
+  refMs = ReferenceTime(gx, gy);
+  TEST_CHECK(timeMs==refMs);
+  TEST_CHECK(DriveTime(turns, nofTurns, lenMm, gx, gy)==timeMs);
+  leftMs = LeftHandTime(gx, gy, NULL);
+  TEST_CHECK(leftMs!=NO_TIME && timeMs<=leftMs);
+  if (nofLoops==0) {
+    TEST_CHECK(timeMs==leftMs); /* only one route */
+  }
+  if (nofTurns>0) {
+    TEST_CHECK(MAZEG_ShortestRoute(&graph, &cost, 0, 0, goal, turns, lenMm, (uint16_t)(nofTurns-1), &nofTurns, NULL)==ERR_OVERFLOW);
+  }
+  return timeMs<leftMs;
+}
+
+/*!
+ * \brief Checks the node times and the next exit at every junction against the route search.
+ */
+static void TestNodeTimes(uint8_t goal, uint32_t routeMs) {
+  static uint32_t nodeMs[MAZEG_MAX_NODES];
+  uint8_t n, node, dir, arrival, exit, turns[MAZEG_MAX_NODES];
+  uint16_t nofTurns, steps;
+  uint32_t ms;
+
+  TEST_CHECK(MAZEG_NodeTimes(&graph, &cost, 0, 0, nodeMs)==ERR_OK);
+  TEST_CHECK(nodeMs[0]==0);
+  TEST_CHECK(nodeMs[goal]==routeMs);
+  for(n=1;n<graph.nofNodes;n++) {
+    TEST_CHECK(MAZEG_ShortestRoute(&graph, &cost, 0, 0, n, turns, NULL, sizeof(turns), &nofTurns, &ms)==ERR_OK && ms==nodeMs[n]);
+    if (n==goal) {
+      TEST_CHECK(MAZEG_NextExit(&graph, &cost, n, 0, goal, &exit)==ERR_FAILED); /* already there */
+      continue;
+    }
+    /* follow the next exit from every junction and heading: leads to the goal, at most over every node once */
+    for(arrival=0;arrival<MAZEG_NOF_DIRS;arrival++) {
+      node = n;
+      dir = arrival;
+      for(steps=0;steps<graph.nofNodes && node!=goal;steps++) {
+        if (MAZEG_NextExit(&graph, &cost, node, dir, goal, &exit)!=ERR_OK) {
+          break;
+        }
+        TEST_CHECK(graph.node[node].neighbor[exit]!=MAZEG_NO_NODE);
+        dir = (uint8_t)((graph.node[node].peerDir[exit]+2)&3);
+        node = graph.node[node].neighbor[exit];
+      }
+      TEST_CHECK(node==goal);
+      TEST_CHECK(steps<graph.nofNodes);
+    }
+  }
+}
+
+/*!
+ * \brief Explores a maze like the robot with the Tremaux rule: the graph gets the junctions as they are reached.
+ * In the finish, the robot turns around as long as a faster route might exist.
+ * \param[out] drivenMm Distance driven for the exploration
+ * \return Number of segments driven, -1 if the exploration did not end in the finish
+ */
+static int ExploreTremaux(int gx, int gy, uint8_t *goal, uint32_t *drivenMm) {
+  static MAZEG_Tremaux tremaux;
+  int x = TMAZE_START_X, y = TMAZE_START_Y, cells, segments;
+  uint8_t curr, next, dir = 0;
+
+  MAZEG_Clear(&graph);
+  *goal = MAZEG_NO_NODE;
+  *drivenMm = 0;
+  TEST_CHECK(MAZEG_AddNode(&graph, 0, 0, 1<<0, &curr)==ERR_OK);
+  MAZEG_TremauxClear(&tremaux);
+  MAZEG_TremauxAddMark(&tremaux, curr, dir); /* we leave the start ahead */
+  for(segments=0;segments<4*MAZEG_MAX_NODES*MAZEG_NOF_DIRS;segments++) {
+    if (!(TMAZE_LineExits(&maze, x, y)&(1<<dir))) {
+      return -1; /* no line in this direction */
+    }
+    cells = 0;
+    do {
+      x += TMAZE_dx[dir];
+      y += TMAZE_dy[dir];
+      cells++;
+    } while(!IsNode(x, y, gx, gy));
+    *drivenMm += (uint32_t)cells*CELL_MM;
+    TEST_CHECK(MAZEG_AddNode(&graph, (int16_t)((y+1)*CELL_MM), (int16_t)(x*CELL_MM), (uint8_t)TMAZE_LineExits(&maze, x, y), &next)==ERR_OK);
+    MAZEG_Link(&graph, curr, dir, next, dir, (uint16_t)(cells*CELL_MM));
+    curr = next;
+    if (x==gx && y==gy) {
+      graph.node[curr].flags |= MAZEG_FLAG_GOAL;
+      *goal = curr;
+      if (tremaux.toGoal || MAZEG_TremauxIsExplored(&graph, &cost, *goal)) {
+        return segments+1;
+      }
+      dir = (uint8_t)((dir+2)&3); /* turn around, a faster route might exist */
+      MAZEG_TremauxAddMark(&tremaux, curr, dir); /* in */
+      MAZEG_TremauxAddMark(&tremaux, curr, dir); /* and out again */
+    } else {
+      next = MAZEG_TremauxSelectDir(&tremaux, &graph, &cost, *goal, curr, dir);
+      TEST_CHECK(MAZEG_TremauxGetMark(&tremaux, curr, next)>=1 && MAZEG_TremauxGetMark(&tremaux, curr, next)<=2);
+      dir = next;
+    }
+  }
+  return -1;
+}
+
+/*!
+ * \brief Total length of the lines of the maze, including the start line.
+ */
+static uint32_t LineLengthMm(void) {
+  int x, y, dir, sides = 0;
+
+  for(x=0;x<maze.w;x++) {
+    for(y=0;y<maze.h;y++) {
+      for(dir=0;dir<TMAZE_NOF_DIRS;dir++) {
+        sides += TMAZE_IsOpen(&maze, x, y, dir);
+      }
+    }
+  }
+  return (uint32_t)(sides/2+1)*CELL_MM;
+}
+
+/*!
+ * \brief Explores a maze with Tremaux' algorithm and checks the route.
+ * \param[out] distMm Distance driven with the left hand rule, with Tremaux and for a full Tremaux exploration
+ */
+static void TestTremaux(int w, int h, int nofLoops, uint32_t distMm[3]) {
+  uint8_t turns[MAZEG_MAX_NODES], goal;
+  uint16_t nofTurns;
+  uint32_t timeMs, fullMs;
+  int gx = w-1, gy = h-1, segments;
+
+  TMAZE_Generate(&maze, w, h, nofLoops);
+  (void)LeftHandTime(gx, gy, &distMm[0]);
+  distMm[2] = 2*LineLengthMm(); /* every line in both directions */
+  goal = BuildGraph(gx, gy);
+  TEST_CHECK(MAZEG_ShortestRoute(&graph, &cost, 0, 0, goal, turns, NULL, sizeof(turns), &nofTurns, &fullMs)==ERR_OK);
+  TestNodeTimes(goal, fullMs);
+  TEST_CHECK(MAZEG_TremauxIsExplored(&graph, &cost, goal)); /* everything known */
+  TEST_CHECK(!MAZEG_TremauxIsExplored(&graph, &cost, MAZEG_NO_NODE)); /* goal not found yet */
+  segments = ExploreTremaux(gx, gy, &goal, &distMm[1]);
+  TEST_CHECK(segments>0);
+  TEST_CHECK(distMm[1]<=distMm[2]+distMm[2]/2); /* at most every line twice, then the route to the finish */
+  TEST_CHECK(goal!=MAZEG_NO_NODE);
+  if (segments<=0 || goal==MAZEG_NO_NODE) {
+    return;
+  }
+  TEST_CHECK(MAZEG_ShortestRoute(&graph, &cost, 0, 0, goal, turns, NULL, sizeof(turns), &nofTurns, &timeMs)==ERR_OK);
+  TEST_CHECK(timeMs==fullMs); /* stopped exploring only when no faster route was possible */
+  TEST_CHECK(DriveTime(turns, nofTurns, NULL, gx, gy)==timeMs);
+}
+
+static void TestUnreachable(void) {
+  uint8_t a, b, turns[4];
+  uint16_t nofTurns;
+
+  MAZEG_Clear(&graph);
+  (void)MAZEG_AddNode(&graph, 0, 0, 1, &a);
+  (void)MAZEG_AddNode(&graph, 1000, 0, 0, &b);
+  TEST_CHECK(a==0 && b==1);
+  TEST_CHECK(MAZEG_ShortestRoute(&graph, &cost, a, 0, b, turns, NULL, sizeof(turns), &nofTurns, NULL)==ERR_FAILED);
+  MAZEG_Link(&graph, a, 1, b, 1, 500); /* the start is no junction: we can not turn right there */
+  TEST_CHECK(MAZEG_ShortestRoute(&graph, &cost, a, 0, b, turns, NULL, sizeof(turns), &nofTurns, NULL)==ERR_FAILED);
+  TEST_CHECK(MAZEG_ShortestRoute(&graph, &cost, a, 1, b, turns, NULL, sizeof(turns), &nofTurns, NULL)==ERR_OK && nofTurns==0);
+  (void)MAZEG_AddNode(&graph, 40, -40, 0, &b); /* close to the start: same node */
+  TEST_CHECK(b==a && graph.nofNodes==2);
+}
+
+int main(void) {
+  int i, j, nofFaster = 0;
+  uint32_t distMm[3], sumMm[3] = {0, 0, 0};
+
+  srand(2);
+  TestUnreachable();
+  for(i=0;i<40;i++) {
+    (void)TestRoute(2+i%5, 2+(i*3)%6, 0);
+  }
+  for(i=0;i<100;i++) {
+    nofFaster += TestRoute(3+i%5, 3+(i*3)%5, 2+i%6);
+  }
+  printf("route faster than the left hand path in %d of 100 mazes with loops\n", nofFaster);
+  TEST_CHECK(nofFaster>=30);
+  for(i=0;i<40;i++) {
+    TestTremaux(2+i%5, 2+(i*3)%6, 0, distMm);
+  }
+  for(i=0;i<100;i++) {
+    TestTremaux(3+i%5, 3+(i*3)%5, 2+i%6, distMm);
+    for(j=0;j<3;j++) {
+      sumMm[j] += distMm[j];
+    }
+  }
+  printf("exploration of 100 mazes with loops: %u mm left hand rule, %u mm Tremaux with early stop, %u mm full Tremaux (average)\n",
+    (unsigned)(sumMm[0]/100), (unsigned)(sumMm[1]/100), (unsigned)(sumMm[2]/100));
+  TEST_CHECK(sumMm[1]<sumMm[2]); /* the early stop saves driving */
+  TEST_CHECK(sumMm[0]<sumMm[1]); /* the left hand rule stops in the finish, but its route is slower in most of these mazes */
+  return TEST_Result("TestMazeGraph");
+}
@@ -0,0 +1,278 @@
+/**
+ * \file
+ * \brief Host test of the maze path recording and simplification.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Explores generated mazes with the left hand rule and records the decisions like the robot,
+ * then drives the simplified path to the finish and back to the start.
+ * The finish is the corner opposite of the start.
+ * The solved paths are replayed with the speed profile of Maze.c and with a fixed speed, to compare the driving time.
+ */
+
+#include "MazePath.h"
+#include "TestUtil.h"
+#include "TestMaze.h"
+
+#define START_X   TMAZE_START_X
+#define START_Y   TMAZE_START_Y
+#define MAX_MOVES 4000
+#define CELL_MM       300 /* length of a cell */
+#define MARGIN_MM     40  /* the junction gets detected this much before the segment end, like in Maze.c */
+#define FIXED_PERCENT 50  /* default PID fw speed */
+#define SAFE_PERCENT  25  /* fastest fixed speed which reaches the turns with the junction speed of the profile */
+
+static TMAZE_Maze maze;
+static const MAZEP_Profile profile = {TRUE, 800, 250, 1500, 1500, 1000}; /* default profile of Maze.c */
+static uint32_t profileMs, safeMs, fixedMs; /* driving time of all replays */
+static int nofReplays, nofFaster;
+
+/*!
+ * \brief Returns the path code taken at a cell with the left hand rule, or -1 if there is no decision (line just continues ahead).
+ */
+static int LeftHandCode(int x, int y, int heading) {
+  int exits = TMAZE_LineExits(&maze, x, y);
+  int ahead = (exits&(1<<heading))!=0;
+  int right = (exits&(1<<((heading+1)&3)))!=0;
+  int left = (exits&(1<<((heading+3)&3)))!=0;
+
+  if (!TMAZE_IsJunction(&maze, x, y)) {
+    return -1;
+  }
+  if (left) {
+    return MAZEP_CODE_LEFT;
+  } else if (ahead) {
+    return MAZEP_CODE_STRAIGHT;
+  } else if (right) {
+    return MAZEP_CODE_RIGHT;
+  }
+  return MAZEP_CODE_UTURN;
+}
+
+static void Move(int *x, int *y, int heading) {
+  *x += TMAZE_dx[heading];
+  *y += TMAZE_dy[heading];
+}
+
+/*!
+ * \brief Explores the maze with the left hand rule from the start to the goal.
+ * \return Number of moves
+ */
+static int Explore(MAZEP_Path *path, int gx, int gy) {
+  int x = START_X, y = START_Y, heading = 0, moves = 0, code;
+
+  MAZEP_Clear(path);
+  while(moves<MAX_MOVES) {
+    Move(&x, &y, heading);
+    moves++;
+    if (x==gx && y==gy) {
+      return moves;
+    }
+    code = LeftHandCode(x, y, heading);
+    if (code>=0) {
+      TEST_CHECK(MAZEP_Add(path, (uint8_t)code)==ERR_OK);
+      heading = (heading+MAZEP_CodeToAngle((uint8_t)code)/90)&3;
+    }
+  }
+  return -1;
+}
+
+/*!
+ * \brief Drives a path like the robot: the next decision is taken at every cell with more than the line ahead.
+ * \param back TRUE to drive the path from the end to the start
+ * \param[out] arrival Heading when arriving at the target
+ * \return Number of moves to the target, or -1 if the path does not lead there
+ */
+static int Drive(const MAZEP_Path *path, bool back, int x, int y, int heading, int tx, int ty, int *arrival) {
+  int moves = 0;
+  uint16_t idx = 0;
+
+  while(moves<MAX_MOVES) {
+    if (!(TMAZE_LineExits(&maze, x, y)&(1<<heading))) {
+      return -1; /* no line in this direction */
+    }
+    Move(&x, &y, heading);
+    moves++;
+    if (x==tx && y==ty) {
+      *arrival = heading;
+      return idx==path->length ? moves : -1; /* all decisions used */
+    }
+    if (!TMAZE_IsJunction(&maze, x, y)) {
+      continue;
+    }
+    if (idx>=path->length) {
+      return -1; /* junction after the end of the path */
+    }
+    heading = (heading+MAZEP_CodeToAngle(back ? MAZEP_GetBackCode(path, idx) : MAZEP_GetCode(path, idx))/90)&3;
+    idx++;
+  }
+  return -1;
+}
+
+/*!
+ * \brief Calculates the segment lengths of a path, like the robot records them while exploring.
+ * \param segLen Length of the segment ending at each decision, path->length+1 entries
+ */
+static void SegmentLengths(const MAZEP_Path *path, uint16_t *segLen, int gx, int gy) {
+  int x = START_X, y = START_Y, heading = 0, moves = 0, cells = 0;
+  uint16_t idx = 0;
+
+  while(moves<MAX_MOVES) {
+    Move(&x, &y, heading);
+    moves++;
+    cells++;
+    if (x==gx && y==gy) {
+      segLen[idx] = (uint16_t)(cells*CELL_MM);
+      return;
+    }
+    if (TMAZE_IsJunction(&maze, x, y) && idx<path->length) {
+      segLen[idx] = (uint16_t)(cells*CELL_MM);
+      cells = 0;
+      heading = (heading+MAZEP_CodeToAngle(MAZEP_GetCode(path, idx))/90)&3;
+      idx++;
+    }
+  }
+}
+
+/*!
+ * \brief Drives a solved path with the speed control of the robot, in steps of 1 ms. Stops at every junction where we turn.
+ * \param back TRUE to drive the path from the end to the start
+ * \param percent Fixed speed in percent, or 0 for the speed profile
+ * \param[out] maxEntryMmS Highest speed within MARGIN_MM of a turn or the end of the path
+ * \return Driving time in ms, without the time for the turns
+ */
+static uint32_t Replay(const MAZEP_Path *path, const uint16_t *segLen, bool back, uint8_t percent, uint32_t *maxEntryMmS) {
+  uint32_t ms = 0, runMm, v, um, maxMmS = 0;
+  uint16_t seg = 0;
+
+  *maxEntryMmS = 0;
+  while(seg<=path->length) {
+    runMm = MAZEP_TurnDistMm(path, segLen, back, seg);
+    for(um=0;um<runMm*1000;um+=v) { /* mm/s times 1 ms is um */
+      if (percent!=0) {
+        v = (uint32_t)percent*profile.fullMmS/100;
+      } else {
+        v = (uint32_t)MAZEP_ProfileSpeedPercent(&profile, (int32_t)(um/1000), (int32_t)(runMm-um/1000)-MARGIN_MM)*profile.fullMmS/100;
+      }
+      if (v>maxMmS) {
+        maxMmS = v;
+      }
+      if (um/1000+MARGIN_MM>=runMm && v>*maxEntryMmS) {
+        *maxEntryMmS = v;
+      }
+      ms++;
+    }
+    while(seg<path->length && (back ? MAZEP_GetBackCode(path, seg) : MAZEP_GetCode(path, seg))==MAZEP_CODE_STRAIGHT) {
+      seg++; /* crossed without stopping */
+    }
+    seg++; /* after the turn */
+  }
+  TEST_CHECK(maxMmS<=profile.maxMmS);
+  return ms;
+}
+
+static void TestProfile(const MAZEP_Path *path, int gx, int gy) {
+  uint16_t segLen[MAZEP_MAX_PATH+1];
+  uint32_t ms, msSafe, entryMmS, entrySafeMmS, entryFixedMmS;
+  bool back;
+
+  SegmentLengths(path, segLen, gx, gy);
+  for(back=FALSE;back<=TRUE;back++) {
+    ms = Replay(path, segLen, back, 0, &entryMmS);
+    msSafe = Replay(path, segLen, back, SAFE_PERCENT, &entrySafeMmS);
+    fixedMs += Replay(path, segLen, back, FIXED_PERCENT, &entryFixedMmS);
+    TEST_CHECK(entryMmS<=profile.junctionMmS); /* slow enough for the turn when we see the junction */
+    TEST_CHECK(entrySafeMmS<=profile.junctionMmS);
+    TEST_CHECK(entryFixedMmS>profile.junctionMmS); /* too fast for the turns */
+    TEST_CHECK(ms<msSafe);
+    profileMs += ms;
+    safeMs += msSafe;
+    nofReplays++;
+    if (ms<msSafe) {
+      nofFaster++;
+    }
+  }
+}
+
+static void TestGenerated(int w, int h, int nofLoops) {
+  MAZEP_Path path;
+  int dist[TMAZE_MAX_SIZE][TMAZE_MAX_SIZE];
+  int gx = w-1, gy = h-1, explored, moves, arrival, startArrival;
+  uint16_t j;
+
+  TMAZE_Generate(&maze, w, h, nofLoops);
+  TMAZE_Distances(&maze, gx, gy, dist);
+  explored = Explore(&path, gx, gy);
+  TEST_CHECK(explored>0);
+  for(j=0;j<path.length;j++) {
+    TEST_CHECK(MAZEP_GetCode(&path, j)!=MAZEP_CODE_UTURN); /* all dead ends are cut */
+  }
+  moves = Drive(&path, FALSE, START_X, START_Y, 0, gx, gy, &arrival);
+  if (nofLoops==0) {
+    TEST_CHECK(moves==dist[0][0]+1); /* only one route without loops */
+  } else {
+    TEST_CHECK(moves>=dist[0][0]+1 && moves<=explored);
+  }
+  /* back from the finish, after the U turn there */
+  TEST_CHECK(Drive(&path, TRUE, gx, gy, (arrival+2)&3, START_X, START_Y, &startArrival)==moves);
+  TEST_CHECK(startArrival==2); /* back on the start line */
+  TestProfile(&path, gx, gy);
+}
+
+static void TestSimplify(void) {
+  static const struct {
+    uint8_t a, b, res;
+  } cases[] = {
+    {MAZEP_CODE_LEFT, MAZEP_CODE_LEFT, MAZEP_CODE_STRAIGHT},
+    {MAZEP_CODE_LEFT, MAZEP_CODE_STRAIGHT, MAZEP_CODE_RIGHT},
+    {MAZEP_CODE_STRAIGHT, MAZEP_CODE_LEFT, MAZEP_CODE_RIGHT},
+    {MAZEP_CODE_RIGHT, MAZEP_CODE_RIGHT, MAZEP_CODE_STRAIGHT},
+    {MAZEP_CODE_STRAIGHT, MAZEP_CODE_STRAIGHT, MAZEP_CODE_UTURN},
+    {MAZEP_CODE_RIGHT, MAZEP_CODE_STRAIGHT, MAZEP_CODE_LEFT},
+  };
+  MAZEP_Path path;
+  int i;
+
+  for(i=0;i<(int)(sizeof(cases)/sizeof(cases[0]));i++) {
+    MAZEP_Clear(&path);
+    (void)MAZEP_Add(&path, MAZEP_CODE_RIGHT);
+    (void)MAZEP_Add(&path, cases[i].a);
+    (void)MAZEP_Add(&path, MAZEP_CODE_UTURN);
+    TEST_CHECK(path.length==3);
+    (void)MAZEP_Add(&path, cases[i].b);
+    TEST_CHECK(path.length==2);
+    TEST_CHECK(MAZEP_GetCode(&path, 0)==MAZEP_CODE_RIGHT);
+    TEST_CHECK(MAZEP_GetCode(&path, 1)==cases[i].res);
+  }
+  /* a nested dead end: R U S U L becomes R (U S U L) -> (R U S) U L -> L U L -> S */
+  MAZEP_Clear(&path);
+  (void)MAZEP_Add(&path, MAZEP_CODE_RIGHT);
+  (void)MAZEP_Add(&path, MAZEP_CODE_UTURN);
+  (void)MAZEP_Add(&path, MAZEP_CODE_STRAIGHT);
+  (void)MAZEP_Add(&path, MAZEP_CODE_UTURN);
+  (void)MAZEP_Add(&path, MAZEP_CODE_LEFT);
+  TEST_CHECK(path.length==1 && MAZEP_GetCode(&path, 0)==MAZEP_CODE_STRAIGHT);
+  /* full path */
+  MAZEP_Clear(&path);
+  for(i=0;i<MAZEP_MAX_PATH;i++) {
+    TEST_CHECK(MAZEP_Add(&path, MAZEP_CODE_STRAIGHT)==ERR_OK);
+  }
+  TEST_CHECK(MAZEP_Add(&path, MAZEP_CODE_LEFT)==ERR_OVERFLOW);
+  TEST_CHECK(path.length==MAZEP_MAX_PATH);
+}
+
+int main(void) {
+  int i;
+
+  srand(1);
+  TestSimplify();
+  for(i=0;i<50;i++) {
+    TestGenerated(2+i%7, 2+(i*3)%9, 0);
+  }
+  for(i=0;i<50;i++) {
+    TestGenerated(3+i%6, 3+(i*5)%7, 1+i%4);
+  }
+  printf("solved path replay: %u ms with the speed profile, %u ms at %d%% (profile faster in %d of %d replays), %u ms at %d%% with too fast turns\n",
+    (unsigned)(profileMs/nofReplays), (unsigned)(safeMs/nofReplays), SAFE_PERCENT, nofFaster, nofReplays, (unsigned)(fixedMs/nofReplays), FIXED_PERCENT);
+  TEST_CHECK(profileMs<safeMs);
+  return TEST_Result("TestMazePath");
+}
@@ -0,0 +1,381 @@
+/**
+ * \file
+ * \brief Host test of the staged motor commits.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The PWM and direction components are replaced by fakes which log every write,
+ * and the PWM timer is a fake counter which advances with every read.
+ * The slew and jerk limits are checked on the signed duty of a sequence of commits.
+ */
+
+#include "Motor.h"
+#include "DIRL.h"
+#include "DIRR.h"
+#include "PWML.h"
+#include "PWMR.h"
+#include "Tacho.h"
+#include "FRTOS1.h"
+#include "TestUtil.h"
+#include <stdlib.h>
+
+#define PWM_OFF         0xFFFF /* zero duty, H-Bridge is low active */
+#define TIMER_MODULO    999    /* fake timer counts 0..999 */
+#define TIMER_STEP      7      /* counter increment for each read */
+
+/* fake timer */
+static uint32_t timerCounter, timerPeriod;
+
+static uint32_t FakeReadCounter(void) {
+  timerCounter += TIMER_STEP;
+  if (timerCounter>TIMER_MODULO) {
+    timerCounter -= TIMER_MODULO+1;
+    timerPeriod++;
+  }
+  return timerCounter;
+}
+
+static uint32_t FakeReadModulo(void) {
+  return TIMER_MODULO;
+}
+
+static const MOT_PwmTimer fakeTimer = {
+  FakeReadCounter,
+  FakeReadModulo
+};
+
+/* log of the hardware writes */
+typedef struct {
+  uint16_t val;        /* last value written */
+  uint32_t counter;    /* timer counter at the last write */
+  uint32_t period;     /* timer period at the last write */
+  int nofWrites;       /* number of writes since the last reset */
+  bool dir;            /* last value of the direction pin */
+  uint16_t valAtDir;   /* PWM value when the direction pin was written */
+  int nofDirWrites;
+} Channel;
+
+static Channel chL, chR;
+static TickType_t tickCount;
+
+static void Write(Channel *ch, uint16_t ratio) {
+  ch->val = ratio;
+  ch->counter = timerCounter;
+  ch->period = timerPeriod;
+  ch->nofWrites++;
+}
+
+static void Dir(Channel *ch, bool val) {
+  ch->dir = val;
+  ch->valAtDir = ch->val;
+  ch->nofDirWrites++;
+}
+
+uint8_t PWML_SetRatio16(uint16_t ratio) { Write(&chL, ratio); return ERR_OK; }
+uint8_t PWMR_SetRatio16(uint16_t ratio) { Write(&chR, ratio); return ERR_OK; }
+uint8_t PWML_Enable(void) { return ERR_OK; }
+uint8_t PWMR_Enable(void) { return ERR_OK; }
+void DIRL_PutVal(bool val) { Dir(&chL, val); }
+void DIRR_PutVal(bool val) { Dir(&chR, val); }
+int32_t TACHO_GetSpeed(bool isLeft) { return 0; }
+TickType_t FRTOS1_xTaskGetTickCount(void) { return tickCount; }
+
+static void ResetLog(void) {
+  chL.nofWrites = chR.nofWrites = 0;
+  chL.nofDirWrites = chR.nofDirWrites = 0;
+}
+
+static void Commit(void) {
+  tickCount += MOT_COMMIT_PERIOD_MS;
+  MOT_CommitStaged();
+}
+
+static void NoRateLimit(void) {
+  MOT_GetMotorHandle(MOT_MOTOR_LEFT)->slewRate = 0;
+  MOT_GetMotorHandle(MOT_MOTOR_RIGHT)->slewRate = 0;
+  MOT_GetMotorHandle(MOT_MOTOR_LEFT)->jerkRate = 0;
+  MOT_GetMotorHandle(MOT_MOTOR_RIGHT)->jerkRate = 0;
+}
+
+/* both channels get written in the same PWM period, outside of the last quarter */
+static void TestReloadWindow(void) {
+  MOT_MotorDevice *left = MOT_GetMotorHandle(MOT_MOTOR_LEFT);
+  MOT_MotorDevice *right = MOT_GetMotorHandle(MOT_MOTOR_RIGHT);
+
+  NoRateLimit();
+  /* counter at the end of the period: the commit has to wait for the reload */
+  timerCounter = 950;
+  timerPeriod = 0;
+  ResetLog();
+  MOT_StageVal(left, 0x8000, MOT_DIR_FORWARD);
+  MOT_StageVal(right, 0x4000, MOT_DIR_FORWARD);
+  Commit();
+  TEST_CHECK(chL.nofWrites==1 && chR.nofWrites==1);
+  TEST_CHECK(chL.val==0x8000 && chR.val==0x4000);
+  TEST_CHECK(chL.period==1 && chR.period==1);
+  TEST_CHECK(chL.counter<=TIMER_MODULO-TIMER_MODULO/4);
+  TEST_CHECK(chR.counter<=TIMER_MODULO-TIMER_MODULO/4);
+
+  /* counter early in the period: written without waiting */
+  timerCounter = 100;
+  timerPeriod = 5;
+  ResetLog();
+  MOT_StageVal(left, 0x9000, MOT_DIR_FORWARD);
+  MOT_StageVal(right, 0x9000, MOT_DIR_FORWARD);
+  Commit();
+  TEST_CHECK(chL.period==5 && chR.period==5);
+  TEST_CHECK(chL.counter==100+TIMER_STEP);
+
+  /* nothing staged: no write at all */
+  ResetLog();
+  Commit();
+  TEST_CHECK(chL.nofWrites==0 && chR.nofWrites==0);
+
+  /* without a shared timer the commit does not wait */
+  MOT_SetPwmTimer(NULL);
+  timerCounter = 950;
+  timerPeriod = 0;
+  MOT_StageVal(left, 0x8000, MOT_DIR_FORWARD);
+  Commit();
+  TEST_CHECK(chL.val==0x8000 && chL.period==0 && timerCounter==950);
+  MOT_SetPwmTimer(&fakeTimer);
+}
+
+/* a reversal passes through zero duty, and the direction pin only changes at zero duty */
+static void TestReversal(void) {
+  MOT_MotorDevice *left = MOT_GetMotorHandle(MOT_MOTOR_LEFT);
+
+  NoRateLimit();
+  MOT_StageVal(left, 0x8000, MOT_DIR_FORWARD);
+  Commit();
+  TEST_CHECK(chL.val==0x8000 && left->currDirection==MOT_DIR_FORWARD);
+
+  ResetLog();
+  MOT_StageVal(left, 0x8000, MOT_DIR_BACKWARD);
+  Commit(); /* first step: zero duty, direction unchanged */
+  TEST_CHECK(chL.val==PWM_OFF);
+  TEST_CHECK(chL.nofDirWrites==0);
+  TEST_CHECK(left->currDirection==MOT_DIR_FORWARD);
+  TEST_CHECK(left->isStaged);
+  Commit(); /* second step: direction and new duty */
+  TEST_CHECK(chL.nofDirWrites==1);
+  TEST_CHECK(chL.valAtDir==PWM_OFF);
+  TEST_CHECK(chL.val==0x8000);
+  TEST_CHECK(left->currDirection==MOT_DIR_BACKWARD);
+  TEST_CHECK(!left->isStaged);
+
+  /* the other motor has not been touched */
+  TEST_CHECK(chR.nofDirWrites==0);
+}
+
+/*!
+ * \brief Returns the signed duty of a motor, -0xFFFF (full backward) to 0xFFFF (full forward).
+ */
+static int32_t Duty(MOT_MotorDevice *motor) {
+  int32_t duty;
+
+  duty = PWM_OFF-motor->currPWMvalue;
+  return motor->currDirection==MOT_DIR_BACKWARD ? -duty : duty;
+}
+
+static void Stage(MOT_MotorDevice *motor, int32_t duty) {
+  if (duty<0) {
+    MOT_StageVal(motor, (uint16_t)(PWM_OFF+duty), MOT_DIR_BACKWARD);
+  } else {
+    MOT_StageVal(motor, (uint16_t)(PWM_OFF-duty), MOT_DIR_FORWARD);
+  }
+}
+
+static void SetLimits(uint32_t slewRate, uint32_t jerkRate) {
+  MOT_MotorDevice *left = MOT_GetMotorHandle(MOT_MOTOR_LEFT);
+
+  left->slewRate = slewRate;
+  left->jerkRate = jerkRate;
+  MOT_SetVal(left, PWM_OFF);
+  MOT_SetDirection(left, MOT_DIR_FORWARD);
+}
+
+/* the slew rate bounds the duty change per time, also with a different commit period and with a reversal */
+static void TestSlewRate(void) {
+  MOT_MotorDevice *left = MOT_GetMotorHandle(MOT_MOTOR_LEFT);
+  int32_t prev, maxStep, maxChange;
+  int i, nofCommits;
+
+  SetLimits(2000, 0); /* full duty in 50 ms */
+  maxStep = (2000*0xFFFF*MOT_COMMIT_PERIOD_MS)/(100*1000);
+  Stage(left, 0xFFFF);
+  prev = Duty(left);
+  maxChange = 0;
+  for(nofCommits=0; nofCommits<100 && left->isStaged; nofCommits++) {
+    Commit();
+    if (abs(Duty(left)-prev)>maxChange) {
+      maxChange = abs(Duty(left)-prev);
+    }
+    prev = Duty(left);
+  }
+  TEST_CHECK(Duty(left)==0xFFFF);
+  TEST_CHECK(maxChange<=maxStep);
+  TEST_CHECK(nofCommits>=10 && nofCommits<=11); /* 50 ms */
+
+  /* full reversal: bounded and through zero */
+  Stage(left, -0xFFFF);
+  maxChange = 0;
+  for(nofCommits=0; nofCommits<100 && left->isStaged; nofCommits++) {
+    Commit();
+    if (abs(Duty(left)-prev)>maxChange) {
+      maxChange = abs(Duty(left)-prev);
+    }
+    prev = Duty(left);
+  }
+  TEST_CHECK(Duty(left)==-0xFFFF);
+  TEST_CHECK(maxChange<=maxStep);
+  TEST_CHECK(nofCommits>=20 && nofCommits<=23); /* 100 ms, plus the zero duty commit */
+
+  /* commits every 10 ms: twice the step, the same time */
+  Stage(left, 0);
+  for(nofCommits=0; nofCommits<100 && left->isStaged; nofCommits++) {
+    tickCount += 2*MOT_COMMIT_PERIOD_MS;
+    MOT_CommitStaged();
+    TEST_CHECK(abs(Duty(left)-prev)<=2*maxStep);
+    prev = Duty(left);
+  }
+  TEST_CHECK(Duty(left)==0);
+  TEST_CHECK(nofCommits>=5 && nofCommits<=6);
+
+  /* two controllers committing in the same tick do not double the rate */
+  Stage(left, 0xFFFF);
+  for(i=0;i<5;i++) {
+    Commit();
+    MOT_CommitStaged();
+  }
+  TEST_CHECK(Duty(left)<=5*maxStep);
+
+  /* after a pause, the first commit is not a jump */
+  Stage(left, -0xFFFF);
+  tickCount += 1000;
+  prev = Duty(left);
+  MOT_CommitStaged();
+  TEST_CHECK(abs(Duty(left)-prev)<=4*maxStep);
+}
+
+/* the jerk rate bounds the change of the slope and the ramp ends at the target without overshoot */
+static void TestJerkRate(void) {
+  MOT_MotorDevice *left = MOT_GetMotorHandle(MOT_MOTOR_LEFT);
+  int32_t prev, step, prevStep, maxSlope, maxJerk, target;
+  int i, nofCommits;
+  bool overshoot;
+
+  SetLimits(2000, 40000); /* full slope after 50 ms */
+  maxSlope = (2000*0xFFFF*MOT_COMMIT_PERIOD_MS)/(100*1000);
+  maxJerk = (int32_t)((40000LL*0xFFFF*MOT_COMMIT_PERIOD_MS*MOT_COMMIT_PERIOD_MS)/(100*1000*1000));
+  srand(1);
+  prev = Duty(left);
+  prevStep = 0;
+  for(i=0;i<20;i++) { /* random targets as they come from a controller */
+    target = (rand()%(2*0xFFFF))-0xFFFF;
+    if (Duty(left)<0 && target>0) {
+      target = -target; /* reversals are tested with the slew rate, they have a zero duty step */
+    } else if (Duty(left)>0 && target<0) {
+      target = -target;
+    }
+    Stage(left, target);
+    overshoot = FALSE;
+    for(nofCommits=0; nofCommits<200 && left->isStaged; nofCommits++) {
+      Commit();
+      step = Duty(left)-prev;
+      TEST_CHECK(abs(step)<=maxSlope);
+      TEST_CHECK(abs(step-prevStep)<=maxJerk+1);
+      if ((target>=prev && Duty(left)>target) || (target<prev && Duty(left)<target)) {
+        overshoot = TRUE;
+      }
+      prev = Duty(left);
+      prevStep = step;
+    }
+    TEST_CHECK(!overshoot);
+    TEST_CHECK(Duty(left)==target);
+  }
+}
+
+/* a direct value (stop) discards a staged ramp, so a later commit does not continue it */
+static void TestStopDiscardsRamp(void) {
+  MOT_MotorDevice *left = MOT_GetMotorHandle(MOT_MOTOR_LEFT);
+  int i;
+
+  SetLimits(2000, 0);
+  Stage(left, 0xFFFF);
+  Commit();
+  TEST_CHECK(Duty(left)>0 && left->isStaged);
+  MOT_SetSpeedPercent(left, 0);
+  TEST_CHECK(!left->isStaged);
+  for(i=0;i<20;i++) {
+    Commit();
+  }
+  TEST_CHECK(Duty(left)==0);
+  TEST_CHECK(chL.val==PWM_OFF);
+}
+
+/*!
+ * \brief Simulated lap: the left motor follows the duty of a controller on a track with straights and curves,
+ * with a first order motor.
+ * \param[out] lapError Sum of the speed error over the lap, in 0.1% of the full speed
+ * \param[out] endError Largest speed error at the end of a track section
+ * \return Largest motor current (duty minus back-EMF) in duty units
+ */
+static int32_t SimulateLap(uint32_t slewRate, uint32_t jerkRate, int32_t *lapError, int32_t *endError) {
+  MOT_MotorDevice *left = MOT_GetMotorHandle(MOT_MOTOR_LEFT);
+  int32_t speed = 0, current, maxCurrent = 0, target;
+  int t;
+
+  SetLimits(slewRate, jerkRate);
+  *lapError = 0;
+  *endError = 0;
+  for(t=0;t<2000;t+=MOT_COMMIT_PERIOD_MS) { /* 2 s lap */
+    if ((t/250)%4==0) {
+      target = 0xFFFF; /* straight */
+    } else if ((t/250)%4==1) {
+      target = 0x4000; /* curve, inner wheel */
+    } else if ((t/250)%4==2) {
+      target = 0xFFFF;
+    } else {
+      target = -0x2000; /* hairpin: inner wheel backward */
+    }
+    Stage(left, target);
+    Commit();
+    current = Duty(left)-speed; /* current is proportional to the voltage not compensated by the back-EMF */
+    if (abs(current)>maxCurrent) {
+      maxCurrent = abs(current);
+    }
+    speed += (Duty(left)-speed)/4; /* motor time constant of 4 periods (20 ms) */
+    *lapError += abs(target-speed)*1000/0xFFFF;
+    if ((t+MOT_COMMIT_PERIOD_MS)%250==0 && abs(target-speed)>*endError) {
+      *endError = abs(target-speed);
+    }
+  }
+  return maxCurrent;
+}
+
+static void TestSimulatedLap(void) {
+  int32_t currentNoLimit, currentLimit, errorNoLimit, errorLimit, endErrorNoLimit, endErrorLimit;
+
+  currentNoLimit = SimulateLap(0, 0, &errorNoLimit, &endErrorNoLimit);
+  currentLimit = SimulateLap(2000, 40000, &errorLimit, &endErrorLimit);
+  printf("simulated lap: peak current %ld%% without and %ld%% with limits, integrated speed error %ld.%ld %%*s without and %ld.%ld %%*s with limits\n",
+    (long)(currentNoLimit*100/0xFFFF), (long)(currentLimit*100/0xFFFF),
+    (long)(errorNoLimit*MOT_COMMIT_PERIOD_MS/10000), (long)(errorNoLimit*MOT_COMMIT_PERIOD_MS/1000%10),
+    (long)(errorLimit*MOT_COMMIT_PERIOD_MS/10000), (long)(errorLimit*MOT_COMMIT_PERIOD_MS/1000%10));
+  TEST_CHECK(currentLimit<currentNoLimit/3); /* the limits cut the current peaks to less than a third */
+  TEST_CHECK(errorLimit>errorNoLimit); /* at the price of a slower response */
+  TEST_CHECK(endErrorNoLimit<0xFFFF/100); /* but the speed still settles within each track section */
+  TEST_CHECK(endErrorLimit<0xFFFF/100);
+}
+
+int main(void) {
+  MOT_Init();
+  MOT_SetPwmTimer(&fakeTimer);
+  TestReloadWindow();
+  TestReversal();
+  TestSlewRate();
+  TestJerkRate();
+  TestStopDiscardsRamp();
+  TestSimulatedLap();
+  return TEST_Result("TestMotor");
+}
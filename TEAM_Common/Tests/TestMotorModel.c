@@ -0,0 +1,106 @@
+/**
+ * \file
+ * \brief Host test of the motor model fit.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Generates encoder positions of a first order motor with dead time, and checks that the fit finds the model again.
+ */
+
+#include <math.h>
+#include "MotorModel.h"
+#include "TestUtil.h"
+
+#define PERIOD_MS     5   /* sample period of 'motor characterize' */
+#define NOF_SAMPLES   200 /* one second */
+
+/*!
+ * \brief Creates the encoder positions of a step response.
+ * \param speed Final speed in steps/s, negative for an encoder counting backward
+ * \param tauMs Time constant
+ * \param deadTimeMs Dead time
+ * \param noise Maximum position noise in steps (pseudo random)
+ */
+static void StepResponse(int16_t *pos, double speed, double tauMs, double deadTimeMs, int noise) {
+  int i;
+  double t, p;
+  unsigned seed = 12345;
+
+  for(i=0;i<NOF_SAMPLES;i++) {
+    t = i*PERIOD_MS-deadTimeMs;
+    if (t<=0) {
+      p = 0;
+    } else {
+      /* integral of speed*(1-exp(-t/tau)) */
+      p = speed*(t-tauMs*(1-exp(-t/tauMs)))/1000;
+    }
+    if (noise!=0) {
+      seed = seed*1103515245u+12345u;
+      p += (int)((seed>>16)%(2*noise+1))-noise;
+    }
+    pos[i] = (int16_t)floor(p+0.5); /* the encoder only counts whole steps */
+  }
+}
+
+static void TestFitStep(double speed, double tauMs, double deadTimeMs, int noise, double tolTauMs, double tolDeadMs) {
+  int16_t pos[NOF_SAMPLES], speedLog[NOF_SAMPLES];
+  MOTM_Model model;
+
+  StepResponse(pos, speed, tauMs, deadTimeMs, noise);
+  MOTM_PosToSpeed(pos, speedLog, NOF_SAMPLES, PERIOD_MS);
+  TEST_CHECK_NEAR(speedLog[NOF_SAMPLES/2], speed, fabs(speed)/50+4*noise*1000/PERIOD_MS/4);
+  TEST_CHECK(MOTM_FitStep(speedLog, NOF_SAMPLES, PERIOD_MS, &model)==ERR_OK);
+  TEST_CHECK_NEAR(model.tauMs, tauMs, tolTauMs);
+  TEST_CHECK_NEAR(model.deadTimeMs, deadTimeMs, tolDeadMs);
+}
+
+static void TestStep(void) {
+  int16_t pos[NOF_SAMPLES], speedLog[NOF_SAMPLES];
+  MOTM_Model model;
+
+  TestFitStep(2000, 40, 15, 0, 4, 4);    /* typical motor */
+  TestFitStep(2000, 80, 0, 0, 6, 4);     /* slow motor, no dead time */
+  TestFitStep(-1500, 40, 10, 0, 4, 4);   /* encoder counting backward */
+  TestFitStep(2500, 30, 20, 1, 6, 5);    /* with one step of encoder noise */
+
+  /* no movement: no model */
+  StepResponse(pos, 0, 40, 10, 0);
+  MOTM_PosToSpeed(pos, speedLog, NOF_SAMPLES, PERIOD_MS);
+  TEST_CHECK(MOTM_FitStep(speedLog, NOF_SAMPLES, PERIOD_MS, &model)==ERR_FAILED);
+  /* too few samples */
+  TEST_CHECK(MOTM_FitStep(speedLog, 4, PERIOD_MS, &model)==ERR_FAILED);
+}
+
+static void TestStaticCurve(void) {
+  MOTM_LineFit fit;
+  MOTM_Model model;
+  int32_t duty, speed;
+
+  /* motor with 30 (steps/s)/% above a deadband of 12%, fit over 20..100% */
+  MOTM_LineFitInit(&fit);
+  for(duty=2000;duty<=10000;duty+=250) {
+    speed = (30*(duty-1200))/100;
+    speed += (duty/250)%3-1; /* some noise */
+    MOTM_LineFitAdd(&fit, duty, speed);
+  }
+  TEST_CHECK(MOTM_LineFitGet(&fit, &model)==ERR_OK);
+  TEST_CHECK_NEAR(model.gainX100, 3000, 15);
+  TEST_CHECK_NEAR(model.offset, -30*12, 5);
+
+  /* feed forward is the inverse of the static curve */
+  TEST_CHECK_NEAR(MOTM_SpeedToDutyX100(&model, 1500), 6200, 20);
+  TEST_CHECK_NEAR(MOTM_SpeedToDutyX100(&model, 0), 1200, 20);
+  TEST_CHECK(MOTM_SpeedToDutyX100(&model, 100000)==10000); /* limited */
+  TEST_CHECK(MOTM_SpeedToDutyX100(&model, -1000)==0);
+
+  /* all samples at the same duty: no line */
+  MOTM_LineFitInit(&fit);
+  MOTM_LineFitAdd(&fit, 5000, 1000);
+  MOTM_LineFitAdd(&fit, 5000, 1010);
+  TEST_CHECK(MOTM_LineFitGet(&fit, &model)==ERR_FAILED);
+}
+
+int main(void) {
+  TestStep();
+  TestStaticCurve();
+  return TEST_Result("TestMotorModel");
+}
@@ -0,0 +1,154 @@
+/**
+ * \file
+ * \brief Host test of the odometry.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Drives known encoder sequences (straights, arcs and spins) through ODO_Update() and compares the pose with the exact geometry.
+ */
+
+#include <math.h>
+#include "Odometry.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#include "TestUtil.h"
+
+#define TICKS_PER_M     10370.0 /* default calibration of Odometry.c */
+#define WHEEL_BASE_M    0.086
+#define PI              3.14159265358979323846
+
+Q4CLeft_QuadCntrType Q4CLeft_Pos;
+Q4CRight_QuadCntrType Q4CRight_Pos;
+
+/* exact pose of the simulated robot, in meters and radians */
+static double simX, simY, simHeading;
+
+/*!
+ * \brief Moves the wheels by a number of ticks in small steps, as the 5 ms drive loop would see them.
+ */
+static void Drive(int32_t ticksL, int32_t ticksR, int nofSteps) {
+  int i;
+  int32_t l, r, prevL = 0, prevR = 0;
+  double dL, dR, dHeading;
+
+  for(i=1;i<=nofSteps;i++) {
+    l = (int32_t)(((int64_t)ticksL*i)/nofSteps);
+    r = (int32_t)(((int64_t)ticksR*i)/nofSteps);
+    Q4CLeft_Pos += (Q4CLeft_QuadCntrType)(l-prevL);
+    Q4CRight_Pos += (Q4CRight_QuadCntrType)(r-prevR);
+    dL = (l-prevL)/TICKS_PER_M;
+    dR = (r-prevR)/TICKS_PER_M;
+    prevL = l;
+    prevR = r;
+    dHeading = (dR-dL)/WHEEL_BASE_M;
+    simX += (dL+dR)/2*cos(simHeading+dHeading/2);
+    simY += (dL+dR)/2*sin(simHeading+dHeading/2);
+    simHeading += dHeading;
+    ODO_Update();
+  }
+}
+
+/*!
+ * \brief Returns the heading error in degrees, wrapped to +/-180 degrees.
+ */
+static double HeadingErrorDeg(const ODO_Pose *pose) {
+  double err;
+
+  err = ODO_AngleToCentiDeg(pose->heading)/100.0-simHeading*180/PI;
+  err = fmod(err, 360);
+  if (err>180) {
+    err -= 360;
+  } else if (err<-180) {
+    err += 360;
+  }
+  return err;
+}
+
+static void CheckPose(double tolMm, double tolDeg) {
+  ODO_Pose pose;
+
+  ODO_GetPose(&pose);
+  TEST_CHECK_NEAR(pose.xUm/1000.0, simX*1000, tolMm);
+  TEST_CHECK_NEAR(pose.yUm/1000.0, simY*1000, tolMm);
+  TEST_CHECK_NEAR(HeadingErrorDeg(&pose), 0, tolDeg);
+}
+
+static void Reset(void) {
+  ODO_ResetPose();
+  ODO_Update();
+  simX = simY = simHeading = 0;
+}
+
+static void TestStraight(void) {
+  ODO_Pose pose;
+
+  Reset();
+  Drive(10370, 10370, 200); /* 1 m forward */
+  ODO_GetPose(&pose);
+  TEST_CHECK_NEAR(pose.xUm, 1000000, 100);
+  TEST_CHECK_NEAR(pose.yUm, 0, 1);
+  TEST_CHECK(pose.heading==0);
+  TEST_CHECK_NEAR(pose.distUm, 1000000, 100);
+  Drive(-5185, -5185, 100); /* half of it backward */
+  ODO_GetPose(&pose);
+  TEST_CHECK_NEAR(pose.xUm, 500000, 100);
+  TEST_CHECK_NEAR(pose.distUm, 500000, 100);
+}
+
+static void TestSpin(void) {
+  ODO_Pose pose;
+  int32_t ticks;
+
+  Reset();
+  ticks = (int32_t)(PI*WHEEL_BASE_M/4*TICKS_PER_M+0.5); /* quarter turn counter-clockwise on the spot */
+  Drive(-ticks, ticks, 50);
+  ODO_GetPose(&pose);
+  TEST_CHECK_NEAR(pose.xUm, 0, 1);
+  TEST_CHECK_NEAR(pose.yUm, 0, 1);
+  TEST_CHECK_NEAR(ODO_AngleToCentiDeg(pose.heading), 9000, 10);
+  CheckPose(0.01, 0.05);
+  Drive(ticks*3, -ticks*3, 150); /* three quarters clockwise */
+  CheckPose(0.01, 0.05);
+  ODO_GetPose(&pose);
+  TEST_CHECK_NEAR(ODO_AngleToCentiDeg(pose.heading), -18000, 30); /* -180 degree, can wrap to +180 */
+}
+
+static void TestArc(void) {
+  double radius = 0.2; /* quarter circle to the left with 200 mm radius */
+
+  Reset();
+  Drive((int32_t)(PI/2*(radius-WHEEL_BASE_M/2)*TICKS_PER_M), (int32_t)(PI/2*(radius+WHEEL_BASE_M/2)*TICKS_PER_M), 100);
+  CheckPose(0.5, 0.1);
+  TEST_CHECK_NEAR(simX*1000, 200, 1); /* the simulation itself ends at (200, 200) mm */
+  TEST_CHECK_NEAR(simY*1000, 200, 1);
+  /* and the same to the right, driving backward */
+  Drive(-(int32_t)(PI/2*(radius+WHEEL_BASE_M/2)*TICKS_PER_M), -(int32_t)(PI/2*(radius-WHEEL_BASE_M/2)*TICKS_PER_M), 100);
+  CheckPose(0.5, 0.1);
+}
+
+static void TestSquareLoop(void) {
+  int i;
+  int32_t spin;
+
+  Reset();
+  spin = (int32_t)(PI*WHEEL_BASE_M/4*TICKS_PER_M+0.5);
+  for(i=0;i<20;i++) { /* 20 laps of a 0.5 m square: accumulated error stays small */
+    Drive(5185, 5185, 100);
+    Drive(-spin, spin, 30);
+    Drive(5185, 5185, 100);
+    Drive(-spin, spin, 30);
+    Drive(5185, 5185, 100);
+    Drive(-spin, spin, 30);
+    Drive(5185, 5185, 100);
+    Drive(-spin, spin, 30);
+  }
+  CheckPose(1, 0.1);
+}
+
+int main(void) {
+  ODO_Init();
+  TestStraight();
+  TestSpin();
+  TestArc();
+  TestSquareLoop();
+  return TEST_Result("TestOdometry");
+}
@@ -0,0 +1,73 @@
+/**
+ * \file
+ * \brief Host test of the turn timing model.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Checks the estimates against the closed form kinematics, and compares rolling turns with turns on the spot
+ * over the line speed, as done on the robot with 'turn bench'.
+ */
+
+#include <math.h>
+#include "TurnModel.h"
+#include "TestUtil.h"
+
+/* values of the robot: TURN_STEPS_90, TURN_ROLL_SPEED, TURN_ROLL_RADIUS_PERCENT and TURN_STEPS_STOP_TIMEOUT_MS of Turn.c,
+ * the twist acceleration DRV_TWIST_DEFAULT_ACCEL_V of Drive.c, and 60% (the position PID limit) of DRV_TWIST_MAX_WHEEL_SPEED for the spin */
+static const TURNM_Params params = {700, 800, 100, 2400, 8000, 150};
+
+static void TestKinematics(void) {
+  double base;
+
+  base = 700*4/M_PI;
+  TEST_CHECK_NEAR(TURNM_WheelBaseSteps(700), base, 1);
+  /* 90 degree arc with radius = base: base*pi/2 at 800 steps/s */
+  TEST_CHECK_NEAR(TURNM_RollArcMs(700, 2*700, 100, 800), base*M_PI/2/800*1000, 1);
+  TEST_CHECK(TURNM_RollArcMs(700, -2*700, 100, 800)==TURNM_RollArcMs(700, 2*700, 100, 800));
+  TEST_CHECK_NEAR(TURNM_RollArcMs(700, 2*700, 50, 800), base*M_PI/4/800*1000, 1);
+  /* triangle: 1000 steps at 8000 steps/s^2 reach 2828 steps/s, t = 2*sqrt(s/a) */
+  TEST_CHECK_NEAR(TURNM_MoveMs(1000, 4000, 8000), 2*sqrt(1000.0/8000)*1000, 2);
+  TEST_CHECK(TURNM_MoveMs(-1000, 4000, 8000)==TURNM_MoveMs(1000, 4000, 8000));
+  /* trapezoid: 700 steps with 1000 steps/s, 125 ms to accelerate and to brake */
+  TEST_CHECK_NEAR(TURNM_MoveMs(700, 1000, 8000), 700+125, 1);
+  /* both meet where the maximum speed is just reached */
+  TEST_CHECK_NEAR(TURNM_MoveMs(500, 2000, 8000), TURNM_MoveMs(501, 4000, 8000), 2);
+}
+
+static void TestRollVsSpot(void) {
+  TURNM_Params slow;
+  int32_t speed, roll, spot, crossover;
+
+  /* rolling at the roll speed is only the arc */
+  TEST_CHECK(TURNM_RollTimeMs(&params, 1, params.rollSpeed)==TURNM_RollArcMs(700, 2*700, 100, 800));
+  /* the wait for the stop is capped by the timeout: braking from 800 steps/s takes 100 ms, from 2400 steps/s 300 ms */
+  slow = params;
+  slow.stopTimeoutMs = 1000;
+  TEST_CHECK(TURNM_SpotTimeMs(&slow, 1, 800)==TURNM_SpotTimeMs(&params, 1, 800));
+  TEST_CHECK(TURNM_SpotTimeMs(&slow, 1, 2400)-TURNM_SpotTimeMs(&params, 1, 2400)==300-150);
+  /* a u-turn spins twice as far, the rolling u-turn drives the double arc */
+  TEST_CHECK(TURNM_SpotTimeMs(&params, 2, 800)>TURNM_SpotTimeMs(&params, 1, 800));
+  TEST_CHECK_NEAR(TURNM_RollTimeMs(&params, 2, 800), 2*TURNM_RollTimeMs(&params, 1, 800), 1);
+
+  printf("90 degree turn: line speed, rolling, on the spot (ms)\n");
+  crossover = 0;
+  for(speed=400;speed<=4000;speed+=400) {
+    roll = TURNM_RollTimeMs(&params, 1, speed);
+    spot = TURNM_SpotTimeMs(&params, 1, speed);
+    printf("  %4d steps/s: %5d %5d\n", (int)speed, (int)roll, (int)spot);
+    if (crossover==0 && spot<roll) {
+      crossover = speed;
+    }
+  }
+  /* at the line following speeds of the maze the arc wins, the stop and restart only pay off when driving much faster */
+  TEST_CHECK(TURNM_RollTimeMs(&params, 1, 800)<TURNM_SpotTimeMs(&params, 1, 800));
+  TEST_CHECK(TURNM_RollTimeMs(&params, 1, 1600)<TURNM_SpotTimeMs(&params, 1, 1600));
+  TEST_CHECK(crossover>1600);
+  TEST_CHECK(TURNM_RollTimeMs(&params, 1, 4000)>TURNM_SpotTimeMs(&params, 1, 4000));
+  printf("turns on the spot are faster from %d steps/s\n", (int)crossover);
+}
+
+int main(void) {
+  TestKinematics();
+  TestRollVsSpot();
+  return TEST_Result("TestTurnModel");
+}
@@ -0,0 +1,48 @@
+/**
+ * \file
+ * \brief Minimal check macros for the host tests.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Each test is a program of its own: failed checks are reported with file and line,
+ * TEST_Result() prints the summary and returns the exit code for make.
+ */
+
+#ifndef TESTUTIL_H_
+#define TESTUTIL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int TEST_nofChecks = 0;
+static int TEST_nofFailed = 0;
+
+static void TEST_Check(int ok, const char *expr, const char *file, int line) {
+  TEST_nofChecks++;
+  if (!ok) {
+    TEST_nofFailed++;
+    printf("%s:%d: check failed: %s\n", file, line, expr);
+  }
+}
+
+static void TEST_CheckNear(double val, double expected, double tolerance, const char *expr, const char *file, int line) {
+  TEST_nofChecks++;
+  if (val<expected-tolerance || val>expected+tolerance) {
+    TEST_nofFailed++;
+    printf("%s:%d: check failed: %s is %g, expected %g +/- %g\n", file, line, expr, val, expected, tolerance);
+  }
+}
+
+#define TEST_CHECK(cond)                   TEST_Check((cond)!=0, #cond, __FILE__, __LINE__)
+#define TEST_CHECK_NEAR(val, expected, tol) TEST_CheckNear((double)(val), (double)(expected), (double)(tol), #val, __FILE__, __LINE__)
+
+/*!
+ * \brief Prints the summary of a test program.
+ * \param name Name of the test
+ * \return Exit code, EXIT_SUCCESS if all checks passed
+ */
+static int TEST_Result(const char *name) {
+  printf("%s: %d checks, %d failed\n", name, TEST_nofChecks, TEST_nofFailed);
+  return TEST_nofFailed==0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif /* TESTUTIL_H_ */
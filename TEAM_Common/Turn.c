@@ -12,11 +12,13 @@
 #include "WAIT1.h"
 #include "Motor.h"
 #include "UTIL1.h"
+#include "FRTOS1.h"
 #if PL_CONFIG_HAS_SHELL
   #include "CLS1.h"
   #include "Shell.h"
 #endif
 #include "Reflectance.h"
+#include "TurnModel.h"
 #if PL_CONFIG_HAS_QUADRATURE
   #include "Q4CLeft.h"
   #include "Q4CRight.h"
@@ -46,6 +48,48 @@ static int32_t TURN_Steps90 = TURN_STEPS_90;
 static int32_t TURN_StepsLine = TURN_STEPS_LINE;
 static int32_t TURN_StepsPostLine = TURN_STEPS_POST_LINE;
 
+#if PL_CONFIG_HAS_REFLECTANCE
+#define TURN_LINE_ARM_PERCENT     50   /* part of the nominal turn before a line is accepted, so we skip the line we start on */
+#define TURN_LINE_MAX_PERCENT     130  /* turn in percent of the nominal turn if no line is found */
+#define TURN_LINE_CENTER_WINDOW   500  /* maximum distance of the line value from the middle for a centered line */
+
+static struct {
+  volatile bool active; /* if the frame callback checks for the line */
+  volatile bool found;  /* set by the frame callback if the line has been found */
+  bool armed;           /* if the minimum turn has been done */
+  int32_t armSteps;     /* wheel steps before a line is accepted */
+  int32_t startL, startR; /* wheel positions at the start of the turn */
+  int32_t foundL, foundR; /* wheel positions where the line has been found */
+  TURN_StopFct stopIt;  /* stop function of the caller */
+} TURN_LineStop;
+
+/*! \todo adopt the values for your robot */
+#define TURN_ROLL_SPEED           800   /* speed in steps/s of the robot center for rolling turns */
+#define TURN_ROLL_RADIUS_PERCENT  100   /* arc radius in percent of the wheel base: inner wheel at 1/2, outer wheel at 3/2 of the speed */
+#define TURN_ROLL_POLL_MS         5     /* how often the stop function is checked while rolling */
+
+static struct {
+  volatile bool active;  /* if the frame callback checks the turn */
+  volatile bool found;   /* set by the frame callback if the line has been found */
+  int32_t startL, startR; /* wheel positions at the start */
+  int32_t headingSteps;  /* heading change as wheel difference (right-left), positive for left turns, 0 for a straight step */
+  int32_t distSteps;     /* distance for a straight step */
+} TURN_Roll;
+static xSemaphoreHandle TURN_RollSem = NULL; /* given by the frame callback at the end of the turn */
+
+#define TURN_CALIB_SPEED          600   /* wheel speed in steps/s for the calibration spin */
+#define TURN_CALIB_NOF_CROSSINGS  4     /* number of line crossings of a full turn over a cross */
+#define TURN_CALIB_TIMEOUT_MS     15000 /* maximum time for the calibration spin */
+
+static struct {
+  volatile uint8_t nofCrossings; /* number of line crossings recorded */
+  bool onLine;           /* if the center sensors are on the line */
+  int32_t entrySteps;    /* spin steps when the line has been entered, -1 if not entered yet */
+  int32_t startL, startR; /* wheel positions at the start */
+  int32_t crossing[TURN_CALIB_NOF_CROSSINGS+1]; /* spin steps at the middle of each line crossing */
+} TURN_Calib;
+#endif
+
 /*!
  * \brief Translate a turn kind into a string
  * \return Returns a descriptive string
@@ -71,52 +115,32 @@ const unsigned char *TURN_TurnKindStr(TURN_Kind kind) {
   }
 }
 
-void TURN_MoveToPos(int32_t targetLPos, int32_t targetRPos, bool wait, TURN_StopFct stopIt, int32_t timeoutMs) {
+DRV_WaitResult TURN_MoveToPos(int32_t targetLPos, int32_t targetRPos, bool wait, TURN_StopFct stopIt, int32_t timeoutMs) {
+  DRV_WaitResult res;
+
   (void)DRV_SetPos(targetLPos, targetRPos);
   (void)DRV_SetMode(DRV_MODE_POS);
-  for(;;) { /* breaks */
-    if (stopIt!=NULL) {
-      if (stopIt()) { /* check stop condition */
-        break;
-      }
-    }
-    WAIT1_WaitOSms(1); /* wait some time, and give Drive module enough time to use new value */
-    timeoutMs--;
-    if (timeoutMs<=0) {
-      break; /* timeout */
-    }
-    if (wait && DRV_HasTurned()) {
-      break;
-    }
-    if (!wait) {
-      break;
-    }
-  } /* for */
+  if (!wait) {
+    return DRV_WAIT_REACHED; /* not waiting */
+  }
+  res = DRV_WaitPosReached(timeoutMs, stopIt); /* drive task notifies us */
 #if PL_CONFIG_HAS_SHELL
-  if (timeoutMs<=0) {
+  if (res==DRV_WAIT_TIMEOUT) {
     SHELL_SendString((unsigned char*)"MoveToPos Timeout.\r\n");
   }
 #endif
+  return res;
 }
 
 static void StepsTurn(int32_t stepsL, int32_t stepsR, TURN_StopFct stopIt, int32_t timeOutMS) {
   int32_t currLPos, currRPos, targetLPos, targetRPos;
-  /* stop before turn */
-  int timeout = TURN_STEPS_STOP_TIMEOUT_MS;
-  
-  DRV_SetMode(DRV_MODE_STOP); /* stop it */
-  WAIT1_WaitOSms(5);
 
-  while (timeout>0 && !DRV_IsStopped()) {
-    /* wait until stopped */
-    timeout-=5;
-    WAIT1_WaitOSms(5);
-  }
+  /* stop before turn */
+  if (DRV_Stop(TURN_STEPS_STOP_TIMEOUT_MS)!=ERR_OK) {
 #if PL_CONFIG_HAS_SHELL
-  if (timeout<=0) {
     SHELL_SendString((unsigned char*)"StepsTurn Stopping Timeout.\r\n");
-  }
 #endif
+  }
   currLPos = Q4CLeft_GetPos();
   currRPos = Q4CRight_GetPos();
   targetLPos = currLPos+stepsL;
@@ -196,6 +220,326 @@ void TURN_TurnAngle(int16_t angle, TURN_StopFct stopIt) {
   }
 }
 
+#if PL_CONFIG_HAS_REFLECTANCE
+static bool TURN_IsLineCentered(void) {
+  int32_t diff;
+
+  if (REF_GetLineKind()!=REF_LINE_STRAIGHT) {
+    return FALSE;
+  }
+  diff = (int32_t)REF_GetLineValue()-REF_MIDDLE_LINE_VALUE;
+  return diff>-TURN_LINE_CENTER_WINDOW && diff<TURN_LINE_CENTER_WINDOW;
+}
+
+/*!
+ * \brief Called for every reflectance frame while turning to a line.
+ */
+static void TURN_LineFrameCallback(void) {
+  int32_t posL, posR, dL, dR;
+
+  if (!TURN_LineStop.active) {
+    return;
+  }
+  posL = Q4CLeft_GetPos();
+  posR = Q4CRight_GetPos();
+  if (!TURN_LineStop.armed) {
+    dL = posL-TURN_LineStop.startL;
+    dR = posR-TURN_LineStop.startR;
+    if (dL<0) {
+      dL = -dL;
+    }
+    if (dR<0) {
+      dR = -dR;
+    }
+    if ((dL+dR)/2>=TURN_LineStop.armSteps) {
+      TURN_LineStop.armed = TRUE;
+    }
+    return;
+  }
+  if (TURN_IsLineCentered()) {
+    TURN_LineStop.foundL = posL;
+    TURN_LineStop.foundR = posR;
+    TURN_LineStop.active = FALSE;
+    TURN_LineStop.found = TRUE; /* the turning task stops at this position: no drive command from the reflectance task, it must not block on the drive queue */
+  }
+}
+
+/*!
+ * \brief Stop function while turning to a line: ends the wait for the nominal turn as soon as the line has been found.
+ */
+static bool TURN_LineStopCheck(void) {
+  return TURN_LineStop.found || (TURN_LineStop.stopIt!=NULL && TURN_LineStop.stopIt());
+}
+
+bool TURN_TurnToLine(TURN_Kind kind, TURN_StopFct stopIt) {
+  int32_t steps, dir, timeoutMs, maxSteps;
+
+  switch(kind) {
+    case TURN_LEFT45:   steps = TURN_Steps90/2; dir = -1; timeoutMs = TURN_STEPS_90_TIMEOUT_MS/2; break;
+    case TURN_RIGHT45:  steps = TURN_Steps90/2; dir = 1;  timeoutMs = TURN_STEPS_90_TIMEOUT_MS/2; break;
+    case TURN_LEFT90:   steps = TURN_Steps90;   dir = -1; timeoutMs = TURN_STEPS_90_TIMEOUT_MS; break;
+    case TURN_RIGHT90:  steps = TURN_Steps90;   dir = 1;  timeoutMs = TURN_STEPS_90_TIMEOUT_MS; break;
+    case TURN_LEFT180:  steps = 2*TURN_Steps90; dir = -1; timeoutMs = TURN_STEPS_90_TIMEOUT_MS*2; break;
+    case TURN_RIGHT180: steps = 2*TURN_Steps90; dir = 1;  timeoutMs = TURN_STEPS_90_TIMEOUT_MS*2; break;
+    default:
+      TURN_Turn(kind, stopIt); /* not a turn on the spot */
+      return FALSE;
+  }
+  if (!REF_IsReady()) { /* no line information: use the step count only */
+    TURN_Turn(kind, stopIt);
+    return FALSE;
+  }
+  /* stop before turn */
+  if (DRV_Stop(TURN_STEPS_STOP_TIMEOUT_MS)!=ERR_OK) {
+#if PL_CONFIG_HAS_SHELL
+    SHELL_SendString((unsigned char*)"TurnToLine Stopping Timeout.\r\n");
+#endif
+  }
+  TURN_LineStop.startL = Q4CLeft_GetPos();
+  TURN_LineStop.startR = Q4CRight_GetPos();
+  TURN_LineStop.armSteps = (steps*TURN_LINE_ARM_PERCENT)/100;
+  TURN_LineStop.armed = FALSE;
+  TURN_LineStop.found = FALSE;
+  TURN_LineStop.stopIt = stopIt;
+  TURN_LineStop.active = TRUE;
+  if (REF_AddFrameCallback(TURN_LineFrameCallback)!=ERR_OK) {
+    TURN_LineStop.active = FALSE;
+    TURN_Turn(kind, stopIt);
+    return FALSE;
+  }
+  maxSteps = (steps*TURN_LINE_MAX_PERCENT)/100;
+  (void)TURN_MoveToPos(TURN_LineStop.startL+dir*maxSteps, TURN_LineStop.startR-dir*maxSteps, TRUE, TURN_LineStopCheck, (timeoutMs*TURN_LINE_MAX_PERCENT)/100);
+  TURN_LineStop.active = FALSE;
+  REF_RemoveFrameCallback(TURN_LineFrameCallback);
+  if (TURN_LineStop.found) { /* go back to where the line has been found */
+    (void)TURN_MoveToPos(TURN_LineStop.foundL, TURN_LineStop.foundR, TRUE, stopIt, TURN_STEPS_STOP_TIMEOUT_MS);
+  }
+  return TURN_LineStop.found;
+}
+
+/*!
+ * \brief Returns the wheel base in wheel steps, derived from TURN_Steps90: a spin of 90 degree moves each wheel by base*pi/4.
+ */
+static int32_t TURN_GetWheelBaseSteps(void) {
+  return TURNM_WheelBaseSteps(TURN_Steps90);
+}
+
+/*!
+ * \brief Called for every reflectance frame during a rolling turn.
+ */
+static void TURN_RollFrameCallback(void) {
+  int32_t dL, dR, progress;
+  bool done = FALSE;
+
+  if (!TURN_Roll.active) {
+    return;
+  }
+  dL = Q4CLeft_GetPos()-TURN_Roll.startL;
+  dR = Q4CRight_GetPos()-TURN_Roll.startR;
+  if (TURN_Roll.headingSteps!=0) { /* arc */
+    progress = ((dR-dL)*100)/TURN_Roll.headingSteps; /* percent of the heading change */
+    if (progress>=TURN_LINE_ARM_PERCENT && TURN_IsLineCentered()) {
+      TURN_Roll.found = TRUE;
+      done = TRUE;
+    } else if (progress>=TURN_LINE_MAX_PERCENT) {
+      done = TRUE; /* no line found */
+    }
+  } else if ((dL+dR)/2>=TURN_Roll.distSteps) { /* straight step */
+    TURN_Roll.found = TURN_IsLineCentered();
+    done = TRUE;
+  }
+  if (done) {
+    TURN_Roll.active = FALSE;
+    (void)xSemaphoreGive(TURN_RollSem);
+  }
+}
+
+bool TURN_RollTurn(TURN_Kind kind, TURN_StopFct stopIt) {
+  int32_t headingSteps, distSteps, omega, radius, timeMs, timeoutMs;
+
+  headingSteps = 0;
+  distSteps = 0;
+  switch(kind) {
+    case TURN_LEFT45:   headingSteps = TURN_Steps90; break;
+    case TURN_RIGHT45:  headingSteps = -TURN_Steps90; break;
+    case TURN_LEFT90:   headingSteps = 2*TURN_Steps90; break;
+    case TURN_RIGHT90:  headingSteps = -2*TURN_Steps90; break;
+    case TURN_STEP_LINE_FW:           distSteps = TURN_StepsLine; break;
+    case TURN_STEP_POST_LINE_FW:      distSteps = TURN_StepsPostLine; break;
+    case TURN_STEP_LINE_FW_POST_LINE: distSteps = TURN_StepsLine+TURN_StepsPostLine; break;
+    case TURN_STRAIGHT: return TRUE; /* keep on rolling */
+    case TURN_LEFT180:
+    case TURN_RIGHT180:
+      return TURN_TurnToLine(kind, stopIt); /* no rolling U turn on a line */
+    default:
+      TURN_Turn(kind, stopIt);
+      return FALSE;
+  }
+  if (!REF_IsReady() || TURN_RollSem==NULL) {
+    TURN_Turn(kind, stopIt);
+    return FALSE;
+  }
+  radius = (TURN_GetWheelBaseSteps()*TURN_ROLL_RADIUS_PERCENT)/100;
+  if (headingSteps!=0) {
+    omega = (TURN_ROLL_SPEED*1000)/radius; /* mrad/s, the drive derives the inner and outer wheel speed from the wheel base */
+    if (headingSteps<0) {
+      omega = -omega;
+    }
+    timeMs = TURNM_RollArcMs(TURN_Steps90, headingSteps, TURN_ROLL_RADIUS_PERCENT, TURN_ROLL_SPEED);
+    timeMs = (timeMs*TURN_LINE_MAX_PERCENT)/100;
+  } else {
+    omega = 0;
+    timeMs = (distSteps*1000)/TURN_ROLL_SPEED;
+  }
+  timeoutMs = 2*timeMs+500; /* allow for acceleration */
+  (void)xSemaphoreTake(TURN_RollSem, 0); /* make sure it is empty */
+  TURN_Roll.startL = Q4CLeft_GetPos();
+  TURN_Roll.startR = Q4CRight_GetPos();
+  TURN_Roll.headingSteps = headingSteps;
+  TURN_Roll.distSteps = distSteps;
+  TURN_Roll.found = FALSE;
+  TURN_Roll.active = TRUE;
+  if (REF_AddFrameCallback(TURN_RollFrameCallback)!=ERR_OK) {
+    TURN_Roll.active = FALSE;
+    TURN_Turn(kind, stopIt);
+    return FALSE;
+  }
+  (void)DRV_SetTwist(TURN_ROLL_SPEED, omega);
+  if (DRV_GetMode()!=DRV_MODE_TWIST) {
+    (void)DRV_SetMode(DRV_MODE_TWIST);
+  }
+  for(timeMs=0;;timeMs+=TURN_ROLL_POLL_MS) {
+    if (FRTOS1_xSemaphoreTake(TURN_RollSem, TURN_ROLL_POLL_MS/portTICK_PERIOD_MS)==pdTRUE) {
+      break; /* done */
+    }
+    if ((stopIt!=NULL && stopIt()) || timeMs>=timeoutMs) {
+      TURN_Roll.active = FALSE;
+      break;
+    }
+  }
+  REF_RemoveFrameCallback(TURN_RollFrameCallback);
+  if (TURN_Roll.found) {
+    (void)DRV_SetMode(DRV_MODE_NONE); /* keep the current duty, line following takes over with the next frame */
+  } else {
+    (void)DRV_SetMode(DRV_MODE_STOP); /* not on the line: do not leave the robot rolling */
+  }
+  return TURN_Roll.found;
+}
+
+#if PL_CONFIG_HAS_SHELL
+/*!
+ * \brief Runs a fixed sequence of turns and reports the time, to compare rolling turns with turns on the spot.
+ * The expected difference is estimated with TurnModel on the host, see Tests/TestTurnModel.c.
+ */
+static uint8_t TURN_Bench(bool rolling, const CLS1_StdIOType *io) {
+  static const TURN_Kind seq[] = {TURN_LEFT90, TURN_STEP_LINE_FW, TURN_RIGHT90, TURN_STEP_LINE_FW, TURN_RIGHT90, TURN_STEP_LINE_FW, TURN_LEFT90};
+  unsigned char buf[48];
+  TickType_t start;
+  int i;
+
+  start = FRTOS1_xTaskGetTickCount();
+  for(i=0;i<(int)(sizeof(seq)/sizeof(seq[0]));i++) {
+    if (rolling) {
+      (void)TURN_RollTurn(seq[i], NULL);
+    } else {
+      TURN_Turn(seq[i], NULL);
+    }
+  }
+  TURN_Turn(TURN_STOP, NULL);
+  (void)DRV_SetMode(DRV_MODE_STOP);
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)(rolling?"rolling: ":"on the spot: "));
+  UTIL1_strcatNum32u(buf, sizeof(buf), (FRTOS1_xTaskGetTickCount()-start)*portTICK_PERIOD_MS);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  CLS1_SendStr(buf, io->stdOut);
+  return ERR_OK;
+}
+
+/*!
+ * \brief Called for every reflectance frame during the calibration spin: records the middle of each line crossing.
+ */
+static void TURN_CalibFrameCallback(void) {
+  int32_t steps;
+  bool onLine;
+
+  if (TURN_Calib.nofCrossings>TURN_CALIB_NOF_CROSSINGS) {
+    return; /* done */
+  }
+  /* clockwise spin: left wheel forward, right wheel backward */
+  steps = ((Q4CLeft_GetPos()-TURN_Calib.startL)-(Q4CRight_GetPos()-TURN_Calib.startR))/2;
+  if (steps<0) {
+    steps = -steps;
+  }
+  onLine = TURN_IsLineCentered();
+  if (onLine && !TURN_Calib.onLine) {
+    TURN_Calib.entrySteps = steps;
+  } else if (!onLine && TURN_Calib.onLine && TURN_Calib.entrySteps>=0) {
+    TURN_Calib.crossing[TURN_Calib.nofCrossings] = (TURN_Calib.entrySteps+steps)/2;
+    TURN_Calib.nofCrossings++;
+  }
+  TURN_Calib.onLine = onLine;
+}
+
+/*!
+ * \brief Spins the robot on a line cross and measures the steps between the line crossings to calibrate TURN_Steps90.
+ */
+static uint8_t TURN_CalibSteps90(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  int32_t quarter, rev, timeMs;
+  int i;
+  uint8_t res = ERR_OK;
+
+  if (!REF_IsReady()) {
+    CLS1_SendStr((unsigned char*)"Reflectance sensors not calibrated!\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  CLS1_SendStr((unsigned char*)"Spinning on the line cross...\r\n", io->stdOut);
+  TURN_Calib.startL = Q4CLeft_GetPos();
+  TURN_Calib.startR = Q4CRight_GetPos();
+  TURN_Calib.onLine = TURN_IsLineCentered();
+  TURN_Calib.entrySteps = -1; /* a line we start on is not counted */
+  TURN_Calib.nofCrossings = 0;
+  if (REF_AddFrameCallback(TURN_CalibFrameCallback)!=ERR_OK) {
+    return ERR_FAILED;
+  }
+  (void)DRV_SetSpeed(TURN_CALIB_SPEED, -TURN_CALIB_SPEED);
+  (void)DRV_SetMode(DRV_MODE_SPEED);
+  for(timeMs=0;TURN_Calib.nofCrossings<=TURN_CALIB_NOF_CROSSINGS && timeMs<TURN_CALIB_TIMEOUT_MS;timeMs+=10) {
+    WAIT1_WaitOSms(10);
+  }
+  REF_RemoveFrameCallback(TURN_CalibFrameCallback);
+  (void)DRV_Stop(TURN_STEPS_STOP_TIMEOUT_MS);
+  if (TURN_Calib.nofCrossings<=TURN_CALIB_NOF_CROSSINGS) {
+    CLS1_SendStr((unsigned char*)"Timeout, not enough line crossings!\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  rev = TURN_Calib.crossing[TURN_CALIB_NOF_CROSSINGS]-TURN_Calib.crossing[0];
+  for(i=0;i<TURN_CALIB_NOF_CROSSINGS;i++) {
+    quarter = TURN_Calib.crossing[i+1]-TURN_Calib.crossing[i];
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"  crossing: ");
+    UTIL1_strcatNum32s(buf, sizeof(buf), quarter);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+    /* on a cross, all crossings shall be about a quarter turn */
+    if (quarter*TURN_CALIB_NOF_CROSSINGS<(rev*3)/4 || quarter*TURN_CALIB_NOF_CROSSINGS>(rev*5)/4) {
+      res = ERR_FAILED;
+    }
+  }
+  if (res!=ERR_OK) {
+    CLS1_SendStr((unsigned char*)"Crossings not evenly spaced, not on a cross?\r\n", io->stdErr);
+    return res;
+  }
+  TURN_Steps90 = rev/4;
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"360 degree: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), rev);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps, steps90: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), TURN_Steps90);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStr(buf, io->stdOut);
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+#endif /* PL_CONFIG_HAS_REFLECTANCE */
+
 #if PL_CONFIG_HAS_SHELL
 static void TURN_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"turn", (unsigned char*)"Group of turning commands\r\n", io->stdOut);
@@ -207,6 +551,12 @@ static void TURN_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"  steps90 <steps>", (unsigned char*)"Number of steps for a 90 degree turn\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  stepsline <steps>", (unsigned char*)"Number of steps for stepping over line\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  stepspostline <steps>", (unsigned char*)"Number of steps for a step post the line\r\n", io->stdOut);
+#if PL_CONFIG_HAS_REFLECTANCE
+  CLS1_SendHelpStr((unsigned char*)"  line left|right|around", (unsigned char*)"Turn left or right (90 degree) or around until the line is found\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  roll left|right", (unsigned char*)"Rolling 90 degree turn until the line is found\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  bench spot|roll", (unsigned char*)"Time a fixed sequence of turns on the spot or rolling\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  calib", (unsigned char*)"Spin on a line cross to calibrate steps90\r\n", io->stdOut);
+#endif
 }
 
 static void TURN_PrintStatus(const CLS1_StdIOType *io) {
@@ -270,6 +620,39 @@ uint8_t TURN_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_St
       CLS1_SendStr((unsigned char*)"Wrong argument\r\n", io->stdErr);
       res = ERR_FAILED;
     }
+#if PL_CONFIG_HAS_REFLECTANCE
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"turn line left")==0) {
+    (void)TURN_TurnToLine(TURN_LEFT90, NULL);
+    TURN_Turn(TURN_STOP, NULL);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"turn line right")==0) {
+    (void)TURN_TurnToLine(TURN_RIGHT90, NULL);
+    TURN_Turn(TURN_STOP, NULL);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"turn line around")==0) {
+    (void)TURN_TurnToLine(TURN_LEFT180, NULL);
+    TURN_Turn(TURN_STOP, NULL);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"turn roll left")==0) {
+    (void)TURN_RollTurn(TURN_LEFT90, NULL);
+    TURN_Turn(TURN_STOP, NULL);
+    (void)DRV_SetMode(DRV_MODE_STOP);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"turn roll right")==0) {
+    (void)TURN_RollTurn(TURN_RIGHT90, NULL);
+    TURN_Turn(TURN_STOP, NULL);
+    (void)DRV_SetMode(DRV_MODE_STOP);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"turn bench spot")==0) {
+    *handled = TRUE;
+    res = TURN_Bench(FALSE, io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"turn bench roll")==0) {
+    *handled = TRUE;
+    res = TURN_Bench(TRUE, io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"turn calib")==0) {
+    *handled = TRUE;
+    res = TURN_CalibSteps90(io);
+#endif
   } else if (UTIL1_strcmp((char*)cmd, (char*)"turn forward postline")==0) {
     TURN_Turn(TURN_STEP_LINE_FW_POST_LINE, NULL);
     TURN_Turn(TURN_STOP, NULL);
@@ -321,5 +704,13 @@ void TURN_Init(void) {
   TURN_Steps90 = TURN_STEPS_90;
   TURN_StepsPostLine = TURN_STEPS_POST_LINE;
   TURN_StepsLine = TURN_STEPS_LINE;
+#if PL_CONFIG_HAS_REFLECTANCE
+  vSemaphoreCreateBinary(TURN_RollSem);
+  if (TURN_RollSem==NULL) { /* semaphore creation failed */
+    for(;;){} /* error */
+  }
+  (void)xSemaphoreTake(TURN_RollSem, 0); /* empty token */
+  vQueueAddToRegistry(TURN_RollSem, "TurnRollSem");
+#endif
 }
 #endif /* PL_CONFIG_HAS_TURN */
@@ -11,6 +11,7 @@
 
 #include "Platform.h"
 #if PL_CONFIG_HAS_TURN
+#include "Drive.h"
 
 typedef enum {
   TURN_LEFT45,   /* turn 45 degree left and stop */
@@ -55,8 +56,9 @@ void TURN_Turn(TURN_Kind kind, TURN_StopFct stopIt);
  * \param wait Wait until it is in position.
  * \param stopIt Callback to stop turning, or NULL.
  * \param timeoutMs Timout value in milliseconds for turning operation.
+ * \return DRV_WAIT_REACHED if in position (or if not waiting), DRV_WAIT_TIMEOUT or DRV_WAIT_ABORTED otherwise.
  */
-void TURN_MoveToPos(int32_t targetLPos, int32_t targetRPos, bool wait, TURN_StopFct stopIt, int32_t timeoutMs);
+DRV_WaitResult TURN_MoveToPos(int32_t targetLPos, int32_t targetRPos, bool wait, TURN_StopFct stopIt, int32_t timeoutMs);
 
 /*!
  * \brief Turn by angle
@@ -64,6 +66,29 @@ void TURN_MoveToPos(int32_t targetLPos, int32_t targetRPos, bool wait, TURN_Stop
  */
 void TURN_TurnAngle(int16_t angle, TURN_StopFct stopIt);
 
+#if PL_CONFIG_HAS_REFLECTANCE
+/*!
+ * \brief Turns the robot like TURN_Turn(), but stops as soon as the center sensors see a line again.
+ * The line is checked for every reflectance sensor frame. If no line is found, the robot turns a bit more than the nominal turn.
+ * \param kind TURN_LEFT45, TURN_RIGHT45, TURN_LEFT90, TURN_RIGHT90, TURN_LEFT180 or TURN_RIGHT180. Other kinds are passed to TURN_Turn().
+ * \param stopIt Callback to stop turning, or NULL.
+ * \return TRUE if the turn has been stopped on the line.
+ */
+bool TURN_TurnToLine(TURN_Kind kind, TURN_StopFct stopIt);
+
+/*!
+ * \brief Rolling variant of TURN_Turn(): the robot does not stop. 45 and 90 degree turns are driven as an arc with constant radius,
+ * forward steps are driven at the same speed. The turn ends as soon as the center sensors see the line again.
+ * If it ends on the line, the drive is handed back with DRV_MODE_NONE, so the robot keeps rolling until line following takes over,
+ * otherwise the robot is stopped with DRV_MODE_STOP.
+ * 180 degree turns use TURN_TurnToLine(), all other kinds use TURN_Turn().
+ * \param kind Kind of turn
+ * \param stopIt Callback to stop turning, or NULL.
+ * \return TRUE if the turn has been ended on the line.
+ */
+bool TURN_RollTurn(TURN_Kind kind, TURN_StopFct stopIt);
+#endif
+
 #if PL_CONFIG_HAS_SHELL
 #include "CLS1.h"
 /*!
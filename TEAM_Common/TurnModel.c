@@ -0,0 +1,86 @@
+/**
+ * \file
+ * \brief Turn timing model implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Kinematic estimates with constant acceleration, without slip and without the time to find the line.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_TURN
+#include "TurnModel.h"
+
+int32_t TURNM_WheelBaseSteps(int32_t steps90) {
+  return (steps90*4000)/3142;
+}
+
+int32_t TURNM_RollArcMs(int32_t steps90, int32_t headingSteps, int32_t radiusPercent, int32_t speed) {
+  int32_t base, radius;
+
+  base = TURNM_WheelBaseSteps(steps90);
+  radius = (base*radiusPercent)/100;
+  if (headingSteps<0) {
+    headingSteps = -headingSteps;
+  }
+  /* arc length of the robot center: radius*angle, with angle = headingSteps/base */
+  return (int32_t)(((int64_t)radius*headingSteps*1000)/((int64_t)base*speed));
+}
+
+/*!
+ * \brief Integer square root.
+ */
+static uint32_t TURNM_Sqrt32(uint32_t val) {
+  uint32_t res = 0, bit = 1UL<<30;
+
+  while(bit>val) {
+    bit >>= 2;
+  }
+  while(bit!=0) {
+    if (val>=res+bit) {
+      val -= res+bit;
+      res = (res>>1)+bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return res;
+}
+
+int32_t TURNM_MoveMs(int32_t steps, int32_t maxSpeed, int32_t accel) {
+  if (steps<0) {
+    steps = -steps;
+  }
+  if ((int64_t)steps*accel<(int64_t)maxSpeed*maxSpeed) { /* triangle: maximum speed not reached, t = 2*sqrt(s/a) */
+    return (int32_t)(2*TURNM_Sqrt32((uint32_t)(((uint64_t)steps*1000000)/accel)));
+  }
+  /* trapezoid: accelerating and braking take maxSpeed/a together, the rest at maximum speed */
+  return (int32_t)(((int64_t)steps*1000)/maxSpeed+((int64_t)maxSpeed*1000)/accel);
+}
+
+int32_t TURNM_RollTimeMs(const TURNM_Params *params, int32_t quarterTurns, int32_t lineSpeed) {
+  int32_t dv;
+
+  dv = lineSpeed-params->rollSpeed;
+  if (dv<0) {
+    dv = -dv;
+  }
+  return TURNM_RollArcMs(params->steps90, 2*quarterTurns*params->steps90, params->rollRadiusPercent, params->rollSpeed)
+        +(int32_t)(((int64_t)2*dv*1000)/params->accel); /* to the roll speed and back */
+}
+
+int32_t TURNM_SpotTimeMs(const TURNM_Params *params, int32_t quarterTurns, int32_t lineSpeed) {
+  int32_t radius, stopMs;
+
+  radius = (TURNM_WheelBaseSteps(params->steps90)*params->rollRadiusPercent)/100;
+  stopMs = (int32_t)(((int64_t)lineSpeed*1000)/params->accel);
+  if (stopMs>params->stopTimeoutMs) {
+    stopMs = params->stopTimeoutMs; /* the spin starts after the timeout, even if still moving */
+  }
+  return (int32_t)(((int64_t)2*radius*1000)/lineSpeed) /* to the center of the junction and away from it again */
+        +stopMs
+        +TURNM_MoveMs(quarterTurns*params->steps90, params->spinSpeed, params->accel)
+        +(int32_t)(((int64_t)lineSpeed*1000)/params->accel); /* back to the line speed */
+}
+
+#endif /* PL_CONFIG_HAS_TURN */
@@ -0,0 +1,73 @@
+/**
+ * \file
+ * \brief Turn timing model interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Estimates the time of a rolling turn (arc at constant speed) and of a turn on the spot (stop, spin, restart),
+ * so the two can be compared for a line speed without driving them.
+ * The functions only work on the provided data and have no hardware dependency. Distances are in wheel steps.
+ */
+
+#ifndef TURNMODEL_H_
+#define TURNMODEL_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_TURN
+
+typedef struct {
+  int32_t steps90;           /*!< wheel steps for a 90 degree spin on the spot */
+  int32_t rollSpeed;         /*!< speed of the robot center in rolling turns, steps/s */
+  int32_t rollRadiusPercent; /*!< arc radius of rolling turns in percent of the wheel base */
+  int32_t spinSpeed;         /*!< maximum wheel speed while spinning on the spot, steps/s */
+  int32_t accel;             /*!< acceleration and deceleration, steps/s^2 */
+  int32_t stopTimeoutMs;     /*!< longest wait for the stop before spinning */
+} TURNM_Params;
+
+/*!
+ * \brief Returns the wheel base, derived from the steps of a 90 degree spin: a spin of 90 degree moves each wheel by base*pi/4.
+ * \param steps90 Wheel steps for a 90 degree spin
+ * \return Wheel base in steps
+ */
+int32_t TURNM_WheelBaseSteps(int32_t steps90);
+
+/*!
+ * \brief Returns the time to drive an arc with constant speed.
+ * \param steps90 Wheel steps for a 90 degree spin
+ * \param headingSteps Heading change as difference of the right and left wheel steps, 2*steps90 for 90 degree
+ * \param radiusPercent Arc radius in percent of the wheel base
+ * \param speed Speed of the robot center in steps/s
+ * \return Time in ms
+ */
+int32_t TURNM_RollArcMs(int32_t steps90, int32_t headingSteps, int32_t radiusPercent, int32_t speed);
+
+/*!
+ * \brief Returns the time of a move which starts and ends at standstill, with a trapezoid speed profile.
+ * \param steps Distance
+ * \param maxSpeed Maximum speed in steps/s
+ * \param accel Acceleration and deceleration in steps/s^2
+ * \return Time in ms
+ */
+int32_t TURNM_MoveMs(int32_t steps, int32_t maxSpeed, int32_t accel);
+
+/*!
+ * \brief Estimates a rolling turn from the line speed: change to the roll speed, the arc, and back to the line speed.
+ * \param params Robot parameters
+ * \param quarterTurns Heading change in 90 degree steps, 1 or 2
+ * \param lineSpeed Line following speed when reaching the junction, steps/s
+ * \return Time in ms
+ */
+int32_t TURNM_RollTimeMs(const TURNM_Params *params, int32_t quarterTurns, int32_t lineSpeed);
+
+/*!
+ * \brief Estimates a turn on the spot over the same piece of track as the rolling turn: the lines the arc cuts off at the line speed,
+ * the wait for the stop (braking, at most the stop timeout), the spin, and the acceleration back to the line speed.
+ * \param params Robot parameters
+ * \param quarterTurns Heading change in 90 degree steps, 1 or 2
+ * \param lineSpeed Line following speed when reaching the junction, steps/s
+ * \return Time in ms
+ */
+int32_t TURNM_SpotTimeMs(const TURNM_Params *params, int32_t quarterTurns, int32_t lineSpeed);
+
+#endif /* PL_CONFIG_HAS_TURN */
+
+#endif /* TURNMODEL_H_ */
@@ -0,0 +1,347 @@
+/**
+ * \file
+ * \brief Wall maze implementation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The robot drives from cell center to cell center. In each cell the walls are sensed with the ToF sensors,
+ * added to the map, and the robot moves to the neighbor cell closest to the goal.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_WALL_MAZE
+#include "WallMaze.h"
+#include "MazeFlood.h"
+#include "Distance.h"
+#include "Turn.h"
+#include "Drive.h"
+#include "Odometry.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#include "Shell.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+
+#define WMAZE_CELL_MM_DEFAULT     180   /* classic micromouse cell */
+#define WMAZE_GOAL_X_DEFAULT      7     /* goal is the 2x2 center of the maze */
+#define WMAZE_GOAL_Y_DEFAULT      7
+#define WMAZE_GOAL_SIZE_DEFAULT   2
+#define WMAZE_CELL_TIMEOUT_MS     3000  /* timeout to drive one cell */
+#define WMAZE_FRONT_STOP_MM       20    /* stop moving if a wall is that close in front */
+#define WMAZE_SETTLE_MS           50    /* time for new ToF measurements after moving */
+
+/* task notification bits */
+#define WMAZE_START_EXPLORE  (1<<0)
+
+typedef enum {
+  WMAZE_RESULT_NONE,     /* not started yet */
+  WMAZE_RESULT_RUNNING,  /* exploring */
+  WMAZE_RESULT_GOAL,     /* goal reached */
+  WMAZE_RESULT_NO_PATH,  /* goal can not be reached */
+  WMAZE_RESULT_FAILED,   /* could not drive to the next cell */
+  WMAZE_RESULT_STOPPED   /* stopped by user */
+} WMAZE_Result;
+
+static MAZEF_Maze maze; /* walls and distances */
+static uint8_t posX, posY, heading; /* current cell and heading */
+static uint16_t cellMm = WMAZE_CELL_MM_DEFAULT;
+static uint16_t nofCells; /* number of cells driven in the last run */
+static uint16_t nofNewWalls; /* number of walls found in the last run */
+static volatile WMAZE_Result result = WMAZE_RESULT_NONE;
+static volatile bool stopRequest = FALSE;
+static xTaskHandle WMAZE_TaskHandle;
+
+void WMAZE_Start(void) {
+  if (!WMAZE_IsRunning()) {
+    (void)xTaskNotify(WMAZE_TaskHandle, WMAZE_START_EXPLORE, eSetBits);
+  }
+}
+
+void WMAZE_Stop(void) {
+  stopRequest = TRUE;
+}
+
+bool WMAZE_IsRunning(void) {
+  return result==WMAZE_RESULT_RUNNING;
+}
+
+static bool WMAZE_StopIt(void) {
+  return stopRequest;
+}
+
+static bool WMAZE_StopAtWall(void) {
+  return stopRequest || DIST_NearFrontObstacle(WMAZE_FRONT_STOP_MM);
+}
+
+/*!
+ * \brief Returns the walls around the robot.
+ * \return Bit set for each absolute direction (1<<MAZEF_NORTH, ...) with a wall
+ */
+static uint8_t WMAZE_SenseWalls(void) {
+  uint8_t sensed, walls = 0;
+
+  sensed = DIST_CheckSurrounding();
+  if (sensed&(1<<DIST_TOF_FRONT)) {
+    walls |= 1<<heading;
+  }
+  if (sensed&(1<<DIST_TOF_RIGHT)) {
+    walls |= 1<<((heading+1)&3);
+  }
+  if (sensed&(1<<DIST_TOF_REAR)) {
+    walls |= 1<<((heading+2)&3);
+  }
+  if (sensed&(1<<DIST_TOF_LEFT)) {
+    walls |= 1<<((heading+3)&3);
+  }
+  return walls;
+}
+
+/*!
+ * \brief Drives one cell ahead.
+ * \return Error code, ERR_OK if we are in the next cell, ERR_BUSY if a wall ahead stopped us before leaving the current cell,
+ * ERR_FAILED if the cell could not be driven or we have been stopped
+ */
+static uint8_t WMAZE_DriveCell(void) {
+  int32_t steps, startL, startR, driven;
+  DRV_WaitResult res;
+
+  steps = ODO_UmToTicks((int32_t)cellMm*1000);
+  startL = (int32_t)Q4CLeft_GetPos();
+  startR = (int32_t)Q4CRight_GetPos();
+  res = TURN_MoveToPos(startL+steps, startR+steps, TRUE, WMAZE_StopAtWall, WMAZE_CELL_TIMEOUT_MS);
+  if (res==DRV_WAIT_REACHED) {
+    return ERR_OK;
+  } else if (res==DRV_WAIT_ABORTED && !stopRequest) { /* wall ahead */
+    (void)DRV_Stop(WMAZE_CELL_TIMEOUT_MS); /* do not keep moving to the target */
+    driven = (((int32_t)Q4CLeft_GetPos()-startL)+((int32_t)Q4CRight_GetPos()-startR))/2;
+    if (driven>=steps/2) {
+      return ERR_OK; /* in the next cell, the wall is at its end */
+    }
+    return ERR_BUSY; /* the wall is on this side of the next cell */
+  }
+  return ERR_FAILED;
+}
+
+static void WMAZE_Explore(void) {
+  uint8_t dir, res;
+
+  stopRequest = FALSE;
+  result = WMAZE_RESULT_RUNNING;
+  posX = 0;
+  posY = 0;
+  heading = MAZEF_NORTH;
+  nofCells = 0;
+  nofNewWalls = 0;
+  for(;;) {
+    if (stopRequest) {
+      result = WMAZE_RESULT_STOPPED;
+      break;
+    }
+    FRTOS1_vTaskDelay(WMAZE_SETTLE_MS/portTICK_PERIOD_MS); /* ToF sensors measure while standing */
+    nofNewWalls += MAZEF_AddWalls(&maze, posX, posY, WMAZE_SenseWalls());
+    if (maze.dist[posY][posX]==0) {
+      result = WMAZE_RESULT_GOAL;
+      break;
+    }
+    dir = MAZEF_NextDir(&maze, posX, posY, heading);
+    if (dir==MAZEF_NO_DIR) {
+      result = WMAZE_RESULT_NO_PATH;
+      break;
+    }
+    switch((dir-heading)&3) {
+      case 1: TURN_Turn(TURN_RIGHT90, WMAZE_StopIt); break;
+      case 2: TURN_Turn(TURN_RIGHT180, WMAZE_StopIt); break;
+      case 3: TURN_Turn(TURN_LEFT90, WMAZE_StopIt); break;
+      default: break; /* straight */
+    }
+    heading = dir;
+    res = WMAZE_DriveCell();
+    if (res==ERR_BUSY) { /* still in the same cell: the wall has not been sensed, add it and find another way */
+      nofNewWalls += MAZEF_AddWalls(&maze, posX, posY, 1<<heading);
+      continue;
+    } else if (res!=ERR_OK) {
+      result = stopRequest?WMAZE_RESULT_STOPPED:WMAZE_RESULT_FAILED;
+      break;
+    }
+    MAZEF_Move(dir, &posX, &posY);
+    nofCells++;
+  }
+  TURN_Turn(TURN_STOP, NULL);
+  SHELL_SendString((unsigned char*)(result==WMAZE_RESULT_GOAL?"WMAZE: goal reached!\r\n":"WMAZE: stopped.\r\n"));
+}
+
+static void WMazeTask(void *pvParameters) {
+  uint32_t notifcationValue;
+
+  (void)pvParameters; /* not used */
+  for(;;) {
+    (void)xTaskNotifyWait(0UL, WMAZE_START_EXPLORE, &notifcationValue, portMAX_DELAY);
+    if (notifcationValue&WMAZE_START_EXPLORE) {
+      WMAZE_Explore();
+    }
+  }
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void WMAZE_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"wmaze", (unsigned char*)"Group of wall maze commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows wall maze help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  start|stop", (unsigned char*)"Starts or stops exploring from cell 0,0 heading north\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  clear", (unsigned char*)"Forget all walls\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  print", (unsigned char*)"Print the walls and the distances to the goal\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  goal <x> <y> <size>", (unsigned char*)"Set the goal area, clears the walls\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  cell <mm>", (unsigned char*)"Set the cell size\r\n", io->stdOut);
+}
+
+static void WMAZE_PrintStatus(const CLS1_StdIOType *io) {
+  static const unsigned char *const resultStr[] = {
+    (const unsigned char*)"none", (const unsigned char*)"running", (const unsigned char*)"goal reached",
+    (const unsigned char*)"no path", (const unsigned char*)"failed", (const unsigned char*)"stopped"
+  };
+  static const unsigned char headingChar[] = "NESW";
+  unsigned char buf[48];
+
+  CLS1_SendStatusStr((unsigned char*)"wmaze", (unsigned char*)"\r\n", io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), resultStr[result]);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  state", buf, io->stdOut);
+  UTIL1_Num8uToStr(buf, sizeof(buf), posX);
+  UTIL1_chcat(buf, sizeof(buf), ',');
+  UTIL1_strcatNum8u(buf, sizeof(buf), posY);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" heading ");
+  UTIL1_chcat(buf, sizeof(buf), headingChar[heading&3]);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", distance ");
+  UTIL1_strcatNum8u(buf, sizeof(buf), maze.dist[posY][posX]);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  cell", buf, io->stdOut);
+  UTIL1_Num8uToStr(buf, sizeof(buf), maze.goalX);
+  UTIL1_chcat(buf, sizeof(buf), ',');
+  UTIL1_strcatNum8u(buf, sizeof(buf), maze.goalY);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" size ");
+  UTIL1_strcatNum8u(buf, sizeof(buf), maze.goalSize);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  goal", buf, io->stdOut);
+  UTIL1_Num16uToStr(buf, sizeof(buf), cellMm);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  cell size", buf, io->stdOut);
+  UTIL1_Num16uToStr(buf, sizeof(buf), nofCells);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" cells, ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), nofNewWalls);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" new walls\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  last run", buf, io->stdOut);
+}
+
+/*!
+ * \brief Prints the maze, north on top, with the distance to the goal in each cell ('?' for cells not visited yet).
+ */
+static void WMAZE_PrintMaze(const CLS1_StdIOType *io) {
+  unsigned char buf[MAZEF_SIZE*4+4];
+  unsigned char c;
+  int x, y, i;
+
+  for(y=MAZEF_SIZE-1;y>=0;y--) {
+    i = 0; /* north walls */
+    for(x=0;x<MAZEF_SIZE;x++) {
+      c = MAZEF_HasWall(&maze, x, y, MAZEF_NORTH)?'-':' ';
+      buf[i++] = '+'; buf[i++] = c; buf[i++] = c; buf[i++] = c;
+    }
+    buf[i++] = '+'; buf[i++] = '\r'; buf[i++] = '\n'; buf[i] = '\0';
+    CLS1_SendStr(buf, io->stdOut);
+    i = 0; /* west walls and distances */
+    for(x=0;x<MAZEF_SIZE;x++) {
+      buf[i++] = MAZEF_HasWall(&maze, x, y, MAZEF_WEST)?'|':' ';
+      if (x==posX && y==posY) {
+        buf[i++] = ' '; buf[i++] = '*'; buf[i++] = ' '; /* robot */
+      } else if (maze.dist[y][x]==MAZEF_DIST_UNREACHABLE) {
+        buf[i++] = ' '; buf[i++] = '-'; buf[i++] = ' ';
+      } else {
+        buf[i++] = (unsigned char)(maze.dist[y][x]>=100?'0'+maze.dist[y][x]/100:' ');
+        buf[i++] = (unsigned char)(maze.dist[y][x]>=10?'0'+(maze.dist[y][x]/10)%10:' ');
+        buf[i++] = (unsigned char)('0'+maze.dist[y][x]%10);
+      }
+      if (!MAZEF_IsVisited(&maze, x, y)) {
+        buf[i-3] = '?';
+      }
+    }
+    buf[i++] = '|'; buf[i++] = '\r'; buf[i++] = '\n'; buf[i] = '\0';
+    CLS1_SendStr(buf, io->stdOut);
+  }
+  i = 0; /* south wall */
+  for(x=0;x<MAZEF_SIZE;x++) {
+    buf[i++] = '+'; buf[i++] = '-'; buf[i++] = '-'; buf[i++] = '-';
+  }
+  buf[i++] = '+'; buf[i++] = '\r'; buf[i++] = '\n'; buf[i] = '\0';
+  CLS1_SendStr(buf, io->stdOut);
+}
+
+uint8_t WMAZE_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+  const unsigned char *p;
+  int32_t x, y, size;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"wmaze help")==0) {
+    WMAZE_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"wmaze status")==0) {
+    WMAZE_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"wmaze start")==0) {
+    WMAZE_Start();
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"wmaze stop")==0) {
+    WMAZE_Stop();
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"wmaze print")==0) {
+    WMAZE_PrintMaze(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"wmaze clear")==0) {
+    if (WMAZE_IsRunning()) {
+      CLS1_SendStr((unsigned char*)"Stop exploring first\r\n", io->stdErr);
+      res = ERR_BUSY;
+    } else {
+      MAZEF_Init(&maze, maze.goalX, maze.goalY, maze.goalSize);
+    }
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"wmaze goal ", sizeof("wmaze goal ")-1)==0) {
+    p = cmd+sizeof("wmaze goal");
+    if (   UTIL1_xatoi(&p, &x)==ERR_OK && UTIL1_xatoi(&p, &y)==ERR_OK && UTIL1_xatoi(&p, &size)==ERR_OK
+        && x>=0 && y>=0 && size>0 && x+size<=MAZEF_SIZE && y+size<=MAZEF_SIZE)
+    {
+      if (WMAZE_IsRunning()) {
+        CLS1_SendStr((unsigned char*)"Stop exploring first\r\n", io->stdErr);
+        res = ERR_BUSY;
+      } else {
+        MAZEF_Init(&maze, (uint8_t)x, (uint8_t)y, (uint8_t)size);
+      }
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong arguments, goal area must be inside the maze\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+    *handled = TRUE;
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"wmaze cell ", sizeof("wmaze cell ")-1)==0) {
+    p = cmd+sizeof("wmaze cell");
+    if (UTIL1_xatoi(&p, &size)==ERR_OK && size>0 && size<=1000) {
+      cellMm = (uint16_t)size;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument, must be in the range 1..1000\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+    *handled = TRUE;
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void WMAZE_Deinit(void) {
+}
+
+void WMAZE_Init(void) {
+  MAZEF_Init(&maze, WMAZE_GOAL_X_DEFAULT, WMAZE_GOAL_Y_DEFAULT, WMAZE_GOAL_SIZE_DEFAULT);
+  if (xTaskCreate(WMazeTask, "WallMaze", 400/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+1, &WMAZE_TaskHandle) != pdPASS) {
+    for(;;){} /* error */
+  }
+}
+
+#endif /* PL_CONFIG_HAS_WALL_MAZE */
@@ -0,0 +1,55 @@
+/**
+ * \file
+ * \brief Wall maze interface.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Explores a cell based wall maze with the ToF distance sensors, using flood fill to find the way to the goal.
+ */
+
+#ifndef WALLMAZE_H_
+#define WALLMAZE_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_WALL_MAZE
+
+/*!
+ * \brief Starts exploring from the start cell (0,0), heading north. Walls known from previous runs are kept.
+ */
+void WMAZE_Start(void);
+
+/*!
+ * \brief Stops exploring.
+ */
+void WMAZE_Stop(void);
+
+/*!
+ * \brief Returns if the robot is exploring.
+ * \return TRUE while exploring
+ */
+bool WMAZE_IsRunning(void);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Module command line parser
+ * \param cmd Pointer to command string to be parsed
+ * \param handled Set to TRUE if command has handled by parser
+ * \param io Shell standard I/O handler
+ * \return Error code, ERR_OK if everything was ok
+ */
+uint8_t WMAZE_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*!
+ * \brief Module de-initialization.
+ */
+void WMAZE_Deinit(void);
+
+/*!
+ * \brief Module initialization.
+ */
+void WMAZE_Init(void);
+
+#endif /* PL_CONFIG_HAS_WALL_MAZE */
+
+#endif /* WALLMAZE_H_ */